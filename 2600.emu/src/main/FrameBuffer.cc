@@ -131,17 +131,10 @@ void FrameBuffer::renderOutput(IG::MutablePixmapView pix, TIA &tia)
 	}
 	else
 	{
-		pix.writeTransformed([this](uint8_t p)
-			{
-				if constexpr(outputBits == 16)
-				{
-					return tiaColorMap16[p];
-				}
-				else
-				{
-					return tiaColorMap32[p];
-				}
-			}, framePix);
+		if constexpr(outputBits == 16)
+			pix.writePaletteExpanded<uint16_t>(tiaColorMap16, framePix);
+		else
+			pix.writePaletteExpanded<uint32_t>(tiaColorMap32, framePix);
 	}
 }
 
@@ -48,6 +48,7 @@ bool EmuSystem::hasResetModes = true;
 IG::Audio::SampleFormat EmuSystem::audioSampleFormat = IG::Audio::SampleFormats::f32;
 bool EmuSystem::hasRectangularPixels = true;
 bool EmuApp::needsGlobalInstance = true;
+bool EmuSystem::canRunAhead = true;
 
 EmuSystem::NameFilterFunc EmuSystem::defaultFsFilter =
 	[](std::string_view name)
@@ -227,8 +228,7 @@ void A2600System::reset(EmuApp &, ResetMode mode)
 
 void A2600System::readState(EmuApp &app, std::span<uint8_t> buff)
 {
-	Serializer state;
-	state.putByteArray(buff.data(), buff.size());
+	Serializer state{buff};
 	if(!osystem.state().loadState(state))
 		throw std::runtime_error("Invalid state data");
 	updateSwitchValues();
@@ -236,11 +236,10 @@ void A2600System::readState(EmuApp &app, std::span<uint8_t> buff)
 
 size_t A2600System::writeState(std::span<uint8_t> buff, SaveStateFlags flags)
 {
-	Serializer state;
-	osystem.state().saveState(state);
+	Serializer state{buff};
+	[[maybe_unused]] bool saved = osystem.state().saveState(state);
+	assert(saved);
 	assert(state.size() == saveStateSize);
-	assert(state.size() <= buff.size());
-	state.getByteArray(buff.data(), buff.size());
 	return saveStateSize;
 }
 
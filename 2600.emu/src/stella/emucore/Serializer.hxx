@@ -18,6 +18,8 @@
 #ifndef SERIALIZER_HXX
 #define SERIALIZER_HXX
 
+#include <span>
+
 #include "bspf.hxx"
 
 /**
@@ -52,12 +54,19 @@ class Serializer
     explicit Serializer(const string& filename, Mode m = Mode::ReadWrite);
     Serializer();
 
+    /**
+      Creates a new Serializer device that reads from/writes to the given
+      memory buffer directly, with no copying or heap allocation.  Reading
+      or writing past the end of the buffer throws std::out_of_range.
+    */
+    explicit Serializer(std::span<uInt8> buffer);
+
   public:
     /**
       Answers whether the serializer is currently initialized for reading
       and writing.
     */
-    explicit operator bool() const { return myStream != nullptr; }
+    explicit operator bool() const { return myStream != nullptr || myBuffer.data(); }
 
     /**
       Sets the read/write location to the given offset in the stream.
@@ -70,7 +79,8 @@ class Serializer
     void rewind();
 
     /**
-      Returns the current total size of the stream.
+      Returns the current total size of the stream.  For a memory buffer,
+      this is the number of bytes written so far.
     */
     size_t size();
 
@@ -220,10 +230,19 @@ class Serializer
     */
     void putBool(bool b);
 
+  private:
+    void read(void* data, size_t size) const;
+    void write(const void* data, size_t size);
+
   private:
     // The stream to send the serialized data to.
     unique_ptr<iostream> myStream;
 
+    // The memory buffer used instead of a stream, if any
+    std::span<uInt8> myBuffer;
+    mutable size_t myBufferPos{0};
+    size_t myBufferEnd{0};
+
     static constexpr uInt8 TruePattern = 0xfe, FalsePattern = 0x01;
 };
 
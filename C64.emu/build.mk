@@ -23,6 +23,7 @@ main/options.cc \
 main/input.cc \
 main/EmuMenuViews.cc \
 main/VicePlugin.cc \
+main/ViceMainloop.cc \
 main/resources.cc \
 main/sysfile.cc \
 main/video.cc \
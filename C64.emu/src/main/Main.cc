@@ -298,6 +298,12 @@ static void saveSnapshotTrap(uint16_t, void *data)
 
 static void runTrap(C64System &sys, auto trapFunc, SnapshotTrapData &snapData)
 {
+	if(sys.inFrameEndTrap)
+	{
+		// emulation thread is waiting inside the CPU's end of frame trap, no need to execute anything
+		trapFunc(0, (void*)&snapData);
+		return;
+	}
 	sys.plugin.interrupt_maincpu_trigger_trap(trapFunc, (void*)&snapData);
 	for(auto i : iotaCount(15))
 	{
@@ -319,10 +325,20 @@ void C64System::readState(EmuApp &app, std::span<uint8_t> buff)
 {
 	plugin.vsync_set_warp_mode(0);
 	SnapshotTrapData data{.plugin{plugin}, .buffData = buff.data(), .buffSize = buff.size()};
+	bool loadInTrap = inFrameEndTrap;
 	runTrap(*this, loadSnapshotTrap, data); // execute cpu trap, snapshot load may cause reboot from a C64 model change
 	if(data.hasError)
 		throw std::runtime_error("Invalid state data");
+	if(loadInTrap)
+	{
+		if(!plugin.maincpu_reset_pending())
+			return;
+		// let the reboot run before loading again
+		setCanvasSkipFrame(true);
+		execC64Frame();
+	}
 	// reload snapshot in case last load caused a reboot
+	data.ranTrap = false;
 	runTrap(*this, loadSnapshotTrap, data);
 	if(data.hasError)
 		throw std::runtime_error("Invalid state data");
@@ -521,9 +537,8 @@ void C64System::loadContent(IO &, EmuSystemCreateParams params, OnLoadProgressDe
 void C64System::execC64Frame()
 {
 	startCanvasRunningFrame();
-	// signal C64 thread to execute one frame and wait for it to finish
-	execSem.release();
-	execDoneSem.acquire();
+	// resume VICE's main loop until it finishes the frame
+	mainloop.runFrame();
 }
 
 void C64System::runFrame(EmuSystemTaskContext taskCtx, EmuVideo *video, EmuAudio *audio)
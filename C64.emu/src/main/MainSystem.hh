@@ -16,7 +16,7 @@
 	along with C64.emu.  If not, see <http://www.gnu.org/licenses/> */
 
 #include "VicePlugin.hh"
-#include <imagine/thread/Semaphore.hh>
+#include "ViceMainloop.hh"
 #include <imagine/pixmap/Pixmap.hh>
 #include <imagine/thread/Thread.hh>
 #include <imagine/fs/FS.hh>
@@ -88,11 +88,11 @@ class C64System final: public EmuSystem
 {
 public:
 	double systemFrameRate{60.};
-	std::binary_semaphore execSem{0}, execDoneSem{0};
 	EmuAudio *audioPtr{};
 	struct video_canvas_s *activeCanvas{};
 	const char *sysFileDir{};
 	VicePlugin plugin{};
+	ViceMainloop mainloop{plugin};
 	mutable ArchiveIO firmwareArch;
 	std::string defaultPaletteName{};
 	std::string lastMissingSysFile;
@@ -100,6 +100,7 @@ public:
 	PixelFormat pixFmt{};
 	ViceSystem currSystem{};
 	std::atomic_bool runningFrame{};
+	bool inFrameEndTrap{};
 	bool ctrlLock{};
 	bool c64IsInit{}, c64FailedInit{};
 	std::array <FS::PathString, Config::envIsLinux ? 3 : 1> sysFilePath{};
@@ -131,14 +132,6 @@ public:
 	C64System(ApplicationContext ctx):
 		EmuSystem{ctx}
 	{
-		makeDetachedThread(
-			[this]()
-			{
-				execSem.acquire();
-				logMsg("starting maincpu_mainloop()");
-				plugin.maincpu_mainloop();
-			});
-
 		if(sysFilePath.size() == 3)
 		{
 			sysFilePath[1] = "~/.local/share/C64.emu";
@@ -0,0 +1,145 @@
+/*  This file is part of C64.emu.
+
+	C64.emu is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	C64.emu is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with C64.emu.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "mainloop"
+#include "ViceMainloop.hh"
+#include "VicePlugin.hh"
+#include <imagine/thread/Thread.hh>
+#include <imagine/logger/logger.h>
+#include <cstdint>
+#ifdef C64EMU_MAINLOOP_COROUTINE
+#include <imagine/vmem/memory.hh>
+#include <imagine/vmem/pageSize.hh>
+#include <sys/mman.h>
+#include <new>
+#endif
+
+#if defined __SANITIZE_ADDRESS__
+#define C64EMU_ASAN_FIBERS
+#elif defined __has_feature
+#if __has_feature(address_sanitizer)
+#define C64EMU_ASAN_FIBERS
+#endif
+#endif
+
+#ifdef C64EMU_ASAN_FIBERS
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+namespace EmuEx
+{
+
+#ifdef C64EMU_MAINLOOP_COROUTINE
+
+// same as the default thread stack size the main loop used to run with
+constexpr size_t loopStackSize = 8 * 1024 * 1024;
+
+static size_t loopStackMapSize() { return loopStackSize + IG::pageSize(); }
+
+// ASan needs to know when execution moves to another stack, otherwise it reports
+// false positives from the stale shadow memory of the stack that was left
+static void startSwitchStack([[maybe_unused]] void **fakeStackSave,
+	[[maybe_unused]] const void *bottom, [[maybe_unused]] size_t size)
+{
+	#ifdef C64EMU_ASAN_FIBERS
+	__sanitizer_start_switch_fiber(fakeStackSave, bottom, size);
+	#endif
+}
+
+static void finishSwitchStack([[maybe_unused]] void *fakeStackSave,
+	[[maybe_unused]] const void **oldBottom, [[maybe_unused]] size_t *oldSize)
+{
+	#ifdef C64EMU_ASAN_FIBERS
+	__sanitizer_finish_switch_fiber(fakeStackSave, oldBottom, oldSize);
+	#endif
+}
+
+ViceMainloop::ViceMainloop(VicePlugin &plugin):
+	plugin{plugin},
+	// only the pages actually used get committed
+	loopStack{(char*)IG::allocVMem(loopStackMapSize())}
+{
+	if(!loopStack)
+		throw std::bad_alloc{};
+	// stacks grow down, an overflow faults on the guard page instead of corrupting the heap
+	if(mprotect(loopStack, IG::pageSize(), PROT_NONE) == -1)
+		logWarn("error protecting main loop stack guard page");
+	getcontext(&loopCtx);
+	loopCtx.uc_stack.ss_sp = loopStack + IG::pageSize();
+	loopCtx.uc_stack.ss_size = loopStackSize;
+	loopCtx.uc_link = {}; // main loop never returns
+	auto ptr = uint64_t(uintptr_t(this));
+	makecontext(&loopCtx, (void(*)())&entry, 2, unsigned(ptr >> 32), unsigned(ptr));
+}
+
+ViceMainloop::~ViceMainloop()
+{
+	IG::freeVMem(loopStack, loopStackMapSize());
+}
+
+void ViceMainloop::entry(unsigned ptrHi, unsigned ptrLo)
+{
+	auto &self = *(ViceMainloop*)uintptr_t(uint64_t(ptrHi) << 32 | ptrLo);
+	finishSwitchStack(nullptr, &self.callerStackBottom, &self.callerStackSize);
+	logMsg("starting maincpu_mainloop()");
+	self.plugin.maincpu_mainloop();
+}
+
+void ViceMainloop::runFrame()
+{
+	std::scoped_lock lock{resumeMutex};
+	void *fakeStack{};
+	startSwitchStack(&fakeStack, loopCtx.uc_stack.ss_sp, loopCtx.uc_stack.ss_size);
+	swapcontext(&callerCtx, &loopCtx);
+	finishSwitchStack(fakeStack, nullptr, nullptr);
+}
+
+void ViceMainloop::yieldFrame()
+{
+	void *fakeStack{};
+	startSwitchStack(&fakeStack, callerStackBottom, callerStackSize);
+	swapcontext(&loopCtx, &callerCtx);
+	// may have been resumed from a different thread than last time
+	finishSwitchStack(fakeStack, &callerStackBottom, &callerStackSize);
+}
+
+#else
+
+ViceMainloop::ViceMainloop(VicePlugin &plugin)
+{
+	makeDetachedThread(
+		[this, &plugin]()
+		{
+			execSem.acquire();
+			logMsg("starting maincpu_mainloop()");
+			plugin.maincpu_mainloop();
+		});
+}
+
+void ViceMainloop::runFrame()
+{
+	execSem.release();
+	execDoneSem.acquire();
+}
+
+void ViceMainloop::yieldFrame()
+{
+	execDoneSem.release();
+	execSem.acquire();
+}
+
+#endif
+
+}
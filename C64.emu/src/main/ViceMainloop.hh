@@ -0,0 +1,68 @@
+#pragma once
+
+/*  This file is part of C64.emu.
+
+	C64.emu is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	C64.emu is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with C64.emu.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <semaphore>
+
+// glibc's ucontext lets the main loop run as a coroutine, Bionic & Darwin lack a usable one
+#if defined __linux__ && !defined __ANDROID__
+#define C64EMU_MAINLOOP_COROUTINE
+#include <ucontext.h>
+#include <mutex>
+#endif
+
+namespace EmuEx
+{
+
+class VicePlugin;
+
+// Runs VICE's maincpu_mainloop() one frame at a time. As a coroutine, the loop runs on its own
+// stack in whichever thread calls runFrame(), otherwise it runs on a separate thread that
+// hands control back & forth with semaphores.
+//
+// The coroutine gets resumed by EmuSystemTask for normal frames and by the main thread for
+// content loading & state traps while the task is paused. runFrame() serializes those so only
+// one thread is ever inside the loop, which is safe to move between threads since VICE keeps
+// no thread-local state.
+class ViceMainloop
+{
+public:
+	ViceMainloop(VicePlugin &);
+	#ifdef C64EMU_MAINLOOP_COROUTINE
+	~ViceMainloop();
+	#endif
+	// Resumes the main loop until the next yieldFrame()
+	void runFrame();
+	// Called from the main loop at the end of a frame
+	void yieldFrame();
+
+private:
+	#ifdef C64EMU_MAINLOOP_COROUTINE
+	VicePlugin &plugin;
+	ucontext_t callerCtx{}, loopCtx{};
+	char *loopStack{}; // mapping starts with a guard page
+	std::mutex resumeMutex;
+	// stack of the thread that last resumed the loop, for ASan's fiber tracking
+	const void *callerStackBottom{};
+	size_t callerStackSize{};
+
+	static void entry(unsigned ptrHi, unsigned ptrLo);
+	#else
+	std::binary_semaphore execSem{0}, execDoneSem{0};
+	#endif
+};
+
+}
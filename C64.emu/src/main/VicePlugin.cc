@@ -314,6 +314,13 @@ void VicePlugin::interrupt_maincpu_trigger_trap(void trap_func(uint16_t, void *d
 		interrupt_maincpu_trigger_trap_(trap_func, data);
 }
 
+bool VicePlugin::maincpu_reset_pending() const
+{
+	if(maincpu_reset_pending_)
+		return maincpu_reset_pending_();
+	return true;
+}
+
 int VicePlugin::init_main()
 {
 	if(init_main_)
@@ -520,6 +527,7 @@ VicePlugin commonVicePlugin(void *lib, ViceSystem system)
 	loadSymbolCheck(plugin.machine_trigger_reset_, lib, "machine_trigger_reset");
 	loadSymbolCheck(plugin.machine_drive_get_type_info_list_, lib, "machine_drive_get_type_info_list");
 	loadSymbolCheck(plugin.interrupt_maincpu_trigger_trap_, lib, "interrupt_maincpu_trigger_trap");
+	loadSymbolCheck(plugin.maincpu_reset_pending_, lib, "maincpu_reset_pending");
 	loadSymbolCheck(plugin.init_main_, lib, "init_main");
 	assert(plugin.init_main_);
 	loadSymbolCheck(plugin.maincpu_mainloop_, lib, "maincpu_mainloop");
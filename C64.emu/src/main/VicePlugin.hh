@@ -66,6 +66,7 @@ struct VicePlugin
 	void (*machine_trigger_reset_)(const unsigned int mode){};
 	struct drive_type_info_s *(*machine_drive_get_type_info_list_)(){};
 	void (*interrupt_maincpu_trigger_trap_)(void (*trap_func_)(uint16_t, void *data), void *data){};
+	int (*maincpu_reset_pending_)(){};
 	int (*init_main_)(){};
 	void (*maincpu_mainloop_)(){};
 	int (*autostart_autodetect_)(const char *file_name, const char *program_name,
@@ -117,6 +118,7 @@ struct VicePlugin
 	void machine_trigger_reset(const unsigned int mode);
 	struct drive_type_info_s *machine_drive_get_type_info_list();
 	void interrupt_maincpu_trigger_trap(void trap_func(uint16_t, void *data), void *data) const;
+	bool maincpu_reset_pending() const;
 	int init_main();
 	void maincpu_mainloop();
 	int autostart_autodetect(const char *file_name, const char *program_name,
@@ -24,6 +24,7 @@
 #include <sys/time.h>
 #include "machine.h"
 #include "maincpu.h"
+#include "interrupt.h"
 #include "drive.h"
 #include "lib.h"
 #include "util.h"
@@ -571,14 +572,26 @@ void vsync_do_end_of_line(void)
 	sound_flush();
 }
 
-void vsync_do_vsync(struct video_canvas_s *c)
+static void vsyncTrap(uint16_t addr, void *data)
 {
-	vsync_do_vsync2(c);
+	vsync_do_vsync2(data);
 	vsync_hook();
 	execute_vsync_callbacks();
 	kbdbuf_flush();
 }
 
+void vsync_do_vsync(struct video_canvas_s *c)
+{
+	// Finish the frame from a trap so the emulation thread waits at an instruction
+	// boundary with the CPU registers exported, the same point snapshots are made from
+	interrupt_maincpu_trigger_trap(vsyncTrap, c);
+}
+
+VICE_API int maincpu_reset_pending(void)
+{
+	return (maincpu_int_status->global_pending_int & IK_RESET) != 0;
+}
+
 bool vsync_should_skip_frame(struct video_canvas_s *c)
 {
 	return c->skipFrame;
@@ -56,8 +56,9 @@ void vsync_do_vsync2(struct video_canvas_s *c)
 	{
 		//logMsg("vsync_do_vsync signaling main thread");
 		sys.runningFrame = false;
-		sys.execDoneSem.release();
-		sys.execSem.acquire();
+		sys.inFrameEndTrap = true;
+		sys.mainloop.yieldFrame();
+		sys.inFrameEndTrap = false;
 	}
 	else
 	{
@@ -12,6 +12,8 @@ EmuSystemTask.cc \
 EmuTiming.cc \
 EmuVideo.cc \
 EmuVideoLayer.cc \
+FrameDelayManager.cc \
+HeadlessBenchmark.cc \
 InputDeviceConfig.cc \
 InputDeviceData.cc \
 KeyConfig.cc \
@@ -19,6 +21,9 @@ OutputTimingManager.cc \
 pathUtils.cc \
 RecentContent.cc \
 RewindManager.cc \
+RunAheadManager.cc \
+StateSaveTask.cc \
+StateScratchArena.cc \
 ToggleInput.cc \
 TurboInput.cc \
 VideoImageEffect.cc \
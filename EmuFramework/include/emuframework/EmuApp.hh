@@ -24,9 +24,12 @@
 #include <emuframework/EmuInput.hh>
 #include <emuframework/Option.hh>
 #include <emuframework/AutosaveManager.hh>
+#include <emuframework/FrameDelayManager.hh>
 #include <emuframework/OutputTimingManager.hh>
 #include <emuframework/RecentContent.hh>
 #include <emuframework/RewindManager.hh>
+#include <emuframework/RunAheadManager.hh>
+#include <emuframework/StateSaveTask.hh>
 #include <imagine/input/inputDefs.hh>
 #include <imagine/gui/ViewManager.hh>
 #include <imagine/gui/TextEntry.hh>
@@ -37,6 +40,7 @@
 #include <imagine/base/Application.hh>
 #include <imagine/base/VibrationManager.hh>
 #include <imagine/base/PerformanceHintManager.hh>
+#include <imagine/thread/JobSystem.hh>
 #include <imagine/audio/Manager.hh>
 #include <imagine/gfx/Renderer.hh>
 #include <imagine/data-type/image/PixmapReader.hh>
@@ -221,6 +225,7 @@ public:
 	void setContentSearchPath(std::string_view path);
 	FS::PathString validSearchPath(const FS::PathString &) const;
 	static void updateLegacySavePath(IG::ApplicationContext, CStringView path);
+	static bool isHeadlessLaunch(IG::CommandArgs);
 	auto screenshotDirectory() const { return system().userPath(userScreenshotPath); }
 	static std::unique_ptr<View> makeCustomView(ViewAttachParams attach, ViewID id);
 	bool handleKeyInput(KeyInfo, const Input::Event &srcEvent);
@@ -320,6 +325,7 @@ public:
 	void setCPUAffinity(int cpuNumber, bool on);
 	bool cpuAffinity(int cpuNumber) const;
 	void applyCPUAffinity(bool active);
+	CPUMask jobSystemCPUMask() const;
 
 	// GUI Options
 	void setIdleDisplayPowerSave(bool on);
@@ -508,6 +514,10 @@ public:
 	InputManager inputManager;
 	OutputTimingManager outputTimingManager;
 	RewindManager rewindManager;
+	RunAheadManager runAheadManager;
+	FrameDelayManager frameDelayManager;
+	StateSaveTask stateSaveTask;
+	JobSystem jobSystem;
 protected:
 	IG_UseMemberIf(enableFrameTimeStats, FrameTimeStats, frameTimeStats);
 	IG_UseMemberIf(Config::threadPerformanceHints, SteadyClockTimePoint, frameStartTimePoint){};
@@ -88,6 +88,7 @@ namespace IG
 
 void ApplicationContext::onInit(ApplicationInitParams initParams)
 {
+	initParams.headless = EmuEx::EmuApp::isHeadlessLaunch(initParams.commandArgs());
 	auto &app = initApplication<EmuEx::MainApp>(initParams, *this);
 	app.mainInitCommon(initParams, *this);
 }
@@ -16,6 +16,7 @@
 	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
 
 #include <imagine/audio/OutputStream.hh>
+#include <imagine/audio/Resampler.hh>
 #include <imagine/time/Time.hh>
 #include <imagine/vmem/RingBuffer.hh>
 #include <imagine/util/used.hh>
@@ -62,6 +63,8 @@ public:
 	void close();
 	void flush();
 	void writeFrames(const void *samples, size_t framesToWrite);
+	void openNullSink();
+	size_t nullSinkFrames() const { return nullSinkFrames_; }
 	void setRate(int rate);
 	int rate() const { return rate_; }
 	int maxRate() const { return defaultRate; }
@@ -85,6 +88,7 @@ protected:
 	IG::Audio::OutputStream audioStream;
 	const IG::Audio::Manager &audioManager;
 	RingBuffer rBuff;
+	IG::Audio::Resampler resampler;
 	SteadyClockTimePoint lastUnderrunTime{};
 	double speedMultiplier{1.};
 	size_t targetBufferFillBytes{};
@@ -98,7 +102,10 @@ protected:
 	AudioFlags flags{defaultAudioFlags};
 	IG_UseMemberIf(IG::Audio::Config::MULTIPLE_SYSTEM_APIS, IG::Audio::Api, audioAPI){};
 	bool addSoundBuffersOnUnderrun{};
+	bool nullSink{};
+	size_t nullSinkFrames_{};
 public:
+	static constexpr double maxRateDelta = .005;
 	bool addSoundBuffersOnUnderrunSetting{};
 	int8_t defaultSoundBuffers{3};
 	int8_t soundBuffers{defaultSoundBuffers};
@@ -110,6 +117,7 @@ public:
 	void resizeAudioBuffer(size_t targetBufferFillBytes);
 	void updateVolume();
 	void updateAddBuffersOnUnderrun();
+	double rateControlRatio() const;
 };
 
 }
@@ -22,9 +22,11 @@
 #include <imagine/audio/SampleFormat.hh>
 #include <imagine/util/rectangle2.h>
 #include <imagine/util/memory/DynArray.hh>
+#include <imagine/util/compression.hh>
 #include <emuframework/EmuTiming.hh>
 #include <emuframework/VController.hh>
 #include <emuframework/EmuInput.hh>
+#include <emuframework/StateScratchArena.hh>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -193,6 +195,7 @@ public:
 	static F2Size validFrameRateRange;
 	static bool hasRectangularPixels;
 	static bool stateSizeChangesAtRuntime;
+	static bool canRunAhead;
 
 	EmuSystem(IG::ApplicationContext ctx): appCtx{ctx} {}
 
@@ -239,6 +242,9 @@ public:
 	bool shouldFastForward() const;
 	FS::FileString contentDisplayNameForPath(CStringView path) const;
 	IG::Rotation contentRotation() const;
+	// converts the output of writeState(buff, {.uncompressed = true}) to the default
+	// compressed format, must not access emulation state since it runs on a worker thread
+	size_t compressState(std::span<uint8_t> dest, std::span<const uint8_t> state) const;
 
 	ApplicationContext appContext() const { return appCtx; }
 	bool isActive() const { return state == State::ACTIVE; }
@@ -247,8 +253,16 @@ public:
 	void loadState(EmuApp &, CStringView uri);
 	void saveState(CStringView uri);
 	DynArray<uint8_t> saveState();
-	DynArray<uint8_t> uncompressGzipState(std::span<uint8_t> buff, size_t expectedSize = 0);
+	ScratchBuffer uncompressState(std::span<uint8_t> buff, size_t expectedSize = 0);
+	size_t compressStateData(std::span<uint8_t> dest, std::span<const uint8_t> state) const;
+	// temporary memory for systems that can't write compressed states directly
+	ScratchBuffer stateScratchBuffer(size_t size) const { return stateScratch.get(size); }
+	StreamCompressor stateCompressor(std::span<uint8_t> dest, std::span<uint8_t> inputBuff = {}) const
+	{
+		return {dest, stateCompressionCodec, stateCompressionLevel, inputBuff, stateScratch.allocator()};
+	}
 	bool stateExists(int slot) const;
+	bool canCompressStatesSeparately() const;
 	static std::string_view stateSlotName(int slot);
 	std::string_view stateSlotName() { return stateSlotName(stateSlot()); }
 	int stateSlot() const { return saveStateSlot; }
@@ -349,6 +363,7 @@ public:
 	auto advanceFramesWithTime(SteadyClockTimePoint time) { return emuTiming.advanceFramesWithTime(time); }
 	void setSpeedMultiplier(EmuAudio &, double speed);
 	SteadyClockTime benchmark(EmuVideo &video);
+	SteadyClockTime benchmark(EmuVideo &video, EmuAudio *audio, std::span<SteadyClockTime> frameTimes);
 	bool hasContent() const;
 	void resetFrameTime();
 	void pause(EmuApp &);
@@ -377,6 +392,7 @@ protected:
 	std::string contentDisplayName_; // more descriptive content name set by system
 	FS::PathString contentSaveDirectory_;
 	FS::PathString userSaveDirectory_;
+	mutable StateScratchArena stateScratch;
 
 	void setupContentUriPaths(CStringView uri, std::string_view displayName);
 	void setupContentFilePaths(CStringView filePath, std::string_view displayName);
@@ -386,6 +402,8 @@ protected:
 public:
 	IG::OnFrameDelegate onFrameUpdate;
 	double targetSpeed{1.};
+	CompressionCodec stateCompressionCodec{CompressionCodec::Gzip}; // older versions can only read gzip states
+	int8_t stateCompressionLevel{defaultCompressionLevel};
 	static constexpr double minFrameRate = 48.;
 };
 
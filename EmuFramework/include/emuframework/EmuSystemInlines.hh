@@ -218,6 +218,18 @@ size_t EmuSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags)
 		return static_cast<MainSystem*>(this)->writeState(buff, flags);
 }
 
+size_t EmuSystem::compressState(std::span<uint8_t> dest, std::span<const uint8_t> state) const
+{
+	if(&MainSystem::compressState != &EmuSystem::compressState)
+		return static_cast<const MainSystem*>(this)->compressState(dest, state);
+	return 0;
+}
+
+bool EmuSystem::canCompressStatesSeparately() const
+{
+	return &MainSystem::compressState != &EmuSystem::compressState;
+}
+
 void EmuSystem::clearInputBuffers(EmuInputView &view)
 {
 	static_cast<MainSystem*>(this)->clearInputBuffers(view);
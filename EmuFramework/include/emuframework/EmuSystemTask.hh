@@ -17,6 +17,7 @@
 
 #include <imagine/base/MessagePort.hh>
 #include <imagine/thread/Thread.hh>
+#include <imagine/time/Time.hh>
 #include <variant>
 
 namespace EmuEx
@@ -43,9 +44,11 @@ public:
 	{
 		EmuVideo *video{};
 		EmuAudio *audio{};
+		FrameParams frameParams{};
 		int8_t frames{};
 		bool skipForward{};
 		bool fastForward{};
+		bool lateFrame{};
 	};
 
 	struct PauseCommand {};
@@ -65,7 +68,8 @@ public:
 	void start();
 	void pause();
 	void stop();
-	void runFrame(EmuVideo *, EmuAudio *, int8_t frames, bool skipForward, bool fastForward);
+	void runFrame(EmuVideo *, EmuAudio *, int8_t frames, bool skipForward, bool fastForward,
+		FrameParams = {}, bool lateFrame = false);
 	void sendVideoFormatChangedReply(EmuVideo &);
 	void sendFrameFinishedReply(EmuVideo &);
 	void sendScreenshotReply(bool success);
@@ -73,7 +77,7 @@ public:
 
 private:
 	EmuApp &app;
-	MessagePort<CommandMessage> commandPort{"EmuSystemTask Command"};
+	RingMessagePort<CommandMessage> commandPort{"EmuSystemTask Command"};
 	std::thread taskThread;
 	ThreadId threadId_{};
 };
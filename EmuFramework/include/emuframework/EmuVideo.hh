@@ -20,6 +20,8 @@
 #include <emuframework/EmuSystemTaskContext.hh>
 #include <imagine/gfx/PixmapBufferTexture.hh>
 #include <imagine/gfx/SyncFence.hh>
+#include <imagine/base/ApplicationContext.hh>
+#include <imagine/util/memory/DynArray.hh>
 #include <optional>
 
 namespace EmuEx
@@ -53,6 +55,8 @@ public:
 	constexpr EmuVideo() = default;
 	void setRendererTask(Gfx::RendererTask &);
 	bool hasRendererTask() const;
+	void setCPUOnly(EmuSystem &, IG::ApplicationContext, IG::PixelFormat);
+	bool isCPUOnly() const { return cpuOnly; }
 	bool setFormat(IG::PixmapDesc desc, EmuSystemTaskContext task = {});
 	void dispatchFormatChanged();
 	void resetImage(IG::PixelFormat newFmt = {});
@@ -87,6 +91,9 @@ public:
 protected:
 	Gfx::RendererTask *rTask{};
 	Gfx::PixmapBufferTexture vidImg;
+	IG::ApplicationContext appCtx{}; // only set in CPU-only mode
+	DynArray<uint8_t> cpuBuff;
+	IG::PixmapDesc cpuDesc{};
 	FrameFinishedDelegate onFrameFinished;
 	FormatChangedDelegate onFormatChanged;
 	IG::PixelFormat renderFmt;
@@ -94,6 +101,7 @@ protected:
 	bool screenshotNextFrame{};
 	Gfx::ColorSpace colSpace{Gfx::ColorSpace::LINEAR};
 	bool useLinearFilter{true};
+	bool cpuOnly{};
 
 	void doScreenshot(EmuSystemTaskContext, IG::PixmapView pix);
 	void postFrameFinished(EmuSystemTaskContext);
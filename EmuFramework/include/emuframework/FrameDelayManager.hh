@@ -0,0 +1,72 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <emuframework/config.hh>
+#include <imagine/time/Time.hh>
+
+namespace IG
+{
+class MapIO;
+class FileIO;
+}
+
+namespace EmuEx
+{
+
+using namespace IG;
+
+// Waits part of the frame after vsync before running the emulated frame so input is read
+// as late as possible while still finishing before the next present. The delay is either
+// fixed or tuned from how long recent frames took to run, backing off when a frame misses
+// its deadline.
+
+class FrameDelayManager
+{
+public:
+	static constexpr int8_t autoOption = -1;
+	static constexpr int8_t maxMilliseconds = 12;
+
+	bool readConfig(MapIO &, unsigned key, size_t size);
+	void writeConfig(FileIO &) const;
+	int8_t option() const { return option_; }
+	void setOption(int8_t);
+	bool isEnabled() const { return option_; }
+
+	// called from the emulation thread around a frame that will be presented, lateFrame is set
+	// when the previous one wasn't ready to draw by its vsync, returns true if it waited
+	bool waitForFrameStart(FrameParams, bool lateFrame);
+	void onFrameFinished();
+
+private:
+	static constexpr SteadyClockTime minMargin{Milliseconds{2}}; // time left to draw & present
+	static constexpr SteadyClockTime backoffStep{Milliseconds{2}};
+	static constexpr SteadyClockTime recoverStep{Microseconds{250}};
+	static constexpr int recoverFrames = 60;
+
+	SteadyClockTimePoint runStart{};
+	SteadyClockTimePoint deadline{};
+	SteadyClockTime frameTime{};
+	SteadyClockTime peakRunTime{};
+	SteadyClockTime margin{minMargin};
+	int onTimeFrames{};
+	int8_t option_{};
+
+	SteadyClockTime autoDelay(bool lateFrame);
+	void backOff();
+};
+
+}
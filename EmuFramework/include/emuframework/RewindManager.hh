@@ -16,8 +16,12 @@
 	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
 
 #include <emuframework/config.hh>
-#include <imagine/base/PausableTimer.hh>
-#include <imagine/util/memory/FlexArray.hh>
+#include <imagine/util/memory/DynArray.hh>
+#include <deque>
+#include <string_view>
+#include <thread>
+#include <semaphore>
+#include <atomic>
 
 namespace IG
 {
@@ -32,47 +36,135 @@ using namespace IG;
 
 class EmuApp;
 
+constexpr size_t rewindMemoryUnitSize = 1024 * 1024;
+// keeps the byte count in range of a 32-bit size_t
+constexpr size_t maxRewindMemoryUnits = sizeof(size_t) > 4 ? 4096 : 2048;
+
+// Stores rewind states in a fixed size byte ring, each state being either a full
+// keyframe or an XOR + zero run-length encoded delta against the last keyframe.
+// States are captured on the emulation thread every saveFrameInterval frames and
+// encoded into the ring on a separate thread.
+
 class RewindManager
 {
 public:
-	RewindManager(EmuApp &);
+	~RewindManager();
 	void clear();
 	bool reset();
 	void rewindState(EmuApp &);
-	void startTimer();
-	void pauseTimer();
-	void resetTimer();
 	bool readConfig(MapIO &, unsigned key, size_t size);
 	void writeConfig(FileIO &) const;
+	bool isEnabled() const { return maxMemory && !memoryTooSmall(); }
+	// set when the memory limit can't hold a single state of the current system
+	bool memoryTooSmall() const { return maxMemory && stateSize && maxMemory < stateSize; }
+	static constexpr std::string_view memoryTooSmallMessage{"Rewind memory is too small for this system's states, rewind is disabled"};
+
+	// called from the emulation thread
+	void onFramesFinished(EmuApp &, int frames);
+	bool runRewindFrame(EmuApp &);
+
+	// hold to continuously step back, one state per saveFrameInterval frames so it plays at normal speed
+	void setRewindHeld(bool held)
+	{
+		if(held)
+			rewindRequested.store(true, std::memory_order::relaxed);
+		rewindHeld.store(held, std::memory_order::relaxed);
+	}
+
+	// returns true while rewinding, stepBack is set when the next state should be restored
+	bool consumeRewindRequest(int frames, bool &stepBack)
+	{
+		if(rewindRequested.exchange(false, std::memory_order::relaxed))
+		{
+			// first step happens right away
+			framesSinceRewind = 0;
+			stepBack = true;
+			return true;
+		}
+		if(!rewindHeld.load(std::memory_order::relaxed))
+			return false;
+		framesSinceRewind += frames;
+		stepBack = framesSinceRewind >= saveFrameInterval();
+		if(stepBack)
+			framesSinceRewind = 0;
+		return true;
+	}
+
+	void updateMaxMemory(size_t max)
+	{
+		maxMemory = max;
+		legacyMaxStates = 0;
+		reset();
+	}
+
+	// set from the UI thread while the emulation thread reads it
+	void updateSaveFrameInterval(uint16_t interval)
+	{
+		saveFrameInterval_.store(std::max(interval, uint16_t{1}), std::memory_order::relaxed);
+	}
+
+	uint16_t saveFrameInterval() const { return saveFrameInterval_.load(std::memory_order::relaxed); }
 
-	void updateMaxStates(size_t max)
+	void updateKeyframeInterval(uint16_t interval)
 	{
-		maxStates = max;
+		keyframeInterval = std::max(interval, uint16_t{1});
 		reset();
 	}
 
 	bool reset(size_t stateSize_)
 	{
 		stateSize = stateSize_;
+		convertLegacyMaxStates();
 		return reset();
 	}
 
 private:
 	struct StateEntry
 	{
-		size_t size{};
-		uint8_t data[];
+		size_t offset{};
+		size_t size{}; // bytes used in the ring
+		size_t stateSize{}; // size of the decoded state
+		bool isKeyframe{};
 	};
 
-	FlexArray<StateEntry> stateEntries;
-	size_t stateIdx{};
+	DynArray<uint8_t> ringBuff;
+	DynArray<uint8_t> stateBuff; // output from writeState() or input to readState()
+	DynArray<uint8_t> keyframeBuff; // copy of the most recent keyframe, zero padded to stateSize
+	DynArray<uint8_t> deltaBuff;
+	std::deque<StateEntry> stateEntries;
+	size_t ringHead{};
+	size_t keyframes{};
+	size_t pendingStateSize{};
+	uint16_t deltasSinceKeyframe{};
+	uint16_t framesSinceSave{};
+	int framesSinceRewind{}; // only used by the emulation thread
+	std::atomic_bool rewindRequested{};
+	std::atomic_bool rewindHeld{};
+	std::thread encodeThread;
+	std::binary_semaphore encodeSem{0};
+	// held by whoever is using the ring and state buffers, the emulation thread
+	// passes it to the encode thread along with a newly captured state
+	std::binary_semaphore ringSem{1};
+	bool quitEncodeThread{};
+	std::atomic<uint16_t> saveFrameInterval_{defaultSaveFrameInterval};
+	uint32_t legacyMaxStates{}; // from CFGKEY_REWIND_STATES, converted once the state size is known
 public:
 	size_t stateSize{};
-	size_t maxStates{};
-	PausableTimer<Seconds> saveTimer;
+	size_t maxMemory{};
+	uint16_t keyframeInterval{defaultKeyframeInterval};
+	static constexpr uint16_t defaultKeyframeInterval{30};
+	static constexpr uint16_t defaultSaveFrameInterval{60};
 
 private:
-	void saveState(EmuApp &);
+	void addState(size_t size);
+	std::span<uint8_t> popState();
+	void freeBuffers();
+	void startEncodeThread();
+	void stopEncodeThread();
+	uint8_t *allocEntry(size_t size, size_t decodedSize, bool isKeyframe);
+	void popOldestKeyframeGroup();
+	void loadLastKeyframe();
+	void convertLegacyMaxStates();
 };
 
 }
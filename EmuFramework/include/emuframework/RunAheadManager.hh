@@ -0,0 +1,71 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <emuframework/config.hh>
+#include <emuframework/EmuSystemTaskContext.hh>
+#include <imagine/time/Time.hh>
+#include <imagine/util/memory/DynArray.hh>
+
+namespace IG
+{
+class MapIO;
+class FileIO;
+}
+
+namespace EmuEx
+{
+
+using namespace IG;
+
+class EmuApp;
+class EmuVideo;
+class EmuAudio;
+
+// Hides input latency built into the emulated game by showing a frame from the future:
+// after the real frame runs, its state is saved, the system runs ahead with the same input
+// and only the last frame is displayed, then the saved state is restored.
+// Only used by systems that set EmuSystem::canRunAhead since it relies on fast serialization.
+
+class RunAheadManager
+{
+public:
+	static constexpr int8_t maxFrames = 4;
+
+	void reset(size_t stateSize);
+	void clear();
+	bool isEnabled() const;
+	bool readConfig(MapIO &, unsigned key, size_t size);
+	void writeConfig(FileIO &) const;
+	int8_t frames() const { return frames_; }
+	void setFrames(int8_t frames);
+
+	// called from the emulation thread, returns false if run-ahead isn't active
+	// and the caller should run the frame normally
+	bool runFrame(EmuApp &, EmuSystemTaskContext, EmuVideo *, EmuAudio *);
+
+private:
+	DynArray<uint8_t> stateBuff;
+	size_t stateSize{};
+	int8_t frames_{};
+	int8_t slowFrames{};
+	bool disabledForSession{};
+
+	void allocBuffer();
+	bool checkSerializationTime(EmuApp &, SteadyClockTime);
+};
+
+}
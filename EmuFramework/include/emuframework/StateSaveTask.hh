@@ -0,0 +1,63 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <emuframework/config.hh>
+#include <imagine/io/FileIO.hh>
+#include <imagine/fs/FSDefs.hh>
+#include <imagine/util/memory/DynArray.hh>
+#include <imagine/util/string/CStringView.hh>
+#include <thread>
+#include <semaphore>
+
+namespace EmuEx
+{
+
+using namespace IG;
+
+class EmuApp;
+
+// Saves states in two stages: an uncompressed snapshot taken on the calling thread with the
+// emulation thread synced, then compression and the file write on a worker thread.
+// Only one save is in flight at a time, a new save waits for the previous one to finish.
+
+class StateSaveTask
+{
+public:
+	StateSaveTask(EmuApp &);
+	~StateSaveTask();
+	void save(CStringView path);
+	void wait();
+
+private:
+	EmuApp &app;
+	std::thread thread;
+	std::binary_semaphore workSem{0};
+	std::binary_semaphore idleSem{1};
+	DynArray<uint8_t> stateBuff;
+	DynArray<uint8_t> compressBuff;
+	FileIO file;
+	FS::PathString tempPath;
+	FS::PathString path;
+	size_t stateSize{};
+	bool needsCompression{};
+	bool quit{};
+
+	void start();
+	void writeFile();
+};
+
+}
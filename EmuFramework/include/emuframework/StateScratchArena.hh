@@ -0,0 +1,104 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/util/compression.hh>
+#include <array>
+#include <vector>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <cstdint>
+
+namespace EmuEx
+{
+
+using namespace IG;
+
+class StateScratchArena;
+
+// Memory borrowed from a StateScratchArena, returned to it when destroyed
+class ScratchBuffer
+{
+public:
+	constexpr ScratchBuffer() = default;
+	ScratchBuffer(StateScratchArena &arena, uint8_t *data, size_t size, size_t capacity):
+		arena{&arena}, data_{data}, size_{size}, capacity{capacity} {}
+	ScratchBuffer(ScratchBuffer &&rhs) noexcept { *this = std::move(rhs); }
+	ScratchBuffer &operator=(ScratchBuffer &&rhs) noexcept
+	{
+		release();
+		arena = std::exchange(rhs.arena, nullptr);
+		data_ = std::exchange(rhs.data_, nullptr);
+		size_ = std::exchange(rhs.size_, 0);
+		capacity = std::exchange(rhs.capacity, 0);
+		return *this;
+	}
+	~ScratchBuffer() { release(); }
+	uint8_t *data() const { return data_; }
+	size_t size() const { return size_; }
+	std::span<uint8_t> span() const { return {data_, size_}; }
+	operator std::span<uint8_t>() const { return span(); }
+	operator std::span<const uint8_t>() const { return span(); }
+	explicit operator bool() const { return data_; }
+
+private:
+	StateScratchArena *arena{};
+	uint8_t *data_{};
+	size_t size_{};
+	size_t capacity{};
+
+	void release();
+};
+
+// Caches the temporary buffers used while reading, writing & compressing states so
+// repeated saves don't hit the system allocator. Blocks are rounded up to power of 2
+// size classes and kept on a free list per class, safe to use from any thread.
+class StateScratchArena
+{
+public:
+	StateScratchArena();
+	StateScratchArena(const StateScratchArena &) = delete;
+	StateScratchArena &operator=(const StateScratchArena &) = delete;
+	~StateScratchArena();
+	ScratchBuffer get(size_t size);
+	// for codec internal allocations, like zlib & LZMA dictionaries
+	const CompressionAllocator *allocator() const { return &compressionAllocator; }
+	// frees all cached blocks
+	void trim();
+
+private:
+	static constexpr int minClassBits = 12; // 4KB
+	static constexpr int maxClassBits = 26; // 64MB, larger blocks aren't cached
+	static constexpr size_t maxCachedBytes = 64 * 1024 * 1024;
+
+	std::mutex mutex;
+	std::array<std::vector<uint8_t*>, maxClassBits - minClassBits + 1> freeBlocks;
+	size_t cachedBytes{};
+	CompressionAllocator compressionAllocator;
+
+	friend class ScratchBuffer;
+	uint8_t *acquire(size_t size, size_t &capacity);
+	void release(uint8_t *block, size_t capacity);
+};
+
+inline void ScratchBuffer::release()
+{
+	if(data_)
+		arena->release(data_, capacity);
+}
+
+}
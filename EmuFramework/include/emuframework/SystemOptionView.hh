@@ -16,6 +16,7 @@
 	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
 
 #include <emuframework/EmuAppHelper.hh>
+#include <emuframework/RunAheadManager.hh>
 #include <imagine/gui/TableView.hh>
 #include <imagine/gui/MenuItem.hh>
 #include <imagine/util/container/ArrayList.hh>
@@ -42,9 +43,18 @@ protected:
 	MultiChoiceMenuItem fastModeSpeed;
 	TextMenuItem slowModeSpeedItem[3];
 	MultiChoiceMenuItem slowModeSpeed;
-	TextMenuItem rewindStatesItem[4];
-	MultiChoiceMenuItem rewindStates;
+	TextMenuItem rewindMemoryItem[4];
+	MultiChoiceMenuItem rewindMemory;
 	DualTextMenuItem rewindTimeInterval;
+	DualTextMenuItem rewindKeyframeInterval;
+	TextMenuItem stateCompressionCodecItem[3];
+	MultiChoiceMenuItem stateCompressionCodec;
+	TextMenuItem stateCompressionLevelItem[4];
+	MultiChoiceMenuItem stateCompressionLevel;
+	TextMenuItem runAheadItem[RunAheadManager::maxFrames + 1];
+	MultiChoiceMenuItem runAhead;
+	TextMenuItem frameDelayItem[8];
+	MultiChoiceMenuItem frameDelay;
 	IG_UseMemberIf(Config::envIsAndroid, BoolMenuItem, performanceMode);
 	IG_UseMemberIf(Config::envIsAndroid && Config::DEBUG_BUILD, BoolMenuItem, noopThread);
 	IG_UseMemberIf(Config::cpuAffinity, TextMenuItem, cpuAffinity);
@@ -35,6 +35,7 @@ MDFN_CDROM_CPPFLAGS = -I$(EMUFRAMEWORK_PATH)/include/shared/lzma \
 
 MDFN_CDROM_SRC := mednafen-emuex/CDImpl.cc \
  mednafen-emuex/ArchiveVFS.cc \
+ mednafen-emuex/CDAudioCache.cc \
  mednafen/cdrom/CDAFReader.cpp \
  mednafen/cdrom/CDAFReader_FLAC.cpp \
  mednafen/cdrom/CDAFReader_MPC.cpp \
@@ -62,6 +62,7 @@ bool AutosaveManager::load(AutosaveActionSource src, LoadAutosaveMode mode)
 		system().loadBackupMemory(app);
 		if(saveOnlyBackupMemory && src == AutosaveActionSource::Auto)
 			return true;
+		app.stateSaveTask.wait();
 		if(!stateIO)
 			stateIO = appContext().openFileUri(statePath(), {}, OpenFlags::createFile());
 		if(stateIO.getExpected<uint8_t>(0)) // check if state contains data
@@ -92,14 +93,17 @@ bool AutosaveManager::load(AutosaveActionSource src, LoadAutosaveMode mode)
 bool AutosaveManager::saveState()
 {
 	log.info("saving autosave state");
-	stateIO.truncate(0);
-	auto state = app.saveState();
-	if(stateIO.write(state.span(), 0).bytes != ssize_t(state.size()))
+	stateIO = {}; // the state file is replaced when the save completes
+	try
+	{
+		app.stateSaveTask.save(statePath());
+		return true;
+	}
+	catch(std::exception &err)
 	{
-		app.postErrorMessage(4, "Error writing autosave state");
+		app.postErrorMessage(4, std::format("Error writing autosave state:\n{}", err.what()));
 		return false;
 	}
-	return true;
 }
 
 bool AutosaveManager::loadState()
@@ -134,6 +138,7 @@ bool AutosaveManager::setSlot(std::string_view name)
 
 bool AutosaveManager::renameSlot(std::string_view name, std::string_view newName)
 {
+	app.stateSaveTask.wait();
 	if(!appContext().renameFileUri(system().contentLocalSaveDirectory(name),
 		system().contentLocalSaveDirectory(newName)))
 	{
@@ -148,6 +153,7 @@ bool AutosaveManager::deleteSlot(std::string_view name)
 {
 	if(name == autoSaveSlot)
 		return false;
+	app.stateSaveTask.wait();
 	auto ctx = appContext();
 	if(!ctx.forEachInDirectoryUri(system().contentLocalSaveDirectory(name),
 			[this, ctx](const FS::directory_entry &e)
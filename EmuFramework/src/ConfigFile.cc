@@ -124,11 +124,15 @@ void EmuApp::saveConfigFile(FileIO &io)
 	writeOptionValueIfNotDefault(io, CFGKEY_VIDEO_PORTRAIT_OFFSET, videoLayer().portraitOffset, 0);
 	writeOptionValueIfNotDefault(io, CFGKEY_FAST_MODE_SPEED, fastModeSpeed, defaultFastModeSpeed);
 	writeOptionValueIfNotDefault(io, CFGKEY_SLOW_MODE_SPEED, slowModeSpeed, defaultSlowModeSpeed);
+	writeOptionValueIfNotDefault(io, CFGKEY_STATE_COMPRESSION_CODEC, system().stateCompressionCodec, CompressionCodec::Gzip);
+	writeOptionValueIfNotDefault(io, CFGKEY_STATE_COMPRESSION_LEVEL, system().stateCompressionLevel, int8_t(defaultCompressionLevel));
 	writeOptionValueIfNotDefault(io, CFGKEY_FRAME_RATE, outputTimingManager.frameTimeOption(VideoSystem::NATIVE_NTSC), OutputTimingManager::autoOption);
 	writeOptionValueIfNotDefault(io, CFGKEY_FRAME_RATE_PAL, outputTimingManager.frameTimeOption(VideoSystem::PAL), OutputTimingManager::autoOption);
 	inputManager.vController.writeConfig(io);
 	autosaveManager_.writeConfig(io);
 	rewindManager.writeConfig(io);
+	runAheadManager.writeConfig(io);
+	frameDelayManager.writeConfig(io);
 	emuAudio.writeConfig(io);
 	emuVideoLayer.writeConfig(io);
 	doIfUsed(overrideScreenFrameRate, [&](auto &rate)
@@ -205,6 +209,10 @@ EmuApp::ConfigParams EmuApp::loadConfigFile(IG::ApplicationContext ctx)
 						return true;
 					if(rewindManager.readConfig(io, key, size))
 						return true;
+					if(runAheadManager.readConfig(io, key, size))
+						return true;
+					if(frameDelayManager.readConfig(io, key, size))
+						return true;
 					if(emuAudio.readConfig(io, key, size))
 						return true;
 					if(recentContent.readConfig(io, key, size, system()))
@@ -248,6 +256,10 @@ EmuApp::ConfigParams EmuApp::loadConfigFile(IG::ApplicationContext ctx)
 				case CFGKEY_CONFIRM_OVERWRITE_STATE: return readOptionValue(io, size, confirmOverwriteState);
 				case CFGKEY_FAST_MODE_SPEED: return readOptionValue(io, size, fastModeSpeed, isValidFastSpeed);
 				case CFGKEY_SLOW_MODE_SPEED: return readOptionValue(io, size, slowModeSpeed, isValidSlowSpeed);
+				case CFGKEY_STATE_COMPRESSION_CODEC:
+					return readOptionValue(io, size, system().stateCompressionCodec, isValidCompressionCodec);
+				case CFGKEY_STATE_COMPRESSION_LEVEL:
+					return readOptionValue(io, size, system().stateCompressionLevel, [](auto l){return l >= defaultCompressionLevel && l <= 9;});
 				#ifdef CONFIG_INPUT_DEVICE_HOTSWAP
 				case CFGKEY_NOTIFY_INPUT_DEVICE_CHANGE: return used(notifyOnInputDeviceChange) ? readOptionValue(io, size, notifyOnInputDeviceChange) : false;
 				#endif
@@ -36,6 +36,7 @@
 #include "configFile.hh"
 #include "EmuOptions.hh"
 #include "pathUtils.hh"
+#include "HeadlessBenchmark.hh"
 #include <imagine/base/ApplicationContext.hh>
 #include <imagine/base/Application.hh>
 #include <imagine/fs/FS.hh>
@@ -53,6 +54,7 @@
 #include <imagine/thread/Thread.hh>
 #include <imagine/bluetooth/BluetoothInputDevScanner.hh>
 #include <imagine/input/android/MogaManager.hh>
+#include <algorithm>
 #include <cmath>
 
 namespace EmuEx
@@ -110,14 +112,14 @@ constexpr bool optionImageZoomIsValid(uint8_t val)
 EmuApp::EmuApp(ApplicationInitParams initParams, ApplicationContext &ctx):
 	Application{initParams},
 	fontManager{ctx},
-	renderer{ctx},
+	renderer{ctx, initParams.headless},
 	audioManager_{ctx},
 	emuAudio{audioManager_},
 	emuVideoLayer{emuVideo, defaultVideoAspectRatio()},
 	emuSystemTask{*this},
 	autosaveManager_{*this},
 	inputManager{ctx},
-	rewindManager{*this},
+	stateSaveTask{*this},
 	pixmapReader{ctx},
 	pixmapWriter{ctx},
 	vibrationManager_{ctx},
@@ -246,15 +248,18 @@ static void suspendEmulation(EmuApp &app)
 		return;
 	app.autosaveManager().save();
 	app.system().flushBackupMemory(app);
+	app.stateSaveTask.wait();
 }
 
 void EmuApp::closeSystem()
 {
 	showUI();
 	emuSystemTask.stop();
+	stateSaveTask.wait();
 	system().closeRuntimeSystem(*this);
 	autosaveManager_.resetSlot();
 	rewindManager.clear();
+	runAheadManager.clear();
 	viewController().onSystemClosed();
 }
 
@@ -299,15 +304,45 @@ void EmuApp::showExitAlert(ViewAttachParams attach, const Input::Event &e)
 		attach, system().hasContent()), e, false);
 }
 
-static const char *parseCommandArgs(IG::CommandArgs arg)
+static std::span<char*> launchArgs(IG::CommandArgs arg)
 {
-	if(arg.c < 2)
+	return std::span{arg.v, size_t(std::max(arg.c, 0))}.subspan(std::min(arg.c, 1));
+}
+
+bool EmuApp::isHeadlessLaunch(IG::CommandArgs arg)
+{
+	return std::ranges::any_of(launchArgs(arg), [](std::string_view str)
 	{
-		return nullptr;
+		return str == "--benchmark" || str.starts_with("--benchmark=");
+	});
+}
+
+static HeadlessBenchmarkParams parseCommandArgs(IG::CommandArgs arg)
+{
+	HeadlessBenchmarkParams params;
+	for(auto argStr : launchArgs(arg))
+	{
+		std::string_view str{argStr};
+		if(str == "--benchmark")
+		{
+			params.frames = defaultHeadlessBenchmarkFrames;
+		}
+		else if(str.starts_with("--benchmark="))
+		{
+			params.frames = std::max(std::atoi(argStr + std::string_view{"--benchmark="}.size()), 1);
+		}
+		else if(str.starts_with("--benchmark-output="))
+		{
+			params.outputPath = argStr + std::string_view{"--benchmark-output="}.size();
+		}
+		else if(!params.contentPath)
+		{
+			params.contentPath = argStr;
+		}
 	}
-	auto launchPath = arg.v[1];
-	log.info("starting content from command line:{}", launchPath);
-	return launchPath;
+	if(params.contentPath && !params.frames)
+		log.info("starting content from command line:{}", params.contentPath);
+	return params;
 }
 
 bool EmuApp::setWindowDrawableConfig(Gfx::DrawableConfig conf)
@@ -443,9 +478,15 @@ void EmuApp::mainInitCommon(IG::ApplicationInitParams initParams, IG::Applicatio
 	system().onOptionsLoaded();
 	loadSystemOptions();
 	updateLegacySavePathOnStoragePath(ctx, system());
-	if(auto launchGame = parseCommandArgs(initParams.commandArgs());
-		launchGame)
-		system().setInitialLoadPath(launchGame);
+	jobSystem.start(JobSystem::threadCountForMask(jobSystemCPUMask(), ctx.cpuCount()));
+	auto launchArgs = parseCommandArgs(initParams.commandArgs());
+	if(launchArgs.frames)
+	{
+		ctx.exit(runHeadlessBenchmark(*this, launchArgs));
+		return;
+	}
+	if(launchArgs.contentPath)
+		system().setInitialLoadPath(launchArgs.contentPath);
 	audioManager().setMusicVolumeControlHint();
 	if(!renderer.supportsColorSpace())
 		windowDrawableConf.colorSpace = {};
@@ -568,6 +609,7 @@ void EmuApp::mainInitCommon(IG::ApplicationInitParams initParams, IG::Applicatio
 					}
 					int interval = frameInterval();
 					auto videoPtr = &this->video();
+					bool lateFrame{};
 					if(frameInfo.advanced + savedAdvancedFrames < interval)
 					{
 						// running at a lower target fps, skip current frames
@@ -590,13 +632,14 @@ void EmuApp::mainInitCommon(IG::ApplicationInitParams initParams, IG::Applicatio
 						else
 						{
 							//log.debug("previous async frame not ready yet");
+							lateFrame = true;
 							doIfUsed(frameTimeStats, [&](auto &stats) { stats.missedFrameCallbacks++; });
 						}
 						win.setDrawEventPriority(Window::drawEventPriorityLocked);
 					}
 					EmuAudio *audioPtr = audio ? &audio : nullptr;
 					runTurboInputEvents();
-					emuSystemTask.runFrame(videoPtr, audioPtr, frameInfo.advanced, skipForward, altSpeed);
+					emuSystemTask.runFrame(videoPtr, audioPtr, frameInfo.advanced, skipForward, altSpeed, params, lateFrame);
 					if(videoPtr)
 					{
 						if(presentationTimeMode == PresentationTimeMode::full ||
@@ -1004,6 +1047,12 @@ void EmuApp::onSystemCreated()
 	{
 		postErrorMessage(4, "Not enough memory for rewind states");
 	}
+	else if(rewindManager.memoryTooSmall())
+	{
+		postErrorMessage(4, RewindManager::memoryTooSmallMessage);
+	}
+	if(EmuSystem::canRunAhead)
+		runAheadManager.reset(system().stateSize());
 	viewController().onSystemCreated();
 }
 
@@ -1135,11 +1184,10 @@ bool EmuApp::saveState(CStringView path)
 		postErrorMessage("System not running");
 		return false;
 	}
-	syncEmulationThread();
 	log.info("saving state {}", path);
 	try
 	{
-		system().saveState(path);
+		stateSaveTask.save(path);
 		return true;
 	}
 	catch(std::exception &err)
@@ -1162,6 +1210,7 @@ bool EmuApp::loadState(CStringView path)
 		return false;
 	}
 	log.info("loading state {}", path);
+	stateSaveTask.wait();
 	syncEmulationThread();
 	try
 	{
@@ -1364,12 +1413,21 @@ bool EmuApp::handleAppActionKeyInput(InputAction action, const Input::Event &src
 		}
 		case rewind:
 		{
-			if(!isPushed)
+			if(!rewindManager.isEnabled())
+			{
+				if(isPushed)
+				{
+					if(rewindManager.memoryTooSmall())
+						postErrorMessage(RewindManager::memoryTooSmallMessage);
+					else
+						postMessage(3, false, "Please set rewind memory in Options➔System");
+				}
 				break;
-			if(rewindManager.maxStates)
+			}
+			if(system().isActive())
+				rewindManager.setRewindHeld(isPushed);
+			else if(isPushed)
 				rewindManager.rewindState(*this);
-			else
-				postMessage(3, false, "Please set rewind states in Options➔System");
 			break;
 		}
 		case softReset:
@@ -1575,6 +1633,16 @@ FrameTimeConfig EmuApp::configFrameTime()
 
 void EmuApp::runFrames(EmuSystemTaskContext taskCtx, EmuVideo *video, EmuAudio *audio, int frames, bool skipForward)
 {
+	if(bool stepBack{}; rewindManager.consumeRewindRequest(frames, stepBack)) [[unlikely]]
+	{
+		// step back one state and show its following frame without audio,
+		// the current frame is shown again until the next step
+		if(stepBack && rewindManager.runRewindFrame(*this))
+			system().runFrame(taskCtx, video, nullptr);
+		else if(video)
+			video->startUnchangedFrame(taskCtx);
+		return;
+	}
 	if(skipForward) [[unlikely]]
 	{
 		if(skipForwardFrames(taskCtx, frames - 1))
@@ -1592,7 +1660,9 @@ void EmuApp::runFrames(EmuSystemTaskContext taskCtx, EmuVideo *video, EmuAudio *
 	{
 		skipFrames(taskCtx, frames - 1, audio);
 	}
-	system().runFrame(taskCtx, video, audio);
+	if(!runAheadManager.runFrame(*this, taskCtx, video, audio))
+		system().runFrame(taskCtx, video, audio);
+	rewindManager.onFramesFinished(*this, frames);
 	system().updateBackupMemoryCounter();
 }
 
@@ -1951,6 +2021,17 @@ void EmuApp::applyCPUAffinity(bool active)
 		(cpuAffinityMode == CPUAffinityMode::Auto ? appContext().performanceCPUMask() : CPUMask(cpuAffinityMask)) : 0;
 	log.info("applying CPU affinity mask {:X}", mask);
 	setThreadCPUAffinityMask(frameThreadGroup, mask);
+	jobSystem.setCPUAffinityMask(mask);
+}
+
+CPUMask EmuApp::jobSystemCPUMask() const
+{
+	// size the pool to the cores the frame threads may run on so small big.LITTLE devices aren't oversubscribed
+	if(!Config::cpuAffinity || cpuAffinityMode == CPUAffinityMode::Any)
+		return 0;
+	if(cpuAffinityMode == CPUAffinityMode::Manual)
+		return doIfUsed(cpuAffinityMask, [](auto mask){ return CPUMask(mask); }, CPUMask{});
+	return appContext().performanceCPUMask();
 }
 
 void EmuApp::setCPUAffinity(int cpuNumber, bool on)
@@ -97,44 +97,14 @@ bool EmuAudio::shouldStartAudioWrites(size_t bytesToWrite) const
 	return rBuff.size() + bytesToWrite >= targetBufferFillBytes;
 }
 
-template<typename T>
-static void simpleResample(T * __restrict__ dest, size_t destFrames, const T * __restrict__ src, size_t srcFrames)
+// Nudges the output rate by up to maxRateDelta to keep the buffer near its fill target,
+// correcting drift between the emulated and device rates without an audible pitch change
+double EmuAudio::rateControlRatio() const
 {
-	if(!destFrames)
-		return;
-	float ratio = (float)srcFrames/(float)destFrames;
-	for(auto i : iotaCount(destFrames))
-	{
-		size_t srcPos = std::floor((float)i * ratio);
-		if(srcPos >= srcFrames) [[unlikely]]
-		{
-			log.info("resample pos {} too high", srcPos);
-			srcPos = srcFrames-1;
-		}
-		dest[i] = src[srcPos];
-	}
-}
-
-static void simpleResample(void *dest, size_t destFrames, const void *src, size_t srcFrames, IG::Audio::Format format)
-{
-	if(format.channels == 1)
-	{
-		if(format.sample.isFloat())
-			simpleResample((uint32_t*)dest, destFrames, (uint32_t*)src, srcFrames);
-		else
-			simpleResample((uint16_t*)dest, destFrames, (uint16_t*)src, srcFrames);
-	}
-	else
-	{
-		if(format.channels != 2)
-		{
-			bug_unreachable("channels == %d", format.channels);
-		}
-		if(format.sample.isFloat())
-			simpleResample((uint64_t*)dest, destFrames, (uint64_t*)src, srcFrames);
-		else
-			simpleResample((uint32_t*)dest, destFrames, (uint32_t*)src, srcFrames);
-	}
+	if(audioWriteState != AudioWriteState::ACTIVE || !targetBufferFillBytes)
+		return 1.;
+	double fill = double(rBuff.size()) / targetBufferFillBytes;
+	return 1. + maxRateDelta * std::clamp(1. - fill, -1., 1.);
 }
 
 void EmuAudio::resizeAudioBuffer(size_t targetBufferFillBytes)
@@ -171,6 +141,7 @@ void EmuAudio::start(FloatSeconds bufferDuration)
 	if(!audioStream.isOpen())
 	{
 		resizeAudioBuffer(targetBufferFillBytes);
+		resampler.reset(inputFormat.sample, inputFormat.channels);
 		audioWriteState = AudioWriteState::BUFFER;
 		IG::Audio::Format outputFormat{inputFormat.rate, audioManager.nativeSampleFormat(), inputFormat.channels};
 		IG::Audio::OutputStreamConfig outputConf
@@ -265,12 +236,18 @@ void EmuAudio::flush()
 	if(audioStream)
 		audioStream.flush();
 	rBuff.clear();
+	resampler.reset(format().sample, channels);
 }
 
 void EmuAudio::writeFrames(const void *samples, size_t framesToWrite)
 {
 	if(!framesToWrite) [[unlikely]]
 		return;
+	if(nullSink) [[unlikely]]
+	{
+		nullSinkFrames_ += framesToWrite;
+		return;
+	}
 	assumeExpr(rBuff);
 	auto inputFormat = format();
 	switch(audioWriteState)
@@ -290,34 +267,18 @@ void EmuAudio::writeFrames(const void *samples, size_t framesToWrite)
 		default:
 		break;
 	}
-	const size_t sampleFrames = framesToWrite;
-	if(speedMultiplier != 1.) [[unlikely]]
-	{
-		framesToWrite = std::ceil((double)framesToWrite / speedMultiplier);
-		framesToWrite = std::max(framesToWrite, 1zu);
-	}
-	auto bytes = inputFormat.framesToBytes(framesToWrite);
-	auto freeBytes = rBuff.freeSpace();
-	if(bytes <= freeBytes)
-	{
-		if(sampleFrames != framesToWrite)
-		{
-			simpleResample(rBuff.writeAddr(), framesToWrite, samples, sampleFrames, inputFormat);
-			rBuff.commitWrite(bytes);
-		}
-		else
-			rBuff.writeUnchecked(samples, bytes);
-	}
-	else
+	auto ratio = rateControlRatio() / speedMultiplier;
+	auto freeFrames = inputFormat.bytesToFrames(rBuff.freeSpace());
+	if(auto outFrames = resampler.outputFrames(framesToWrite, ratio);
+		outFrames > freeFrames) [[unlikely]]
 	{
-		log.info("overrun, only {} out of {} bytes free", freeBytes, bytes);
+		log.info("overrun, only {} out of {} frames free", freeFrames, outFrames);
 		#ifdef CONFIG_EMUFRAMEWORK_AUDIO_STATS
 		audioStats.overruns++;
 		#endif
-		auto freeFrames = inputFormat.bytesToFrames(freeBytes);
-		simpleResample(rBuff.writeAddr(), freeFrames, samples, sampleFrames, inputFormat);
-		rBuff.commitWrite(freeBytes);
 	}
+	auto bytes = inputFormat.framesToBytes(resampler.process(rBuff.writeAddr(), freeFrames, samples, framesToWrite, ratio));
+	rBuff.commitWrite(bytes);
 	if(audioWriteState == AudioWriteState::BUFFER && shouldStartAudioWrites(bytes))
 	{
 		if(Config::DEBUG_BUILD)
@@ -331,6 +292,14 @@ void EmuAudio::writeFrames(const void *samples, size_t framesToWrite)
 	}
 }
 
+// Discards written frames without an output stream and only counts them, used for headless benchmarking
+void EmuAudio::openNullSink()
+{
+	close();
+	nullSink = true;
+	nullSinkFrames_ = 0;
+}
+
 void EmuAudio::setRate(int newRate)
 {
 	assert(newRate <= defaultRate);
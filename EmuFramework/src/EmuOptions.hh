@@ -78,6 +78,10 @@ enum { CFGKEY_SOUND = 0, CFGKEY_TOUCH_CONTROL_DISPLAY = 1,
 	CFGKEY_INPUT_KEY_CONFIGS_V2 = 114, CFGKEY_VCONTROLLER_HIGHLIGHT_PUSHED_BUTTONS = 115,
 	CFGKEY_RECENT_CONTENT_V2 = 116, CFGKEY_MAX_RECENT_CONTENT = 117,
 	CFGKEY_REWIND_STATES = 118, CFGKEY_REWIND_TIMER_SECS = 119,
+	CFGKEY_REWIND_MEMORY = 120, CFGKEY_REWIND_KEYFRAME_INTERVAL = 121,
+	CFGKEY_REWIND_FRAME_INTERVAL = 122, CFGKEY_STATE_COMPRESSION_CODEC = 123,
+	CFGKEY_STATE_COMPRESSION_LEVEL = 124, CFGKEY_RUN_AHEAD_FRAMES = 125,
+	CFGKEY_FRAME_DELAY = 126,
 	// 256+ is reserved
 };
 
@@ -28,7 +28,7 @@
 #include <imagine/util/math.hh>
 #include <imagine/util/ScopeGuard.hh>
 #include <imagine/util/string.h>
-#include <imagine/util/zlib.hh>
+#include <imagine/util/compression.hh>
 #include <imagine/util/format.hh>
 #include <imagine/logger/logger.h>
 #include <algorithm>
@@ -54,6 +54,7 @@ constexpr SystemLogger log{"EmuSystem"};
 [[gnu::weak]] F2Size EmuSystem::validFrameRateRange{minFrameRate, 80.};
 [[gnu::weak]] bool EmuSystem::hasRectangularPixels = false;
 [[gnu::weak]] bool EmuSystem::stateSizeChangesAtRuntime = false;
+[[gnu::weak]] bool EmuSystem::canRunAhead = false;
 
 bool EmuSystem::stateExists(int slot) const
 {
@@ -80,8 +81,10 @@ void EmuSystem::loadState(EmuApp &app, CStringView uri)
 
 void EmuSystem::saveState(CStringView uri)
 {
+	auto stateArr = stateScratchBuffer(stateSize());
+	auto size = writeState(stateArr);
 	auto file = appContext().openFileUri(uri, {}, OpenFlags::newFile());
-	file.write(saveState().span());
+	file.write(stateArr.span().first(size));
 }
 
 DynArray<uint8_t> EmuSystem::saveState()
@@ -91,14 +94,14 @@ DynArray<uint8_t> EmuSystem::saveState()
 	return stateArr;
 }
 
-DynArray<uint8_t> EmuSystem::uncompressGzipState(std::span<uint8_t> buff, size_t expectedSize)
+ScratchBuffer EmuSystem::uncompressState(std::span<uint8_t> buff, size_t expectedSize)
 {
-	assert(hasGzipHeader(buff));
-	auto uncompSize = gzipUncompressedSize(buff);
+	assert(isCompressed(buff));
+	auto uncompSize = uncompressedSize(buff);
 	if(expectedSize && expectedSize != uncompSize)
 		throw std::runtime_error("Invalid state size from header");
-	auto uncompArr = dynArrayForOverwrite<uint8_t>(uncompSize);
-	auto size = uncompressGzip(uncompArr, buff);
+	auto uncompArr = stateScratchBuffer(uncompSize);
+	auto size = uncompress(uncompArr, buff, stateScratch.allocator());
 	if(!size)
 		throw std::runtime_error("Error uncompressing state");
 	if(expectedSize && size != expectedSize)
@@ -106,6 +109,17 @@ DynArray<uint8_t> EmuSystem::uncompressGzipState(std::span<uint8_t> buff, size_t
 	return uncompArr;
 }
 
+size_t EmuSystem::compressStateData(std::span<uint8_t> dest, std::span<const uint8_t> state) const
+{
+	if(auto size = compress(dest, state, stateCompressionCodec, stateCompressionLevel, stateScratch.allocator());
+		size)
+	{
+		return size;
+	}
+	// data didn't compress into the buffer, store it as-is
+	return compress(dest, state, CompressionCodec::None);
+}
+
 void EmuSystem::setSpeedMultiplier(EmuAudio &emuAudio, double speed)
 {
 	emuTiming.setSpeedMultiplier(speed);
@@ -302,7 +316,7 @@ void EmuSystem::pause(EmuApp &app)
 		state = State::PAUSED;
 	app.audio().stop();
 	app.autosaveManager().pauseTimer();
-	app.rewindManager.pauseTimer();
+	app.rewindManager.setRewindHeld(false);
 	onStop();
 }
 
@@ -316,13 +330,15 @@ void EmuSystem::start(EmuApp &app)
 	onStart();
 	app.startAudio();
 	app.autosaveManager().startTimer();
-	if(stateSizeChangesAtRuntime && app.rewindManager.maxStates)
+	if(stateSizeChangesAtRuntime && (app.rewindManager.maxMemory || app.runAheadManager.isEnabled()))
 	{
 		auto newStateSize = stateSize();
-		if(newStateSize != app.rewindManager.stateSize)
+		// also checked when the memory limit was too small for the old size
+		if(app.rewindManager.maxMemory && newStateSize != app.rewindManager.stateSize)
 			app.rewindManager.reset(newStateSize);
+		if(app.runAheadManager.isEnabled())
+			app.runAheadManager.reset(newStateSize);
 	}
-	app.rewindManager.startTimer();
 }
 
 SteadyClockTime EmuSystem::benchmark(EmuVideo &video)
@@ -335,6 +351,21 @@ SteadyClockTime EmuSystem::benchmark(EmuVideo &video)
 	return SteadyClock::now() - before;
 }
 
+// runs one frame per entry of frameTimes and records its time
+SteadyClockTime EmuSystem::benchmark(EmuVideo &video, EmuAudio *audio, std::span<SteadyClockTime> frameTimes)
+{
+	auto before = SteadyClock::now();
+	auto frameStart = before;
+	for(auto &t : frameTimes)
+	{
+		runFrame({}, &video, audio);
+		auto frameEnd = SteadyClock::now();
+		t = frameEnd - frameStart;
+		frameStart = frameEnd;
+	}
+	return frameStart - before;
+}
+
 void EmuSystem::configFrameTime(int outputRate, FrameTime outputFrameTime)
 {
 	if(!hasContent())
@@ -57,6 +57,8 @@ void EmuSystemTask::start()
 							else
 								fastForwardFrames += run.frames;
 							runCmd.skipForward = run.skipForward;
+							runCmd.frameParams = run.frameParams;
+							runCmd.lateFrame |= run.lateFrame;
 							return true;
 						},
 						[&](PauseCommand &)
@@ -82,8 +84,15 @@ void EmuSystemTask::start()
 					return true;
 				assumeExpr(runCmd.frames > 0);
 				//log.debug("running {} frame(s)", runCmd.frames);
+				// more than one queued frame means emulation is already behind, don't delay it further
+				bool delayFrame = runCmd.video && runCmd.frames == 1 && !runCmd.skipForward &&
+					hasTime(runCmd.frameParams.timestamp);
+				if(delayFrame && app.frameDelayManager.waitForFrameStart(runCmd.frameParams, runCmd.lateFrame))
+					app.record(FrameTimeStatEvent::startOfEmulation);
 				app.runFrames({this}, runCmd.video, runCmd.audio,
 					runCmd.frames, runCmd.skipForward);
+				if(delayFrame)
+					app.frameDelayManager.onFrameFinished();
 				return true;
 			});
 			sem.release();
@@ -112,12 +121,13 @@ void EmuSystemTask::stop()
 	app.flushMainThreadMessages();
 }
 
-void EmuSystemTask::runFrame(EmuVideo *video, EmuAudio *audio, int8_t frames, bool skipForward, bool fastForward)
+void EmuSystemTask::runFrame(EmuVideo *video, EmuAudio *audio, int8_t frames, bool skipForward, bool fastForward,
+	FrameParams frameParams, bool lateFrame)
 {
 	assumeExpr(frames > 0);
 	if(!taskThread.joinable()) [[unlikely]]
 		return;
-	commandPort.send({.command = RunFrameCommand{video, audio, frames, skipForward, fastForward}});
+	commandPort.send({.command = RunFrameCommand{video, audio, frameParams, frames, skipForward, fastForward, lateFrame}});
 }
 
 void EmuSystemTask::sendVideoFormatChangedReply(EmuVideo &video)
@@ -54,6 +54,16 @@ bool EmuVideo::hasRendererTask() const
 	return rTask;
 }
 
+// Renders frames into a memory buffer instead of a texture, for running a system without a renderer
+void EmuVideo::setCPUOnly(EmuSystem &sys, IG::ApplicationContext ctx, IG::PixelFormat fmt)
+{
+	assert(!rTask);
+	appCtx = ctx;
+	cpuOnly = true;
+	renderFmt = fmt;
+	sys.onVideoRenderFormatChange(*this, fmt);
+}
+
 static bool isValidRenderFormat(IG::PixelFormat fmt)
 {
 	return fmt == IG::PIXEL_FMT_RGBA8888 ||
@@ -67,7 +77,12 @@ bool EmuVideo::setFormat(IG::PixmapDesc desc, EmuSystemTaskContext taskCtx)
 	{
 		return false; // no change to size/format
 	}
-	if(!vidImg)
+	if(isCPUOnly())
+	{
+		cpuBuff.resetForOverwrite(desc.bytes());
+		cpuDesc = desc;
+	}
+	else if(!vidImg)
 	{
 		Gfx::TextureConfig conf{desc, samplerConfig()};
 		conf.colorSpace = colSpace;
@@ -96,6 +111,8 @@ void EmuVideo::dispatchFormatChanged()
 
 EmuVideoImage EmuVideo::startFrame(EmuSystemTaskContext taskCtx)
 {
+	if(isCPUOnly())
+		return {taskCtx, *this, Gfx::LockedTextureBuffer{nullptr, MutablePixmapView{cpuDesc, cpuBuff.data()}, {}, 0, false}};
 	auto lockedTex = vidImg.lock();
 	return {taskCtx, *this, lockedTex};
 }
@@ -162,6 +179,11 @@ void EmuVideo::finishFrame(EmuSystemTaskContext taskCtx, Gfx::LockedTextureBuffe
 		doScreenshot(taskCtx, texBuff.pixmap());
 	}
 	app().record(FrameTimeStatEvent::aboutToSubmitFrame);
+	if(isCPUOnly())
+	{
+		postFrameFinished(taskCtx);
+		return;
+	}
 	vidImg.unlock(texBuff);
 	postFrameFinished(taskCtx);
 }
@@ -173,7 +195,10 @@ void EmuVideo::finishFrame(EmuSystemTaskContext taskCtx, IG::PixmapView pix)
 		doScreenshot(taskCtx, pix);
 	}
 	app().record(FrameTimeStatEvent::aboutToSubmitFrame);
-	vidImg.write(pix, {.async = true});
+	if(isCPUOnly())
+		MutablePixmapView{cpuDesc, cpuBuff.data()}.write(pix);
+	else
+		vidImg.write(pix, {.async = true});
 	postFrameFinished(taskCtx);
 }
 
@@ -223,6 +248,8 @@ Gfx::Renderer &EmuVideo::renderer() const
 
 IG::ApplicationContext EmuVideo::appContext() const
 {
+	if(!rTask)
+		return appCtx;
 	return rTask->appContext();
 }
 
@@ -247,6 +274,8 @@ void EmuVideoImage::endFrame()
 
 WSize EmuVideo::size() const
 {
+	if(isCPUOnly())
+		return cpuDesc.w() ? cpuDesc.size : WSize{1, 1};
 	if(!vidImg)
 		return {1, 1};
 	else
@@ -255,6 +284,8 @@ WSize EmuVideo::size() const
 
 bool EmuVideo::formatIsEqual(IG::PixmapDesc desc) const
 {
+	if(isCPUOnly())
+		return desc == cpuDesc;
 	return vidImg && desc == vidImg.pixmapDesc();
 }
 
@@ -0,0 +1,111 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <emuframework/FrameDelayManager.hh>
+#include <emuframework/Option.hh>
+#include "EmuOptions.hh"
+#include <imagine/io/MapIO.hh>
+#include <imagine/io/FileIO.hh>
+#include <imagine/logger/logger.h>
+#include <algorithm>
+#include <thread>
+
+namespace EmuEx
+{
+
+constexpr SystemLogger log{"FrameDelayMgr"};
+
+void FrameDelayManager::setOption(int8_t opt)
+{
+	option_ = opt;
+	frameTime = {};
+}
+
+bool FrameDelayManager::waitForFrameStart(FrameParams params, bool lateFrame)
+{
+	runStart = {};
+	if(!option_)
+		return false;
+	if(params.frameTime != frameTime)
+	{
+		// new screen rate or option, start tuning over
+		frameTime = params.frameTime;
+		peakRunTime = {};
+		margin = minMargin;
+		onTimeFrames = 0;
+	}
+	auto delay = option_ == autoOption ? autoDelay(lateFrame) :
+		std::min(SteadyClockTime{Milliseconds{option_}}, frameTime - minMargin);
+	deadline = params.timestamp + frameTime;
+	bool waited = delay > SteadyClockTime{};
+	if(waited)
+		std::this_thread::sleep_until(params.timestamp + delay);
+	runStart = SteadyClock::now();
+	return waited;
+}
+
+void FrameDelayManager::onFrameFinished()
+{
+	if(!hasTime(runStart))
+		return;
+	auto now = SteadyClock::now();
+	// keep the slowest recent run time, decaying so a single slow frame is forgotten
+	peakRunTime = std::max(now - runStart, peakRunTime - peakRunTime / 32);
+	if(option_ == autoOption && now > deadline)
+		backOff();
+}
+
+SteadyClockTime FrameDelayManager::autoDelay(bool lateFrame)
+{
+	if(lateFrame)
+	{
+		backOff();
+	}
+	else if(++onTimeFrames >= recoverFrames)
+	{
+		onTimeFrames = 0;
+		margin = std::max(margin - recoverStep, minMargin);
+	}
+	return std::clamp(frameTime - peakRunTime - margin, SteadyClockTime{}, SteadyClockTime{Milliseconds{maxMilliseconds}});
+}
+
+void FrameDelayManager::backOff()
+{
+	onTimeFrames = 0;
+	if(margin >= frameTime)
+		return;
+	margin = std::min(margin + backoffStep, frameTime);
+	log.debug("missed frame deadline, delay margin now:{}us", duration_cast<Microseconds>(margin).count());
+}
+
+bool FrameDelayManager::readConfig(MapIO &io, unsigned key, size_t size)
+{
+	switch(key)
+	{
+		default: return false;
+		case CFGKEY_FRAME_DELAY: return readOptionValue<int8_t>(io, size, [&](auto ms)
+		{
+			if(ms >= autoOption && ms <= maxMilliseconds)
+				option_ = ms;
+		});
+	}
+}
+
+void FrameDelayManager::writeConfig(FileIO &io) const
+{
+	writeOptionValueIfNotDefault(io, CFGKEY_FRAME_DELAY, option_, int8_t{});
+}
+
+}
@@ -0,0 +1,186 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include "HeadlessBenchmark.hh"
+#include <emuframework/EmuApp.hh>
+#include <emuframework/EmuAudio.hh>
+#include <emuframework/EmuVideo.hh>
+#include <imagine/io/IO.hh>
+#include <imagine/io/FileIO.hh>
+#include <imagine/util/format.hh>
+#include <imagine/logger/logger.h>
+#include <algorithm>
+#include <cstdio>
+
+namespace EmuEx
+{
+
+constexpr SystemLogger log{"HeadlessBenchmark"};
+
+static std::string jsonString(std::string_view str)
+{
+	std::string out{'"'};
+	for(auto c : str)
+	{
+		switch(c)
+		{
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if((unsigned char)c < 0x20)
+					out += std::format("\\u{:04x}", int(c));
+				else
+					out += c;
+		}
+	}
+	out += '"';
+	return out;
+}
+
+static double toMs(SteadyClockTime t) { return duration_cast<FloatSeconds>(t).count() * 1000.; }
+
+static SteadyClockTime percentile(std::span<SteadyClockTime> sortedTimes, double p)
+{
+	auto idx = std::min(size_t(sortedTimes.size() * p), sortedTimes.size() - 1);
+	return sortedTimes[idx];
+}
+
+static bool writeOutput(const char *outputPath, std::string_view json)
+{
+	if(!outputPath)
+	{
+		std::fwrite(json.data(), 1, json.size(), stdout);
+		std::fflush(stdout);
+		return true;
+	}
+	return FileUtils::writeToPath(outputPath, std::span{(const unsigned char*)json.data(), json.size()}) == ssize_t(json.size());
+}
+
+static DynArray<uint8_t> writeUncompressedState(EmuSystem &sys)
+{
+	auto stateArr = dynArrayForOverwrite<uint8_t>(sys.stateSize());
+	stateArr.trim(sys.writeState(stateArr, {.uncompressed = true}));
+	return stateArr;
+}
+
+// Saves a state the way slot saves & autosaves do, loads it back, and checks a new
+// uncompressed save matches the one taken before, repeated for background compression
+static bool stateRoundTripMatches(EmuApp &app)
+{
+	auto &sys = app.system();
+	try
+	{
+		auto loadAndCompare = [&](std::span<const uint8_t> before, DynArray<uint8_t> &saved)
+		{
+			if(!saved.size())
+			{
+				log.error("state save wrote no data");
+				return false;
+			}
+			sys.readState(app, saved);
+			if(!std::ranges::equal(before, writeUncompressedState(sys)))
+			{
+				log.error("state differs after loading it back");
+				return false;
+			}
+			return true;
+		};
+		auto before = writeUncompressedState(sys);
+		auto saved = dynArrayForOverwrite<uint8_t>(sys.stateSize());
+		saved.trim(sys.writeState(saved));
+		if(!loadAndCompare(before, saved))
+			return false;
+		if(sys.canCompressStatesSeparately())
+		{
+			saved = dynArrayForOverwrite<uint8_t>(sys.stateSize());
+			saved.trim(sys.compressState(saved, before));
+			if(!loadAndCompare(before, saved))
+				return false;
+		}
+	}
+	catch(std::exception &err)
+	{
+		log.error("error in state round trip:{}", err.what());
+		return false;
+	}
+	return true;
+}
+
+int runHeadlessBenchmark(EmuApp &app, HeadlessBenchmarkParams params)
+{
+	if(!params.contentPath)
+	{
+		log.error("no content path given for benchmark");
+		std::fputs("error: no content path given for benchmark\n", stderr);
+		return 1;
+	}
+	auto ctx = app.appContext();
+	auto &sys = app.system();
+	auto &video = app.video();
+	auto &audio = app.audio();
+	video.setCPUOnly(sys, ctx, IG::PIXEL_FMT_RGBA8888);
+	// startEmulation() normally installs these, nothing presents the frames here
+	video.setOnFrameFinished([](EmuVideo &){});
+	video.setOnFormatChanged([](EmuVideo &){});
+	audio.openNullSink();
+	app.autosaveManager().resetSlot(noAutosaveName);
+	try
+	{
+		sys.createWithMedia({}, params.contentPath, ctx.fileUriDisplayName(params.contentPath), {},
+			[](int, int, const char*){ return true; });
+	}
+	catch(std::exception &err)
+	{
+		log.error("error loading content:{}", err.what());
+		std::fprintf(stderr, "error loading content: %s\n", err.what());
+		return 1;
+	}
+	sys.configFrameTime(audio.rate(), sys.frameTime());
+	log.info("running {} frames of {}", params.frames, sys.contentDisplayName());
+	auto frameTimes = DynArray<SteadyClockTime>(params.frames);
+	auto totalTime = sys.benchmark(video, &audio, frameTimes);
+	std::ranges::sort(frameTimes);
+	bool stateOK = stateRoundTripMatches(app);
+	auto seconds = duration_cast<FloatSeconds>(totalTime).count();
+	auto json = std::format(
+		"{{\n"
+		"  \"system\": {},\n"
+		"  \"content\": {},\n"
+		"  \"frames\": {},\n"
+		"  \"seconds\": {:.6f},\n"
+		"  \"fps\": {:.3f},\n"
+		"  \"frameTimeP50Ms\": {:.4f},\n"
+		"  \"frameTimeP99Ms\": {:.4f},\n"
+		"  \"frameTimeMaxMs\": {:.4f},\n"
+		"  \"audioRate\": {},\n"
+		"  \"audioFrames\": {},\n"
+		"  \"stateRoundTrip\": {}\n"
+		"}}\n",
+		jsonString(sys.shortSystemName()), jsonString(sys.contentDisplayName()),
+		params.frames, seconds, params.frames / seconds,
+		toMs(percentile(frameTimes, .5)), toMs(percentile(frameTimes, .99)), toMs(frameTimes[params.frames - 1]),
+		audio.rate(), audio.nullSinkFrames(), stateOK);
+	sys.closeRuntimeSystem(app);
+	if(!writeOutput(params.outputPath, json))
+	{
+		log.error("error writing output:{}", params.outputPath);
+		return 1;
+	}
+	return stateOK ? 0 : 1;
+}
+
+}
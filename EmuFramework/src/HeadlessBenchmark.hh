@@ -0,0 +1,39 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+namespace EmuEx
+{
+
+class EmuApp;
+
+// Launched with: --benchmark[=frames] [--benchmark-output=file.json] content
+// Runs the content without a window or renderer and writes the results as JSON,
+// to stdout if no output file is given. Afterwards a save state is loaded back and
+// must match, otherwise the exit code is non-zero.
+struct HeadlessBenchmarkParams
+{
+	const char *contentPath{};
+	const char *outputPath{};
+	int frames{};
+};
+
+constexpr int defaultHeadlessBenchmarkFrames = 1800;
+
+// returns the process exit code
+int runHeadlessBenchmark(EmuApp &, HeadlessBenchmarkParams);
+
+}
\ No newline at end of file
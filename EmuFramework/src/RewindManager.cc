@@ -16,89 +16,362 @@
 #include <emuframework/RewindManager.hh>
 #include <emuframework/EmuApp.hh>
 #include "EmuOptions.hh"
+#include <imagine/util/ScopeGuard.hh>
+#include <imagine/util/math.hh>
 #include <imagine/logger/logger.h>
+#include <algorithm>
+#include <cstring>
+#include <optional>
 
 namespace EmuEx
 {
 
 constexpr SystemLogger log{"RewindMgr"};
-constexpr Seconds defaultSaveFreq{1};
 
-RewindManager::RewindManager(EmuApp &app):
-	saveTimer
+// Delta format is a list of runs: [uint32 unchanged byte count][uint32 changed byte count][changed bytes XOR keyframe].
+// Changed runs only end on a span of at least minUnchangedRun matching bytes to limit header overhead.
+constexpr size_t runHeaderSize = sizeof(uint32_t) * 2;
+constexpr size_t minUnchangedRun = runHeaderSize * 2;
+
+static size_t matchingBytes(const uint8_t *a, const uint8_t *b, size_t size)
+{
+	size_t pos{};
+	for(; pos + sizeof(uint64_t) <= size; pos += sizeof(uint64_t))
+	{
+		uint64_t aWord, bWord;
+		std::memcpy(&aWord, a + pos, sizeof(uint64_t));
+		std::memcpy(&bWord, b + pos, sizeof(uint64_t));
+		if(aWord != bWord)
+			break;
+	}
+	while(pos < size && a[pos] == b[pos])
+		pos++;
+	return pos;
+}
+
+static std::optional<size_t> encodeDelta(std::span<uint8_t> out, std::span<const uint8_t> state, std::span<const uint8_t> keyframe)
+{
+	assumeExpr(state.size() == keyframe.size());
+	const auto size = state.size();
+	size_t outPos{}, pos{};
+	while(pos < size)
 	{
-		defaultSaveFreq,
-		"RewindManager::saveStateTimer",
-		[this, &app]()
+		auto unchanged = matchingBytes(&state[pos], &keyframe[pos], size - pos);
+		pos += unchanged;
+		if(pos == size)
+			break;
+		auto changedStart = pos;
+		while(pos < size)
 		{
-			//log.debug("running rewind save state timer");
-			saveState(app);
-			saveTimer.update();
-			return true;
+			if(state[pos] != keyframe[pos])
+			{
+				pos++;
+				continue;
+			}
+			auto matchSize = matchingBytes(&state[pos], &keyframe[pos], std::min(minUnchangedRun, size - pos));
+			if(matchSize == minUnchangedRun || pos + matchSize == size)
+				break;
+			pos += matchSize;
 		}
-	} {}
+		auto changed = pos - changedStart;
+		if(outPos + runHeaderSize + changed > out.size())
+			return {};
+		uint32_t header[2]{uint32_t(unchanged), uint32_t(changed)};
+		std::memcpy(&out[outPos], header, runHeaderSize);
+		outPos += runHeaderSize;
+		for(auto i : iotaCount(changed))
+		{
+			out[outPos + i] = state[changedStart + i] ^ keyframe[changedStart + i];
+		}
+		outPos += changed;
+	}
+	return outPos;
+}
+
+static void decodeDelta(std::span<uint8_t> state, std::span<const uint8_t> delta)
+{
+	size_t pos{}, deltaPos{};
+	while(deltaPos < delta.size())
+	{
+		uint32_t header[2];
+		std::memcpy(header, &delta[deltaPos], runHeaderSize);
+		deltaPos += runHeaderSize;
+		pos += header[0];
+		assumeExpr(pos + header[1] <= state.size());
+		for(auto i : iotaCount(header[1]))
+		{
+			state[pos + i] ^= delta[deltaPos + i];
+		}
+		pos += header[1];
+		deltaPos += header[1];
+	}
+}
+
+RewindManager::~RewindManager()
+{
+	// wait for any state being encoded like clear() & reset(), otherwise a pending
+	// state and the quit request could both release encodeSem
+	ringSem.acquire();
+	stopEncodeThread();
+	ringSem.release();
+}
 
 void RewindManager::clear()
 {
-	saveTimer.cancel();
-	stateEntries = {};
-	stateIdx = 0;
+	ringSem.acquire();
+	stopEncodeThread();
+	freeBuffers();
 	stateSize = 0;
+	ringSem.release();
 }
 
 bool RewindManager::reset()
 {
 	if(!stateSize)
 		return true;
-	try
+	ringSem.acquire();
+	auto releaseRing = scopeGuard([&]{ ringSem.release(); });
+	stopEncodeThread();
+	freeBuffers();
+	if(maxMemory < stateSize)
 	{
-		if(maxStates)
-			log.info("allocating {} states of size:{}", maxStates, stateSize);
-		stateEntries.reset(maxStates, stateSize);
-		stateIdx = 0;
+		if(maxMemory)
+			log.warn("rewind memory:{} too small for state size:{}", maxMemory, stateSize);
 		return true;
 	}
+	try
+	{
+		log.info("allocating {} bytes for states of size:{}, keyframe interval:{}", maxMemory, stateSize, keyframeInterval);
+		ringBuff.resetForOverwrite(maxMemory);
+		stateBuff.resetForOverwrite(stateSize);
+		keyframeBuff.resetForOverwrite(stateSize);
+		deltaBuff.resetForOverwrite(stateSize);
+	}
 	catch(...)
 	{
+		freeBuffers();
 		return false;
 	}
+	startEncodeThread();
+	return true;
 }
 
-void RewindManager::saveState(EmuApp &app)
+void RewindManager::convertLegacyMaxStates()
 {
-	assumeExpr(maxStates);
-	assumeExpr(stateIdx < maxStates);
-	//log.debug("saving rewind state index:{}", stateIdx);
-	auto &entry = stateEntries[stateIdx];
-	stateIdx = stateIdx + 1 == maxStates ? 0 : stateIdx + 1;
-	entry.size = app.writeState({entry.data, stateSize}, {.uncompressed = true});
+	if(!legacyMaxStates || !stateSize)
+		return;
+	// older versions stored a fixed number of full states, reserve the same amount of memory
+	auto units = std::min(divRoundUp(uint64_t(legacyMaxStates) * stateSize, uint64_t(rewindMemoryUnitSize)),
+		uint64_t(maxRewindMemoryUnits));
+	maxMemory = units * rewindMemoryUnitSize;
+	log.info("converted rewind limit of {} states to {} MiB", legacyMaxStates, units);
+	legacyMaxStates = 0;
 }
 
-void RewindManager::rewindState(EmuApp &app)
+void RewindManager::freeBuffers()
+{
+	ringBuff = {};
+	stateBuff = {};
+	keyframeBuff = {};
+	deltaBuff = {};
+	stateEntries = {};
+	ringHead = 0;
+	keyframes = 0;
+	deltasSinceKeyframe = 0;
+	framesSinceSave = 0;
+}
+
+void RewindManager::startEncodeThread()
+{
+	quitEncodeThread = false;
+	encodeThread = std::thread
+	{
+		[this]()
+		{
+			while(true)
+			{
+				encodeSem.acquire();
+				if(quitEncodeThread)
+					return;
+				addState(pendingStateSize);
+				ringSem.release();
+			}
+		}
+	};
+}
+
+// ringSem must be held so no state is waiting on encodeSem
+void RewindManager::stopEncodeThread()
+{
+	if(!encodeThread.joinable())
+		return;
+	quitEncodeThread = true;
+	encodeSem.release();
+	encodeThread.join();
+}
+
+uint8_t *RewindManager::allocEntry(size_t size, size_t decodedSize, bool isKeyframe)
+{
+	if(size > ringBuff.size())
+		return {};
+	while(stateEntries.size())
+	{
+		auto tail = stateEntries.front().offset;
+		if(ringHead > tail)
+		{
+			if(ringBuff.size() - ringHead >= size)
+				break;
+			if(tail >= size)
+			{
+				ringHead = 0;
+				break;
+			}
+		}
+		else if(tail - ringHead >= size)
+		{
+			break;
+		}
+		// deltas depend on the latest keyframe, so only a new keyframe can evict it
+		if(!isKeyframe && keyframes == 1)
+			return {};
+		popOldestKeyframeGroup();
+	}
+	if(stateEntries.empty())
+		ringHead = 0;
+	auto offset = std::exchange(ringHead, ringHead + size);
+	stateEntries.emplace_back(offset, size, decodedSize, isKeyframe);
+	if(isKeyframe)
+		keyframes++;
+	return &ringBuff[offset];
+}
+
+void RewindManager::popOldestKeyframeGroup()
+{
+	assumeExpr(stateEntries.front().isKeyframe);
+	stateEntries.pop_front();
+	keyframes--;
+	while(stateEntries.size() && !stateEntries.front().isKeyframe)
+	{
+		stateEntries.pop_front();
+	}
+}
+
+void RewindManager::loadLastKeyframe()
 {
-	if(!maxStates)
+	deltasSinceKeyframe = 0;
+	for(const auto &entry : stateEntries | std::views::reverse)
+	{
+		if(entry.isKeyframe)
+		{
+			std::ranges::copy(std::span{&ringBuff[entry.offset], entry.size}, keyframeBuff.begin());
+			std::fill(keyframeBuff.begin() + entry.size, keyframeBuff.end(), 0);
+			return;
+		}
+		deltasSinceKeyframe++;
+	}
+}
+
+void RewindManager::onFramesFinished(EmuApp &app, int frames)
+{
+	if(!isEnabled())
+		return;
+	auto interval = saveFrameInterval();
+	framesSinceSave = std::min(framesSinceSave + frames, int(interval));
+	if(framesSinceSave < interval)
+		return;
+	if(!ringSem.try_acquire()) // previous state is still encoding, retry on the next frame
 		return;
-	assumeExpr(stateIdx < maxStates);
-	auto prevIdx = stateIdx ? stateIdx - 1 : maxStates - 1;
-	auto &entry = stateEntries[prevIdx];
-	if(!entry.size)
+	if(!encodeThread.joinable())
+	{
+		ringSem.release();
 		return;
-	log.info("rewinding to state index:{}", prevIdx);
-	app.readState({entry.data, std::exchange(entry.size, 0)});
-	stateIdx = prevIdx;
-	saveTimer.reset();
+	}
+	framesSinceSave = 0;
+	pendingStateSize = app.system().writeState(stateBuff, {.uncompressed = true});
+	encodeSem.release();
 }
 
-void RewindManager::startTimer()
+void RewindManager::addState(size_t size)
 {
-	if(!stateEntries.size())
+	std::fill(stateBuff.begin() + size, stateBuff.end(), 0);
+	if(keyframes && deltasSinceKeyframe + 1 < keyframeInterval)
+	{
+		auto deltaSize = encodeDelta(deltaBuff, stateBuff.span(), keyframeBuff.span());
+		if(deltaSize)
+		{
+			auto entryData = allocEntry(*deltaSize, size, false);
+			if(entryData)
+			{
+				//log.debug("saved rewind delta of size:{}", *deltaSize);
+				std::copy_n(deltaBuff.data(), *deltaSize, entryData);
+				deltasSinceKeyframe++;
+				return;
+			}
+		}
+	}
+	auto entryData = allocEntry(size, size, true);
+	if(!entryData)
 		return;
-	saveTimer.start();
+	//log.debug("saved rewind keyframe of size:{}", size);
+	std::copy_n(stateBuff.data(), size, entryData);
+	std::swap(stateBuff, keyframeBuff);
+	deltasSinceKeyframe = 0;
 }
 
-void RewindManager::pauseTimer()
+std::span<uint8_t> RewindManager::popState()
 {
-	saveTimer.pause();
+	if(stateEntries.empty())
+		return {};
+	auto entry = stateEntries.back();
+	stateEntries.pop_back();
+	ringHead = stateEntries.size() ? entry.offset : 0;
+	std::span<const uint8_t> entryData{&ringBuff[entry.offset], entry.size};
+	if(entry.isKeyframe)
+	{
+		std::ranges::copy(entryData, stateBuff.begin());
+		keyframes--;
+		loadLastKeyframe();
+	}
+	else
+	{
+		std::ranges::copy(keyframeBuff, stateBuff.begin());
+		decodeDelta(stateBuff, entryData);
+		deltasSinceKeyframe--;
+	}
+	//log.debug("rewinding to {} state, {} remaining", entry.isKeyframe ? "keyframe" : "delta", stateEntries.size());
+	framesSinceSave = 0;
+	return {stateBuff.data(), entry.stateSize};
+}
+
+bool RewindManager::runRewindFrame(EmuApp &app)
+{
+	ringSem.acquire();
+	auto releaseRing = scopeGuard([&]{ ringSem.release(); });
+	auto state = popState();
+	if(state.empty())
+		return false;
+	try
+	{
+		app.system().readState(app, state);
+		return true;
+	}
+	catch(std::exception &err)
+	{
+		log.error("error reading rewind state:{}", err.what());
+		return false;
+	}
+}
+
+void RewindManager::rewindState(EmuApp &app)
+{
+	app.syncEmulationThread();
+	ringSem.acquire();
+	auto releaseRing = scopeGuard([&]{ ringSem.release(); });
+	auto state = popState();
+	if(state.empty())
+		return;
+	log.info("rewinding to state, {} remaining", stateEntries.size());
+	app.readState(state);
 }
 
 bool RewindManager::readConfig(MapIO &io, unsigned key, size_t size)
@@ -106,20 +379,35 @@ bool RewindManager::readConfig(MapIO &io, unsigned key, size_t size)
 	switch(key)
 	{
 		default: return false;
-		case CFGKEY_REWIND_STATES: return readOptionValue<uint32_t>(io, size, [&](auto m){ maxStates = m; });
-		case CFGKEY_REWIND_TIMER_SECS: return readOptionValue<int16_t>(io, size, [&](auto s)
+		case CFGKEY_REWIND_MEMORY: return readOptionValue<uint64_t>(io, size, [&](auto m)
+		{
+			maxMemory = std::min(m, uint64_t(maxRewindMemoryUnits * rewindMemoryUnitSize));
+			legacyMaxStates = 0;
+		});
+		case CFGKEY_REWIND_STATES: return readOptionValue<uint32_t>(io, size, [&](auto m)
+		{
+			if(!maxMemory)
+				legacyMaxStates = m;
+		});
+		case CFGKEY_REWIND_KEYFRAME_INTERVAL: return readOptionValue<uint16_t>(io, size, [&](auto i)
 		{
-			if(s > 0)
-				saveTimer.frequency = Seconds{s};
+			if(i > 0)
+				keyframeInterval = i;
+		});
+		case CFGKEY_REWIND_FRAME_INTERVAL: return readOptionValue<uint16_t>(io, size, [&](auto i)
+		{
+			if(i > 0)
+				updateSaveFrameInterval(i);
 		});
 	}
 }
 
 void RewindManager::writeConfig(FileIO &io) const
 {
-	writeOptionValueIfNotDefault(io, CFGKEY_REWIND_STATES, uint32_t(maxStates), 0u);
-	writeOptionValueIfNotDefault(io, CFGKEY_REWIND_TIMER_SECS, int16_t(saveTimer.frequency.count()), defaultSaveFreq.count());
+	writeOptionValueIfNotDefault(io, CFGKEY_REWIND_MEMORY, uint64_t(maxMemory), uint64_t{});
+	writeOptionValueIfNotDefault(io, CFGKEY_REWIND_STATES, legacyMaxStates, uint32_t{});
+	writeOptionValueIfNotDefault(io, CFGKEY_REWIND_KEYFRAME_INTERVAL, keyframeInterval, defaultKeyframeInterval);
+	writeOptionValueIfNotDefault(io, CFGKEY_REWIND_FRAME_INTERVAL, saveFrameInterval(), defaultSaveFrameInterval);
 }
 
-
 }
@@ -0,0 +1,138 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <emuframework/RunAheadManager.hh>
+#include <emuframework/EmuApp.hh>
+#include "EmuOptions.hh"
+#include <imagine/logger/logger.h>
+
+namespace EmuEx
+{
+
+constexpr SystemLogger log{"RunAheadMgr"};
+
+// number of consecutive frames where saving + restoring the state takes over
+// a quarter of the frame time before run-ahead is turned off for the session
+constexpr int8_t maxSlowFrames = 30;
+
+bool RunAheadManager::isEnabled() const
+{
+	return EmuSystem::canRunAhead && frames_ && !disabledForSession;
+}
+
+void RunAheadManager::reset(size_t stateSize_)
+{
+	stateSize = stateSize_;
+	disabledForSession = false;
+	slowFrames = 0;
+	allocBuffer();
+}
+
+void RunAheadManager::clear()
+{
+	stateBuff = {};
+	stateSize = 0;
+}
+
+void RunAheadManager::setFrames(int8_t frames)
+{
+	frames_ = std::clamp(frames, int8_t{}, maxFrames);
+	disabledForSession = false;
+	slowFrames = 0;
+	allocBuffer();
+}
+
+void RunAheadManager::allocBuffer()
+{
+	if(!isEnabled() || !stateSize)
+	{
+		stateBuff = {};
+		return;
+	}
+	if(stateBuff.size() != stateSize)
+	{
+		log.info("allocating {} bytes for run-ahead state", stateSize);
+		stateBuff.resetForOverwrite(stateSize);
+	}
+}
+
+bool RunAheadManager::checkSerializationTime(EmuApp &app, SteadyClockTime time)
+{
+	if(time <= app.system().frameTime() / 4)
+	{
+		slowFrames = 0;
+		return true;
+	}
+	if(++slowFrames < maxSlowFrames)
+		return true;
+	log.warn("state save/restore took {}, disabling run-ahead", duration_cast<Microseconds>(time));
+	disabledForSession = true;
+	app.runOnMainThread([&app](ApplicationContext)
+	{
+		app.postErrorMessage(4, "Run-ahead disabled, this content is too slow to save & restore each frame");
+	});
+	return false;
+}
+
+bool RunAheadManager::runFrame(EmuApp &app, EmuSystemTaskContext taskCtx, EmuVideo *video, EmuAudio *audio)
+{
+	if(!video || !isEnabled() || !stateBuff.size()) [[likely]]
+		return false;
+	auto &sys = app.system();
+	// the real frame, which produces the audio
+	sys.runFrame(taskCtx, nullptr, audio);
+	auto saveStart = SteadyClock::now();
+	auto size = sys.writeState(stateBuff, {.uncompressed = true});
+	auto saveTime = SteadyClock::now() - saveStart;
+	// frames ahead using the same input, only the last is shown
+	for(int i = 1; i < frames_; i++)
+	{
+		sys.runFrame(taskCtx, nullptr, nullptr);
+	}
+	sys.runFrame(taskCtx, video, nullptr);
+	auto restoreStart = SteadyClock::now();
+	try
+	{
+		sys.readState(app, {stateBuff.data(), size});
+	}
+	catch(std::exception &err)
+	{
+		log.error("error restoring run-ahead state:{}", err.what());
+		disabledForSession = true;
+		return true;
+	}
+	checkSerializationTime(app, saveTime + (SteadyClock::now() - restoreStart));
+	return true;
+}
+
+bool RunAheadManager::readConfig(MapIO &io, unsigned key, size_t size)
+{
+	switch(key)
+	{
+		default: return false;
+		case CFGKEY_RUN_AHEAD_FRAMES: return readOptionValue<int8_t>(io, size, [&](auto f)
+		{
+			if(f >= 0 && f <= maxFrames)
+				frames_ = f;
+		});
+	}
+}
+
+void RunAheadManager::writeConfig(FileIO &io) const
+{
+	writeOptionValueIfNotDefault(io, CFGKEY_RUN_AHEAD_FRAMES, frames_, int8_t{});
+}
+
+}
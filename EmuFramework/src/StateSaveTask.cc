@@ -0,0 +1,139 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+
+#include <emuframework/StateSaveTask.hh>
+#include <emuframework/EmuApp.hh>
+#include <imagine/fs/FS.hh>
+#include <imagine/util/string/uri.hh>
+#include <imagine/util/ScopeGuard.hh>
+#include <imagine/logger/logger.h>
+
+namespace EmuEx
+{
+
+constexpr SystemLogger log{"StateSaveTask"};
+
+StateSaveTask::StateSaveTask(EmuApp &app):
+	app{app} {}
+
+StateSaveTask::~StateSaveTask()
+{
+	if(!thread.joinable())
+		return;
+	idleSem.acquire();
+	quit = true;
+	workSem.release();
+	thread.join();
+}
+
+void StateSaveTask::start()
+{
+	if(thread.joinable())
+		return;
+	thread = std::thread
+	{
+		[this]()
+		{
+			while(true)
+			{
+				workSem.acquire();
+				if(quit)
+					return;
+				writeFile();
+				idleSem.release();
+			}
+		}
+	};
+}
+
+void StateSaveTask::save(CStringView path_)
+{
+	if(!idleSem.try_acquire())
+	{
+		log.info("waiting for previous state save to finish");
+		idleSem.acquire();
+	}
+	auto releaseIdle = scopeGuard([&]{ idleSem.release(); });
+	app.syncEmulationThread();
+	auto &sys = app.system();
+	auto maxSize = sys.stateSize();
+	if(stateBuff.size() < maxSize)
+		stateBuff.resetForOverwrite(maxSize);
+	needsCompression = sys.canCompressStatesSeparately();
+	stateSize = sys.writeState(stateBuff, {.uncompressed = needsCompression});
+	if(needsCompression && compressBuff.size() < maxSize)
+		compressBuff.resetForOverwrite(maxSize);
+	path = path_;
+	auto ctx = app.appContext();
+	if(isUri(path))
+	{
+		// document URIs can't be reliably renamed, write the state in place
+		tempPath.clear();
+		file = ctx.openFileUri(path, {}, OpenFlags::newFile());
+	}
+	else
+	{
+		tempPath = path;
+		tempPath += ".tmp";
+		file = ctx.openFileUri(tempPath, {}, OpenFlags::newFile());
+	}
+	start();
+	releaseIdle.cancel();
+	workSem.release();
+}
+
+void StateSaveTask::writeFile()
+{
+	auto postError = [&](const char *msg)
+	{
+		log.error("{}:{}", msg, path);
+		app.runOnMainThread([&app = app, msg](ApplicationContext)
+		{
+			app.postErrorMessage(4, msg);
+		});
+	};
+	std::span<uint8_t> data{stateBuff.data(), stateSize};
+	if(needsCompression)
+	{
+		data = {compressBuff.data(), app.system().compressState(compressBuff, data)};
+	}
+	auto bytesWritten = data.size() ? file.write(data).bytes : -1;
+	file = {};
+	if(bytesWritten != ssize_t(data.size()))
+	{
+		if(tempPath.size())
+			FS::remove(tempPath);
+		postError("Error writing state file");
+		return;
+	}
+	if(tempPath.size() && !FS::rename(tempPath, path))
+	{
+		FS::remove(tempPath);
+		postError("Error renaming state file");
+		return;
+	}
+	log.info("wrote {} bytes to state:{}", data.size(), path);
+}
+
+void StateSaveTask::wait()
+{
+	if(!thread.joinable())
+		return;
+	idleSem.acquire();
+	idleSem.release();
+}
+
+}
@@ -0,0 +1,124 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <emuframework/StateScratchArena.hh>
+#include <imagine/logger/logger.h>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <cstddef>
+
+namespace EmuEx
+{
+
+constexpr SystemLogger log{"StateScratch"};
+
+// codec allocations store their capacity in front of the returned pointer
+constexpr size_t allocHeaderSize = alignof(std::max_align_t);
+
+StateScratchArena::StateScratchArena():
+	compressionAllocator
+	{
+		.alloc = [](void *ctx, size_t size) -> void*
+		{
+			auto &arena = *static_cast<StateScratchArena*>(ctx);
+			size_t capacity;
+			auto block = arena.acquire(size + allocHeaderSize, capacity);
+			std::memcpy(block, &capacity, sizeof(capacity));
+			return block + allocHeaderSize;
+		},
+		.free = [](void *ctx, void *ptr)
+		{
+			if(!ptr)
+				return;
+			auto &arena = *static_cast<StateScratchArena*>(ctx);
+			auto block = static_cast<uint8_t*>(ptr) - allocHeaderSize;
+			size_t capacity;
+			std::memcpy(&capacity, block, sizeof(capacity));
+			arena.release(block, capacity);
+		},
+		.ctx = this
+	} {}
+
+StateScratchArena::~StateScratchArena()
+{
+	trim();
+}
+
+ScratchBuffer StateScratchArena::get(size_t size)
+{
+	size_t capacity;
+	auto block = acquire(size, capacity);
+	return {*this, block, size, capacity};
+}
+
+void StateScratchArena::trim()
+{
+	std::scoped_lock lock{mutex};
+	for(auto &blocks : freeBlocks)
+	{
+		for(auto b : blocks)
+			delete[] b;
+		blocks.clear();
+	}
+	cachedBytes = 0;
+}
+
+static int sizeClassBits(size_t size, int minBits)
+{
+	return std::max(int(std::bit_width(size - 1)), minBits);
+}
+
+uint8_t *StateScratchArena::acquire(size_t size, size_t &capacity)
+{
+	auto bits = sizeClassBits(std::max(size, size_t(1)), minClassBits);
+	if(bits > maxClassBits)
+	{
+		capacity = size;
+		return new uint8_t[size];
+	}
+	capacity = size_t(1) << bits;
+	{
+		std::scoped_lock lock{mutex};
+		auto &blocks = freeBlocks[bits - minClassBits];
+		if(blocks.size())
+		{
+			auto block = blocks.back();
+			blocks.pop_back();
+			cachedBytes -= capacity;
+			return block;
+		}
+	}
+	return new uint8_t[capacity];
+}
+
+void StateScratchArena::release(uint8_t *block, size_t capacity)
+{
+	auto bits = sizeClassBits(capacity, minClassBits);
+	if(bits <= maxClassBits && capacity == size_t(1) << bits)
+	{
+		std::scoped_lock lock{mutex};
+		if(cachedBytes + capacity <= maxCachedBytes)
+		{
+			freeBlocks[bits - minClassBits].push_back(block);
+			cachedBytes += capacity;
+			return;
+		}
+	}
+	log.debug("freeing uncached block of size:{}", capacity);
+	delete[] block;
+}
+
+}
@@ -183,19 +183,21 @@ SystemOptionView::SystemOptionView(ViewAttachParams attach, bool customMenu):
 			.defaultItemOnSelect = [this](TextMenuItem &item) { app().setAltSpeed(AltSpeedMode::slow, item.id); }
 		},
 	},
-	rewindStatesItem
+	rewindMemoryItem
 	{
 		{"0",  attach, {.id = 0}},
-		{"30", attach, {.id = 30}},
-		{"60", attach, {.id = 60}},
+		{"16", attach, {.id = 16}},
+		{"64", attach, {.id = 64}},
 		{"Custom Value", attach, [this](const Input::Event &e)
 			{
-				app().pushAndShowNewCollectValueRangeInputView<int, 0, 50000>(attachParams(), e,
-					"Input 0 to 50000", std::to_string(app().rewindManager.maxStates),
+				app().pushAndShowNewCollectValueRangeInputView<int, 0, maxRewindMemoryUnits>(attachParams(), e,
+					std::format("Input 0 to {}", maxRewindMemoryUnits), std::to_string(app().rewindManager.maxMemory / rewindMemoryUnitSize),
 					[this](EmuApp &app, auto val)
 					{
-						app.rewindManager.updateMaxStates(val);
-						rewindStates.setSelected(val, *this);
+						app.rewindManager.updateMaxMemory(val * rewindMemoryUnitSize);
+						if(app.rewindManager.memoryTooSmall())
+							app.postErrorMessage(RewindManager::memoryTooSmallMessage);
+						rewindMemory.setSelected(val, *this);
 						dismissPrevious();
 						return true;
 					});
@@ -203,35 +205,136 @@ SystemOptionView::SystemOptionView(ViewAttachParams attach, bool customMenu):
 			}, {.id = defaultMenuId}
 		},
 	},
-	rewindStates
+	rewindMemory
 	{
-		"Rewind States", attach,
-		MenuId{app().rewindManager.maxStates},
-		rewindStatesItem,
+		"Rewind Memory (MiB)", attach,
+		MenuId{app().rewindManager.maxMemory / rewindMemoryUnitSize},
+		rewindMemoryItem,
 		{
 			.onSetDisplayString = [this](auto idx, Gfx::Text &t)
 			{
-				t.resetString(std::format("{}", app().rewindManager.maxStates));
+				t.resetString(std::format("{}", app().rewindManager.maxMemory / rewindMemoryUnitSize));
 				return true;
 			},
-			.defaultItemOnSelect = [this](TextMenuItem &item) { app().rewindManager.updateMaxStates(item.id); }
+			.defaultItemOnSelect = [this](TextMenuItem &item)
+			{
+				app().rewindManager.updateMaxMemory(item.id * rewindMemoryUnitSize);
+				if(app().rewindManager.memoryTooSmall())
+					app().postErrorMessage(RewindManager::memoryTooSmallMessage);
+			}
 		},
 	},
 	rewindTimeInterval
 	{
-		"Rewind State Interval (Seconds)", std::to_string(app().rewindManager.saveTimer.frequency.count()), attach,
+		"Rewind State Interval (Frames)", std::to_string(app().rewindManager.saveFrameInterval()), attach,
 		[this](const Input::Event &e)
 		{
-			app().pushAndShowNewCollectValueRangeInputView<int, 1, 60>(attachParams(), e,
-				"Input 1 to 60", std::to_string(app().rewindManager.saveTimer.frequency.count()),
+			app().pushAndShowNewCollectValueRangeInputView<int, 1, 600>(attachParams(), e,
+				"Input 1 to 600", std::to_string(app().rewindManager.saveFrameInterval()),
 				[this](EmuApp &app, auto val)
 				{
-					app.rewindManager.saveTimer.frequency = Seconds{val};
+					app.rewindManager.updateSaveFrameInterval(val);
 					rewindTimeInterval.set2ndName(std::to_string(val));
 					return true;
 				});
 		}
 	},
+	rewindKeyframeInterval
+	{
+		"Rewind Keyframe Interval (States)", std::to_string(app().rewindManager.keyframeInterval), attach,
+		[this](const Input::Event &e)
+		{
+			app().pushAndShowNewCollectValueRangeInputView<int, 1, 600>(attachParams(), e,
+				"Input 1 to 600", std::to_string(app().rewindManager.keyframeInterval),
+				[this](EmuApp &app, auto val)
+				{
+					app.rewindManager.updateKeyframeInterval(val);
+					rewindKeyframeInterval.set2ndName(std::to_string(val));
+					return true;
+				});
+		}
+	},
+	stateCompressionCodecItem
+	{
+		{"Standard (Gzip)", attach, {.id = CompressionCodec::Gzip}},
+		{"Fast (LZ4)",      attach, {.id = CompressionCodec::LZ4}},
+		{"Max (LZMA)",      attach, {.id = CompressionCodec::LZMA}},
+	},
+	stateCompressionCodec
+	{
+		"Save State Compression", attach,
+		MenuId{system().stateCompressionCodec},
+		stateCompressionCodecItem,
+		{
+			.defaultItemOnSelect = [this](TextMenuItem &item)
+			{
+				system().stateCompressionCodec = CompressionCodec(item.id.val);
+				// LZ4 has no compression levels
+				stateCompressionLevel.setActive(system().stateCompressionCodec != CompressionCodec::LZ4);
+			}
+		},
+	},
+	stateCompressionLevelItem
+	{
+		{"Default",      attach, {.id = defaultCompressionLevel}},
+		{"1 (Fastest)",  attach, {.id = 1}},
+		{"6",            attach, {.id = 6}},
+		{"9 (Smallest)", attach, {.id = 9}},
+	},
+	stateCompressionLevel
+	{
+		"Save State Compression Level", attach,
+		MenuId{system().stateCompressionLevel},
+		stateCompressionLevelItem,
+		{
+			.defaultItemOnSelect = [this](TextMenuItem &item) { system().stateCompressionLevel = item.id; }
+		},
+	},
+	runAheadItem
+	{
+		{"Off", attach, {.id = 0}},
+		{"1",   attach, {.id = 1}},
+		{"2",   attach, {.id = 2}},
+		{"3",   attach, {.id = 3}},
+		{"4",   attach, {.id = 4}},
+	},
+	runAhead
+	{
+		"Run-ahead Frames", attach,
+		MenuId{app().runAheadManager.frames()},
+		runAheadItem,
+		{
+			.defaultItemOnSelect = [this](TextMenuItem &item)
+			{
+				app().syncEmulationThread();
+				app().runAheadManager.setFrames(item.id);
+			}
+		},
+	},
+	frameDelayItem
+	{
+		{"Off",   attach, {.id = 0}},
+		{"Auto",  attach, {.id = FrameDelayManager::autoOption}},
+		{"2ms",   attach, {.id = 2}},
+		{"4ms",   attach, {.id = 4}},
+		{"6ms",   attach, {.id = 6}},
+		{"8ms",   attach, {.id = 8}},
+		{"10ms",  attach, {.id = 10}},
+		{"12ms",  attach, {.id = 12}},
+	},
+	frameDelay
+	{
+		"Frame Delay", attach,
+		MenuId{app().frameDelayManager.option()},
+		frameDelayItem,
+		{
+			.defaultItemOnSelect = [this](TextMenuItem &item)
+			{
+				app().syncEmulationThread();
+				app().frameDelayManager.setOption(item.id);
+			}
+		},
+	},
 	performanceMode
 	{
 		"Performance Mode", attach,
@@ -274,8 +377,15 @@ void SystemOptionView::loadStockItems()
 	item.emplace_back(&confirmOverwriteState);
 	item.emplace_back(&fastModeSpeed);
 	item.emplace_back(&slowModeSpeed);
-	item.emplace_back(&rewindStates);
+	item.emplace_back(&rewindMemory);
 	item.emplace_back(&rewindTimeInterval);
+	item.emplace_back(&rewindKeyframeInterval);
+	item.emplace_back(&stateCompressionCodec);
+	stateCompressionLevel.setActive(system().stateCompressionCodec != CompressionCodec::LZ4);
+	item.emplace_back(&stateCompressionLevel);
+	if(EmuSystem::canRunAhead)
+		item.emplace_back(&runAhead);
+	item.emplace_back(&frameDelay);
 	if(used(performanceMode) && appContext().hasSustainedPerformanceMode())
 		item.emplace_back(&performanceMode);
 	if(used(noopThread))
@@ -0,0 +1,135 @@
+/*  This file is part of EmuFramework.
+
+	EmuFramework is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	EmuFramework is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <mednafen-emuex/CDAudioCache.hh>
+#include <mednafen/cdrom/CDAFReader.h>
+#include <imagine/logger/logger.h>
+#include <algorithm>
+#include <cstring>
+
+namespace Mednafen
+{
+
+constexpr IG::SystemLogger log{"CDAudioCache"};
+
+CDAudioCache::CDAudioCache(unsigned seconds):
+	capacity{std::max(seconds * framesPerSecond, decodeChunkFrames)} {}
+
+CDAudioCache::~CDAudioCache()
+{
+	if(!thread.joinable())
+		return;
+	{
+		std::scoped_lock lock{mutex};
+		exitThread = true;
+	}
+	cond.notify_all();
+	thread.join();
+}
+
+uint64 CDAudioCache::read(CDAFReader &r, uint64 frameOffset, int16 *buf, uint64 frames)
+{
+	{
+		std::unique_lock lock{mutex};
+		if(&r == reader && frameOffset >= startFrame && frameOffset <= startFrame + validFrames)
+		{
+			// frames before this read aren't needed anymore, free them for the decoder
+			validFrames -= frameOffset - startFrame;
+			startFrame = frameOffset;
+			cond.notify_all();
+			// the decoder is already heading here, wait for it instead of seeking away
+			auto gen = generation;
+			cond.wait(lock, [&]{ return generation != gen || atEnd || frames <= validFrames; });
+			if(generation == gen && frames <= validFrames)
+			{
+				auto pos = frameOffset % capacity;
+				auto firstFrames = std::min(frames, capacity - pos);
+				memcpy(buf, &ring[pos * 2], firstFrames * 4);
+				memcpy(buf + firstFrames * 2, &ring[0], (frames - firstFrames) * 4);
+				return frames;
+			}
+		}
+	}
+	uint64 ret;
+	{
+		std::scoped_lock decodeLock{decodeMutex};
+		ret = r.Read(frameOffset, buf, frames);
+	}
+	restart(r, frameOffset + ret);
+	return ret;
+}
+
+void CDAudioCache::hint(CDAFReader &r, uint64 frameOffset)
+{
+	{
+		std::scoped_lock lock{mutex};
+		if(&r == reader && frameOffset >= startFrame && frameOffset <= startFrame + validFrames)
+			return;
+	}
+	restart(r, frameOffset);
+}
+
+void CDAudioCache::restart(CDAFReader &r, uint64 frameOffset)
+{
+	{
+		std::scoped_lock lock{mutex};
+		reader = &r;
+		startFrame = frameOffset;
+		validFrames = 0;
+		atEnd = false;
+		generation++;
+		if(!thread.joinable())
+		{
+			log.info("starting decoder with {} frame ring", capacity);
+			ring = std::make_unique<int16[]>(capacity * 2);
+			thread = std::thread{[this]{ decodeLoop(); }};
+		}
+	}
+	cond.notify_all();
+}
+
+void CDAudioCache::decodeLoop()
+{
+	std::unique_lock lock{mutex};
+	while(true)
+	{
+		cond.wait(lock, [&]{ return exitThread || (!atEnd && validFrames < capacity); });
+		if(exitThread)
+			return;
+		// decode straight into the free part of the ring, only this thread appends to it
+		auto gen = generation;
+		auto r = reader;
+		auto decodePos = startFrame + validFrames;
+		auto ringPos = decodePos % capacity;
+		// publish a single sector first after a restart since the next read is likely waiting on it
+		auto chunkFrames = validFrames ? decodeChunkFrames : sectorFrames;
+		auto frames = std::min({capacity - validFrames, capacity - ringPos, chunkFrames});
+		lock.unlock();
+		uint64 decoded;
+		{
+			std::scoped_lock decodeLock{decodeMutex};
+			decoded = r->Read(decodePos, &ring[ringPos * 2], frames);
+		}
+		lock.lock();
+		if(gen != generation)
+			continue;
+		validFrames += decoded;
+		if(decoded < frames)
+			atEnd = true;
+		cond.notify_all();
+	}
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	EmuFramework is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	EmuFramework is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <mednafen/types.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Mednafen
+{
+
+class CDAFReader;
+
+// Decodes audio tracks on a separate thread into a ring of stereo frames ahead of the
+// last read position, a read outside the decoded range restarts decoding from there
+class CDAudioCache
+{
+public:
+	static constexpr unsigned defaultSeconds = 2;
+
+	CDAudioCache(unsigned seconds);
+	~CDAudioCache();
+	uint64 read(CDAFReader &, uint64 frameOffset, int16 *buf, uint64 frames);
+	void hint(CDAFReader &, uint64 frameOffset);
+
+private:
+	static constexpr uint64 framesPerSecond = 44100;
+	static constexpr uint64 sectorFrames = 588;
+	static constexpr uint64 decodeChunkFrames = sectorFrames * 4;
+
+	std::unique_ptr<int16[]> ring;
+	uint64 capacity; // in frames
+	CDAFReader *reader{};
+	uint64 startFrame{};
+	uint64 validFrames{};
+	uint32 generation{};
+	bool atEnd{};
+	bool exitThread{};
+	std::mutex mutex; // guards the ring state
+	std::mutex decodeMutex; // CDAFReader isn't thread-safe, lock before mutex
+	std::condition_variable cond;
+	std::thread thread;
+
+	void restart(CDAFReader &, uint64 frameOffset);
+	void decodeLoop();
+};
+
+}
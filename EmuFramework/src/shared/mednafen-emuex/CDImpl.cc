@@ -131,7 +131,8 @@ void CDAccess_Image::HintReadSector(int32 lba, int32 count)
 		{
 			if(ct->AReader)
 			{
-				// ignore audio readers, they are read sequentially anyway
+				if(audioCache)
+					audioCache->hint(*ct->AReader, (ct->FileOffset / 4) + (lba - ct->LBA) * 588);
 			}
 			else
 			{
@@ -18,7 +18,7 @@
 #include <imagine/gui/MenuItem.hh>
 #include <imagine/util/format.hh>
 #include <imagine/util/string.h>
-#include <imagine/util/zlib.hh>
+#include <imagine/util/compression.hh>
 #include <emuframework/EmuApp.hh>
 #include <mednafen/types.h>
 #include <mednafen/video/surface.h>
@@ -177,18 +177,16 @@ inline size_t stateSizeMDFN()
 inline void readStateMDFN(EmuApp &app, std::span<uint8_t> buff)
 {
 	using namespace Mednafen;
-	if(hasGzipHeader(buff))
+	if(isCompressed(buff))
 	{
-		MemoryStream s{gzipUncompressedSize(buff), -1};
-		auto outputSize = uncompressGzip({s.map(), size_t(s.size())}, buff);
-		if(!outputSize)
-			throw std::runtime_error("Error uncompressing state");
+		auto uncompArr = app.system().uncompressState(buff);
+		auto outputSize = uncompArr.size();
 		if(outputSize <= 32)
 			throw std::runtime_error("Invalid state size");
-		auto sizeFromHeader = MDFN_de32lsb(s.map() + 16 + 4) & 0x7FFFFFFF;
+		auto sizeFromHeader = MDFN_de32lsb(uncompArr.data() + 16 + 4) & 0x7FFFFFFF;
 		if(sizeFromHeader != outputSize)
 			throw std::runtime_error(std::format("Bad state header size, got {} but expected {}", sizeFromHeader, outputSize));
-		s.setSize(outputSize);
+		FileStream s{uncompArr};
 		MDFNSS_LoadSM(&s);
 	}
 	else
@@ -198,7 +196,7 @@ inline void readStateMDFN(EmuApp &app, std::span<uint8_t> buff)
 	}
 }
 
-inline size_t writeStateMDFN(std::span<uint8_t> buff, SaveStateFlags flags)
+inline size_t writeStateMDFN(const EmuSystem &sys, std::span<uint8_t> buff, SaveStateFlags flags)
 {
 	using namespace Mednafen;
 	if(flags.uncompressed)
@@ -209,9 +207,11 @@ inline size_t writeStateMDFN(std::span<uint8_t> buff, SaveStateFlags flags)
 	}
 	else
 	{
-		MemoryStream s;
+		// the header size is patched after writing so the state can't be compressed as it's written
+		auto stateArr = sys.stateScratchBuffer(buff.size());
+		FileStream s{stateArr};
 		MDFNSS_SaveSM(&s);
-		return compressGzip(buff, {s.map(), size_t(s.size())}, MDFN_GetSettingI("filesys.state_comp_level"));
+		return sys.compressStateData(buff, stateArr.span().first(s.tell()));
 	}
 }
 
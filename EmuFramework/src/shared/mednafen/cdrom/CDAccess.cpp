@@ -35,7 +35,7 @@ CDAccess::CDAccess()
 
 }
 
-CDAccess* CDAccess_Open(VirtualFS* vfs, const std::string& path, bool image_memcache)
+CDAccess* CDAccess_Open(VirtualFS* vfs, const std::string& path, bool image_memcache, unsigned audioCacheSeconds)
 {
  CDAccess *ret = NULL;
 
@@ -47,7 +47,7 @@ CDAccess* CDAccess_Open(VirtualFS* vfs, const std::string& path, bool image_memc
  if(vfs->test_ext(path, ".chd"))
   ret = new CDAccess_CHD(vfs, path, image_memcache);
  else
-  ret = new CDAccess_Image(vfs, path, image_memcache);
+  ret = new CDAccess_Image(vfs, path, image_memcache, audioCacheSeconds);
 
  return ret;
 }
@@ -53,7 +53,8 @@ class CDAccess
  CDAccess& operator=(const CDAccess&); // No assignment operator.
 };
 
-CDAccess* CDAccess_Open(VirtualFS* vfs, const std::string& path, bool image_memcache);
+// audioCacheSeconds sizes the decode-ahead cache of compressed audio tracks, 0 disables it
+CDAccess* CDAccess_Open(VirtualFS* vfs, const std::string& path, bool image_memcache, unsigned audioCacheSeconds);
 
 }
 #endif
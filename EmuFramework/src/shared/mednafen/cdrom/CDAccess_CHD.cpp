@@ -23,6 +23,7 @@
 #include <mednafen/general.h>
 
 #include <stdio.h>
+#include <algorithm>
 
 #include "CDAccess_CHD.h"
 
@@ -83,8 +84,12 @@ void CDAccess_CHD::Load(VirtualFS* vfs, const std::string &path, bool image_memc
 
   /* allocate storage for sector reads */
   const chd_header *head = chd_get_header(chd);
-  hunkmem = (uint8_t *)malloc(head->hunkbytes);
-  oldhunk = -1;
+  hunkbytes = head->hunkbytes;
+  totalhunks = head->totalhunks;
+  sectors_per_hunk = hunkbytes / (2352 + 96);
+  readBuf = std::make_unique<uint8_t[]>(hunkbytes);
+  for (auto &h : hunkCache)
+    h.data = std::make_unique<uint8_t[]>(hunkbytes);
 
   MDFN_printf("chd_load '%s' hunkbytes=%d\n", path.c_str(), head->hunkbytes);
 
@@ -209,87 +214,143 @@ void CDAccess_CHD::Load(VirtualFS* vfs, const std::string &path, bool image_memc
       assert(Tracks[x].index[i] >= 0);
     }
   }
+
+  prefetchThread = std::thread{[this]() { PrefetchThread(); }};
 }
 
 CDAccess_CHD::~CDAccess_CHD()
 {
+  if (prefetchThread.joinable())
+  {
+    {
+      std::lock_guard lock{cacheMutex};
+      prefetchExit = true;
+    }
+    prefetchCond.notify_one();
+    prefetchThread.join();
+  }
+
   if (chd != NULL)
     chd_close(chd);
+}
 
-  if (hunkmem)
-    free(hunkmem);
+bool CDAccess_CHD::CopyCachedHunk(int hunknum, uint32_t offset, uint8_t *buf, uint32_t size)
+{
+  std::lock_guard lock{cacheMutex};
+  for (auto &h : hunkCache)
+  {
+    if (h.hunknum == hunknum)
+    {
+      h.lastUse = ++hunkUseCounter;
+      memcpy(buf, h.data.get() + offset, size);
+      return true;
+    }
+  }
+  return false;
 }
 
-bool CDAccess_CHD::Read_CHD_Hunk_RAW(uint8_t *buf, int32_t lba, CHDFILE_TRACK_INFO* track)
+void CDAccess_CHD::InsertCachedHunk(int hunknum, const uint8_t *data)
 {
-  const chd_header *head = chd_get_header(chd);
-  int cad = lba - track->LBA + track->fileOffset;
-  int sph = head->hunkbytes / (2352 + 96);
-  int hunknum = cad / sph; //(cad * head->unitbytes) / head->hunkbytes;
-  int hunkofs = cad % sph; //(cad * head->unitbytes) % head->hunkbytes;
-  int err = CHDERR_NONE;
+  std::lock_guard lock{cacheMutex};
+  CachedHunk *slot = &hunkCache[0];
+  for (auto &h : hunkCache)
+  {
+    if (h.hunknum == hunknum)
+      return;
+    if (h.lastUse < slot->lastUse)
+      slot = &h;
+  }
+  memcpy(slot->data.get(), data, hunkbytes);
+  slot->hunknum = hunknum;
+  slot->lastUse = ++hunkUseCounter;
+}
 
-  /* each hunk holds ~8 sectors, optimize when reading contiguous sectors */
-  if (hunknum != oldhunk)
+void CDAccess_CHD::RequestPrefetch(int hunknum, int count)
+{
   {
-    err = chd_read(chd, hunknum, hunkmem);
-    if (err != CHDERR_NONE)
-    	MDFN_printf("chd_read_sector failed lba=%d error=%d\n", lba, err);
-    else
-      oldhunk = hunknum;
+    std::lock_guard lock{cacheMutex};
+    int end = std::min(hunknum + count, totalhunks);
+    // already working on this range
+    if (hunknum >= prefetchNext && end <= prefetchEnd)
+      return;
+    prefetchNext = hunknum;
+    prefetchEnd = end;
   }
+  prefetchCond.notify_one();
+}
 
-  memcpy(buf, hunkmem + hunkofs * (2352 + 96), 2352);
+void CDAccess_CHD::PrefetchThread(void)
+{
+  auto buf = std::make_unique<uint8_t[]>(hunkbytes);
+  std::unique_lock lock{cacheMutex};
+  while (true)
+  {
+    prefetchCond.wait(lock, [&]() { return prefetchExit || prefetchNext < prefetchEnd; });
+    if (prefetchExit)
+      return;
+    int hunknum = prefetchNext++;
+    bool cached = false;
+    for (auto &h : hunkCache)
+      cached |= h.hunknum == hunknum;
+    if (cached)
+      continue;
+    lock.unlock();
+    {
+      std::lock_guard chdLock{chdMutex};
+      if (chd_read(chd, hunknum, buf.get()) == CHDERR_NONE)
+        InsertCachedHunk(hunknum, buf.get());
+    }
+    lock.lock();
+  }
+}
 
-  return err;
+int32_t CDAccess_CHD::HunkForLBA(int32_t lba, const CHDFILE_TRACK_INFO* track) const
+{
+  return (lba - track->LBA + track->fileOffset) / sectors_per_hunk;
 }
 
-bool CDAccess_CHD::Read_CHD_Hunk_M1(uint8_t *buf, int32_t lba, CHDFILE_TRACK_INFO* track)
+bool CDAccess_CHD::Read_CHD_Hunk(uint8_t *buf, int32_t lba, CHDFILE_TRACK_INFO* track, uint32_t size)
 {
-  const chd_header *head = chd_get_header(chd);
   int cad = lba - track->LBA + track->fileOffset;
-  int sph = head->hunkbytes / (2352 + 96);
-  int hunknum = cad / sph; //(cad * head->unitbytes) / head->hunkbytes;
-  int hunkofs = cad % sph; //(cad * head->unitbytes) % head->hunkbytes;
+  int hunknum = cad / sectors_per_hunk;
+  uint32_t hunkofs = (cad % sectors_per_hunk) * (2352 + 96);
   int err = CHDERR_NONE;
 
-  /* each hunk holds ~8 sectors, optimize when reading contiguous sectors */
-  if (hunknum != oldhunk)
+  if (!CopyCachedHunk(hunknum, hunkofs, buf, size))
   {
-    err = chd_read(chd, hunknum, hunkmem);
-    if (err != CHDERR_NONE)
-    	MDFN_printf("chd_read_sector failed lba=%d error=%d\n", lba, err);
-    else
-      oldhunk = hunknum;
+    std::lock_guard chdLock{chdMutex};
+    // the prefetcher may have finished it while waiting for the lock
+    if (!CopyCachedHunk(hunknum, hunkofs, buf, size))
+    {
+      err = chd_read(chd, hunknum, readBuf.get());
+      if (err != CHDERR_NONE)
+        MDFN_printf("chd_read_sector failed lba=%d error=%d\n", lba, err);
+      else
+      {
+        InsertCachedHunk(hunknum, readBuf.get());
+        memcpy(buf, readBuf.get() + hunkofs, size);
+      }
+    }
   }
 
-  memcpy(buf + 16, hunkmem + hunkofs * (2352 + 96), 2048);
+  // reads are mostly sequential, keep the following hunks ready
+  RequestPrefetch(hunknum + 1, PrefetchHunks);
 
-  return err;
+  return err == CHDERR_NONE;
 }
 
-bool CDAccess_CHD::Read_CHD_Hunk_M2(uint8_t *buf, int32_t lba, CHDFILE_TRACK_INFO* track)
+void CDAccess_CHD::HintReadSector(int32 lba, int32 count)
 {
-  const chd_header *head = chd_get_header(chd);
-  int cad = lba - track->LBA + track->fileOffset;
-  int sph = head->hunkbytes / (2352 + 96);
-  int hunknum = cad / sph; //(cad * head->unitbytes) / head->hunkbytes;
-  int hunkofs = cad % sph; //(cad * head->unitbytes) % head->hunkbytes;
-  int err = CHDERR_NONE;
-
-  /* each hunk holds ~8 sectors, optimize when reading contiguous sectors */
-  if (hunknum != oldhunk)
+  for (int32_t track = FirstTrack; track < (FirstTrack + NumTracks); track++)
   {
-    err = chd_read(chd, hunknum, hunkmem);
-    if (err != CHDERR_NONE)
-    	MDFN_printf("chd_read_sector failed lba=%d error=%d\n", lba, err);
-    else
-      oldhunk = hunknum;
+    const CHDFILE_TRACK_INFO *ct = &Tracks[track];
+    if (lba >= (ct->LBA - ct->pregap_dv) && lba < (ct->LBA + ct->sectors))
+    {
+      int32_t hunks = (std::max(count, 1) + sectors_per_hunk - 1) / sectors_per_hunk;
+      RequestPrefetch(HunkForLBA(lba, ct), std::max(hunks, PrefetchHunks));
+      return;
+    }
   }
-
-  memcpy(buf + 16, hunkmem + hunkofs * (2352 + 96), 2336);
-
-  return err;
 }
 
 int CDAccess_CHD::Read_Raw_Sector(uint8 *buf, int32 lba)
@@ -377,24 +438,24 @@ int CDAccess_CHD::Read_Raw_Sector(uint8 *buf, int32 lba)
       switch (ct->DIFormat)
       {
       case DI_FORMAT_AUDIO:
-        Read_CHD_Hunk_RAW(buf, lba, ct);
+        Read_CHD_Hunk(buf, lba, ct, 2352);
         if (ct->RawAudioMSBFirst)
           Endian_A16_Swap(buf, 588 * 2);
         break;
 
       case DI_FORMAT_MODE1:
-        Read_CHD_Hunk_M1(buf, lba, ct);
+        Read_CHD_Hunk(buf + 16, lba, ct, 2048);
         encode_mode1_sector(lba + 150, buf);
         break;
 
       case DI_FORMAT_MODE1_RAW:
       case DI_FORMAT_MODE2_RAW:
       case DI_FORMAT_CDI_RAW:
-        Read_CHD_Hunk_RAW(buf, lba, ct);
+        Read_CHD_Hunk(buf, lba, ct, 2352);
         break;
 
       case DI_FORMAT_MODE2:
-        Read_CHD_Hunk_M2(buf, lba, ct);
+        Read_CHD_Hunk(buf + 16, lba, ct, 2336);
         encode_mode2_sector(lba + 150, buf);
         break;
 
@@ -24,6 +24,11 @@
 
 #include "CDAccess.h"
 #include <libchdr/chd.h>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 namespace Mednafen
 {
@@ -66,7 +71,7 @@ class CDAccess_CHD final : public CDAccess
 
  void Read_TOC(CDUtility::TOC *toc) final;
 
- void HintReadSector(int32 lba, int32 count) final {};
+ void HintReadSector(int32 lba, int32 count) final;
 
  int Read_Sector(uint8 *buf, int32 lba, uint32 size) final;
 
@@ -78,9 +83,14 @@ class CDAccess_CHD final : public CDAccess
   // MakeSubPQ will OR the simulated P and Q subchannel data into SubPWBuf.
   int32_t MakeSubPQ(int32_t lba, uint8_t *SubPWBuf) const;
 
-  bool Read_CHD_Hunk_RAW(uint8_t *buf, int32_t lba, CHDFILE_TRACK_INFO* track);
-  bool Read_CHD_Hunk_M1(uint8_t *buf, int32_t lba, CHDFILE_TRACK_INFO* track);
-  bool Read_CHD_Hunk_M2(uint8_t *buf, int32_t lba, CHDFILE_TRACK_INFO* track);
+  // Copies size bytes of the sector at lba, starting from its first byte
+  bool Read_CHD_Hunk(uint8_t *buf, int32_t lba, CHDFILE_TRACK_INFO* track, uint32_t size);
+  int32_t HunkForLBA(int32_t lba, const CHDFILE_TRACK_INFO* track) const;
+
+  bool CopyCachedHunk(int hunknum, uint32_t offset, uint8_t *buf, uint32_t size);
+  void InsertCachedHunk(int hunknum, const uint8_t *data);
+  void RequestPrefetch(int hunknum, int count);
+  void PrefetchThread(void);
 
   int32_t NumTracks;
   int32_t FirstTrack;
@@ -97,10 +107,31 @@ class CDAccess_CHD final : public CDAccess
   int num_tracks;
 
   chd_file *chd;
-  /* hunk data cache */
-  uint8_t *hunkmem;
-  /* last hunknum read */
-  int oldhunk;
+  uint32_t hunkbytes;
+  int32_t totalhunks;
+  int32_t sectors_per_hunk;
+
+  // Recently decompressed hunks, the least recently used one gets replaced
+  struct CachedHunk
+  {
+    int hunknum = -1;
+    uint32_t lastUse = 0;
+    std::unique_ptr<uint8_t[]> data;
+  };
+  static constexpr int HunkCacheSize = 32;
+  // hunks decompressed ahead of the last read or hinted sector
+  static constexpr int PrefetchHunks = 8;
+  std::array<CachedHunk, HunkCacheSize> hunkCache;
+  uint32_t hunkUseCounter = 0;
+  std::mutex cacheMutex; // guards hunkCache & the prefetch range
+  std::mutex chdMutex; // chd_read() isn't re-entrant, lock before cacheMutex
+  std::unique_ptr<uint8_t[]> readBuf;
+
+  std::thread prefetchThread;
+  std::condition_variable prefetchCond;
+  int prefetchNext = 0;
+  int prefetchEnd = 0;
+  bool prefetchExit = false;
 };
 
 }
@@ -45,6 +45,7 @@
 #include <imagine/util/string.h>
 
 #include <map>
+#include <algorithm>
 
 namespace Mednafen
 {
@@ -968,7 +969,7 @@ void CDAccess_Image::Cleanup(void)
  }
 }
 
-CDAccess_Image::CDAccess_Image(VirtualFS* vfs, const std::string& path, bool image_memcache) : NumTracks(0), FirstTrack(0), LastTrack(0), total_sectors(0)
+CDAccess_Image::CDAccess_Image(VirtualFS* vfs, const std::string& path, bool image_memcache, unsigned audioCacheSeconds) : NumTracks(0), FirstTrack(0), LastTrack(0), total_sectors(0)
 {
  try
  {
@@ -978,6 +979,9 @@ CDAccess_Image::CDAccess_Image(VirtualFS* vfs, const std::string& path, bool ima
   }
   else
    ImageOpen(vfs, path, image_memcache);
+
+  if(audioCacheSeconds && std::any_of(std::begin(Tracks), std::end(Tracks), [](auto &t){ return t.AReader; }))
+   audioCache = std::make_unique<CDAudioCache>(audioCacheSeconds);
  }
  catch(...)
  {
@@ -988,6 +992,7 @@ CDAccess_Image::CDAccess_Image(VirtualFS* vfs, const std::string& path, bool ima
 
 CDAccess_Image::~CDAccess_Image()
 {
+ audioCache.reset();
  Cleanup();
 }
 
@@ -1079,7 +1084,9 @@ int CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
    if(ct->AReader)
    {
     int16 AudioBuf[588 * 2];
-    uint64 frames_read = ct->AReader->Read((ct->FileOffset / 4) + (lba - ct->LBA) * 588, AudioBuf, 588);
+    uint64 frame_offset = (ct->FileOffset / 4) + (lba - ct->LBA) * 588;
+    uint64 frames_read = audioCache ? audioCache->read(*ct->AReader, frame_offset, AudioBuf, 588)
+     : ct->AReader->Read(frame_offset, AudioBuf, 588);
 
     ct->LastSamplePos += frames_read;
 
@@ -1,7 +1,9 @@
 #ifndef __MDFN_CDACCESS_IMAGE_H
 #define __MDFN_CDACCESS_IMAGE_H
 
+#include <mednafen-emuex/CDAudioCache.hh>
 #include <map>
+#include <memory>
 
 namespace Mednafen
 {
@@ -66,7 +68,7 @@ class CDAccess_Image final: public CDAccess
 {
  public:
 
- CDAccess_Image(VirtualFS* vfs, const std::string& path, bool image_memcache);
+ CDAccess_Image(VirtualFS* vfs, const std::string& path, bool image_memcache, unsigned audioCacheSeconds);
  ~CDAccess_Image() final;
 
  int Read_Raw_Sector(uint8 *buf, int32 lba) final;
@@ -93,6 +95,8 @@ class CDAccess_Image final: public CDAccess
 
  std::string base_dir;
 
+ std::unique_ptr<CDAudioCache> audioCache;
+
  void ImageOpen(VirtualFS* vfs, const std::string& path, bool image_memcache);
  void ImageOpenBinary(VirtualFS* vfs, const std::string& path, bool isIso);
  void LoadSBI(VirtualFS* vfs, const std::string& sbi_path);
@@ -227,7 +227,7 @@ Stream *CDInterface::MakeStream(int32 lba, uint32 sector_count)
 }
 
 
-CDInterface* CDInterface::Open(VirtualFS* vfs, const std::string& path, bool image_memcache, const uint64 affinity)
+CDInterface* CDInterface::Open(VirtualFS* vfs, const std::string& path, bool image_memcache, const uint64 affinity, unsigned audioCacheSeconds)
 {
  //
  // Don't allow a custom VirtualFS implementation unless CD image memory caching is enabled, due to thread
@@ -241,7 +241,7 @@ CDInterface* CDInterface::Open(VirtualFS* vfs, const std::string& path, bool ima
  //
  //
  //
- std::unique_ptr<CDAccess> cda(CDAccess_Open(vfs, path, image_memcache));
+ std::unique_ptr<CDAccess> cda(CDAccess_Open(vfs, path, image_memcache, audioCacheSeconds));
 
  if(image_memcache)
   return new CDInterface_ST(std::move(cda));
@@ -41,7 +41,7 @@ class CDInterface
  // the CDInterface object is deleted.  If "image_memcache" is true, then the VirtualFS object
  // only needs to remain valid until Open() returns.
  //
- static CDInterface* Open(VirtualFS* vfs, const std::string& path, bool image_memcache, const uint64 affinity);
+ static CDInterface* Open(VirtualFS* vfs, const std::string& path, bool image_memcache, const uint64 affinity, unsigned audioCacheSeconds);
 
  CDInterface();
  virtual ~CDInterface();
@@ -20,7 +20,7 @@
 #include <imagine/io/FileIO.hh>
 #include <imagine/util/format.hh>
 #include <imagine/util/string.h>
-#include <imagine/util/zlib.hh>
+#include <imagine/util/compression.hh>
 #include <vbam/gba/GBA.h>
 #include <vbam/gba/GBAGfx.h>
 #include <vbam/gba/Sound.h>
@@ -37,6 +37,7 @@ const char *EmuSystem::creditsViewStr = CREDITS_INFO_STRING "(c) 2012-2024\nRobe
 bool EmuSystem::hasBundledGames = true;
 bool EmuSystem::hasCheats = true;
 bool EmuApp::needsGlobalInstance = true;
+bool EmuSystem::canRunAhead = true;
 constexpr WSize lcdSize{240, 160};
 
 EmuSystem::NameFilterFunc EmuSystem::defaultFsFilter =
@@ -81,10 +82,10 @@ FS::FileString GbaSystem::stateFilename(int slot, std::string_view name) const
 
 void GbaSystem::readState(EmuApp &app, std::span<uint8_t> buff)
 {
-	DynArray<uint8_t> uncompArr;
-	if(hasGzipHeader(buff))
+	ScratchBuffer uncompArr;
+	if(isCompressed(buff))
 	{
-		uncompArr = uncompressGzipState(buff, saveStateSize);
+		uncompArr = uncompressState(buff, saveStateSize);
 		buff = uncompArr;
 	}
 	if(!CPUReadState(gGba, buff.data()))
@@ -101,12 +102,17 @@ size_t GbaSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags)
 	else
 	{
 		assert(saveStateSize);
-		auto stateArr = DynArray<uint8_t>(saveStateSize);
+		auto stateArr = stateScratchBuffer(saveStateSize);
 		CPUWriteState(gGba, stateArr.data());
-		return compressGzip(buff, stateArr, Z_DEFAULT_COMPRESSION);
+		return compressState(buff, stateArr);
 	}
 }
 
+size_t GbaSystem::compressState(std::span<uint8_t> dest, std::span<const uint8_t> state) const
+{
+	return compressStateData(dest, state);
+}
+
 void GbaSystem::loadBackupMemory(EmuApp &app)
 {
 	if(coreOptions.saveType == GBA_SAVE_NONE)
@@ -273,12 +279,12 @@ void systemDrawScreen(EmuEx::EmuSystemTaskContext taskCtx, EmuEx::EmuVideo &vide
 	assumeExpr(img.pixmap().size() == framePix.size());
 	if(img.pixmap().format() == IG::PIXEL_FMT_RGB565)
 	{
-		img.pixmap().writeTransformed([](uint16_t p){ return systemColorMap.map16[p]; }, framePix);
+		img.pixmap().writePaletteExpanded<uint16_t>(systemColorMap.map16, framePix);
 	}
 	else
 	{
 		assumeExpr(img.pixmap().format().bytesPerPixel() == 4);
-		img.pixmap().writeTransformed([](uint16_t p){ return systemColorMap.map32[p]; }, framePix);
+		img.pixmap().writePaletteExpanded<uint32_t>(systemColorMap.map32, framePix);
 	}
 	img.endFrame();
 }
@@ -37,6 +37,7 @@ namespace EmuEx
 
 const char *EmuSystem::creditsViewStr = CREDITS_INFO_STRING "(c) 2011-2024\nRobert Broglia\nwww.explusalpha.com\n\nPortions (c) the\nMednafen Team\nmednafen.github.io";
 bool EmuApp::needsGlobalInstance = true;
+bool EmuSystem::canRunAhead = true;
 
 EmuSystem::NameFilterFunc EmuSystem::defaultFsFilter =
 	[](std::string_view name)
@@ -65,7 +66,8 @@ FS::FileString LynxSystem::stateFilename(int slot, std::string_view name) const
 
 size_t LynxSystem::stateSize() { return stateSizeMDFN(); }
 void LynxSystem::readState(EmuApp &app, std::span<uint8_t> buff) { readStateMDFN(app, buff); }
-size_t LynxSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags) { return writeStateMDFN(buff, flags); }
+size_t LynxSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags) { return writeStateMDFN(*this, buff, flags); }
+size_t LynxSystem::compressState(std::span<uint8_t> dest, std::span<const uint8_t> state) const { return compressStateData(dest, state); }
 
 void LynxSystem::closeSystem()
 {
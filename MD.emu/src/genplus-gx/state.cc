@@ -422,3 +422,20 @@ int state_save(unsigned char *buffer, bool uncompressed)
 		return outbytes + 4;
   }
 }
+
+int state_compress(unsigned char *buffer, const unsigned char *uncompressedState)
+{
+	int32 inbytes32;
+	memcpy(&inbytes32, uncompressedState, 4);
+	if(inbytes32 > 0) // already compressed
+	{
+		memcpy(buffer, uncompressedState, inbytes32 + 4);
+		return inbytes32 + 4;
+	}
+	unsigned long inbytes = -inbytes32;
+	unsigned long outbytes = STATE_SIZE;
+	compress2((Bytef *)(buffer + 4), &outbytes, (const Bytef *)(uncompressedState + 4), inbytes, 9);
+	int32 outbytes32 = outbytes;
+	memcpy(buffer, &outbytes32, 4);
+	return outbytes + 4;
+}
@@ -42,5 +42,6 @@
 /* Function prototypes */
 void state_load(const unsigned char *buffer);
 int state_save(unsigned char *buffer, bool uncompressed = false);
+int state_compress(unsigned char *buffer, const unsigned char *uncompressedState);
 
 #endif
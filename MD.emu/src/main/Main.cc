@@ -32,6 +32,7 @@
 #include <mednafen/mednafen.h>
 #include <mednafen/cdrom/CDAccess.h>
 #include <mednafen-emuex/ArchiveVFS.hh>
+#include <mednafen-emuex/CDAudioCache.hh>
 #endif
 #include "Cheats.hh"
 #include <imagine/fs/FS.hh>
@@ -54,6 +55,7 @@ bool EmuSystem::hasPALVideoSystem = true;
 bool EmuSystem::canRenderRGBA8888 = RENDER_BPP == 32;
 bool EmuSystem::hasRectangularPixels = true;
 bool EmuApp::needsGlobalInstance = true;
+bool EmuSystem::canRunAhead = true;
 
 MdApp::MdApp(ApplicationInitParams initParams, ApplicationContext &ctx):
 	EmuApp{initParams, ctx}, mdSystem{ctx} {}
@@ -155,6 +157,12 @@ size_t MdSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags)
 	return state_save(buff.data(), flags.uncompressed);
 }
 
+size_t MdSystem::compressState(std::span<uint8_t> dest, std::span<const uint8_t> state) const
+{
+	assert(dest.size() >= maxSaveStateSize);
+	return state_compress(dest.data(), state.data());
+}
+
 static bool sramHasContent(std::span<uint8> sram)
 {
 	for(auto v : sram)
@@ -359,11 +367,11 @@ void MdSystem::loadContent(IO &io, EmuSystemCreateParams, OnLoadProgressDelegate
 				io = std::move(*archIt);
 			}
 			ArchiveVFS archVFS{ArchiveIO{std::move(io)}};
-			cd = CDAccess_Open(&archVFS, std::string{contentFileName()}, true);
+			cd = CDAccess_Open(&archVFS, std::string{contentFileName()}, true, CDAudioCache::defaultSeconds);
 		}
 		else
 		{
-			cd = CDAccess_Open(&NVFS, std::string{contentLocation()}, false);
+			cd = CDAccess_Open(&NVFS, std::string{contentLocation()}, false, CDAudioCache::defaultSeconds);
 		}
 
 		unsigned region = REGION_USA;
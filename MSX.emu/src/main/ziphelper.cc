@@ -16,7 +16,7 @@
 #define LOGTAG "main"
 #include <archive.h>
 #include <archive_entry.h>
-#include <imagine/fs/ArchiveFS.hh>
+#include <imagine/fs/ArchiveIndex.hh>
 #include <imagine/io/IO.hh>
 #include <imagine/logger/logger.h>
 #include <imagine/util/string.h>
@@ -35,7 +35,7 @@ constexpr SystemLogger log{"zipHelper"};
 using namespace EmuEx;
 
 static struct archive *writeArch{};
-static FS::ArchiveIterator cachedZipIt{};
+static FS::ArchiveIndex cachedZipIndex{};
 static FS::PathString cachedZipName{};
 static uint8_t *buffData{};
 static size_t buffSize{};
@@ -50,7 +50,7 @@ size_t zipMemBufferSize() { return buffSize; }
 
 static void unsetCachedReadZip()
 {
-	cachedZipIt = {};
+	cachedZipIndex = {};
 	cachedZipName = {};
 	EmuEx::log.info("unset cached read zip archive");
 }
@@ -70,36 +70,33 @@ void zipCacheReadOnlyZip(const char* zipName_)
 		{
 			EmuEx::log.info("using memory buffer as cached read zip archive");
 			std::span buff{buffData, buffSize};
-			cachedZipIt = IO{buff};
+			cachedZipIndex = FS::ArchiveIndex{IO{buff}};
 		}
 		else
 		{
 			EmuEx::log.info("setting cached read zip archive:{}", zipName);
-			cachedZipIt = {EmuEx::gAppContext().openFileUri(zipName)};
+			cachedZipIndex = FS::ArchiveIndex{EmuEx::gAppContext().openFileUri(zipName)};
 		}
 	}
 }
 
-static void *loadFromArchiveIt(FS::ArchiveIterator &it, const char* zipName, const char* fileName, int* size)
+static void *loadFromArchive(FS::ArchiveIndex &index, const char* zipName, const char* fileName, int* size)
 {
-	for(auto &entry : it)
+	if(auto entry = index.find(fileName);
+		entry && entry->type != FS::file_type::directory)
 	{
-		if(entry.type() == FS::file_type::directory)
+		int fileSize = entry->size;
+		void *buff = malloc(fileSize);
+		if(!index.read(*entry, {static_cast<uint8_t*>(buff), entry->size}))
 		{
-			continue;
-		}
-		//logMsg("archive file entry:%s", entry.name());
-		if(entry.name() == fileName)
-		{
-			int fileSize = entry.size();
-			void *buff = malloc(fileSize);
-			entry.read(buff, fileSize);
-			*size = fileSize;
-			return buff;
+			free(buff);
+			return nullptr;
 		}
+		*size = fileSize;
+		return buff;
 	}
 	logErr("file %s not in %sarchive:%s", fileName,
-		cachedZipIt.hasEntry() && cachedZipName == zipName ? "cached " : "", zipName);
+		cachedZipIndex && cachedZipName == zipName ? "cached " : "", zipName);
 	return nullptr;
 }
 
@@ -107,15 +104,14 @@ void* zipLoadFile(const char* zipName, const char* fileName, int* size)
 {
 	try
 	{
-		if(cachedZipIt.hasEntry() && cachedZipName == zipName)
+		if(cachedZipIndex && cachedZipName == zipName)
 		{
-			cachedZipIt.rewind();
-			return loadFromArchiveIt(cachedZipIt, zipName, fileName, size);
+			return loadFromArchive(cachedZipIndex, zipName, fileName, size);
 		}
 		else
 		{
-			auto it = FS::ArchiveIterator{EmuEx::gAppContext().openFileUri(zipName)};
-			return loadFromArchiveIt(it, zipName, fileName, size);
+			FS::ArchiveIndex index{EmuEx::gAppContext().openFileUri(zipName)};
+			return loadFromArchive(index, zipName, fileName, size);
 		}
 	}
 	catch(...)
@@ -8,6 +8,7 @@ main/input.cc \
 main/options.cc \
 main/state.cc \
 main/unzip.cc \
+main/romcache.cc \
 main/EmuMenuViews.cc
 
 CPPFLAGS += -I$(projectPath)/src \
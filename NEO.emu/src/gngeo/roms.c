@@ -922,131 +922,50 @@ static void free_region(ROM_REGION *r) {
 	r->p = NULL;
 }
 
-static int zip_seek_current_file(struct ZFILE *gz, Uint32 offset) {
-	const Uint32 s = 1024 * 32;
-	Uint8 buf[s];
-	while (offset) {
-		Uint32 c = offset;
-		if (c > s)
-			c = s;
-
-		c = gn_unzip_fread(gz, buf, c);
-		if (c <= 0) {
-			break;
-		}
-		offset -= c;
-	}
-	return 0;
-
-}
-
 static int read_counter;
 
-static int read_data_i(struct ZFILE *gz, ROM_REGION *r, Uint32 dest, Uint32 size) {
-	Uint8 *p = r->p + dest;
-	if (r->p == NULL || r->size < (dest & ~0x1) + (size * 2)) {
-		logMsg("Region not allocated or not big enough %08x %08x", r->size,
-				dest + (size * 2));
-		return -1;
-	}
-	Uint8 *buf = malloc(size);
-	Uint32 c = gn_unzip_fread(gz, buf, size);
-	if (c <= 0) {
-		free(buf);
-		return 0;
-	}
-	for (Uint32 i = 0; i < c; i++) {
-		//printf("%d %d\n",i,c);
-		*p = buf[i];
-		p += 2;
-	}
-	free(buf);
-	read_counter += c;
-	gn_update_pbar(read_counter);
-	return 0;
-}
-
-static int read_data_p(struct ZFILE *gz, ROM_REGION *r, Uint32 dest, Uint32 size) {
-	if (r->p == NULL || r->size < dest + size) {
-		logMsg("Region not allocated or not big enough");
-		return -1;
-	}
-	Uint32 c = gn_unzip_fread(gz, r->p + dest, size);
-	if (c <= 0) {
-		return 0;
-	}
-	read_counter += c;
-	gn_update_pbar(read_counter);
-	return 0;
-}
-
-static int load_region(struct PKZIP *pz, GAME_ROMS *r, int region, Uint32 src,
-		Uint32 dest, Uint32 size, Uint32 crc, char *filename) {
-	int rc;
-	int badcrc = 0;
-	struct ZFILE *gz;
-
-
-	gz = gn_unzip_fopen(pz, filename, crc);
-	if (gz == NULL) {
-		//DEBUG_LOG("KO\n");
-		DEBUG_LOG("Load file %-17s in region %d: KO", filename, region);
-		return 1;
-	}
-
-	if (src != 0) { /* TODO: Reuse an allready opened zfile */
-
-		if (region == REGION_SPRITES)
-			rc = zip_seek_current_file(gz, src / 2);
-		else
-			rc = zip_seek_current_file(gz, src);
-		DEBUG_LOG("setoffset: %d %08x %08x %08x", rc, src, dest, size);
-	}
-
-	DEBUG_LOG("Trying to load file %-17s in region %d", filename, region);
-
+static ROM_REGION *get_region(GAME_ROMS *r, int region) {
 	switch (region) {
-		case REGION_SPRITES: /* Special interleaved loading  */
-			read_data_i(gz, &r->tiles, dest, size);
-			break;
-		case REGION_AUDIO_CPU_CARTRIDGE:
-			read_data_p(gz, &r->cpu_z80, dest, size);
-			break;
-		case REGION_AUDIO_CPU_ENCRYPTED:
-			read_data_p(gz, &r->cpu_z80c, dest, size);
-			break;
-		case REGION_MAIN_CPU_CARTRIDGE:
-			read_data_p(gz, &r->cpu_m68k, dest, size);
-			break;
-		case REGION_FIXED_LAYER_CARTRIDGE:
-			read_data_p(gz, &r->game_sfix, dest, size);
-			break;
-		case REGION_AUDIO_DATA_1:
-			read_data_p(gz, &r->adpcma, dest, size);
-			break;
-		case REGION_AUDIO_DATA_2:
-			read_data_p(gz, &r->adpcmb, dest, size);
-			break;
-		case REGION_MAIN_CPU_BIOS:
-			read_data_p(gz, &r->bios_m68k, dest, size);
-			break;
-		case REGION_AUDIO_CPU_BIOS:
-			read_data_p(gz, &r->bios_audio, dest, size);
-			break;
-		case REGION_FIXED_LAYER_BIOS:
-			read_data_p(gz, &r->bios_sfix, dest, size);
-			break;
-
-		default:
-			DEBUG_LOG("Unhandled region %d", region);
-			break;
-
+		case REGION_SPRITES: return &r->tiles;
+		case REGION_AUDIO_CPU_CARTRIDGE: return &r->cpu_z80;
+		case REGION_AUDIO_CPU_ENCRYPTED: return &r->cpu_z80c;
+		case REGION_MAIN_CPU_CARTRIDGE: return &r->cpu_m68k;
+		case REGION_FIXED_LAYER_CARTRIDGE: return &r->game_sfix;
+		case REGION_AUDIO_DATA_1: return &r->adpcma;
+		case REGION_AUDIO_DATA_2: return &r->adpcmb;
+		case REGION_MAIN_CPU_BIOS: return &r->bios_m68k;
+		case REGION_AUDIO_CPU_BIOS: return &r->bios_audio;
+		case REGION_FIXED_LAYER_BIOS: return &r->bios_sfix;
+	}
+	return NULL;
+}
+
+static void setup_region_read(GAME_ROMS *r, const struct romfile *rom, struct ZREAD *zr) {
+	ROM_REGION *reg = get_region(r, rom->region);
+	memset(zr, 0, sizeof(*zr));
+	zr->filename = rom->filename;
+	zr->crc = rom->crc;
+	zr->size = rom->size;
+	if (!reg) {
+		DEBUG_LOG("Unhandled region %d", rom->region);
+		return;
 	}
-	DEBUG_LOG("Load file %-17s in region %d: OK %s", filename, region,
-			(badcrc ? "(Bad CRC)" : ""));
-	//unzCloseCurrentFile(gz);
-	gn_unzip_fclose(gz);
-	return 0;
+	if (rom->region == REGION_SPRITES) { /* Special interleaved loading  */
+		zr->offset = rom->src / 2;
+		zr->interleaved = 1;
+		if (reg->p == NULL || reg->size < (rom->dest & ~0x1) + (rom->size * 2)) {
+			logMsg("Region not allocated or not big enough %08x %08x", reg->size,
+					rom->dest + (rom->size * 2));
+			return;
+		}
+	} else {
+		zr->offset = rom->src;
+		if (reg->p == NULL || reg->size < rom->dest + rom->size) {
+			logMsg("Region not allocated or not big enough");
+			return;
+		}
+	}
+	zr->dest = reg->p + rom->dest;
 }
 
 static int convert_roms_tile(Uint8 *g, int tileno) {
@@ -1335,43 +1254,31 @@ ROM_DEF *dr_check_zip(void *contextPtr, const char *filename) {
 	return drv;
 }
 
-int dr_load_roms(void *contextPtr, GAME_ROMS *r, char *rom_path, char *name, char romerror[1024]) {
-	//unzFile *gz,*gzp=NULL,*rdefz;
-	struct PKZIP *gz, *gzp = NULL;
-	ROM_DEF *drv;
+/* CRCs of the files actually found for each rom, so the cache is only used with the same set */
+static void get_rom_crcs(ROM_DEF *drv, struct PKZIP *gz, struct PKZIP *gzp, Uint32 *rom_crcs) {
+	struct ZREAD probes[32];
 	int i;
-	int romsize;
-
-	memset(r, 0, sizeof (GAME_ROMS));
-
-	drv = res_load_drv(contextPtr, name);
-	if (!drv) {
-		sprintf(romerror, "Can't find rom driver for %s", name);
-		return false;
-	}
-
-	gz = open_rom_zip(contextPtr, rom_path, name);
-	if (gz == NULL) {
-		sprintf(romerror,"Game %s.zip not found", name);
-		return false;
+	memset(probes, 0, sizeof(probes));
+	for (i = 0; i < (int)drv->nb_romfile; i++) {
+		probes[i].filename = drv->rom[i].filename;
+		probes[i].crc = drv->rom[i].crc;
 	}
+	gn_unzip_read_batch(gz, probes, drv->nb_romfile, NULL);
+	if (gzp)
+		gn_unzip_read_batch(gzp, probes, drv->nb_romfile, NULL);
+	for (i = 0; i < (int)drv->nb_romfile; i++)
+		rom_crcs[i] = probes[i].found ? probes[i].entryCrc : 0;
+}
 
-	/* Open Parent.
-	 For now, only one parent is supported, no recursion
-	 */
-	gzp = open_rom_zip(contextPtr, rom_path, drv->parent);
-	if (gzp == NULL) {
-		sprintf(romerror,"%s.zip not found, make sure it's in your ROM directory", drv->parent);
-		return false;
-	}
+static void update_load_pbar(uint32_t bytesRead) {
+	read_counter += bytesRead;
+	gn_update_pbar(read_counter);
+}
 
-	//printf("year %d\n",drv->year);
-	//return;
+static int load_rom_files(GAME_ROMS *r, ROM_DEF *drv, struct PKZIP *gz, struct PKZIP *gzp, char romerror[1024]) {
+	int i;
+	int romsize;
 
-	strcpy(r->info.name, drv->name);
-	strcpy(r->info.longname, drv->longname);
-	r->info.year = drv->year;
-	r->info.flags = 0;
 	allocate_region(&r->cpu_m68k, drv->romsize[REGION_MAIN_CPU_CARTRIDGE],
 			REGION_MAIN_CPU_CARTRIDGE);
 	if (drv->romsize[REGION_AUDIO_CPU_CARTRIDGE] == 0
@@ -1422,37 +1329,71 @@ int dr_load_roms(void *contextPtr, GAME_ROMS *r, char *rom_path, char *name, cha
 	for (i = 0; i < (int)drv->nb_romfile; i++)
 		romsize += drv->rom[i].size;
 	gn_init_pbar(PBAR_ACTION_LOADROM, romsize);
+	struct ZREAD reads[32];
+	for (i = 0; i < (int)drv->nb_romfile; i++)
+		setup_region_read(r, &drv->rom[i], &reads[i]);
+	gn_unzip_read_batch(gz, reads, drv->nb_romfile, update_load_pbar);
+	/* Files not found in the roms, try the parent */
+	if (gzp)
+		gn_unzip_read_batch(gzp, reads, drv->nb_romfile, update_load_pbar);
 	for (i = 0; i < (int)drv->nb_romfile; i++) {
-		//		gn_update_pbar(i, drv->nb_romfile);
-		if (load_region(gz, r, drv->rom[i].region, drv->rom[i].src,
-				drv->rom[i].dest, drv->rom[i].size, drv->rom[i].crc,
-				drv->rom[i].filename) != 0) {
-			/* File not found in the roms, try the parent */
-			if (gzp) {
-				int region = drv->rom[i].region;
-				int pi;
-				pi = load_region(gzp, r, drv->rom[i].region, drv->rom[i].src,
-						drv->rom[i].dest, drv->rom[i].size, drv->rom[i].crc,
-						drv->rom[i].filename);
-				DEBUG_LOG("From parent %d", pi);
-				if (pi && (region != 5 && region != 0 && region != 7)) {
-					sprintf(romerror, "File check for %s failed, ROM set not compatible",
-							drv->rom[i].filename);
-					goto error1;
-				}
-			} else {
-				int region = drv->rom[i].region;
-				if (region != 5 && region != 0 && region != 7) {
-					sprintf(romerror, "File check for %s failed, ROM set not compatible",
-							drv->rom[i].filename);
-					goto error1;
-				}
-
-			}
+		int region = drv->rom[i].region;
+		DEBUG_LOG("Load file %-17s in region %d: %s", drv->rom[i].filename, region,
+				reads[i].found ? "OK" : "KO");
+		if (!reads[i].found && region != 5 && region != 0 && region != 7) {
+			sprintf(romerror, "File check for %s failed, ROM set not compatible",
+					drv->rom[i].filename);
+			gn_terminate_pbar();
+			return false;
 		}
-
 	}
 	gn_terminate_pbar();
+	return true;
+}
+
+int dr_load_roms(void *contextPtr, GAME_ROMS *r, char *rom_path, char *name, char romerror[1024]) {
+	//unzFile *gz,*gzp=NULL,*rdefz;
+	struct PKZIP *gz, *gzp = NULL;
+	ROM_DEF *drv;
+	Uint32 rom_crcs[32];
+	int nb_rom;
+	int cached;
+
+	memset(r, 0, sizeof (GAME_ROMS));
+
+	drv = res_load_drv(contextPtr, name);
+	if (!drv) {
+		sprintf(romerror, "Can't find rom driver for %s", name);
+		return false;
+	}
+
+	gz = open_rom_zip(contextPtr, rom_path, name);
+	if (gz == NULL) {
+		sprintf(romerror,"Game %s.zip not found", name);
+		return false;
+	}
+
+	/* Open Parent.
+	 For now, only one parent is supported, no recursion
+	 */
+	gzp = open_rom_zip(contextPtr, rom_path, drv->parent);
+	if (gzp == NULL) {
+		sprintf(romerror,"%s.zip not found, make sure it's in your ROM directory", drv->parent);
+		return false;
+	}
+
+	//printf("year %d\n",drv->year);
+	//return;
+
+	strcpy(r->info.name, drv->name);
+	strcpy(r->info.longname, drv->longname);
+	r->info.year = drv->year;
+	r->info.flags = 0;
+	get_rom_crcs(drv, gz, gzp, rom_crcs);
+	nb_rom = drv->nb_romfile;
+	cached = gn_load_rom_cache(contextPtr, r, rom_crcs, nb_rom);
+	if (!cached && !load_rom_files(r, drv, gz, gzp, romerror))
+		goto error1;
 	/* Close/clean up */
 	gn_close_zip(gz);
 	if (gzp) gn_close_zip(gzp);
@@ -1475,13 +1416,16 @@ int dr_load_roms(void *contextPtr, GAME_ROMS *r, char *rom_path, char *name, cha
 	 */
 	memory.nb_of_tiles = r->tiles.size >> 7;
 
-	/* Init rom and bios */
+	/* Init rom and bios, the cache already holds decrypted & converted data */
+	need_decrypt = !cached;
 	init_roms(contextPtr, r);
-	convert_all_tile(r);
+	if (!cached) {
+		convert_all_tile(r);
+		gn_save_rom_cache(contextPtr, r, rom_crcs, nb_rom);
+	}
 	return dr_load_bios(contextPtr, r, romerror);
 
 error1:
-	gn_terminate_pbar();
 	//unzClose(gz);
 	//if (gzp) unzClose(gzp);
 	gn_close_zip(gz);
@@ -1860,6 +1804,8 @@ int dr_save_gno(GAME_ROMS *r, char *filename) {
 #endif
 
 void dr_free_roms(GAME_ROMS *r) {
+	/* regions used from the mapped cache aren't freed */
+	gn_release_rom_cache(r);
 	free_region(&r->cpu_m68k);
 	free_region(&r->cpu_z80c);
 
@@ -88,4 +88,10 @@ struct PathArray
 
 struct PathArray get_rom_path(void *contextPtr);
 
+/* Cache of the converted ROM regions keyed by the CRCs of the loaded files,
+   large read-only regions are used directly from the mapped cache file */
+int gn_load_rom_cache(void *contextPtr, GAME_ROMS *r, const Uint32 *rom_crcs, int nb_rom);
+void gn_save_rom_cache(void *contextPtr, const GAME_ROMS *r, const Uint32 *rom_crcs, int nb_rom);
+void gn_release_rom_cache(GAME_ROMS *r);
+
 #endif
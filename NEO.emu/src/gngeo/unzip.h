@@ -51,12 +51,29 @@ typedef struct PKZIP {
 struct ZFILE;
 struct PKZIP;
 
+/* One file read for gn_unzip_read_batch() */
+struct ZREAD {
+	const char *filename;
+	uint32_t crc;
+	uint32_t offset; /* bytes to skip from the start of the file */
+	uint8_t *dest; /* NULL to only check the file exists */
+	uint32_t size;
+	int interleaved; /* write to every other byte of dest */
+	int found;
+	uint32_t entryCrc; /* CRC32 of the archive file that was found */
+	uint32_t bytesRead;
+};
+
 void gn_unzip_fclose(struct ZFILE *z);
 int gn_unzip_fread(struct ZFILE *z,uint8_t *data,unsigned int size);
 struct ZFILE *gn_unzip_fopen(struct PKZIP *zf,const char *filename,uint32_t file_crc);
 struct PKZIP *gn_open_zip(void *contextPtr, const char *file);
 uint8_t *gn_unzip_file_malloc(struct PKZIP *zf,const char *filename,uint32_t file_crc,unsigned int *outlen);
 void gn_close_zip(struct PKZIP *zf);
+/* Reads all requests not already found, decompressing files in parallel when possible.
+   onRead, if not NULL, gets the byte count of each request as it finishes, possibly from
+   a worker thread but never concurrently. Returns how many new requests were found in the archive */
+int gn_unzip_read_batch(struct PKZIP *zf, struct ZREAD *reads, int count, void (*onRead)(uint32_t bytesRead));
 int gn_strictROMChecking();
 struct PKZIP *open_rom_zip(void *contextPtr, char *romPath, char *name);
 
@@ -21,7 +21,7 @@
 #include <imagine/io/FileIO.hh>
 #include <imagine/util/ScopeGuard.hh>
 #include <imagine/util/format.hh>
-#include <imagine/util/zlib.hh>
+#include <imagine/util/compression.hh>
 
 extern "C"
 {
@@ -164,10 +164,10 @@ void NeoSystem::readState(EmuApp &app, std::span<uint8_t> buff)
 	Uint8 *bksw_unscramble = memory.bksw_unscramble;
 	int *bksw_offset=memory.bksw_offset;
 
-	DynArray<uint8_t> uncompArr;
-	if(hasGzipHeader(buff))
+	ScratchBuffer uncompArr;
+	if(isCompressed(buff))
 	{
-		uncompArr = uncompressGzipState(buff, saveStateSize);
+		uncompArr = uncompressState(buff, saveStateSize);
 		buff = uncompArr;
 	}
 	MapIO buffIO{buff};
@@ -220,14 +220,19 @@ size_t NeoSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags)
 	else
 	{
 		assert(saveStateSize);
-		auto stateArr = DynArray<uint8_t>{saveStateSize};
+		auto stateArr = stateScratchBuffer(saveStateSize);
 		MapIO buffIO{stateArr};
 		openState(buffIO, STWRITE);
 		makeState(buffIO, STWRITE);
-		return compressGzip(buff, stateArr, Z_DEFAULT_COMPRESSION);
+		return compressState(buff, stateArr);
 	}
 }
 
+size_t NeoSystem::compressState(std::span<uint8_t> dest, std::span<const uint8_t> state) const
+{
+	return compressStateData(dest, state);
+}
+
 void NeoSystem::loadBackupMemory(EmuApp &app)
 {
 	logMsg("loading nvram & memcard");
@@ -289,29 +294,11 @@ void NeoSystem::loadContent(IO &, EmuSystemCreateParams, OnLoadProgressDelegate
 	}
 	auto freeDrv = IG::scopeGuard([&](){ free(drv); });
 	logMsg("rom set %s, %s", drv->name, drv->longname);
-	auto gnoFilename = EmuSystem::contentSaveFilePath(".gno");
-	if(optionCreateAndUseCache && ctx.fileUriExists(gnoFilename))
+	// converted ROMs are cached by dr_load_roms() if optionCreateAndUseCache is set
+	char errorStr[1024];
+	if(!init_game(&ctx, drv->name, errorStr))
 	{
-		logMsg("loading .gno file");
-		char errorStr[1024];
-		if(!init_game(&ctx, gnoFilename.data(), errorStr))
-		{
-			throw std::runtime_error(errorStr);
-		}
-	}
-	else
-	{
-		char errorStr[1024];
-		if(!init_game(&ctx, drv->name, errorStr))
-		{
-			throw std::runtime_error(errorStr);
-		}
-
-		if(optionCreateAndUseCache && !ctx.fileUriExists(gnoFilename))
-		{
-			logMsg("%s doesn't exist, creating", gnoFilename.data());
-			dr_save_gno(&memory.rom, gnoFilename.data());
-		}
+		throw std::runtime_error(errorStr);
 	}
 	EmuSystem::setContentDisplayName(drv->longname);
 	setTimerIntOption();
@@ -0,0 +1,202 @@
+/*  This file is part of NEO.emu.
+
+	NEO.emu is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	NEO.emu is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with NEO.emu.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "romcache"
+#include "MainSystem.hh"
+#include <imagine/base/ApplicationContext.hh>
+#include <imagine/io/FileIO.hh>
+#include <imagine/util/math.hh>
+#include <imagine/util/utility.h>
+#include <imagine/logger/logger.h>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+extern "C"
+{
+	#include <gngeo/roms.h>
+}
+
+using namespace IG;
+using namespace EmuEx;
+
+// Regions are stored as they are after decryption & sprite conversion, page aligned so the
+// large read-only ones can be used directly from the mapped file
+
+constexpr std::array<char, 8> cacheMagic{'N', 'E', 'O', 'R', 'O', 'M', 'S', 0};
+constexpr uint32_t cacheVersion = 1; // bump when decryption or tile conversion output changes
+constexpr unsigned cacheAlign = 4096;
+constexpr size_t maxCacheROMs = 32;
+
+constexpr ROM_REGION GAME_ROMS::*cachedRegions[]
+{
+	&GAME_ROMS::cpu_m68k, &GAME_ROMS::cpu_z80, &GAME_ROMS::cpu_z80c,
+	&GAME_ROMS::tiles, &GAME_ROMS::game_sfix, &GAME_ROMS::bios_sfix,
+	&GAME_ROMS::bios_audio, &GAME_ROMS::bios_m68k, &GAME_ROMS::adpcma,
+	&GAME_ROMS::adpcmb, &GAME_ROMS::spr_usage, &GAME_ROMS::gfix_usage,
+};
+
+// only read by the video & sound code, all others get patched after loading
+static bool regionUsedFromMap(ROM_REGION GAME_ROMS::*region)
+{
+	return region == &GAME_ROMS::tiles || region == &GAME_ROMS::spr_usage ||
+		region == &GAME_ROMS::adpcma || region == &GAME_ROMS::adpcmb;
+}
+
+struct CacheRegion
+{
+	uint64_t offset;
+	uint64_t size;
+};
+
+struct CacheHeader
+{
+	std::array<char, 8> magic;
+	uint32_t version;
+	uint32_t infoFlags;
+	std::array<char, 32> name;
+	uint32_t romCount;
+	std::array<uint32_t, maxCacheROMs> romCRCs;
+	std::array<CacheRegion, std::size(cachedRegions)> regions;
+};
+
+static FileIO cacheFile;
+
+static NeoSystem &neoSystem() { return static_cast<NeoSystem&>(gSystem()); }
+
+static bool cacheEnabled(int romCount)
+{
+	return neoSystem().optionCreateAndUseCache && romCount <= (int)maxCacheROMs;
+}
+
+static bool headerMatches(const CacheHeader &h, const GAME_ROMS &r, const Uint32 *romCRCs, int romCount, size_t fileSize)
+{
+	if(h.magic != cacheMagic || h.version != cacheVersion ||
+		strncmp(h.name.data(), r.info.name, h.name.size()) ||
+		h.romCount != (uint32_t)romCount || !std::equal(romCRCs, romCRCs + romCount, h.romCRCs.begin()))
+	{
+		return false;
+	}
+	return std::ranges::all_of(h.regions, [&](const CacheRegion &reg)
+	{
+		return reg.size <= UINT32_MAX && reg.offset <= fileSize && reg.size <= fileSize - reg.offset;
+	});
+}
+
+CLINK int gn_load_rom_cache(void *contextPtr, GAME_ROMS *r, const Uint32 *romCRCs, int romCount)
+{
+	if(!cacheEnabled(romCount))
+		return false;
+	auto &ctx = *((ApplicationContext*)contextPtr);
+	auto path = neoSystem().contentSaveFilePath(".neorom");
+	auto file = ctx.openFileUri(path, IOAccessHint::Random, {.test = true});
+	if(!file)
+		return false;
+	auto data = file.map();
+	if(!data.data())
+	{
+		logErr("can't map %s", path.data());
+		return false;
+	}
+	CacheHeader h;
+	if(data.size() < sizeof(h))
+		return false;
+	memcpy(&h, data.data(), sizeof(h));
+	if(!headerMatches(h, *r, romCRCs, romCount, data.size()))
+	{
+		logMsg("%s is out of date", path.data());
+		return false;
+	}
+	for(size_t i = 0; i < std::size(cachedRegions); i++)
+	{
+		auto &region = r->*cachedRegions[i];
+		auto [offset, size] = h.regions[i];
+		if(!size)
+		{
+			region = {};
+		}
+		else if(regionUsedFromMap(cachedRegions[i]))
+		{
+			region = {data.data() + offset, Uint32(size)};
+		}
+		else
+		{
+			region = {(Uint8*)malloc(size), Uint32(size)};
+			memcpy(region.p, data.data() + offset, size);
+		}
+	}
+	r->info.flags = h.infoFlags;
+	cacheFile = std::move(file);
+	logMsg("using converted ROMs from %s", path.data());
+	return true;
+}
+
+CLINK void gn_save_rom_cache(void *contextPtr, const GAME_ROMS *r, const Uint32 *romCRCs, int romCount)
+{
+	if(!cacheEnabled(romCount))
+		return;
+	CacheHeader h{.magic = cacheMagic, .version = cacheVersion, .infoFlags = r->info.flags,
+		.romCount = (uint32_t)romCount};
+	strncpy(h.name.data(), r->info.name, h.name.size());
+	std::copy_n(romCRCs, romCount, h.romCRCs.begin());
+	uint64_t offset = alignRoundedUp(sizeof(h), cacheAlign);
+	for(size_t i = 0; i < std::size(cachedRegions); i++)
+	{
+		auto &region = r->*cachedRegions[i];
+		// ADPCM-B data shared with ADPCM-A gets aliased again when loading
+		if(!region.p || (cachedRegions[i] == &GAME_ROMS::adpcmb && region.p == r->adpcma.p))
+			continue;
+		h.regions[i] = {offset, region.size};
+		offset = alignRoundedUp(offset + region.size, cacheAlign);
+	}
+	auto &ctx = *((ApplicationContext*)contextPtr);
+	auto path = neoSystem().contentSaveFilePath(".neorom");
+	auto file = ctx.openFileUri(path, OpenFlags::testNewFile());
+	if(!file)
+	{
+		logErr("can't create %s", path.data());
+		return;
+	}
+	for(size_t i = 0; i < std::size(cachedRegions); i++)
+	{
+		auto &region = r->*cachedRegions[i];
+		auto [regionOffset, size] = h.regions[i];
+		if(size && file.write(region.p, size, regionOffset) != (ssize_t)size)
+		{
+			logErr("error writing %s", path.data());
+			file = {};
+			ctx.removeFileUri(path);
+			return;
+		}
+	}
+	// header goes last so an incomplete file never matches
+	file.write(&h, sizeof(h), 0);
+	logMsg("wrote converted ROMs to %s", path.data());
+}
+
+CLINK void gn_release_rom_cache(GAME_ROMS *r)
+{
+	if(!cacheFile)
+		return;
+	auto data = cacheFile.map();
+	for(auto regionPtr : cachedRegions)
+	{
+		auto &region = r->*regionPtr;
+		if(region.p >= data.data() && region.p < data.data() + data.size())
+			region = {};
+	}
+	cacheFile = {};
+}
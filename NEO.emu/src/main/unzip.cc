@@ -17,13 +17,16 @@
 #include <imagine/base/ApplicationContext.hh>
 #include <imagine/io/IO.hh>
 #include <imagine/io/FileIO.hh>
-#include <imagine/fs/ArchiveFS.hh>
+#include <imagine/fs/ArchiveIndex.hh>
 #include <imagine/fs/FS.hh>
 #include <imagine/util/ScopeGuard.hh>
 #include <imagine/util/bit.hh>
 #include <imagine/logger/logger.h>
 #include <imagine/util/string.h>
+#include <emuframework/EmuApp.hh>
 #include <cstdlib>
+#include <algorithm>
+#include <vector>
 
 extern "C"
 {
@@ -33,41 +36,54 @@ extern "C"
 
 using namespace IG;
 
-struct PKZIP : public FS::ArchiveIterator {};
+struct PKZIP
+{
+	FS::ArchiveIndex index;
+};
 
 struct ZFILE
 {
-	ArchiveIO io;
-	FS::ArchiveIterator *arch;
+	std::unique_ptr<uint8_t[]> data;
+	MapIO io;
 };
 
-ZFILE *gn_unzip_fopen(PKZIP *archPtr, const char *filename, uint32_t fileCRC)
+// interleaved reads decompress into temporary buffers, limit how much is in flight
+constexpr size_t maxInterleavedBatchBytes = 64 * 1024 * 1024;
+
+static const FS::ArchiveIndex::Entry *findEntry(PKZIP &arch, const char *filename, uint32_t fileCRC)
 {
-	auto &arch = *archPtr;
-	arch.rewind();
-	for(auto &entry : arch)
+	if(auto e = arch.index.findCRC32(fileCRC);
+		e)
 	{
-		if(entry.type() == FS::file_type::directory)
-		{
-			continue;
-		}
-		auto crc = entry.crc32();
-		//logMsg("archive file entry:%s crc32:0x%X", name, crc);
-		int loadByName = fileCRC == (uint32_t)-1 || !gn_strictROMChecking();
-		if((loadByName && entry.name() == filename) || crc == fileCRC)
-		{
-			//logMsg("opened archive entry file:%s crc32:0x%X", name, crc);
-			return new ZFILE{std::move(entry), archPtr};
-		}
+		return e;
+	}
+	bool loadByName = fileCRC == (uint32_t)-1 || !gn_strictROMChecking();
+	if(auto e = arch.index.find(filename);
+		loadByName && e && e->type == FS::file_type::regular)
+	{
+		return e;
 	}
 	logMsg("file:%s crc32:0x%X not found in archive", filename, fileCRC);
 	return nullptr;
 }
 
+ZFILE *gn_unzip_fopen(PKZIP *archPtr, const char *filename, uint32_t fileCRC)
+{
+	auto entry = findEntry(*archPtr, filename, fileCRC);
+	if(!entry)
+		return nullptr;
+	auto data = std::make_unique_for_overwrite<uint8_t[]>(entry->size);
+	if(!archPtr->index.read(*entry, {data.get(), entry->size}))
+	{
+		logErr("error reading archive entry:%s", entry->name.c_str());
+		return nullptr;
+	}
+	MapIO io{std::span<uint8_t>{data.get(), entry->size}};
+	return new ZFILE{std::move(data), std::move(io)};
+}
+
 void gn_unzip_fclose(ZFILE *z)
 {
-	//logMsg("done with archive entry");
-	*z->arch = std::move(z->io);
 	delete z;
 }
 
@@ -77,13 +93,85 @@ int gn_unzip_fread(ZFILE *z, uint8_t *data, unsigned int size)
 	return z->io.read(data, size);
 }
 
+int gn_unzip_read_batch(PKZIP *archPtr, ZREAD *reads, int count, void (*onRead)(uint32_t bytesRead))
+{
+	std::vector<FS::ArchiveIndex::ReadRequest> directReqs;
+	std::vector<ZREAD*> directReads;
+	std::vector<std::pair<ZREAD*, const FS::ArchiveIndex::Entry*>> interleavedReads;
+	int found{};
+	for(auto &zr : std::span{reads, size_t(count)})
+	{
+		if(zr.found)
+			continue;
+		auto entry = findEntry(*archPtr, zr.filename, zr.crc);
+		if(!entry)
+			continue;
+		zr.found = 1;
+		zr.entryCrc = entry->crc32;
+		found++;
+		zr.bytesRead = 0;
+		if(!zr.dest || zr.offset >= entry->size)
+			continue;
+		auto size = std::min(size_t(zr.size), entry->size - zr.offset);
+		if(zr.interleaved)
+		{
+			zr.size = size;
+			interleavedReads.emplace_back(&zr, entry);
+		}
+		else
+		{
+			directReqs.push_back({.entry = entry, .dest = {zr.dest, size}, .offset = zr.offset});
+			directReads.emplace_back(&zr);
+		}
+	}
+	auto &jobSystem = EmuEx::gApp().jobSystem;
+	FS::ArchiveIndex::OnReadDelegate onDirectRead;
+	if(onRead)
+		onDirectRead = [onRead](const FS::ArchiveIndex::ReadRequest &r){ onRead(r.bytesRead); };
+	archPtr->index.read(directReqs, &jobSystem, onDirectRead);
+	for(size_t i = 0; i < directReqs.size(); i++)
+	{
+		directReads[i]->bytesRead = directReqs[i].bytesRead;
+	}
+	// interleaved data (sprites) goes to every other byte of the destination
+	for(auto batchBegin = interleavedReads.begin(); batchBegin != interleavedReads.end();)
+	{
+		std::vector<FS::ArchiveIndex::ReadRequest> reqs;
+		std::vector<std::unique_ptr<uint8_t[]>> buffs;
+		size_t batchBytes{};
+		auto batchEnd = batchBegin;
+		for(; batchEnd != interleavedReads.end() && (reqs.empty() || batchBytes + batchEnd->first->size <= maxInterleavedBatchBytes); ++batchEnd)
+		{
+			auto &[zr, entry] = *batchEnd;
+			auto &buff = buffs.emplace_back(std::make_unique_for_overwrite<uint8_t[]>(zr->size));
+			reqs.push_back({.entry = entry, .dest = {buff.get(), zr->size}, .offset = zr->offset});
+			batchBytes += zr->size;
+		}
+		archPtr->index.read(reqs, &jobSystem);
+		for(size_t i = 0; i < reqs.size(); i++)
+		{
+			auto &zr = *batchBegin[i].first;
+			auto p = zr.dest;
+			for(auto b : reqs[i].dest.first(reqs[i].bytesRead))
+			{
+				*p = b;
+				p += 2;
+			}
+			zr.bytesRead = reqs[i].bytesRead;
+			if(onRead)
+				onRead(zr.bytesRead);
+		}
+		batchBegin = batchEnd;
+	}
+	return found;
+}
+
 PKZIP *gn_open_zip(void *contextPtr, const char *path)
 {
 	auto &ctx = *((IG::ApplicationContext*)contextPtr);
 	try
 	{
-		auto arch = std::make_unique<FS::ArchiveIterator>(ctx.openFileUri(path));
-		return static_cast<PKZIP*>(arch.release());
+		return new PKZIP{FS::ArchiveIndex{ctx.openFileUri(path)}};
 	}
 	catch(...)
 	{
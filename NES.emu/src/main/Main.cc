@@ -53,6 +53,7 @@ bool EmuSystem::hasPALVideoSystem = true;
 bool EmuSystem::hasResetModes = true;
 bool EmuSystem::hasRectangularPixels = true;
 bool EmuApp::needsGlobalInstance = true;
+bool EmuSystem::canRunAhead = true;
 unsigned fceuCheats = 0;
 
 NesApp::NesApp(ApplicationInitParams initParams, ApplicationContext &ctx):
@@ -441,12 +442,12 @@ void NesSystem::renderVideo(EmuSystemTaskContext taskCtx, EmuVideo &video, uint8
 	assumeExpr(pix.size() == ppuPixRegion.size());
 	if(pix.format() == IG::PIXEL_RGB565)
 	{
-		pix.writeTransformed([&](uint8 p){ return nativeCol.col16[p]; }, ppuPixRegion);
+		pix.writePaletteExpanded<uint16_t>(nativeCol.col16, ppuPixRegion);
 	}
 	else
 	{
 		assumeExpr(pix.format().bytesPerPixel() == 4);
-		pix.writeTransformed([&](uint8 p){ return nativeCol.col32[p]; }, ppuPixRegion);
+		pix.writePaletteExpanded<uint32_t>(nativeCol.col32, ppuPixRegion);
 	}
 	img.endFrame();
 }
@@ -39,6 +39,7 @@ namespace EmuEx
 
 const char *EmuSystem::creditsViewStr = CREDITS_INFO_STRING "(c) 2011-2024\nRobert Broglia\nwww.explusalpha.com\n\nPortions (c) the\nMednafen Team\nmednafen.github.io";
 bool EmuApp::needsGlobalInstance = true;
+bool EmuSystem::canRunAhead = true;
 
 EmuSystem::NameFilterFunc EmuSystem::defaultFsFilter =
 	[](std::string_view name)
@@ -72,7 +73,8 @@ FS::FileString NgpSystem::stateFilename(int slot, std::string_view name) const
 
 size_t NgpSystem::stateSize() { return stateSizeMDFN(); }
 void NgpSystem::readState(EmuApp &app, std::span<uint8_t> buff) { readStateMDFN(app, buff); }
-size_t NgpSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags) { return writeStateMDFN(buff, flags); }
+size_t NgpSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags) { return writeStateMDFN(*this, buff, flags); }
+size_t NgpSystem::compressState(std::span<uint8_t> dest, std::span<const uint8_t> state) const { return compressStateData(dest, state); }
 
 static FS::PathString saveFilename(const EmuApp &app)
 {
@@ -301,6 +301,27 @@ class CustomSystemOptionView : public SystemOptionView, public MainAppHelper<Cus
 		return [this](TextMenuItem &item) { system().setCdSpeed(item.id); };
 	}
 
+	TextMenuItem cddaCacheItem[5]
+	{
+		{"Off", attachParams(), setCddaCacheDel(), {.id = 0}},
+		{"1s",  attachParams(), setCddaCacheDel(), {.id = 1}},
+		{"2s",  attachParams(), setCddaCacheDel(), {.id = 2}},
+		{"4s",  attachParams(), setCddaCacheDel(), {.id = 4}},
+		{"8s",  attachParams(), setCddaCacheDel(), {.id = 8}},
+	};
+
+	MultiChoiceMenuItem cddaCache
+	{
+		"CD Audio Decode Buffer", attachParams(),
+		MenuId{system().cddaCacheSeconds},
+		cddaCacheItem
+	};
+
+	TextMenuItem::SelectDelegate setCddaCacheDel()
+	{
+		return [this](TextMenuItem &item) { system().cddaCacheSeconds = item.id; };
+	}
+
 	TextMenuItem emuCoreItems[3]
 	{
 		{"Auto",      attachParams(), setEmuCoreDel(), {.id = EmuCore::Auto}},
@@ -351,6 +372,7 @@ public:
 		loadStockItems();
 		item.emplace_back(&emuCore);
 		item.emplace_back(&cdSpeed);
+		item.emplace_back(&cddaCache);
 		item.emplace_back(&saveFilenameType);
 	}
 };
@@ -40,6 +40,7 @@ constexpr double masterClockFrac = 21477272.727273 / 3.;
 constexpr auto pceFrameTimeWith262Lines{fromSeconds<FrameTime>(455. * 262. / masterClockFrac)}; // ~60.05Hz
 constexpr auto pceFrameTime{fromSeconds<FrameTime>(455. * 263. / masterClockFrac)}; //~59.82Hz
 bool EmuApp::needsGlobalInstance = true;
+bool EmuSystem::canRunAhead = true;
 
 PceApp::PceApp(ApplicationInitParams initParams, ApplicationContext &ctx):
 	EmuApp{initParams, ctx}, pceSystem{ctx} {}
@@ -129,11 +130,11 @@ void PceSystem::loadContent(IO &io, EmuSystemCreateParams, OnLoadProgressDelegat
 		if(isArchive)
 		{
 			ArchiveVFS archVFS{ArchiveIO{std::move(io)}};
-			CDInterfaces.push_back(CDInterface::Open(&archVFS, std::string{contentFileName()}, true, 0));
+			CDInterfaces.push_back(CDInterface::Open(&archVFS, std::string{contentFileName()}, true, 0, cddaCacheSeconds));
 		}
 		else
 		{
-			CDInterfaces.push_back(CDInterface::Open(&NVFS, std::string{contentLocation()}, false, 0));
+			CDInterfaces.push_back(CDInterface::Open(&NVFS, std::string{contentLocation()}, false, 0, cddaCacheSeconds));
 		}
 		writeCDMD5(mdfnGameInfo, CDInterfaces);
 		mdfnGameInfo.LoadCD(&CDInterfaces);
@@ -211,7 +212,8 @@ void PceSystem::reset(EmuApp &, ResetMode mode)
 
 size_t PceSystem::stateSize() { return stateSizeMDFN(); }
 void PceSystem::readState(EmuApp &app, std::span<uint8_t> buff) { readStateMDFN(app, buff); }
-size_t PceSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags) { return writeStateMDFN(buff, flags); }
+size_t PceSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags) { return writeStateMDFN(*this, buff, flags); }
+size_t PceSystem::compressState(std::span<uint8_t> dest, std::span<const uint8_t> state) const { return compressStateData(dest, state); }
 
 double PceSystem::videoAspectRatioScale() const
 {
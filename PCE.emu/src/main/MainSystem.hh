@@ -65,7 +65,7 @@ enum
 	CFGKEY_NO_SPRITE_LIMIT = 281, CFGKEY_CD_SPEED = 282,
 	CFGKEY_CDDA_VOLUME = 283, CFGKEY_ADPCM_VOLUME = 284,
 	CFGKEY_ADPCM_FILTER = 285, CFGKEY_EMU_CORE = 286,
-	CFGKEY_NO_MD5_FILENAMES = 287,
+	CFGKEY_NO_MD5_FILENAMES = 287, CFGKEY_CDDA_CACHE_SECONDS = 288,
 };
 
 void set6ButtonPadEnabled(EmuApp &, bool);
@@ -107,6 +107,7 @@ public:
 	VisibleLines defaultVisibleLines{};
 	VisibleLines visibleLines{};
 	uint8_t cdSpeed{2};
+	uint8_t cddaCacheSeconds{2};
 	uint8_t cddaVolume{100};
 	uint8_t adpcmVolume{100};
 	bool noSpriteLimit{};
@@ -140,6 +141,7 @@ public:
 	size_t stateSize();
 	void readState(EmuApp &, std::span<uint8_t> buff);
 	size_t writeState(std::span<uint8_t> buff, SaveStateFlags);
+	size_t compressState(std::span<uint8_t> dest, std::span<const uint8_t> state) const;
 	bool readConfig(ConfigType, MapIO &, unsigned key, size_t readSize);
 	void writeConfig(ConfigType, FileIO &);
 	void reset(EmuApp &, ResetMode mode);
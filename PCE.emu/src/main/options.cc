@@ -68,6 +68,7 @@ bool PceSystem::readConfig(ConfigType type, MapIO &io, unsigned key, size_t read
 			case CFGKEY_CORRECT_LINE_ASPECT: return readOptionValue(io, readSize, correctLineAspect);
 			case CFGKEY_NO_SPRITE_LIMIT: return readOptionValue(io, readSize, noSpriteLimit);
 			case CFGKEY_CD_SPEED: return readOptionValue(io, readSize, cdSpeed, [](auto val){return val <= 8;});
+			case CFGKEY_CDDA_CACHE_SECONDS: return readOptionValue(io, readSize, cddaCacheSeconds, [](auto val){return val <= 2 || val == 4 || val == 8;});
 			case CFGKEY_CDDA_VOLUME: return readOptionValue(io, readSize, cddaVolume, [](auto val){return val <= 200;});
 			case CFGKEY_ADPCM_VOLUME: return readOptionValue(io, readSize, adpcmVolume, [](auto val){return val <= 200;});
 			case CFGKEY_ADPCM_FILTER: return readOptionValue(io, readSize, adpcmFilter);
@@ -101,6 +102,7 @@ void PceSystem::writeConfig(ConfigType type, FileIO &io)
 			writeOptionValue(io, CFGKEY_NO_SPRITE_LIMIT, noSpriteLimit);
 		if(cdSpeed != 2)
 			writeOptionValue(io, CFGKEY_CD_SPEED, cdSpeed);
+		writeOptionValueIfNotDefault(io, CFGKEY_CDDA_CACHE_SECONDS, cddaCacheSeconds, 2);
 		if(cddaVolume != 100)
 			writeOptionValue(io, CFGKEY_CDDA_VOLUME, cddaVolume);
 		if(adpcmVolume != 100)
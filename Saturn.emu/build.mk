@@ -41,15 +41,19 @@ ifeq ($(ARCH), arm)
   yabause/sh2_dynarec/sh2_dynarec.c
  endif
 else ifeq ($(ARCH), x86_64)
- # TODO: x86_64 dynarec has 64/32-bit pointer conversion issues
- #CPPFLAGS += -DCPU_X64=1 -DUSE_DYNAREC=1 -DSH2_DYNAREC=1
- #SRC += yabause/sh2_dynarec/linkage_x64.s yabause/sh2_dynarec/sh2_dynarec.c
+ CPPFLAGS += -DCPU_X64=1 \
+ -DUSE_DYNAREC=1 \
+ -DSH2_DYNAREC=1
+ SRC += yabause/sh2_dynarec/linkage_x64.s \
+ yabause/sh2_dynarec/sh2_dynarec.c
+ q68JIT := 1
 else ifeq ($(ARCH), x86)
  CPPFLAGS += -DCPU_X86=1 \
  -DUSE_DYNAREC=1 \
  -DSH2_DYNAREC=1
  SRC += yabause/sh2_dynarec/linkage_x86.s \
  yabause/sh2_dynarec/sh2_dynarec.c
+ q68JIT := 1
 endif
 
 SRC += yabause/bios.c \
@@ -92,7 +96,12 @@ SRC += yabause/q68/q68.c \
 yabause/q68/q68-core.c \
 yabause/m68kq68.c
 CPPFLAGS += -DHAVE_Q68=1
-# TODO: -DQ68_USE_JIT=1
+# the Q68 JIT only has x86/x86_64 and PSP (MIPS) backends
+ifdef q68JIT
+ SRC += yabause/q68/q68-jit.c \
+ yabause/q68/q68-jit-x86.S
+ CPPFLAGS += -DQ68_USE_JIT=1
+endif
 
 include $(EMUFRAMEWORK_PATH)/package/emuframework.mk
 
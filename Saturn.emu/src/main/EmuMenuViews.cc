@@ -69,6 +69,19 @@ class CustomSystemOptionView : public SystemOptionView
 		sh2CoreItem
 	};
 
+	#ifdef Q68_USE_JIT
+	BoolMenuItem m68kJIT
+	{
+		"68K JIT", attachParams(),
+		(bool)optionM68KJIT,
+		[this](BoolMenuItem &item)
+		{
+			optionM68KJIT = item.flipBoolValue(*this);
+			yinit.m68kcoretype = optionM68KJIT ? M68KCORE_Q68JIT : M68KCORE_Q68;
+		}
+	};
+	#endif
+
 public:
 	CustomSystemOptionView(ViewAttachParams attach): SystemOptionView{attach, true}
 	{
@@ -87,6 +100,9 @@ public:
 			}
 			item.emplace_back(&sh2Core);
 		}
+		#ifdef Q68_USE_JIT
+		item.emplace_back(&m68kJIT);
+		#endif
 		item.emplace_back(&bios);
 	}
 };
@@ -17,6 +17,9 @@
 #include <emuframework/EmuSystemInlines.hh>
 #include <emuframework/EmuAppInlines.hh>
 #include <imagine/fs/FS.hh>
+#include <imagine/io/FileStream.hh>
+#include <imagine/io/MapIO.hh>
+#include <imagine/audio/SampleConversion.hh>
 #include <imagine/util/format.hh>
 #include <imagine/util/string.h>
 
@@ -32,14 +35,16 @@ extern "C"
 	#include <yabause/cdbase.h>
 	#include <yabause/cs0.h>
 	#include <yabause/cs2.h>
+	#include <yabause/memory.h>
 }
 
 // from sh2_dynarec.c
 #define SH2CORE_DYNAREC 2
 extern const int defaultSH2CoreID =
-#ifdef SH2_DYNAREC
+#if defined SH2_DYNAREC && !defined CPU_X64
 SH2CORE_DYNAREC;
 #else
+// the x86_64 dynarec can be picked in the options but isn't the default yet
 SH2CORE_INTERPRETER;
 #endif
 
@@ -67,19 +72,6 @@ static void SNDImagineUnMuteAudio() {}
 static void SNDImagineSetVolume(int volume) {}
 static int SNDImagineChangeVideoFormat(int vertfreq) { return 0; }
 
-static void mergeSamplesToStereo(s32 srcL, s32 srcR, s16 *dst)
-{
-	// Left Channel
-	if (srcL > 0x7FFF) *dst = 0x7FFF;
-	else if (srcL < -0x8000) *dst = -0x8000;
-	else *dst = srcL;
-	dst++;
-	// Right Channel
-	if (srcR > 0x7FFF) *dst = 0x7FFF;
-	else if (srcR < -0x8000) *dst = -0x8000;
-	else *dst = srcR;
-}
-
 static void SNDImagineUpdateAudioNull(u32 *leftchanbuffer, u32 *rightchanbuffer, u32 frames) {}
 
 static void SNDImagineUpdateAudio(u32 *leftchanbuffer, u32 *rightchanbuffer, u32 frames);
@@ -130,6 +122,9 @@ M68K_struct *M68KCoreList[] =
 	#endif
 	#ifdef HAVE_Q68
 	&M68KQ68,
+	#ifdef Q68_USE_JIT
+	&M68KQ68JIT,
+	#endif
 	#endif
 	nullptr
 };
@@ -227,6 +222,11 @@ CLINK void YuiSwapBuffers()
 	}
 }
 
+CLINK void YuiParallelFor(int begin, int end, int grainSize, void (*func)(void *data, int begin, int end), void *data)
+{
+	gApp().jobSystem.parallelFor(begin, end, grainSize, [&](int rowBegin, int rowEnd){ func(data, rowBegin, rowEnd); });
+}
+
 CLINK void YuiSetVideoAttribute(int type, int val) { }
 CLINK int YuiSetVideoMode(int width, int height, int bpp, int fullscreen) { return 0; }
 
@@ -258,9 +258,49 @@ FS::FileString SaturnSystem::stateFilename(int slot, std::string_view name) cons
 	return IG::format<FS::FileString>("{}.0{}.yss", name, saveSlotCharUpper(slot));
 }
 
-size_t SaturnSystem::stateSize() { return 0; }
-void SaturnSystem::readState(EmuApp &app, std::span<uint8_t> buff) {}
-size_t SaturnSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags) { return 0; }
+static size_t writeYabState(std::span<uint8_t> buff)
+{
+	IG::FileStream<MapIO> stream{MapIO{buff}, "wb"};
+	auto size = YabSaveStateStream(stream.filePtr());
+	if(size < 0)
+		throw std::runtime_error("Error writing state data");
+	return size;
+}
+
+size_t SaturnSystem::stateSize() { return saveStateSize; }
+
+void SaturnSystem::readState(EmuApp &app, std::span<uint8_t> buff)
+{
+	ScratchBuffer uncompArr;
+	if(isCompressed(buff))
+	{
+		uncompArr = uncompressState(buff, saveStateSize);
+		buff = uncompArr;
+	}
+	IG::FileStream<MapIO> stream{MapIO{buff}, "rb"};
+	if(YabLoadStateStream(stream.filePtr()) != 0)
+		throw std::runtime_error("Invalid state data");
+}
+
+size_t SaturnSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags)
+{
+	if(flags.uncompressed)
+	{
+		return writeYabState(buff);
+	}
+	else
+	{
+		assert(saveStateSize);
+		auto stateArr = stateScratchBuffer(saveStateSize);
+		writeYabState(stateArr);
+		return compressState(buff, stateArr);
+	}
+}
+
+size_t SaturnSystem::compressState(std::span<uint8_t> dest, std::span<const uint8_t> state) const
+{
+	return compressStateData(dest, state);
+}
 
 void SaturnSystem::onFlushBackupMemory(EmuApp &, BackupMemoryDirtyFlags)
 {
@@ -297,6 +337,9 @@ void SaturnSystem::loadContent(IO &, EmuSystemCreateParams, OnLoadProgressDelega
 	pad[0] = PerPadAdd(&PORTDATA1);
 	pad[1] = PerPadAdd(&PORTDATA2);
 	ScspSetFrameAccurate(1);
+	// state size depends on the cartridge type, measure it once per content
+	static constexpr size_t maxStateSize = 0x1000000;
+	saveStateSize = writeYabState({std::make_unique<uint8_t[]>(maxStateSize).get(), maxStateSize});
 }
 
 void SaturnSystem::configAudioRate(FrameTime outputFrameTime, int outputRate)
@@ -332,10 +375,7 @@ static void SNDImagineUpdateAudio(u32 *leftchanbuffer, u32 *rightchanbuffer, u32
 {
 	//logMsg("got %d audio frames to write", frames);
 	s16 sample[frames*2];
-	for(auto i : IG::iotaCount(frames))
-	{
-		mergeSamplesToStereo(leftchanbuffer[i], rightchanbuffer[i], &sample[i*2]);
-	}
+	IG::Audio::mergeStereoSamples(sample, (const int32_t*)leftchanbuffer, (const int32_t*)rightchanbuffer, frames);
 	if(EmuEx::emuAudio)
 	{
 		EmuEx::emuAudio->writeFrames(sample, frames);
@@ -7,6 +7,7 @@ extern "C"
 {
 	#include <yabause/yabause.h>
 	#include <yabause/sh2core.h>
+	#include <yabause/m68kcore.h>
 	#include <yabause/peripheral.h>
 }
 
@@ -22,6 +23,7 @@ namespace EmuEx
 {
 
 extern Byte1Option optionSH2Core;
+extern Byte1Option optionM68KJIT;
 extern FS::PathString biosPath;
 extern unsigned SH2Cores;
 extern yabauseinit_struct yinit;
@@ -30,6 +32,8 @@ extern PerPad_struct *pad[2];
 class SaturnSystem final: public EmuSystem
 {
 public:
+	size_t saveStateSize{};
+
 	SaturnSystem(ApplicationContext ctx):
 		EmuSystem{ctx}
 	{
@@ -44,6 +48,7 @@ public:
 	size_t stateSize();
 	void readState(EmuApp &, std::span<uint8_t> buff);
 	size_t writeState(std::span<uint8_t> buff, SaveStateFlags);
+	size_t compressState(std::span<uint8_t> dest, std::span<const uint8_t> state) const;
 	bool readConfig(ConfigType, MapIO &, unsigned key, size_t readSize);
 	void writeConfig(ConfigType, FileIO &);
 	void reset(EmuApp &, ResetMode mode);
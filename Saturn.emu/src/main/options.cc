@@ -36,7 +36,7 @@ namespace EmuEx
 
 enum
 {
-	CFGKEY_BIOS_PATH = 279, CFGKEY_SH2_CORE = 280
+	CFGKEY_BIOS_PATH = 279, CFGKEY_SH2_CORE = 280, CFGKEY_M68K_JIT = 281
 };
 
 static bool OptionSH2CoreIsValid(uint8_t val)
@@ -56,6 +56,9 @@ static bool OptionSH2CoreIsValid(uint8_t val)
 const char *EmuSystem::configFilename = "SaturnEmu.config";
 Byte1Option optionSH2Core{CFGKEY_SH2_CORE, (uint8_t)defaultSH2CoreID, false, OptionSH2CoreIsValid};
 unsigned SH2Cores = std::size(SH2CoreList) - 1;
+#ifdef Q68_USE_JIT
+Byte1Option optionM68KJIT{CFGKEY_M68K_JIT, 0};
+#endif
 bool EmuApp::hasIcon = false;
 bool EmuSystem::hasSound = !(Config::envIsAndroid || Config::envIsIOS);
 int EmuSystem::forcedSoundRate = 44100;
@@ -73,6 +76,9 @@ std::span<const AspectRatioInfo> SaturnSystem::aspectRatioInfos()
 void SaturnSystem::onOptionsLoaded()
 {
 	yinit.sh2coretype = optionSH2Core;
+	#ifdef Q68_USE_JIT
+	yinit.m68kcoretype = optionM68KJIT ? M68KCORE_Q68JIT : M68KCORE_Q68;
+	#endif
 }
 
 bool SaturnSystem::readConfig(ConfigType type, MapIO &io, unsigned key, size_t readSize)
@@ -84,6 +90,9 @@ bool SaturnSystem::readConfig(ConfigType type, MapIO &io, unsigned key, size_t r
 			case CFGKEY_BIOS_PATH:
 				return readStringOptionValue(io, readSize, biosPath);
 			case CFGKEY_SH2_CORE: return optionSH2Core.readFromIO(io, readSize);
+			#ifdef Q68_USE_JIT
+			case CFGKEY_M68K_JIT: return optionM68KJIT.readFromIO(io, readSize);
+			#endif
 		}
 	}
 	return false;
@@ -95,6 +104,9 @@ void SaturnSystem::writeConfig(ConfigType type, FileIO &io)
 	{
 		writeStringOptionValue(io, CFGKEY_BIOS_PATH, biosPath);
 		optionSH2Core.writeWithKeyIfNotDefault(io);
+		#ifdef Q68_USE_JIT
+		optionM68KJIT.writeWithKeyIfNotDefault(io);
+		#endif
 	}
 }
 
@@ -23,6 +23,11 @@
 
 #include "q68/q68.h"
 
+#ifdef Q68_USE_JIT
+# include <string.h>
+# include <sys/mman.h>
+#endif
+
 /*************************************************************************/
 
 /**
@@ -52,6 +57,9 @@
 /* Interface function declarations (must come before interface definition) */
 
 static int m68kq68_init(void);
+#ifdef Q68_USE_JIT
+static int m68kq68_init_jit(void);
+#endif
 static void m68kq68_deinit(void);
 static void m68kq68_reset(void);
 
@@ -84,6 +92,12 @@ static void m68kq68_set_writew(M68K_WRITE *func);
 static uint32_t dummy_read(uint32_t address);
 static void dummy_write(uint32_t address, uint32_t data);
 
+#ifdef Q68_USE_JIT
+static void *jit_code_malloc(size_t size);
+static void *jit_code_realloc(void *ptr, size_t size);
+static void jit_code_free(void *ptr);
+#endif
+
 #ifdef NEED_TRAMPOLINE
 static uint32_t readb_trampoline(uint32_t address);
 static uint32_t readw_trampoline(uint32_t address);
@@ -130,6 +144,47 @@ M68K_struct M68KQ68 = {
     .SetWriteW   = m68kq68_set_writew,
 };
 
+#ifdef Q68_USE_JIT
+
+/* Same interface with dynamic translation enabled */
+
+M68K_struct M68KQ68JIT = {
+    .id          = M68KCORE_Q68JIT,
+    .Name        = "Q68 68k Emulator Interface (JIT)",
+
+    .Init        = m68kq68_init_jit,
+    .DeInit      = m68kq68_deinit,
+    .Reset       = m68kq68_reset,
+
+    .Exec        = m68kq68_exec,
+    .Sync        = m68kq68_sync,
+
+    .GetDReg     = m68kq68_get_dreg,
+    .GetAReg     = m68kq68_get_areg,
+    .GetPC       = m68kq68_get_pc,
+    .GetSR       = m68kq68_get_sr,
+    .GetUSP      = m68kq68_get_usp,
+    .GetMSP      = m68kq68_get_ssp,
+
+    .SetDReg     = m68kq68_set_dreg,
+    .SetAReg     = m68kq68_set_areg,
+    .SetPC       = m68kq68_set_pc,
+    .SetSR       = m68kq68_set_sr,
+    .SetUSP      = m68kq68_set_usp,
+    .SetMSP      = m68kq68_set_ssp,
+
+    .SetIRQ      = m68kq68_set_irq,
+    .WriteNotify = m68kq68_write_notify,
+
+    .SetFetch    = m68kq68_set_fetch,
+    .SetReadB    = m68kq68_set_readb,
+    .SetReadW    = m68kq68_set_readw,
+    .SetWriteB   = m68kq68_set_writeb,
+    .SetWriteW   = m68kq68_set_writew,
+};
+
+#endif
+
 /*-----------------------------------------------------------------------*/
 
 /* Virtual processor state block */
@@ -172,6 +227,31 @@ static int m68kq68_init(void)
     return 0;
 }
 
+#ifdef Q68_USE_JIT
+
+/**
+ * m68kq68_init_jit:  Initialize the virtual processor with dynamic
+ * translation enabled.
+ *
+ * [Parameters]
+ *     None
+ * [Return value]
+ *     Zero on success, negative on failure
+ */
+static int m68kq68_init_jit(void)
+{
+    if (m68kq68_init() != 0) {
+        return -1;
+    }
+    q68_set_jit_code_funcs(state, jit_code_malloc, jit_code_realloc,
+                           jit_code_free);
+    q68_set_jit(state, 1);
+
+    return 0;
+}
+
+#endif  // Q68_USE_JIT
+
 /*-----------------------------------------------------------------------*/
 
 /**
@@ -520,6 +600,60 @@ static void writew_trampoline(uint32_t address, uint32_t data) {
 
 #endif  // NEED_TRAMPOLINE
 
+/*-----------------------------------------------------------------------*/
+
+#ifdef Q68_USE_JIT
+
+/**
+ * jit_code_malloc, jit_code_realloc, jit_code_free:  Allocate executable
+ * memory for translated code, since the regular heap isn't executable on
+ * NX-enabled hosts.  Each buffer gets its own mapping with the mapping
+ * size stored in front of the returned pointer.
+ *
+ * [Parameters]
+ *      ptr: Buffer to resize or free (jit_code_realloc/free only)
+ *     size: Requested buffer size in bytes (jit_code_malloc/realloc only)
+ * [Return value]
+ *     Allocated buffer, NULL on failure (jit_code_malloc/realloc only)
+ */
+
+#define JIT_CODE_HEADER 16  // Keeps the code 16-byte aligned
+
+static void *jit_code_malloc(size_t size) {
+    const size_t map_size = size + JIT_CODE_HEADER;
+    void *base = mmap(NULL, map_size, PROT_READ | PROT_WRITE | PROT_EXEC,
+                      MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+    *(size_t *)base = map_size;
+    return (uint8_t *)base + JIT_CODE_HEADER;
+}
+
+static void *jit_code_realloc(void *ptr, size_t size) {
+    if (!ptr) {
+        return jit_code_malloc(size);
+    }
+    const size_t old_size =
+        *(size_t *)((uint8_t *)ptr - JIT_CODE_HEADER) - JIT_CODE_HEADER;
+    void *new_ptr = jit_code_malloc(size);
+    if (!new_ptr) {
+        return NULL;
+    }
+    memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+    jit_code_free(ptr);
+    return new_ptr;
+}
+
+static void jit_code_free(void *ptr) {
+    if (ptr) {
+        void *base = (uint8_t *)ptr - JIT_CODE_HEADER;
+        munmap(base, *(size_t *)base);
+    }
+}
+
+#endif  // Q68_USE_JIT
+
 /*************************************************************************/
 /*************************************************************************/
 
@@ -992,31 +992,26 @@ void FormatBackupRam(void *mem, u32 size)
 //    [sh2core.c] frc.div changed to frc.shift
 //    [sh2core.c] wdt probably needs to be written as well
 
-int YabSaveState(const char *filename)
+// Writes a complete state to fp, returns its size or a negative value on error.
+// The screenshot and movie data are only written when withextras is set, memory
+// streams used for rewind and in-memory states leave them out.
+static int SaveStateToStream(FILE *fp, int withextras)
 {
    u32 i;
-   FILE *fp;
    int offset;
    IOCheck_struct check;
    u8 *buf;
    int totalsize;
-   int outputwidth;
-   int outputheight;
+   int outputwidth = 0;
+   int outputheight = 0;
    int movieposition;
    int temp;
    u32 temp32;
+   long end;
 
    check.done = 0;
    check.size = 0;
 
-   //use a second set of savestates for movies
-   filename = MakeMovieStateName(filename);
-   if (!filename)
-      return -1;
-
-   if ((fp = fopen(filename, "wb")) == NULL)
-      return -1;
-
    // Write signature
    fprintf(fp, "YSS");
 
@@ -1072,43 +1067,81 @@ int YabSaveState(const char *filename)
    ywrite(&check, (void *)&yabsys.CurSH2FreqType, sizeof(int), 1, fp);
    ywrite(&check, (void *)&yabsys.IsPal, sizeof(int), 1, fp);
 
-   VIDCore->GetGlSize(&outputwidth, &outputheight);
+   if (withextras)
+   {
+      VIDCore->GetGlSize(&outputwidth, &outputheight);
 
-   totalsize=outputwidth * outputheight * sizeof(u32);
+      totalsize=outputwidth * outputheight * sizeof(u32);
 
-   if ((buf = (u8 *)malloc(totalsize)) == NULL)
-   {
-      return -2;
-   }
+      if ((buf = (u8 *)malloc(totalsize)) == NULL)
+      {
+         return -2;
+      }
 
-   YuiSwapBuffers();
-   #ifdef USE_OPENGL
-   glPixelZoom(1,1);
-   glReadBuffer(GL_BACK);
-   glReadPixels(0, 0, outputwidth, outputheight, GL_RGBA, GL_UNSIGNED_BYTE, buf);
-   #endif
-   YuiSwapBuffers();
+      YuiSwapBuffers();
+      #ifdef USE_OPENGL
+      glPixelZoom(1,1);
+      glReadBuffer(GL_BACK);
+      glReadPixels(0, 0, outputwidth, outputheight, GL_RGBA, GL_UNSIGNED_BYTE, buf);
+      #endif
+      YuiSwapBuffers();
 
-   ywrite(&check, (void *)&outputwidth, sizeof(outputwidth), 1, fp);
-   ywrite(&check, (void *)&outputheight, sizeof(outputheight), 1, fp);
+      ywrite(&check, (void *)&outputwidth, sizeof(outputwidth), 1, fp);
+      ywrite(&check, (void *)&outputheight, sizeof(outputheight), 1, fp);
 
-   ywrite(&check, (void *)buf, totalsize, 1, fp);
-   free(buf);
+      ywrite(&check, (void *)buf, totalsize, 1, fp);
+      free(buf);
+   }
+   else
+   {
+      // empty screenshot
+      ywrite(&check, (void *)&outputwidth, sizeof(outputwidth), 1, fp);
+      ywrite(&check, (void *)&outputheight, sizeof(outputheight), 1, fp);
+   }
 
    movieposition=ftell(fp);
    //write the movie to the end of the savestate
-   SaveMovieInState(fp, check);
+   if (withextras)
+      SaveMovieInState(fp, check);
 
    i += StateFinishHeader(fp, offset);
+   end = ftell(fp);
 
    // Go back and update size
    fseek(fp, 8, SEEK_SET);
    ywrite(&check, (void *)&i, sizeof(i), 1, fp);
    fseek(fp, 16, SEEK_SET);
    ywrite(&check, (void *)&movieposition, sizeof(movieposition), 1, fp);
+   fseek(fp, end, SEEK_SET);
+
+   if (check.done != check.size)
+      return -1;
+
+   return (int)end;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int YabSaveState(const char *filename)
+{
+   FILE *fp;
+   int ret;
+
+   //use a second set of savestates for movies
+   filename = MakeMovieStateName(filename);
+   if (!filename)
+      return -1;
+
+   if ((fp = fopen(filename, "wb")) == NULL)
+      return -1;
+
+   ret = SaveStateToStream(fp, 1);
 
    fclose(fp);
 
+   if (ret < 0)
+      return ret;
+
    OSDPushMessage(OSDMSG_STATUS, 150, "STATE SAVED");
 
    return 0;
@@ -1116,9 +1149,17 @@ int YabSaveState(const char *filename)
 
 //////////////////////////////////////////////////////////////////////////////
 
-int YabLoadState(const char *filename)
+int YabSaveStateStream(FILE *fp)
+{
+   return SaveStateToStream(fp, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Loads a state from fp. A NULL filename marks a memory stream: its size may
+// be larger than the state data and no movie data is read.
+static int LoadStateFromStream(FILE *fp, const char *filename)
 {
-   FILE *fp;
    char id[3];
    u8 endian;
    int headerversion, version, size, chunksize, headersize;
@@ -1132,13 +1173,7 @@ int YabLoadState(const char *filename)
    int movieposition;
    int temp;
    u32 temp32;
-
-   filename = MakeMovieStateName(filename);
-   if (!filename)
-      return -1;
-
-   if ((fp = fopen(filename, "rb")) == NULL)
-      return -1;
+   long streamsize;
 
    headersize = 0xC;
 
@@ -1147,7 +1182,6 @@ int YabLoadState(const char *filename)
 
    if (strncmp(id, "YSS", 3) != 0)
    {
-      fclose(fp);
       return -2;
    }
 
@@ -1170,7 +1204,6 @@ int YabLoadState(const char *filename)
       default:
          /* we're trying to open a save state using a future version
           * of the YSS format, that won't work, sorry :) */
-         fclose(fp);
          return -3;
          break;
    }
@@ -1183,16 +1216,15 @@ int YabLoadState(const char *filename)
    {
       // should setup reading so it's byte-swapped
       YabSetError(YAB_ERR_OTHER, (void *)"Load State byteswapping not supported");
-      fclose(fp);
       return -3;
    }
 
    // Make sure size variable matches actual size minus header
    fseek(fp, 0, SEEK_END);
+   streamsize = ftell(fp) - headersize;
 
-   if (size != (ftell(fp) - headersize))
+   if (filename ? size != streamsize : size > streamsize)
    {
-      fclose(fp);
       return -2;
    }
    fseek(fp, headersize, SEEK_SET);
@@ -1203,7 +1235,6 @@ int YabLoadState(const char *filename)
    
    if (StateCheckRetrieveHeader(fp, "CART", &version, &chunksize) != 0)
    {
-      fclose(fp);
       // Revert back to old state here
       ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
       return -3;
@@ -1212,7 +1243,6 @@ int YabLoadState(const char *filename)
 
    if (StateCheckRetrieveHeader(fp, "CS2 ", &version, &chunksize) != 0)
    {
-      fclose(fp);
       // Revert back to old state here
       ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
       return -3;
@@ -1221,7 +1251,6 @@ int YabLoadState(const char *filename)
 
    if (StateCheckRetrieveHeader(fp, "MSH2", &version, &chunksize) != 0)
    {
-      fclose(fp);
       // Revert back to old state here
       ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
       return -3;
@@ -1230,7 +1259,6 @@ int YabLoadState(const char *filename)
 
    if (StateCheckRetrieveHeader(fp, "SSH2", &version, &chunksize) != 0)
    {
-      fclose(fp);
       // Revert back to old state here
       ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
       return -3;
@@ -1239,7 +1267,6 @@ int YabLoadState(const char *filename)
 
    if (StateCheckRetrieveHeader(fp, "SCSP", &version, &chunksize) != 0)
    {
-      fclose(fp);
       // Revert back to old state here
       ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
       return -3;
@@ -1248,7 +1275,6 @@ int YabLoadState(const char *filename)
 
    if (StateCheckRetrieveHeader(fp, "SCU ", &version, &chunksize) != 0)
    {
-      fclose(fp);
       // Revert back to old state here
       ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
       return -3;
@@ -1257,7 +1283,6 @@ int YabLoadState(const char *filename)
 
    if (StateCheckRetrieveHeader(fp, "SMPC", &version, &chunksize) != 0)
    {
-      fclose(fp);
       // Revert back to old state here
       ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
       return -3;
@@ -1266,7 +1291,6 @@ int YabLoadState(const char *filename)
 
    if (StateCheckRetrieveHeader(fp, "VDP1", &version, &chunksize) != 0)
    {
-      fclose(fp);
       // Revert back to old state here
       ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
       return -3;
@@ -1275,7 +1299,6 @@ int YabLoadState(const char *filename)
 
    if (StateCheckRetrieveHeader(fp, "VDP2", &version, &chunksize) != 0)
    {
-      fclose(fp);
       // Revert back to old state here
       ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
       return -3;
@@ -1284,7 +1307,6 @@ int YabLoadState(const char *filename)
 
    if (StateCheckRetrieveHeader(fp, "OTHR", &version, &chunksize) != 0)
    {
-      fclose(fp);
       // Revert back to old state here
       ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
       return -3;
@@ -1306,7 +1328,7 @@ int YabLoadState(const char *filename)
    YabauseChangeTiming(yabsys.CurSH2FreqType);
    yabsys.UsecFrac = (temp32 << YABSYS_TIMING_BITS) * temp / 10;
 
-   if (headerversion > 1) {
+   if (headerversion > 1 && filename) {
 
    yread(&check, (void *)&outputwidth, sizeof(outputwidth), 1, fp);
    yread(&check, (void *)&outputheight, sizeof(outputheight), 1, fp);
@@ -1315,11 +1337,11 @@ int YabLoadState(const char *filename)
 
    if ((buf = (u8 *)malloc(totalsize)) == NULL)
    {
+      ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
       return -2;
    }
 
    yread(&check, (void *)buf, totalsize, 1, fp);
-   free(buf);
 
    YuiSwapBuffers();
 
@@ -1336,15 +1358,38 @@ int YabLoadState(const char *filename)
    glDrawPixels(outputwidth, outputheight, GL_RGBA, GL_UNSIGNED_BYTE, buf);
    #endif
    YuiSwapBuffers();
+   free(buf);
 
    fseek(fp, movieposition, SEEK_SET);
    MovieReadState(fp, filename);
    }
-   
-   fclose(fp);
 
    ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
 
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int YabLoadState(const char *filename)
+{
+   FILE *fp;
+   int ret;
+
+   filename = MakeMovieStateName(filename);
+   if (!filename)
+      return -1;
+
+   if ((fp = fopen(filename, "rb")) == NULL)
+      return -1;
+
+   ret = LoadStateFromStream(fp, filename);
+
+   fclose(fp);
+
+   if (ret != 0)
+      return ret;
+
    OSDPushMessage(OSDMSG_STATUS, 150, "STATE LOADED");
 
    return 0;
@@ -1352,6 +1397,13 @@ int YabLoadState(const char *filename)
 
 //////////////////////////////////////////////////////////////////////////////
 
+int YabLoadStateStream(FILE *fp)
+{
+   return LoadStateFromStream(fp, NULL);
+}
+
+//////////
+
 int YabSaveStateSlot(const char *dirpath, u8 slot)
 {
    char filename[512];
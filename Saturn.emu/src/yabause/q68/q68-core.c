@@ -263,7 +263,7 @@ int q68_run(Q68State *state, int cycles)
             }
         }
 #ifdef Q68_USE_JIT
-        if (!state->jit_running) {
+        if (state->jit_enabled && !state->jit_running) {
             state->jit_running = q68_jit_find(state, state->PC);
             if (UNLIKELY(!state->jit_running)) {
                 state->jit_running = q68_jit_translate(state, state->PC);
@@ -295,6 +295,18 @@ int q68_run(Q68State *state, int cycles)
             q68_ops[index]++;
 #endif
             state->cycles += (*opcode_table[index])(state, opcode);
+            if (UNLIKELY(state->exception)) {
+                /* These exceptions stack the address of the faulting
+                 * instruction rather than of the next one */
+                switch (state->exception) {
+                  case EX_ILLEGAL_INSTRUCTION:
+                  case EX_PRIVILEGE_VIOLATION:
+                  case EX_LINE_1010:
+                  case EX_LINE_1111:
+                    state->PC = state->current_PC - 2;
+                    break;
+                }
+            }
 #ifdef Q68_USE_JIT
         }
 #endif
@@ -924,6 +936,10 @@ static int opMOVE(Q68State *state, uint32_t opcode)
 {
     const int size = (opcode>>12==1 ? SIZE_B : opcode>>12==2 ? SIZE_L : SIZE_W);
 
+    if (size == SIZE_B && (opcode>>6 & 7) == EA_ADDRESS_REG) {
+        return op_ill(state, opcode);  // MOVEA.B doesn't exist
+    }
+
     int cycles_src;
     const uint32_t data = ea_get(state, opcode, size, 0, &cycles_src);
     if (cycles_src < 0) {
@@ -1250,13 +1266,17 @@ static int op_alu(Q68State *state, uint32_t opcode)
         areg_dest = 1;
     }
 
-    /* Retrieve the register and EA values */
-    uint32_t reg_val = areg_dest ? state->A[reg] : (state->D[reg] & valuemask);
+    /* Retrieve the EA and register values (in that order, so that e.g.
+     * SUBA.L -(A0),A0 sees the decremented register) */
     int cycles;
     uint32_t ea_val = ea_get(state, opcode, size, ea_dest, &cycles);
     if (cycles < 0) {
         return 0;
     }
+    uint32_t reg_val = areg_dest ? state->A[reg] : (state->D[reg] & valuemask);
+    if (areg_dest && size == SIZE_W) {
+        ea_val = (int32_t)(int16_t)ea_val;  // Word sources are sign-extended
+    }
     if (size == SIZE_L || areg_dest) {
         cycles += 4;
     }
@@ -1446,7 +1466,8 @@ static int op_MUL(Q68State *state, uint32_t opcode)
     if (sign) {
         state->D[reg] = (int16_t)state->D[reg] * (int16_t)data;
     } else {
-        state->D[reg] = (uint16_t)state->D[reg] * data;
+        /* Multiply as unsigned int, the promotion to int can overflow */
+        state->D[reg] = (uint32_t)(uint16_t)state->D[reg] * data;
     }
     INSN_CLEAR_CC();
     INSN_SETNZ(state->D[reg]);
@@ -1566,11 +1587,11 @@ static int opshft(Q68State *state, uint32_t opcode)
                 }
                 data <<= 1;
             } else {
-                data = (int32_t)data >> (count-1);
+                data >>= count-1;  // Logical, unlike ASR
                 if (data & 1) {
                     state->SR |= SR_X | SR_C;
                 }
-                data = (int32_t)data >> 1;
+                data >>= 1;
             }
             break;
           case 2: {  // ROXL/ROXR
@@ -1595,19 +1616,23 @@ static int opshft(Q68State *state, uint32_t opcode)
             break;
           }
           default: {  // (case 3) ROL/ROR
+            /* C gets the last bit rotated out even if the count is a
+             * multiple of the operand size */
             count %= nbits;
             if (is_left) {
-                data = (data << count) | (data >> (nbits - count));
-                if ((data >> (nbits-1)) & 1) {
+                if (count) {
+                    data = (data << count) | (data >> (nbits - count));
+                }
+                if (data & 1) {
                     state->SR |= SR_C;
                 }
-                data <<= 1;
             } else {
-                data = (data >> count) | (data << (nbits - count));
-                if (data & 1) {
+                if (count) {
+                    data = (data >> count) | (data << (nbits - count));
+                }
+                if ((data >> (nbits-1)) & 1) {
                     state->SR |= SR_C;
                 }
-                data = (int32_t)data >> 1;
             }
             break;
           }
@@ -2139,10 +2164,8 @@ static int opLINK(Q68State *state, uint32_t opcode)
 static int opUNLK(Q68State *state, uint32_t opcode)
 {
     INSN_GET_REG0;
-    /* FIXME: What happens if A7 is used as the register?  I.e. does the
-     *        postincrement happen before or after the value is written to
-     *        the destination register?  The Motorola docs could be read
-     *        both ways, so going by the literal operation sequence here. */
+    /* For UNLK A7, the value loaded from the stack ends up in A7 (the
+     * postincrement happens first), as in the JIT and other cores */
     state->A[7] = state->A[reg0];
 #ifndef Q68_DISABLE_ADDRESS_ERROR
     if (state->A[7] & 1) {
@@ -2153,8 +2176,9 @@ static int opUNLK(Q68State *state, uint32_t opcode)
         return 0;
     }
 #endif
-    state->A[reg0] = READU32(state, state->A[7]);
+    const uint32_t data = READU32(state, state->A[7]);
     state->A[7] += 4;
+    state->A[reg0] = data;
     return 12;
 }
 
@@ -2363,6 +2387,7 @@ static int opMOVP(Q68State *state, uint32_t opcode)
         } else {
             data  = READU8(state, addr+0) <<  8;
             data |= READU8(state, addr+2) <<  0;
+            data |= state->D[reg] & 0xFFFF0000;  // Word reads leave the upper half
         }
         state->D[reg] = data;
     }
@@ -43,26 +43,26 @@ static const struct {
     {0xFFC0, 0x0000, "ORI.B #<imm8>,<ea.b>"},
     {0xFFFF, 0x007C, "ORI.W #<imm8>,SR"},
     {0xFFC0, 0x0040, "ORI.W #<imm16>,<ea.w>"},
-    {0xFFC0, 0x0080, "ORI.L #<imm16>,<ea.l>"},
+    {0xFFC0, 0x0080, "ORI.L #<imm32>,<ea.l>"},
     {0xFFFF, 0x023C, "ANDI.B #<imm8>,CCR"},
     {0xFFC0, 0x0200, "ANDI.B #<imm8>,<ea.b>"},
     {0xFFFF, 0x027C, "ANDI.W #<imm8>,SR"},
     {0xFFC0, 0x0240, "ANDI.W #<imm16>,<ea.w>"},
-    {0xFFC0, 0x0280, "ANDI.L #<imm16>,<ea.l>"},
+    {0xFFC0, 0x0280, "ANDI.L #<imm32>,<ea.l>"},
     {0xFFC0, 0x0400, "SUBI.B #<imm8>,<ea.b>"},
     {0xFFC0, 0x0440, "SUBI.W #<imm16>,<ea.w>"},
-    {0xFFC0, 0x0480, "SUBI.L #<imm16>,<ea.l>"},
+    {0xFFC0, 0x0480, "SUBI.L #<imm32>,<ea.l>"},
     {0xFFC0, 0x0600, "ADDI.B #<imm8>,<ea.b>"},
     {0xFFC0, 0x0640, "ADDI.W #<imm16>,<ea.w>"},
-    {0xFFC0, 0x0680, "ADDI.L #<imm16>,<ea.l>"},
+    {0xFFC0, 0x0680, "ADDI.L #<imm32>,<ea.l>"},
     {0xFFFF, 0x0A3C, "EORI.B #<imm8>,CCR"},
     {0xFFC0, 0x0A00, "EORI.B #<imm8>,<ea.b>"},
     {0xFFFF, 0x0A7C, "EORI.W #<imm8>,SR"},
     {0xFFC0, 0x0A40, "EORI.W #<imm16>,<ea.w>"},
-    {0xFFC0, 0x0A80, "EORI.L #<imm16>,<ea.l>"},
+    {0xFFC0, 0x0A80, "EORI.L #<imm32>,<ea.l>"},
     {0xFFC0, 0x0C00, "CMPI.B #<imm8>,<ea.b>"},
     {0xFFC0, 0x0C40, "CMPI.W #<imm16>,<ea.w>"},
-    {0xFFC0, 0x0C80, "CMPI.L #<imm16>,<ea.l>"},
+    {0xFFC0, 0x0C80, "CMPI.L #<imm32>,<ea.l>"},
 
     /* Bit twiddling and MOVEP */
 
@@ -568,6 +568,11 @@ const char *q68_disassemble(Q68State *state, uint32_t address,
                 } else {
                     APPEND("%s%X", imm16<10 ? "" : "$", imm16);
                 }
+            } else if (strcmp(tagbuf,"imm32") == 0) {
+                uint32_t imm32 = READU16(state, address) << 16
+                               | READU16(state, address+2);
+                address += 4;
+                APPEND("%s%X", imm32<10 ? "" : "$", imm32);
             } else if (strcmp(tagbuf,"pcrel8") == 0) {
                 int8_t disp8 = opcode & 0xFF;
                 APPEND("$%X", (base_address+2) + disp8);
@@ -236,6 +236,17 @@ struct Q68State_ {
     /* Buffer for tracking translated code blocks */
     uint8_t jit_pages[1<<(24-(Q68_JIT_PAGE_BITS+3))];
 
+    /* Fields below are not accessed from the JIT assembly, keep them after
+     * jit_pages so the structure offsets used there don't change */
+
+    /* Nonzero if translated code should be used (see q68_set_jit()) */
+    unsigned int jit_enabled;
+
+    /* Native code buffer allocation functions (see q68_set_jit_code_funcs()) */
+    void *(*jit_code_malloc_func)(size_t size);
+    void *(*jit_code_realloc_func)(void *ptr, size_t size);
+    void (*jit_code_free_func)(void *ptr);
+
 };
 
 /*-----------------------------------------------------------------------*/
@@ -595,7 +595,8 @@ Q68JitEntry *q68_jit_translate(Q68State *state, uint32_t address)
 
     /* Initialize the new entry */
 
-    current_entry->native_code = state->malloc_func(Q68_JIT_BLOCK_EXPAND_SIZE);
+    current_entry->native_code =
+        state->jit_code_malloc_func(Q68_JIT_BLOCK_EXPAND_SIZE);
     if (!current_entry->native_code) {
         DMSG("No memory for code at $%06X", address);
         current_entry = NULL;
@@ -663,8 +664,8 @@ Q68JitEntry *q68_jit_translate(Q68State *state, uint32_t address)
     ) {
         JIT_PAGE_SET(state, index);
     }
-    void *newptr = state->realloc_func(current_entry->native_code,
-                                       current_entry->native_length);
+    void *newptr = state->jit_code_realloc_func(current_entry->native_code,
+                                                current_entry->native_length);
     if (newptr) {
         current_entry->native_code = newptr;
         current_entry->native_size = current_entry->native_length;
@@ -1079,7 +1080,7 @@ static void clear_entry(Q68State *state, Q68JitEntry *entry)
 
     /* Free the native code */
     state->jit_total_data -= entry->native_size;
-    state->free_func(entry->native_code);
+    state->jit_code_free_func(entry->native_code);
     entry->native_code = NULL;
 
     /* Clear the entry from the table and hash chain */
@@ -1144,7 +1145,8 @@ static void clear_oldest_entry(Q68State *state)
 static int expand_buffer(Q68JitEntry *entry)
 {
     const uint32_t newsize = entry->native_size + Q68_JIT_BLOCK_EXPAND_SIZE;
-    void *newptr = entry->state->realloc_func(entry->native_code, newsize);
+    void *newptr = entry->state->jit_code_realloc_func(entry->native_code,
+                                                       newsize);
     if (!newptr) {
         DMSG("Out of memory");
         return 0;
@@ -1346,6 +1348,7 @@ static unsigned int cc_info(uint16_t opcode)
 {
     const unsigned int INPUT_XNZVC  = 0x1F00;
     const unsigned int INPUT_XZ     = 0x1400;
+    const unsigned int INPUT_NZ     = 0x0C00;
     const unsigned int INPUT_X      = 0x1000;
     const unsigned int INPUT_N      = 0x0800;
     const unsigned int INPUT_V      = 0x0200;
@@ -1552,8 +1555,9 @@ static unsigned int cc_info(uint16_t opcode)
         }
 
       case 0x8:
-        if ((opcode>>6 & 3) == 3) {  // MULS/MULU
-            return INPUT_NONE | OUTPUT_NZVC;
+        if ((opcode>>6 & 3) == 3) {  // DIVS/DIVU
+            /* N and Z are unmodified on overflow, so treat as input */
+            return INPUT_NZ | OUTPUT_NZVC;
         } else if ((opcode & 0x01F0) == 0x0100) {  // SBCD
             return INPUT_XZ | OUTPUT_XZC;
         } else {  // OR
@@ -1578,7 +1582,7 @@ static unsigned int cc_info(uint16_t opcode)
         return INPUT_NONE | OUTPUT_NZVC;
 
       case 0xC:
-        if ((opcode>>6 & 3) == 3) {  // DIVS/DIVD
+        if ((opcode>>6 & 3) == 3) {  // MULS/MULU
             return INPUT_NONE | OUTPUT_NZVC;
         } else if ((opcode & 0x01F0) == 0x0100) {  // ABCD
             return INPUT_XZ | OUTPUT_XZC;
@@ -1598,6 +1602,13 @@ static unsigned int cc_info(uint16_t opcode)
         }
 
       case 0xE:
+        if ((opcode>>6 & 3) == 3
+         && ((opcode & 0x0800)
+             || (opcode>>3 & 7) <= EA_ADDRESS_REG
+             || (opcode & 0x3F) > (EA_MISC<<3 | EA_MISC_ABSOLUTE_L))) {
+            /* Illegal memory shift/rotate */
+            return 0;
+        }
         /* Shift/rotate */
         return INPUT_X | OUTPUT_XNZVC;
 
@@ -1798,7 +1809,7 @@ static void ea_get(Q68State *state, uint32_t opcode, int size,
                 if (op_num == 1) {
                     JIT_EMIT_GET_OP1_IMMEDIATE(current_entry, val);
                 } else {
-                    JIT_EMIT_GET_OP1_IMMEDIATE(current_entry, val);
+                    JIT_EMIT_GET_OP2_IMMEDIATE(current_entry, val);
                 }
             }
             break;
@@ -2152,6 +2163,10 @@ static int opMOVE(Q68State *state, uint32_t opcode)
 {
     const int size = (opcode>>12==1 ? SIZE_B : opcode>>12==2 ? SIZE_L : SIZE_W);
 
+    if (size == SIZE_B && (opcode>>6 & 7) == EA_ADDRESS_REG) {
+        return op_ill(state, opcode);  // MOVEA.B doesn't exist
+    }
+
     int cycles_src;
     ea_get(state, opcode, size, 0, &cycles_src, 1);
     if (cycles_src < 0) {
@@ -2230,6 +2245,8 @@ static int op_CHK(Q68State *state, uint32_t opcode)
     }
 
     JIT_EMIT_ADD_CYCLES(current_entry, 10 + cycles);
+    /* The exception frame holds the address of the next instruction */
+    advance_PC(state);
     /* The JIT code takes care of adding the extra 34 cycles of exception
      * processing if necessary */
     JIT_EMIT_CHK_W(current_entry);
@@ -2676,6 +2693,8 @@ static int op_DIV(Q68State *state, uint32_t opcode)
     JIT_EMIT_GET_OP2_REGISTER(current_entry, reg*4);
     /* Add the EA cycles now, in case a divide-by-zero exception occurs */
     JIT_EMIT_ADD_CYCLES(current_entry, cycles);
+    /* The exception frame holds the address of the next instruction */
+    advance_PC(state);
 
     if (sign) {
         JIT_EMIT_DIVS_W(current_entry);
@@ -3341,6 +3360,7 @@ static int opmisc(Q68State *state, uint32_t opcode)
  */
 static int opTRAP(Q68State *state, uint32_t opcode)
 {
+    advance_PC(state);  // TRAP stacks the address of the next instruction
     return raise_exception(state, EX_TRAP + (opcode & 0x000F));
 }
 
@@ -3401,9 +3421,9 @@ static int opMUSP(Q68State *state, uint32_t opcode)
     JIT_EMIT_CHECK_SUPER(current_entry);
     INSN_GET_REG0;
     if (opcode & 0x0008) {
-        JIT_EMIT_MOVE_TO_USP(current_entry, reg0*4);
+        JIT_EMIT_MOVE_TO_USP(current_entry, (8+reg0)*4);
     } else {
-        JIT_EMIT_MOVE_FROM_USP(current_entry, reg0*4);
+        JIT_EMIT_MOVE_FROM_USP(current_entry, (8+reg0)*4);
     }
     JIT_EMIT_ADD_CYCLES(current_entry, 4);
     return 0;
@@ -3425,12 +3445,16 @@ static int op4E7x(Q68State *state, uint32_t opcode)
       case 1:  // $4E71 NOP
         JIT_EMIT_ADD_CYCLES(current_entry, 4);
         return 0;
-      case 2:  // $4E72 STOP
+      case 2: {  // $4E72 STOP
         JIT_EMIT_CHECK_SUPER(current_entry);
         JIT_EMIT_ADD_CYCLES(current_entry, 4);
+        /* The PC has to point past the new SR value, as in the
+         * interpreter */
+        const uint16_t new_SR = IFETCH(state);
         advance_PC(state);
-        JIT_EMIT_STOP(current_entry, IFETCH(state));
+        JIT_EMIT_STOP(current_entry, new_SR);
         return 1;
+      }
       case 3: {  // $4E73 RTE
         JIT_EMIT_CHECK_SUPER(current_entry);
 #ifndef Q68_DISABLE_ADDRESS_ERROR
@@ -3452,6 +3476,7 @@ static int op4E7x(Q68State *state, uint32_t opcode)
         PC_updated = 1;
         return 1;
       case 6:  // $4E76 TRAPV
+        advance_PC(state);
         JIT_EMIT_TRAPV(current_entry);
         JIT_EMIT_ADD_CYCLES(current_entry, 4);
         return 0;
@@ -3552,15 +3577,15 @@ static int opMOVP(Q68State *state, uint32_t opcode)
 
     if (to_memory) {
         if (is_long) {
-            JIT_EMIT_MOVEP_WRITE_L(current_entry, reg0*4, disp, reg*4);
+            JIT_EMIT_MOVEP_WRITE_L(current_entry, (8+reg0)*4, disp, reg*4);
         } else {
-            JIT_EMIT_MOVEP_WRITE_W(current_entry, reg0*4, disp, reg*4);
+            JIT_EMIT_MOVEP_WRITE_W(current_entry, (8+reg0)*4, disp, reg*4);
         }
     } else {
         if (is_long) {
-            JIT_EMIT_MOVEP_READ_L(current_entry, reg0*4, disp, reg*4);
+            JIT_EMIT_MOVEP_READ_L(current_entry, (8+reg0)*4, disp, reg*4);
         } else {
-            JIT_EMIT_MOVEP_READ_W(current_entry, reg0*4, disp, reg*4);
+            JIT_EMIT_MOVEP_READ_W(current_entry, (8+reg0)*4, disp, reg*4);
         }
     }
 
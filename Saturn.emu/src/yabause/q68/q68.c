@@ -89,6 +89,11 @@ Q68State *q68_create_ex(void *(*malloc_func)(size_t size),
     state->malloc_func  = malloc_func;
     state->realloc_func = realloc_func;
     state->free_func    = free_func;
+    state->jit_enabled  = 0;
+    state->jit_code_malloc_func  = malloc_func;
+    state->jit_code_realloc_func = realloc_func;
+    state->jit_code_free_func    = free_func;
+    state->jit_running  = NULL;
 
 #ifdef Q68_USE_JIT
     if (!q68_jit_init(state)) {
@@ -197,6 +202,63 @@ void q68_set_jit_flush_func(Q68State *state, void (*flush_func)(void))
     state->jit_flush   = flush_func;
 }
 
+/*-----------------------------------------------------------------------*/
+
+/**
+ * q68_set_jit_code_funcs:  Set the functions used to allocate buffers for
+ * translated native code.  These must return executable memory on hosts
+ * that enforce no-execute permissions on the regular heap.  If not set,
+ * the functions passed to q68_create_ex() are used.  This function has no
+ * effect if dynamic translation is not enabled.
+ *
+ * [Parameters]
+ *           state: Processor state block
+ *     malloc_func: Function for allocating a native code buffer
+ *    realloc_func: Function for adjusting the size of a native code buffer
+ *       free_func: Function for freeing a native code buffer
+ * [Return value]
+ *     None
+ */
+void q68_set_jit_code_funcs(Q68State *state,
+                            void *(*malloc_func)(size_t size),
+                            void *(*realloc_func)(void *ptr, size_t size),
+                            void (*free_func)(void *ptr))
+{
+#ifdef Q68_USE_JIT
+    /* Existing translations belong to the old allocator */
+    q68_jit_reset(state);
+    state->jit_running = NULL;
+    state->jit_code_malloc_func  = malloc_func;
+    state->jit_code_realloc_func = realloc_func;
+    state->jit_code_free_func    = free_func;
+#endif
+}
+
+/*-----------------------------------------------------------------------*/
+
+/**
+ * q68_set_jit:  Enable or disable the use of dynamic translation.  Dynamic
+ * translation is disabled when a virtual processor is created.  Disabling
+ * it drops any translated code.  This function has no effect if dynamic
+ * translation was not enabled at compile time.
+ *
+ * [Parameters]
+ *      state: Processor state block
+ *     enable: Nonzero to execute through translated code, zero to interpret
+ * [Return value]
+ *     None
+ */
+void q68_set_jit(Q68State *state, int enable)
+{
+#ifdef Q68_USE_JIT
+    if (!enable && state->jit_enabled) {
+        q68_jit_reset(state);
+        state->jit_running = NULL;
+    }
+    state->jit_enabled = (enable != 0);
+#endif
+}
+
 /*************************************************************************/
 
 /**
@@ -265,6 +327,8 @@ void q68_set_areg(Q68State *state, int num, uint32_t value)
 void q68_set_pc(Q68State *state, uint32_t value)
 {
     state->PC = value;
+    /* Don't resume a translated block at the old PC */
+    state->jit_running = NULL;
 }
 
 void q68_set_sr(Q68State *state, uint16_t value)
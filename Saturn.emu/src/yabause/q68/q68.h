@@ -153,6 +153,40 @@ extern void q68_set_writew_func(Q68State *state, Q68WriteFunc func);
  */
 extern void q68_set_jit_flush_func(Q68State *state, void (*flush_func)(void));
 
+/**
+ * q68_set_jit_code_funcs:  Set the functions used to allocate buffers for
+ * translated native code.  These must return executable memory on hosts
+ * that enforce no-execute permissions on the regular heap.  If not set,
+ * the functions passed to q68_create_ex() are used.  This function has no
+ * effect if dynamic translation is not enabled.
+ *
+ * [Parameters]
+ *           state: Processor state block
+ *     malloc_func: Function for allocating a native code buffer
+ *    realloc_func: Function for adjusting the size of a native code buffer
+ *       free_func: Function for freeing a native code buffer
+ * [Return value]
+ *     None
+ */
+extern void q68_set_jit_code_funcs(Q68State *state,
+                                   void *(*malloc_func)(size_t size),
+                                   void *(*realloc_func)(void *ptr, size_t size),
+                                   void (*free_func)(void *ptr));
+
+/**
+ * q68_set_jit:  Enable or disable the use of dynamic translation.  Dynamic
+ * translation is disabled when a virtual processor is created.  Disabling
+ * it drops any translated code.  This function has no effect if dynamic
+ * translation was not enabled at compile time.
+ *
+ * [Parameters]
+ *      state: Processor state block
+ *     enable: Nonzero to execute through translated code, zero to interpret
+ * [Return value]
+ *     None
+ */
+extern void q68_set_jit(Q68State *state, int enable);
+
 /*----------------------------------*/
 
 /**
@@ -0,0 +1,458 @@
+/*  This file is part of Yabause.
+
+    Yabause is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Yabause is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Yabause; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*
+ * Interpreter/JIT lockstep checker
+ *
+ * Runs the same stream of generated 68000 test programs on two Q68
+ * processors, one interpreting and one using dynamic translation, each
+ * with its own copy of memory. Every exception vector points at a STOP
+ * instruction, so a program ends when it runs off its end or takes an
+ * exception. Data and address registers start out random, the latter
+ * pointing into the data area. The processors are run in randomly sized
+ * cycle slices to exercise resuming translated blocks, then all registers
+ * and memory are compared and the first mismatch is reported with a
+ * disassembly of the program. Programs that take an address error are
+ * skipped since the stacked PC is imprecise on a real 68000 too.
+ *
+ * Not part of the emulator build, link it against the Q68 sources built
+ * with -DQ68_USE_JIT=1 and the CPU_* define of the host, e.g.:
+ *
+ *   cc -O2 -DCPU_X64=1 -DQ68_USE_JIT=1 q68_lockstep.c q68.c q68-core.c
+ *      q68-disasm.c q68-jit.c q68-jit-x86.S -o q68_lockstep
+ *   ./q68_lockstep [programs] [seed] [first program]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include "q68.h"
+#include "q68-internal.h"
+
+#define RAM_SIZE      0x100000  // Mirrored through the 24-bit address space
+#define HANDLER_ADDR  0x000400
+#define ADDRERR_ADDR  0x000410  // Separate handler for address errors
+#define ILLEGAL_ADDR  0x000420  // Separate handler for illegal instructions
+#define CODE_ADDR     0x001000
+#define STACK_TOP     0x008000
+#define DATA_ADDR     0x010000
+#define MAX_INSNS     192
+#define CYCLE_LIMIT   4000000
+
+static uint8_t ram[2][RAM_SIZE];
+static uint8_t code[RAM_SIZE];  // Unmodified copy for disassembly
+static uint8_t *cur_ram;
+static uint32_t init_regs[16];
+
+static uint32_t rng_state;
+
+static uint32_t rng(void)
+{
+   rng_state ^= rng_state << 13;
+   rng_state ^= rng_state >> 17;
+   rng_state ^= rng_state << 5;
+   return rng_state;
+}
+
+/*************************************************************************/
+
+static uint32_t readb(uint32_t address)
+{
+   return cur_ram[address & (RAM_SIZE-1)];
+}
+
+static uint32_t readw(uint32_t address)
+{
+   address &= RAM_SIZE-1;
+   return cur_ram[address] << 8 | cur_ram[address+1];
+}
+
+static void writeb(uint32_t address, uint32_t data)
+{
+   cur_ram[address & (RAM_SIZE-1)] = data;
+}
+
+static void writew(uint32_t address, uint32_t data)
+{
+   address &= RAM_SIZE-1;
+   cur_ram[address] = data >> 8;
+   cur_ram[address+1] = data;
+}
+
+static void poke16(uint8_t *mem, uint32_t address, uint16_t data)
+{
+   mem[address] = data >> 8;
+   mem[address+1] = data;
+}
+
+static void poke32(uint8_t *mem, uint32_t address, uint32_t data)
+{
+   poke16(mem, address, data >> 16);
+   poke16(mem, address+2, data);
+}
+
+/*************************************************************************/
+
+/* Translated code must live in executable memory */
+
+static void *code_malloc(size_t size)
+{
+   void *base = mmap(NULL, size + 16, PROT_READ | PROT_WRITE | PROT_EXEC,
+                     MAP_PRIVATE | MAP_ANON, -1, 0);
+   if (base == MAP_FAILED)
+      return NULL;
+   *(size_t *)base = size + 16;
+   return (uint8_t *)base + 16;
+}
+
+static void code_free(void *ptr)
+{
+   if (ptr)
+   {
+      void *base = (uint8_t *)ptr - 16;
+      munmap(base, *(size_t *)base);
+   }
+}
+
+static void *code_realloc(void *ptr, size_t size)
+{
+   void *new_ptr;
+   size_t old_size;
+
+   if (!ptr)
+      return code_malloc(size);
+   old_size = *(size_t *)((uint8_t *)ptr - 16) - 16;
+   if (!(new_ptr = code_malloc(size)))
+      return NULL;
+   memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+   code_free(ptr);
+   return new_ptr;
+}
+
+/*************************************************************************/
+
+/* Opcodes the generator doesn't produce at random: anything that transfers
+ * control somewhere unpredictable. Branches and loops are emitted with
+ * known targets instead. */
+static int is_excluded(uint16_t op)
+{
+   if ((op & 0xF000) == 0x6000)             // Bcc/BRA/BSR
+      return 1;
+   if ((op & 0xF0F8) == 0x50C8)             // DBcc
+      return 1;
+   if ((op & 0xFF80) == 0x4E80)             // JSR/JMP
+      return 1;
+   if (op == 0x4E72 || op == 0x4E73 || op == 0x4E75 || op == 0x4E77) // STOP/RTE/RTS/RTR
+      return 1;
+   return 0;
+}
+
+/* Returns whether the instruction can load an arbitrary value into A7 (any
+ * use other than as a base register), which just leads to a cascade of
+ * address errors */
+static int writes_a7(const char *text)
+{
+   const char *p = text;
+
+   while ((p = strstr(p, "A7")) != NULL)
+   {
+      if (p == text || p[-1] != '(')
+         return 1;
+      p += 2;
+   }
+   return 0;
+}
+
+/* Generates one instruction at address, returning its length in words */
+static int gen_insn(Q68State *state, uint8_t *mem, uint32_t address)
+{
+   for (;;)
+   {
+      uint16_t op = rng();
+      int nwords, i;
+      const char *text;
+
+      if (is_excluded(op))
+         continue;
+      poke16(mem, address, op);
+      for (i = 1; i < 5; i++)
+      {
+         uint16_t ext = rng();
+         // keep displacements in brief extension words small, and most
+         // displacements even so that word and long accesses don't all fault
+         if ((rng() & 3) == 0)
+            ext &= 0xF0FF;
+         if (rng() % 8)
+            ext &= ~1;
+         poke16(mem, address + i*2, ext);
+      }
+      cur_ram = mem;
+      text = q68_disassemble(state, address, &nwords);
+      if (strcmp(text, "???") == 0 || writes_a7(text))
+         continue;
+      return nwords;
+   }
+}
+
+static uint32_t gen_program(Q68State *state, uint8_t *mem)
+{
+   uint32_t pc = CODE_ADDR;
+   int n = 1 + rng() % MAX_INSNS, i;
+
+   for (i = 0; i < n; i++)
+   {
+      uint32_t kind = rng() % 16;
+
+      if (kind == 0)
+      {
+         // Bcc.B over the next instruction
+         uint32_t branch = pc;
+         int len;
+         pc += 2;
+         len = gen_insn(state, mem, pc);
+         pc += len * 2;
+         poke16(mem, branch, 0x6000 | (rng() % 16) << 8 | (len * 2));
+         if ((mem[branch] & 0x0F) == 1) // BSR would return to a random place
+            mem[branch] &= 0xF0;
+      }
+      else if (kind == 1)
+      {
+         // MOVEQ #n,Dr; body; DBcc Dr,body
+         uint32_t reg = rng() % 8, body;
+         poke16(mem, pc, 0x7000 | reg << 9 | (rng() % 8));
+         pc += 2;
+         body = pc;
+         pc += gen_insn(state, mem, pc) * 2;
+         poke16(mem, pc, 0x50C8 | (rng() % 16) << 8 | reg);
+         poke16(mem, pc + 2, (uint16_t)(body - (pc + 2)));
+         pc += 4;
+      }
+      else
+      {
+         pc += gen_insn(state, mem, pc) * 2;
+      }
+   }
+   poke16(mem, pc, 0x4E72); // STOP #$2700
+   poke16(mem, pc + 2, 0x2700);
+   return pc + 4;
+}
+
+static void setup_memory(uint8_t *mem)
+{
+   uint32_t i;
+
+   for (i = 0; i < RAM_SIZE; i += 2)
+      poke16(mem, i, rng());
+   // reset vectors, then every exception stops the processor
+   poke32(mem, 0, STACK_TOP);
+   poke32(mem, 4, CODE_ADDR);
+   for (i = 8; i < 0x400; i += 4)
+      poke32(mem, i, HANDLER_ADDR);
+   poke16(mem, HANDLER_ADDR, 0x4E72);
+   poke16(mem, HANDLER_ADDR + 2, 0x2700);
+   // the PC stacked for an address error is imprecise on a real 68000 as
+   // well, those programs are detected and not compared
+   poke32(mem, 3*4, ADDRERR_ADDR);
+   poke16(mem, ADDRERR_ADDR, 0x4E72);
+   poke16(mem, ADDRERR_ADDR + 2, 0x2700);
+   poke32(mem, 4*4, ILLEGAL_ADDR);
+   poke16(mem, ILLEGAL_ADDR, 0x4E72);
+   poke16(mem, ILLEGAL_ADDR + 2, 0x2700);
+   // anything popped off the stack also leads to the handler
+   for (i = STACK_TOP - 0x1000; i < STACK_TOP + 0x100; i += 4)
+      poke32(mem, i, HANDLER_ADDR);
+}
+
+/*************************************************************************/
+
+static Q68State *create_state(int jit)
+{
+   Q68State *state = q68_create();
+
+   if (!state)
+   {
+      fprintf(stderr, "q68_create failed\n");
+      exit(1);
+   }
+   q68_set_readb_func(state, readb);
+   q68_set_readw_func(state, readw);
+   q68_set_writeb_func(state, writeb);
+   q68_set_writew_func(state, writew);
+   if (jit)
+   {
+      q68_set_jit_code_funcs(state, code_malloc, code_realloc, code_free);
+      q68_set_jit(state, 1);
+   }
+   return state;
+}
+
+/* Returns 1 if the program stopped, 0 if it ran out of cycles and -1 if it
+ * took an address error */
+static int run(Q68State *state, int idx)
+{
+   int total = 0, i;
+
+   cur_ram = ram[idx];
+   q68_reset(state);
+   for (i = 0; i < 8; i++)
+   {
+      q68_set_dreg(state, i, init_regs[i]);
+      if (i < 7)
+         q68_set_areg(state, i, init_regs[8+i]);
+   }
+   while (total < CYCLE_LIMIT)
+   {
+      if (state->halted)
+         return q68_get_pc(state) == ADDRERR_ADDR + 4 ? -1 : 1;
+      total += q68_run(state, 1 + rng() % 400);
+   }
+   return 0;
+}
+
+static void dump_program(Q68State *state, uint32_t end)
+{
+   uint32_t pc = CODE_ADDR;
+
+   int i;
+
+   fprintf(stderr, "  initial");
+   for (i = 0; i < 15; i++)
+      fprintf(stderr, " %c%d=%08X", i < 8 ? 'D' : 'A', i & 7, init_regs[i]);
+   fprintf(stderr, "\n");
+   cur_ram = code;
+   while (pc < end)
+   {
+      int nwords;
+      const char *text = q68_disassemble(state, pc, &nwords);
+      fprintf(stderr, "  %06X: %s\n", pc, text);
+      pc += nwords * 2;
+   }
+}
+
+static int compare(Q68State *interp, Q68State *jit, uint32_t end)
+{
+   int i, bad = 0;
+
+   for (i = 0; i < 8; i++)
+   {
+      if (q68_get_dreg(interp, i) != q68_get_dreg(jit, i))
+      {
+         fprintf(stderr, "D%d: interp %08X jit %08X\n", i, q68_get_dreg(interp, i), q68_get_dreg(jit, i));
+         bad = 1;
+      }
+      if (q68_get_areg(interp, i) != q68_get_areg(jit, i))
+      {
+         fprintf(stderr, "A%d: interp %08X jit %08X\n", i, q68_get_areg(interp, i), q68_get_areg(jit, i));
+         bad = 1;
+      }
+   }
+   if (q68_get_pc(interp) != q68_get_pc(jit))
+   {
+      fprintf(stderr, "PC: interp %06X jit %06X\n", q68_get_pc(interp), q68_get_pc(jit));
+      bad = 1;
+   }
+   if (q68_get_sr(interp) != q68_get_sr(jit))
+   {
+      fprintf(stderr, "SR: interp %04X jit %04X\n", q68_get_sr(interp), q68_get_sr(jit));
+      bad = 1;
+   }
+   if (q68_get_usp(interp) != q68_get_usp(jit) || q68_get_ssp(interp) != q68_get_ssp(jit))
+   {
+      fprintf(stderr, "USP/SSP: interp %08X/%08X jit %08X/%08X\n",
+              q68_get_usp(interp), q68_get_ssp(interp), q68_get_usp(jit), q68_get_ssp(jit));
+      bad = 1;
+   }
+   if (memcmp(ram[0], ram[1], RAM_SIZE) != 0)
+   {
+      for (i = 0; i < RAM_SIZE; i++)
+      {
+         if (ram[0][i] != ram[1][i])
+         {
+            fprintf(stderr, "RAM differs first at %06X: interp %02X jit %02X\n", i, ram[0][i], ram[1][i]);
+            break;
+         }
+      }
+      bad = 1;
+   }
+   if (bad)
+      dump_program(interp, end);
+   return bad;
+}
+
+int main(int argc, char *argv[])
+{
+   int programs = argc > 1 ? atoi(argv[1]) : 1000;
+   uint32_t seed = argc > 2 ? strtoul(argv[2], NULL, 0) : 1;
+   int first = argc > 3 ? atoi(argv[3]) : 0;
+   Q68State *interp = create_state(0);
+   Q68State *jit = create_state(1);
+   int i, failures = 0, skipped = 0;
+
+   for (i = first; i < first + programs; i++)
+   {
+      uint32_t end;
+      int done0, done1, j;
+
+      // every program has its own random stream so it can be rerun alone
+      rng_state = (seed * 0x9E3779B9u) ^ (i * 0x85EBCA6Bu);
+      if (!rng_state)
+         rng_state = 1;
+      setup_memory(ram[0]);
+      for (j = 0; j < 8; j++)
+         init_regs[j] = rng();
+      for (j = 8; j < 16; j++)
+      {
+         // address registers point into the data area, mostly at even addresses
+         init_regs[j] = DATA_ADDR + rng() % (RAM_SIZE - 2*DATA_ADDR);
+         if (rng() % 8)
+            init_regs[j] &= ~1;
+      }
+      end = gen_program(interp, ram[0]);
+      memcpy(ram[1], ram[0], RAM_SIZE);
+      memcpy(code, ram[0], RAM_SIZE);
+
+      done0 = run(interp, 0);
+      done1 = run(jit, 1);
+      if (q68_get_pc(interp) == ILLEGAL_ADDR + 4
+       && q68_get_pc(jit) == ILLEGAL_ADDR + 4)
+      {
+         /* the JIT drops condition codes that it expects the next
+          * instruction to overwrite, which an illegal form of that
+          * instruction doesn't do; ignore the stacked CCR */
+         uint32_t ccr = (q68_get_areg(interp, 7) + 1) & (RAM_SIZE-1);
+         ram[1][ccr] = ram[0][ccr];
+      }
+      if (done0 != 1 || done1 != 1)
+      {
+         // no common stopping point to compare at
+         skipped++;
+         continue;
+      }
+      if (compare(interp, jit, end))
+      {
+         fprintf(stderr, "program %d (seed %u) differs\n", i, seed);
+         if (++failures >= 5)
+            break;
+      }
+   }
+   printf("%d programs, %d failures, %d skipped\n", programs, failures, skipped);
+   q68_destroy(jit);
+   q68_destroy(interp);
+   return failures != 0;
+}
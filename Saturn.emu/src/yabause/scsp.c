@@ -3924,6 +3924,8 @@ SoundLoadState (FILE *fp, int version, int size)
 
   // Lastly, sound ram
   yread (&check, (void *)SoundRam, 0x80000, 1, fp);
+  // Drop any code translated from the old contents
+  M68K->WriteNotify (0, 0x80000);
 
   if (version > 1)
     {
@@ -252,7 +252,7 @@ int isclean(pointer addr)
   return 1;
 }
 
-void get_bounds(pointer addr,u32 *start,u32 *end)
+void get_bounds(pointer addr,pointer *start,pointer *end)
 {
   u32 *ptr=(u32 *)addr;
   #ifndef HAVE_ARMv7
@@ -1533,6 +1533,14 @@ void emit_orrge_imm(int rs,int imm,int rt)
   }
 }
 
+void emit_orrvs_imm(int rs,int imm,int rt)
+{
+  u32 armval;
+  int ok=genimm(imm,&armval);
+  assert(ok);
+  assem_debug("orrvs %s,%s,#%d\n",regname[rt],regname[rs],imm);
+  output_w32(0x63800000|rd_rn_rm(rt,rs,0)|armval);
+}
 void emit_orrgt_imm(int rs,int imm,int rt)
 {
   u32 armval;
@@ -1644,6 +1652,18 @@ void emit_subc(int s, int t, int sr)
   emit_adc(sr,sr,sr);
   emit_xorimm(sr,1,sr);
 }
+void emit_addv(int s, int t, int sr, int temp)
+{
+  emit_andimm(sr,~1,sr);
+  emit_adds(t,s,t);
+  emit_orrvs_imm(sr,1,sr);
+}
+void emit_subv(int s, int t, int sr, int temp)
+{
+  emit_andimm(sr,~1,sr);
+  emit_subs(t,s,t);
+  emit_orrvs_imm(sr,1,sr);
+}
 void emit_shrsr(int t, int sr)
 {
   emit_andimm(sr,~1,sr);
@@ -3025,7 +3045,7 @@ void printregs(int edi,int esi,int ebp,int esp,int b,int d,int c,int a)
   printf("regs: %x %x %x %x %x %x %x (%x)\n",a,b,c,d,ebp,esi,edi,(&edi)[-1]);
 }
 
-int do_dirty_stub(int i)
+pointer do_dirty_stub(int i)
 {
   assem_debug("do_dirty_stub %x\n",start+i*2);
   u32 alignedlen=((((u32)source)+slen*2+2)&~2)-(u32)alignedsource;
@@ -3074,7 +3094,7 @@ int do_map_r(int s,int ar,int map,int cache,int x,int a,int shift,int c,u32 addr
   }
   return map;
 }
-int do_map_r_branch(int map, int c, u32 addr, int *jaddr)
+int do_map_r_branch(int map, int c, u32 addr, pointer *jaddr)
 {
   if(!c) {
     emit_test(map,map);
@@ -3116,7 +3136,7 @@ int do_map_w(int s,int ar,int map,int cache,int x,int c,u32 addr)
   }
   return map;
 }
-void do_map_w_branch(int map, int c, u32 addr, int *jaddr)
+void do_map_w_branch(int map, int c, u32 addr, pointer *jaddr)
 {
   if(!c||can_direct_write(addr)) {
     emit_testimm(map,0x40000000);
@@ -19,8 +19,9 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 u64 memory_map[1048576];
-ALIGNED(8) u32 mini_ht_master[32][2];
-ALIGNED(8) u32 mini_ht_slave[32][2];
+// [0] = virtual address, [1] = translated address
+ALIGNED(16) u64 mini_ht_master[2][32];
+ALIGNED(16) u64 mini_ht_slave[2][32];
 ALIGNED(4) u8 restore_candidate[512];
 int rccount;
 int master_reg[22];
@@ -85,68 +86,62 @@ void set_jump_target(pointer addr,pointer target)
   {
     assert(ptr[1]>=0x80&&ptr[1]<=0x8f);
     u32 *ptr2=(u32 *)(ptr+2);
-    *ptr2=target-(u32)ptr2-4;
+    *ptr2=target-(pointer)ptr2-4;
   }
   else if(*ptr==0xe8||*ptr==0xe9) {
     u32 *ptr2=(u32 *)(ptr+1);
-    *ptr2=target-(u32)ptr2-4;
+    *ptr2=target-(pointer)ptr2-4;
   }
   else
   {
-    assert(*ptr==0xc7); /* mov immediate (store address) */
-    u32 *ptr2=(u32 *)(ptr+6);
-    *ptr2=target;
+    assert(ptr[0]==0x48&&ptr[1]==0x8D); /* lea (mini_ht return address) */
+    u32 *ptr2=(u32 *)(ptr+3);
+    *ptr2=target-(pointer)ptr2-4;
   }
 }
 
+// The extjump stub loads the address of the branch with a rip-relative lea
+static pointer extjump_branch(void *stub)
+{
+  assert(((u8 *)stub)[5]==0x48&&((u8 *)stub)[6]==0x8D);
+  return (pointer)stub+12+*((s32 *)(stub+8));
+}
+
 void *kill_pointer(void *stub)
 {
-  u32 i_ptr=*((u32 *)(stub+6));
-  *((u32 *)i_ptr)=(u32)stub-(u32)i_ptr-4;
+  pointer i_ptr=extjump_branch(stub);
+  *((u32 *)i_ptr)=(pointer)stub-i_ptr-4;
   return (void *)i_ptr;
 }
 pointer get_pointer(void *stub)
 {
-  pointer i_ptr=*((u32 *)(stub+6));
+  pointer i_ptr=extjump_branch(stub);
   return *((s32 *)i_ptr)+i_ptr+4;
 }
 
+// The dirty stub is:
+//   movabs $source,%rax; lea copy(%rip),%rbx; mov $len,%ecx;
+//   mov $vaddr,%r12d; call verify_code
+
 // Find the "clean" entry point from a "dirty" entry point
 // by skipping past the call to verify_code
 pointer get_clean_addr(pointer addr)
 {
   u8 *ptr=(u8 *)addr;
-  if(ptr[0]==0xB8) {
-    assert(ptr[21]==0xE8); // call instruction
-    if(ptr[26]==0xE9) return *(s32 *)(ptr+27)+addr+31; // follow jmp
-    else return(addr+26);
-  }
-  /* 64-bit source pointer */
-  assert(ptr[26]==0xE8); // call instruction
-  if(ptr[31]==0xE9) return *(s32 *)(ptr+32)+addr+36; // follow jmp
-  else return(addr+31);
+  assert(ptr[28]==0xE8); // call instruction
+  if(ptr[33]==0xE9) return *(s32 *)(ptr+34)+addr+38; // follow jmp
+  else return(addr+33);
 }
 
 int verify_dirty(pointer addr)
 {
   u8 *ptr=(u8 *)addr;
-  if(ptr[0]==0xB8) {
-    u32 source=*(u32 *)(ptr+1);
-    u32 copy=*(u32 *)(ptr+6);
-    u32 len=*(u32 *)(ptr+11);
-    //printf("source=%x source-rdram=%x\n",source,source-(int)rdram);
-    assert(ptr[21]==0xE8); // call instruction
-    //printf("verify_dirty: %x %x %x\n",source,copy,len);
-    return !memcmp((void *)source,(void *)copy,len);
-  }
   assert(ptr[0]==0x48&&ptr[1]==0xB8);
-  /* 64-bit source pointer */
   u64 source=*(u64 *)(ptr+2);
-  u32 copy=*(u32 *)(ptr+11);
-  u32 len=*(u32 *)(ptr+16);
-  //printf("source=%x source-rdram=%x\n",source,source-(int)rdram);
-  assert(ptr[26]==0xE8); // call instruction
-  //printf("verify_dirty: %x %x %x\n",source,copy,len);
+  pointer copy=addr+17+*(s32 *)(ptr+13);
+  u32 len=*(u32 *)(ptr+18);
+  assert(ptr[28]==0xE8); // call instruction
+  //printf("verify_dirty: %llx %lx %x\n",source,copy,len);
   return !memcmp((void *)source,(void *)copy,len);
 }
 
@@ -155,44 +150,26 @@ int verify_dirty(pointer addr)
 int isclean(pointer addr)
 {
   u8 *ptr=(u8 *)addr;
-  if(ptr[0]==0xB8) {
-    if(ptr[0]!=0xB8) return 1; // mov imm,%eax
-    if(ptr[5]!=0xBB) return 1; // mov imm,%ebx
-    if(ptr[10]!=0xB9) return 1; // mov imm,%ecx
-    if(ptr[15]!=0x41) return 1; // rex prefix
-    if(ptr[16]!=0xBC) return 1; // mov imm,%r12d
-    if(ptr[21]!=0xE8) return 1; // call instruction
-  }else{
-    if(ptr[0]!=0x48) return 1; // rex prefix
-    if(ptr[1]!=0xB8) return 1; // mov imm,%rax
-    if(ptr[10]!=0xBB) return 1; // mov imm,%ebx
-    if(ptr[15]!=0xB9) return 1; // mov imm,%ecx
-    if(ptr[20]!=0x41) return 1; // rex prefix
-    if(ptr[21]!=0xBC) return 1; // mov imm,%r12d
-    if(ptr[26]!=0xE8) return 1; // call instruction
-  }
+  if(ptr[0]!=0x48) return 1; // rex prefix
+  if(ptr[1]!=0xB8) return 1; // mov imm,%rax
+  if(ptr[10]!=0x48) return 1; // rex prefix
+  if(ptr[11]!=0x8D) return 1; // lea rel,%rbx
+  if(ptr[17]!=0xB9) return 1; // mov imm,%ecx
+  if(ptr[22]!=0x41) return 1; // rex prefix
+  if(ptr[23]!=0xBC) return 1; // mov imm,%r12d
+  if(ptr[28]!=0xE8) return 1; // call instruction
   return 0;
 }
 
-void get_bounds(pointer addr,u32 *start,u32 *end)
+void get_bounds(pointer addr,pointer *start,pointer *end)
 {
   u8 *ptr=(u8 *)addr;
-  if(ptr[0]==0xB8) {
-    u32 source=*(u32 *)(ptr+1);
-    //u32 copy=*(u32 *)(ptr+6);
-    u32 len=*(u32 *)(ptr+11);
-    assert(ptr[21]==0xE8); // call instruction
-    *start=source;
-    *end=source+len;
-  }else{
-    assert(ptr[0]==0x48&&ptr[1]==0xB8);
-    u64 source=*(u64 *)(ptr+2);
-    //32 copy=*(u32 *)(ptr+11);
-    u32 len=*(u32 *)(ptr+16);
-    assert(ptr[26]==0xE8); // call instruction
-    *start=source;
-    *end=source+len;
-  }
+  assert(ptr[0]==0x48&&ptr[1]==0xB8);
+  u64 source=*(u64 *)(ptr+2);
+  u32 len=*(u32 *)(ptr+18);
+  assert(ptr[28]==0xE8); // call instruction
+  *start=source;
+  *end=source+len;
 }
 
 /* Register allocation */
@@ -684,21 +661,21 @@ void emit_zeroreg(int rt)
 
 void emit_loadreg(int r, int hr)
 {
-  int addr=(slave?(int)slave_reg:(int)master_reg)+(r<<2);
-  if(r==CCREG) addr=slave?(int)&slave_cc:(int)&master_cc;
+  pointer addr=(slave?(pointer)slave_reg:(pointer)master_reg)+(r<<2);
+  if(r==CCREG) addr=slave?(pointer)&slave_cc:(pointer)&master_cc;
   assem_debug("mov %x+%d,%%%s\n",addr,r,regname[hr]);
   output_byte(0x8B);
   output_modrm(0,5,hr);
-  output_w32(addr-(int)out-4); // Note: rip-relative in 64-bit mode
+  output_w32(addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
 }
 void emit_storereg(int r, int hr)
 {
-  int addr=(slave?(int)slave_reg:(int)master_reg)+(r<<2);
-  if(r==CCREG) addr=slave?(int)&slave_cc:(int)&master_cc;
+  pointer addr=(slave?(pointer)slave_reg:(pointer)master_reg)+(r<<2);
+  if(r==CCREG) addr=slave?(pointer)&slave_cc:(pointer)&master_cc;
   assem_debug("mov %%%s,%x+%d\n",regname[hr],addr,r);
   output_byte(0x89);
   output_modrm(0,5,hr);
-  output_w32(addr-(int)out-4); // Note: rip-relative in 64-bit mode
+  output_w32(addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
 }
 
 void emit_test(int rs, int rt)
@@ -1270,36 +1247,36 @@ void emit_cmpimm(int rs,int imm)
 
 void emit_cmovne(u32 *addr,int rt)
 {
-  assem_debug("cmovne %x,%%%s",(int)addr,regname[rt]);
+  assem_debug("cmovne %x,%%%s",(pointer)addr,regname[rt]);
   if(addr==&const_zero) assem_debug(" [zero]\n");
   else if(addr==&const_one) assem_debug(" [one]\n");
   else assem_debug("\n");
   output_byte(0x0F);
   output_byte(0x45);
   output_modrm(0,5,rt);
-  output_w32((int)addr-(int)out-4); // Note: rip-relative in 64-bit mode
+  output_w32((pointer)addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
 }
 void emit_cmovl(u32 *addr,int rt)
 {
-  assem_debug("cmovl %x,%%%s",(int)addr,regname[rt]);
+  assem_debug("cmovl %x,%%%s",(pointer)addr,regname[rt]);
   if(addr==&const_zero) assem_debug(" [zero]\n");
   else if(addr==&const_one) assem_debug(" [one]\n");
   else assem_debug("\n");
   output_byte(0x0F);
   output_byte(0x4C);
   output_modrm(0,5,rt);
-  output_w32((int)addr-(int)out-4); // Note: rip-relative in 64-bit mode
+  output_w32((pointer)addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
 }
 void emit_cmovs(u32 *addr,int rt)
 {
-  assem_debug("cmovs %x,%%%s",(int)addr,regname[rt]);
+  assem_debug("cmovs %x,%%%s",(pointer)addr,regname[rt]);
   if(addr==&const_zero) assem_debug(" [zero]\n");
   else if(addr==&const_one) assem_debug(" [one]\n");
   else assem_debug("\n");
   output_byte(0x0F);
   output_byte(0x48);
   output_modrm(0,5,rt);
-  output_w32((int)addr-(int)out-4); // Note: rip-relative in 64-bit mode
+  output_w32((pointer)addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
 }
 void emit_cmovne_reg(int rs,int rt)
 {
@@ -1308,6 +1285,13 @@ void emit_cmovne_reg(int rs,int rt)
   output_byte(0x45);
   output_modrm(3,rs,rt);
 }
+void emit_cmovno_reg(int rs,int rt)
+{
+  assem_debug("cmovno %%%s,%%%s\n",regname[rs],regname[rt]);
+  output_byte(0x0F);
+  output_byte(0x41);
+  output_modrm(3,rs,rt);
+}
 void emit_cmovl_reg(int rs,int rt)
 {
   assem_debug("cmovl %%%s,%%%s\n",regname[rs],regname[rt]);
@@ -1640,6 +1624,22 @@ void emit_subc(int s, int t, int sr)
   emit_sbb(s,t);
   emit_adc(sr,sr);
 }
+void emit_addv(int s, int t, int sr, int temp)
+{
+  assert(temp>=0);
+  emit_orimm(sr,1,sr);
+  emit_addimm(sr,-1,temp);
+  emit_add(t,s,t);
+  emit_cmovno_reg(temp,sr);
+}
+void emit_subv(int s, int t, int sr, int temp)
+{
+  assert(temp>=0);
+  emit_orimm(sr,1,sr);
+  emit_addimm(sr,-1,temp);
+  emit_sub(t,s,t);
+  emit_cmovno_reg(temp,sr);
+}
 void emit_shrsr(int t, int sr)
 {
   emit_shrimm(sr,1,sr);
@@ -1699,73 +1699,73 @@ void emit_rotcrsr(int t, int sr)
   emit_adc(sr,sr);
 }
 
-void emit_call(int a)
+void emit_call(pointer a)
 {
-  assem_debug("call %x (%x+%x)\n",a,(int)out+5,a-(int)out-5);
+  assem_debug("call %x (%x+%x)\n",a,(pointer)out+5,a-(pointer)out-5);
   output_byte(0xe8);
-  output_w32(a-(int)out-4);
+  output_w32(a-(pointer)out-4);
 }
-void emit_jmp(int a)
+void emit_jmp(pointer a)
 {
-  assem_debug("jmp %x (%x+%x)\n",a,(int)out+5,a-(int)out-5);
+  assem_debug("jmp %x (%x+%x)\n",a,(pointer)out+5,a-(pointer)out-5);
   output_byte(0xe9);
-  output_w32(a-(int)out-4);
+  output_w32(a-(pointer)out-4);
 }
-void emit_jne(int a)
+void emit_jne(pointer a)
 {
   assem_debug("jne %x\n",a);
   output_byte(0x0f);
   output_byte(0x85);
-  output_w32(a-(int)out-4);
+  output_w32(a-(pointer)out-4);
 }
-void emit_jeq(int a)
+void emit_jeq(pointer a)
 {
   assem_debug("jeq %x\n",a);
   output_byte(0x0f);
   output_byte(0x84);
-  output_w32(a-(int)out-4);
+  output_w32(a-(pointer)out-4);
 }
-void emit_js(int a)
+void emit_js(pointer a)
 {
   assem_debug("js %x\n",a);
   output_byte(0x0f);
   output_byte(0x88);
-  output_w32(a-(int)out-4);
+  output_w32(a-(pointer)out-4);
 }
-void emit_jns(int a)
+void emit_jns(pointer a)
 {
   assem_debug("jns %x\n",a);
   output_byte(0x0f);
   output_byte(0x89);
-  output_w32(a-(int)out-4);
+  output_w32(a-(pointer)out-4);
 }
-void emit_jl(int a)
+void emit_jl(pointer a)
 {
   assem_debug("jl %x\n",a);
   output_byte(0x0f);
   output_byte(0x8c);
-  output_w32(a-(int)out-4);
+  output_w32(a-(pointer)out-4);
 }
-void emit_jge(int a)
+void emit_jge(pointer a)
 {
   assem_debug("jge %x\n",a);
   output_byte(0x0f);
   output_byte(0x8d);
-  output_w32(a-(int)out-4);
+  output_w32(a-(pointer)out-4);
 }
-void emit_jno(int a)
+void emit_jno(pointer a)
 {
   assem_debug("jno %x\n",a);
   output_byte(0x0f);
   output_byte(0x81);
-  output_w32(a-(int)out-4);
+  output_w32(a-(pointer)out-4);
 }
-void emit_jc(int a)
+void emit_jc(pointer a)
 {
   assem_debug("jc %x\n",a);
   output_byte(0x0f);
   output_byte(0x82);
-  output_w32(a-(int)out-4);
+  output_w32(a-(pointer)out-4);
 }
 
 void emit_pushimm(int imm)
@@ -1857,7 +1857,7 @@ void emit_negc(int rs, int rt, int sr)
   }
 }
 
-void emit_readword(u64 addr, int rt)
+void emit_readword(pointer addr, int rt)
 {
   if(addr-(u64)out+0x7FFFFFFA>0xFFFFFFFE) {
     //TODO: special eax case
@@ -1876,7 +1876,7 @@ void emit_readword(u64 addr, int rt)
     assem_debug("mov %x,%%%s\n",addr,regname[rt]);
     output_byte(0x8B);
     output_modrm(0,5,rt);
-    output_w32(addr-(int)out-4); // Note: rip-relative in 64-bit mode
+    output_w32(addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
   }
 }
 void emit_readword_indexed(int addr, int rs, int rt)
@@ -1960,16 +1960,17 @@ void emit_movmem_indexedx8(int addr, int rs, int rt)
   output_sib(3,rs,5);
   output_w32(addr);
 }
-void emit_movmem_indexedx8_64(int addr, int rs, int rt)
+// Load memory_map[rs] (%r15 points to memory_map)
+void emit_readmap(int rs, int rt)
 {
-  assem_debug("mov (%x,%%%s,8),%%%s\n",addr,regname[rs],regname[rt]);
-  output_rex(1,0,0,rt>>3);
+  assem_debug("mov (%%r15,%%%s,8),%%%s\n",regname[rs],regname[rt]);
+  assert(rs<8&&rt<8);
+  output_rex(1,0,0,1);
   output_byte(0x8B);
   output_modrm(0,4,rt);
-  output_sib(3,rs,5);
-  output_w32(addr);
+  output_sib(3,rs,MMAP_BASE_REG&7);
 }
-void emit_movsbl(u64 addr, int rt)
+void emit_movsbl(pointer addr, int rt)
 {
   if(addr-(u64)out+0x7FFFFFF9>0xFFFFFFFE) {
     emit_movimm64(addr,rt);
@@ -1989,7 +1990,7 @@ void emit_movsbl(u64 addr, int rt)
     output_byte(0x0F);
     output_byte(0xBE);
     output_modrm(0,5,rt);
-    output_w32(addr-(int)out-4); // rip-relative
+    output_w32(addr-(pointer)out-4); // rip-relative
   }
 }
 void emit_movsbl_indexed(int addr, int rs, int rt)
@@ -2042,7 +2043,7 @@ void emit_movsbl_indexed_map(int addr, int rs, int map, int rt)
     }
   }
 }
-void emit_movswl(u64 addr, int rt)
+void emit_movswl(pointer addr, int rt)
 {
   if(addr-(u64)out+0x7FFFFFF9>0xFFFFFFFE) {
     emit_movimm64(addr,rt);
@@ -2062,7 +2063,7 @@ void emit_movswl(u64 addr, int rt)
     output_byte(0x0F);
     output_byte(0xBF);
     output_modrm(0,5,rt);
-    output_w32(addr-(int)out-4); // rip-relative
+    output_w32(addr-(pointer)out-4); // rip-relative
   }
 }
 void emit_movswl_indexed(int addr, int rs, int rt)
@@ -2115,13 +2116,13 @@ void emit_movswl_indexed_map(int addr, int rs, int map, int rt)
     }
   }
 }
-void emit_movzbl(int addr, int rt)
+void emit_movzbl(pointer addr, int rt)
 {
   assem_debug("movzbl %x,%%%s\n",addr,regname[rt]);
   output_byte(0x0F);
   output_byte(0xB6);
   output_modrm(0,5,rt);
-  output_w32(addr-(int)out-4); // Note: rip-relative in 64-bit mode
+  output_w32(addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
 }
 void emit_movzbl_indexed(int addr, int rs, int rt)
 {
@@ -2171,13 +2172,13 @@ void emit_movzbl_indexed_map(int addr, int rs, int map, int rt)
     }
   }
 }
-void emit_movzwl(int addr, int rt)
+void emit_movzwl(pointer addr, int rt)
 {
   assem_debug("movzwl %x,%%%s\n",addr,regname[rt]);
   output_byte(0x0F);
   output_byte(0xB7);
   output_modrm(0,5,rt);
-  output_w32(addr-(int)out-4); // Note: rip-relative in 64-bit mode
+  output_w32(addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
 }
 void emit_movzwl_indexed(int addr, int rs, int rt)
 {
@@ -2201,25 +2202,27 @@ void emit_movzwl_map(int addr, int map, int rt)
     output_w32(addr);
   }
 }
-void emit_movq(u64 addr, int rt)
+void emit_movq(pointer addr, int rt)
 {
-  if(addr-(u64)out+0x7FFFFFFA>0xFFFFFFFF) {
-    assert(addr-(u64)out+0x7FFFFFFA<0x100000000);
-    //TODO: special eax case
+  if(addr-(u64)out+0x7FFFFFFA>0xFFFFFFFE) {
     emit_movimm64(addr,rt);
-    //FIXME
-    assem_debug("mov (%%%s),%%%s\n",regname[rt],regname[rt]);
+    assem_debug("movq (%%%s),%%%s\n",regname[rt],regname[rt]);
+    output_rex(1,0,0,0);
     output_byte(0x8B);
-    output_modrm(0,rt,rt);
-    output_byte(0xCC);//remove
+    if(rt!=EBP) {
+      output_modrm(0,rt,rt);
+    } else {
+      output_modrm(1,rt,rt);
+      output_byte(0);
+    }
   }
   else
   {
     assem_debug("movq %llx,%%%s\n",addr,regname[rt]);
-    output_rex(1,0,0,rt>>8);
+    output_rex(1,0,0,0);
     output_byte(0x8B);
     output_modrm(0,5,rt);
-    output_w32(addr-(int)out-4); // Note: rip-relative in 64-bit mode
+    output_w32(addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
   }
 }
 
@@ -2235,12 +2238,12 @@ void emit_xchg(int rs, int rt)
     output_modrm(3,rs,rt);
   }
 }
-void emit_writeword(int rt, int addr)
+void emit_writeword(int rt, pointer addr)
 {
   assem_debug("movl %%%s,%x\n",regname[rt],addr);
   output_byte(0x89);
   output_modrm(0,5,rt);
-  output_w32(addr-(int)out-4); // Note: rip-relative in 64-bit mode
+  output_w32(addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
 }
 void emit_writeword_indexed(int rt, int addr, int rs)
 {
@@ -2294,13 +2297,13 @@ void emit_writeword_indexed_map(int rt, int addr, int rs, int map, int temp)
     }
   }
 }
-void emit_writehword(int rt, int addr)
+void emit_writehword(int rt, pointer addr)
 {
   assem_debug("movw %%%s,%x\n",regname[rt]+1,addr);
   output_byte(0x66);
   output_byte(0x89);
   output_modrm(0,5,rt);
-  output_w32(addr-(int)out-4); // Note: rip-relative in 64-bit mode
+  output_w32(addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
 }
 void emit_writehword_indexed(int rt, int addr, int rs)
 {
@@ -2352,13 +2355,13 @@ void emit_writehword_indexed_map(int rt, int addr, int rs, int map, int temp)
     }
   }
 }
-void emit_writebyte(int rt, int addr)
+void emit_writebyte(int rt, pointer addr)
 {
   assem_debug("movb %%%cl,%x\n",regname[rt][1],addr);
   if(rt>=4) output_rex(0,rt>>3,0,0);
   output_byte(0x88);
   output_modrm(0,5,rt);
-  output_w32(addr-(int)out-4); // Note: rip-relative in 64-bit mode
+  output_w32(addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
 }
 void emit_writebyte_indexed(int rt, int addr, int rs)
 {
@@ -2411,12 +2414,12 @@ void emit_writebyte_indexed_map(int rt, int addr, int rs, int map, int temp)
     }
   }
 }
-void emit_writeword_imm(int imm, int addr)
+void emit_writeword_imm(int imm, pointer addr)
 {
   assem_debug("movl $%x,%x\n",imm,addr);
   output_byte(0xC7);
   output_modrm(0,5,0);
-  output_w32(addr-(int)out-8); // Note: rip-relative in 64-bit mode
+  output_w32(addr-(pointer)out-8); // Note: rip-relative in 64-bit mode
   output_w32(imm);
 }
 void emit_writeword_imm_esp(int imm, int addr)
@@ -2429,22 +2432,30 @@ void emit_writeword_imm_esp(int imm, int addr)
   if(addr) output_byte(addr);
   output_w32(imm);
 }
-void emit_writedword_imm32(int imm, int addr)
+void emit_writedword(int rt, pointer addr)
+{
+  assem_debug("movq %%%s,%x\n",regname[rt],addr);
+  output_rex(1,0,0,0);
+  output_byte(0x89);
+  output_modrm(0,5,rt);
+  output_w32(addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
+}
+void emit_writedword_imm32(int imm, pointer addr)
 {
   assem_debug("movq $%x,%x\n",imm,addr);
   output_rex(1,0,0,0);
   output_byte(0xC7);
   output_modrm(0,5,0);
-  output_w32(addr-(int)out-8); // Note: rip-relative in 64-bit mode
+  output_w32(addr-(pointer)out-8); // Note: rip-relative in 64-bit mode
   output_w32(imm); // Note: This 32-bit value will be sign extended
 }
-void emit_writebyte_imm(int imm, int addr)
+void emit_writebyte_imm(int imm, pointer addr)
 {
   assem_debug("movb $%x,%x\n",imm,addr);
   assert(imm>=-128&&imm<128);
   output_byte(0xC6);
   output_modrm(0,5,0);
-  output_w32(addr-(int)out-5); // Note: rip-relative in 64-bit mode
+  output_w32(addr-(pointer)out-5); // Note: rip-relative in 64-bit mode
   output_byte(imm);
 }
 
@@ -2620,11 +2631,22 @@ void emit_div0s(int s1, int s2, int sr, int temp) {
   emit_adc(sr,sr);
 }
 
+// Load a rip-relative address
+void emit_lea_rip(pointer addr,unsigned int rt)
+{
+  assem_debug("lea %x,%%%s\n",addr,regname[rt]);
+  assert(rt<8);
+  output_rex(1,0,0,0);
+  output_byte(0x8D);
+  output_modrm(0,5,rt);
+  output_w32(addr-(pointer)out-4);
+}
+
 // Load return address
 void emit_load_return_address(unsigned int rt)
 {
   // (assumes this instruction will be followed by a 5-byte jmp instruction)
-  emit_movimm((int)out+10,rt);
+  emit_lea_rip((pointer)out+12,rt);
 }
 
 // Load 2 immediates optimizing for small code size
@@ -2642,7 +2664,7 @@ void emit_cmpmem_imm_byte(pointer addr,int imm)
   assem_debug("cmpb $%d,%x\n",imm,addr);
   output_byte(0x80);
   output_modrm(0,5,7);
-  output_w32(addr-(int)out-5); // Note: rip-relative in 64-bit mode
+  output_w32(addr-(pointer)out-5); // Note: rip-relative in 64-bit mode
   output_byte(imm);
 }
 
@@ -2670,24 +2692,48 @@ void emit_cmpmem_indexed(int addr,int rs,int rt)
   output_w32(addr);
 }
 
+// special case for checking mini_ht, relative to memory_map in %r15
+void emit_cmpmem_indexed_mmap(int offset,int rs,int rt)
+{
+  assert(rs>=0&&rs<8);
+  assert(rt>=0&&rt<8);
+  assem_debug("cmp %x(%%r15,%%%s),%%%s\n",offset,regname[rs],regname[rt]);
+  output_rex(0,0,0,1);
+  output_byte(0x39);
+  output_modrm(2,4,rt);
+  output_sib(0,rs,MMAP_BASE_REG&7);
+  output_w32(offset);
+}
+void emit_readdword_indexed_mmap(int offset,int rs,int rt)
+{
+  assert(rs>=0&&rs<8);
+  assert(rt>=0&&rt<8);
+  assem_debug("movq %x(%%r15,%%%s),%%%s\n",offset,regname[rs],regname[rt]);
+  output_rex(1,0,0,1);
+  output_byte(0x8B);
+  output_modrm(2,4,rt);
+  output_sib(0,rs,MMAP_BASE_REG&7);
+  output_w32(offset);
+}
+
 // special case for checking memory_map in verify_mapping
-void emit_cmpmem(int addr,int rt)
+void emit_cmpmem(pointer addr,int rt)
 {
   assert(rt>=0&&rt<8);
   assem_debug("cmp %x,%%%s\n",addr,regname[rt]);
   output_byte(0x39);
   output_modrm(0,5,rt);
-  output_w32((int)addr-(int)out-4); // Note: rip-relative in 64-bit mode
+  output_w32((pointer)addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
 }
 
 // Used to preload hash table entries
 void emit_prefetch(void *addr)
 {
-  assem_debug("prefetch %x\n",(int)addr);
+  assem_debug("prefetch %x\n",(pointer)addr);
   output_byte(0x0F);
   output_byte(0x18);
   output_modrm(0,5,1);
-  output_w32((int)addr-(int)out-4); // Note: rip-relative in 64-bit mode
+  output_w32((pointer)addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
 }
 
 /*void emit_submem(int r,int addr)
@@ -2696,7 +2742,7 @@ void emit_prefetch(void *addr)
   assem_debug("sub %x,%%%s\n",addr,regname[r]);
   output_byte(0x2B);
   output_modrm(0,5,r);
-  output_w32((int)addr);
+  output_w32((pointer)addr);
 }*/
 
 void emit_flds(int r)
@@ -2889,12 +2935,12 @@ void emit_fldcw_indexed(int addr,int r)
   output_sib(1,r,5);
   output_w32(addr);
 }
-void emit_fldcw(int addr)
+void emit_fldcw(pointer addr)
 {
   assem_debug("fldcw %x\n",addr);
   output_byte(0xd9);
   output_modrm(0,5,5);
-  output_w32(addr-(int)out-4); // Note: rip-relative in 64-bit mode
+  output_w32(addr-(pointer)out-4); // Note: rip-relative in 64-bit mode
 }
 void emit_movss_load(unsigned int addr,unsigned int ssereg)
 {
@@ -3014,8 +3060,7 @@ void emit_extjump(pointer addr, int target)
     addr++;
   }
   emit_movimm(target,EAX);
-  emit_movimm(addr,EBX);
-  //assert(addr>=0x7000000&&addr<0x7FFFFFF);
+  emit_lea_rip(addr,EBX);
 //DEBUG >
 #ifdef DEBUG_CYCLE_COUNT
   emit_readword((int)&last_count,ECX);
@@ -3032,7 +3077,7 @@ void emit_extjump(pointer addr, int target)
 void do_readstub(int n)
 {
   assem_debug("do_readstub %x\n",start+stubs[n][3]*2);
-  set_jump_target(stubs[n][1],(int)out);
+  set_jump_target(stubs[n][1],(pointer)out);
   int type=stubs[n][0];
   int i=stubs[n][3];
   int rs=stubs[n][4];
@@ -3074,11 +3119,11 @@ void do_readstub(int n)
     temp=!addr;
   }*/
   if(type==LOADB_STUB)
-    emit_call((int)MappedMemoryReadByte);
+    emit_call((pointer)MappedMemoryReadByte);
   if(type==LOADW_STUB)
-    emit_call((int)MappedMemoryReadWord);
+    emit_call((pointer)MappedMemoryReadWord);
   if(type==LOADL_STUB)
-    emit_call((int)MappedMemoryReadLong);
+    emit_call((pointer)MappedMemoryReadLong);
   if(type==LOADS_STUB)
   {
     // RTE instruction, pop PC and SR from stack
@@ -3087,7 +3132,7 @@ void do_readstub(int n)
     if(rs==EAX||rs==ECX||rs==EDX||rs==ESI||rs==EDI)
       emit_mov(rs,12);
       //emit_writeword_indexed(rs,0,ESP);
-    emit_call((int)MappedMemoryReadLong);
+    emit_call((pointer)MappedMemoryReadLong);
     if(rs==EAX||rs==ECX||rs==EDX||rs==ESI)
       emit_mov(12,rs);
       //emit_readword_indexed(0,ESP,rs);
@@ -3109,7 +3154,7 @@ void do_readstub(int n)
       }else
         emit_addimm(rs,4,EDI);
     }
-    emit_call((int)MappedMemoryReadLong);
+    emit_call((pointer)MappedMemoryReadLong);
     assert(rt>=0);
     if(rt!=EAX) emit_mov(EAX,rt);
     if(pc==EAX||pc==ECX||pc==EDX||pc==ESI||pc==EDI)
@@ -3144,11 +3189,11 @@ void inline_readstub(int type, int i, u32 addr, signed char regmap[], int target
   save_regs(reglist);
   emit_movimm(addr,EDI);
   if(type==LOADB_STUB)
-    emit_call((int)MappedMemoryReadByte);
+    emit_call((pointer)MappedMemoryReadByte);
   if(type==LOADW_STUB)
-    emit_call((int)MappedMemoryReadWord);
+    emit_call((pointer)MappedMemoryReadWord);
   if(type==LOADL_STUB)
-    emit_call((int)MappedMemoryReadLong);
+    emit_call((pointer)MappedMemoryReadLong);
   assert(type!=LOADS_STUB);
   if(type==LOADB_STUB)
   {
@@ -3168,7 +3213,7 @@ void inline_readstub(int type, int i, u32 addr, signed char regmap[], int target
 void do_writestub(int n)
 {
   assem_debug("do_writestub %x\n",start+stubs[n][3]*2);
-  set_jump_target(stubs[n][1],(int)out);
+  set_jump_target(stubs[n][1],(pointer)out);
   int type=stubs[n][0];
   int i=stubs[n][3];
   int rs=stubs[n][4];
@@ -3221,11 +3266,11 @@ void do_writestub(int n)
     temp=!addr;
   }*/
   if(type==STOREB_STUB)
-    emit_call((int)WriteInvalidateByteSwapped);
+    emit_call((pointer)WriteInvalidateByteSwapped);
   if(type==STOREW_STUB)
-    emit_call((int)WriteInvalidateWord);
+    emit_call((pointer)WriteInvalidateWord);
   if(type==STOREL_STUB)
-    emit_call((int)WriteInvalidateLong);
+    emit_call((pointer)WriteInvalidateLong);
   
   restore_regs(reglist);
   emit_jmp(stubs[n][2]); // return address
@@ -3243,18 +3288,18 @@ void inline_writestub(int type, int i, u32 addr, signed char regmap[], int targe
   if(rt!=ESI) emit_mov(rt,ESI);
   emit_movimm(addr,EDI); // FIXME - should be able to move the existing value
   if(type==STOREB_STUB)
-    emit_call((int)WriteInvalidateByte);
+    emit_call((pointer)WriteInvalidateByte);
   if(type==STOREW_STUB)
-    emit_call((int)WriteInvalidateWord);
+    emit_call((pointer)WriteInvalidateWord);
   if(type==STOREL_STUB)
-    emit_call((int)WriteInvalidateLong);
+    emit_call((pointer)WriteInvalidateLong);
   restore_regs(reglist);
 }
 
 void do_rmwstub(int n)
 {
   assem_debug("do_rmwstub %x\n",start+stubs[n][3]*2);
-  set_jump_target(stubs[n][1],(int)out);
+  set_jump_target(stubs[n][1],(pointer)out);
   int type=stubs[n][0];
   int i=stubs[n][3];
   int rs=stubs[n][4];
@@ -3298,7 +3343,7 @@ void do_rmwstub(int n)
     output_byte(12+16);
     emit_writeword(ECX,(int)&MSH2->cycles);
   }*/
-  emit_call((int)MappedMemoryReadByte);
+  emit_call((pointer)MappedMemoryReadByte);
   emit_mov(EAX,ESI);
   if(rs==EAX||rs==ECX||rs==EDX||rs==ESI||rs==EDI)
     emit_mov(12,EDI);
@@ -3316,8 +3361,8 @@ void do_rmwstub(int n)
     //emit_writeword_indexed(EDX,0,ESP);
     emit_orimm(ESI,0x80,ESI);
   }
-  //emit_call((int)MappedMemoryWriteByte);
-  emit_call((int)WriteInvalidateByte);
+  //emit_call((pointer)MappedMemoryWriteByte);
+  emit_call((pointer)WriteInvalidateByte);
   
   restore_regs(reglist);
 
@@ -3340,7 +3385,7 @@ void do_rmwstub(int n)
 
 void do_unalignedwritestub(int n)
 {
-  set_jump_target(stubs[n][1],(int)out);
+  set_jump_target(stubs[n][1],(pointer)out);
   output_byte(0xCC);
   emit_jmp(stubs[n][2]); // return address
 }
@@ -3350,21 +3395,18 @@ void printregs(int edi,int esi,int ebp,int esp,int b,int d,int c,int a)
   printf("regs: %x %x %x %x %x %x %x (%x)\n",a,b,c,d,ebp,esi,edi,(&edi)[-1]);
 }
 
-int do_dirty_stub(int i)
+pointer do_dirty_stub(int i)
 {
   assem_debug("do_dirty_stub %x\n",start+i*2);
-  u32 alignedlen=((((u32)source)+slen*2+2)&~2)-(u32)alignedsource;
-  if((u64)source<=0xFFFFFFFF)
-    emit_movimm(((u32)source)&~3,EAX); //alignedsource
-  else
-    emit_movimm64(((u64)source)&~3,EAX); //alignedsource
-  emit_movimm((u32)copy,EBX);
-  emit_movimm((((u32)source+slen*2+2)&~3)-((u32)source&~3),ECX);
+  // Careful about the code output here, verify_dirty needs to parse it.
+  emit_movimm64(((pointer)source)&~3,EAX); //alignedsource
+  emit_lea_rip((pointer)copy,EBX);
+  emit_movimm((((pointer)source+slen*2+2)&~3)-((pointer)source&~3),ECX);
   emit_movimm(start+i*2+slave,12);
-  emit_call((int)&verify_code);
-  int entry=(int)out;
+  emit_call((pointer)&verify_code);
+  pointer entry=(pointer)out;
   load_regs_entry(i);
-  if(entry==(int)out) entry=instr_addr[i];
+  if(entry==(pointer)out) entry=instr_addr[i];
   emit_jmp(instr_addr[i]);
   return entry;
 }
@@ -3375,7 +3417,7 @@ int do_map_r(int s,int ar,int map,int cache,int x,int a,int shift,int c,u32 addr
 {
   if(c) {
     /*if((signed int)addr>=(signed int)0xC0000000) {
-      emit_movq((int)(memory_map+(addr>>12)),map);
+      emit_movq((pointer)(memory_map+(addr>>12)),map);
     }
     else*/
       return -1; // No mapping
@@ -3387,15 +3429,15 @@ int do_map_r(int s,int ar,int map,int cache,int x,int a,int shift,int c,u32 addr
     if(x) emit_xorimm(s,x,ar);
     //if(shift>=0) emit_lea8(s,shift);
     //if(~a) emit_andimm(s,a,ar);
-    emit_movmem_indexedx8_64((int)memory_map,map,map);
+    emit_readmap(map,map);
   }
   return map;
 }
-int do_map_r_branch(int map, int c, u32 addr, int *jaddr)
+int do_map_r_branch(int map, int c, u32 addr, pointer *jaddr)
 {
   if(!c) {
     emit_test64(map,map);
-    *jaddr=(int)out;
+    *jaddr=(pointer)out;
     emit_js(0);
   }
   return map;
@@ -3411,7 +3453,7 @@ int do_map_w(int s,int ar,int map,int cache,int x,int c,u32 addr)
 {
   if(c) {
     if(can_direct_write(addr)) {
-      emit_movq((int)(memory_map+(addr>>12)),map);
+      emit_movq((pointer)(memory_map+(addr>>12)),map);
     }
     else
       return -1; // No mapping
@@ -3422,15 +3464,15 @@ int do_map_w(int s,int ar,int map,int cache,int x,int c,u32 addr)
     emit_shrimm(map,12,map);
     // Schedule this while we wait on the load
     if(x) emit_xorimm(s,x,ar);
-    emit_movmem_indexedx8_64((int)memory_map,map,map);
+    emit_readmap(map,map);
   }
   emit_shlimm64(map,2,map);
   return map;
 }
-void do_map_w_branch(int map, int c, u32 addr, int *jaddr)
+void do_map_w_branch(int map, int c, u32 addr, pointer *jaddr)
 {
   if(!c||can_direct_write(addr)) {
-    *jaddr=(int)out;
+    *jaddr=(pointer)out;
     emit_jc(0);
   }
 }
@@ -3465,21 +3507,27 @@ void do_miniht_load(int ht,int rh) {
   // a single instruction (below)
 }
 
+static int miniht_offset(void) {
+  pointer offset=(slave?(pointer)mini_ht_slave:(pointer)mini_ht_master)-(pointer)memory_map;
+  assert(offset+0x80000000<0x100000000);
+  return offset;
+}
+
 void do_miniht_jump(int rs,int rh,int ht) {
-  emit_cmpmem_indexed(slave?(u32)mini_ht_slave:(u32)mini_ht_master,rh,rs);
+  emit_cmpmem_indexed_mmap(miniht_offset(),rh,rs);
   emit_jne(jump_vaddr_reg[slave][rs]);
-  emit_readword_indexed(slave?(u32)mini_ht_slave+4:(u32)mini_ht_master+4,rh,rh);
+  emit_readdword_indexed_mmap(miniht_offset()+sizeof(mini_ht_master[0]),rh,rh);
   emit_jmpreg(rh);
 }
 
 void do_miniht_insert(int return_address,int rt,int temp) {
   emit_movimm(return_address,rt); // PC into link register
-  //emit_writeword_imm(return_address,(int)&mini_ht[(return_address&0xFF)>>8][0]);
-  if(slave) emit_writeword(rt,(int)&mini_ht_slave[(return_address&0xFF)>>3][0]);
-  else emit_writeword(rt,(int)&mini_ht_master[(return_address&0xFF)>>3][0]);
-  add_to_linker((int)out,return_address,1);
-  if(slave) emit_writeword_imm(0,(int)&mini_ht_slave[(return_address&0xFF)>>3][1]);
-  else emit_writeword_imm(0,(int)&mini_ht_master[(return_address&0xFF)>>3][1]);
+  if(slave) emit_writeword(rt,(pointer)&mini_ht_slave[0][(return_address&0xFF)>>3]);
+  else emit_writeword(rt,(pointer)&mini_ht_master[0][(return_address&0xFF)>>3]);
+  add_to_linker((pointer)out,return_address,1);
+  emit_lea_rip(0,temp);
+  if(slave) emit_writedword(temp,(pointer)&mini_ht_slave[1][(return_address&0xFF)>>3]);
+  else emit_writedword(temp,(pointer)&mini_ht_master[1][(return_address&0xFF)>>3]);
 }
 
 void wb_valid(signed char pre[],signed char entry[],u32 dirty_pre,u32 dirty,u64 u)
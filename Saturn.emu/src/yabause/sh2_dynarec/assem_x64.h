@@ -12,7 +12,8 @@
 
 #define USE_MINI_HT 1
 
-#define BASE_ADDR 0x70000000 // Code generator target address
+extern u8 sh2_dynarec_target[];
+#define BASE_ADDR ((pointer)sh2_dynarec_target) // Code generator target address
 #define TARGET_SIZE_2 25 // 2^25 = 32 megabytes
 #define JUMP_TABLE_SIZE 0 // Not needed for x86
 
@@ -23,6 +24,10 @@
 #define ARG1_REG 7 /* RDI */
 #define ARG2_REG 6 /* RSI */
 
+/* %r15 holds the address of memory_map while running translated code,
+   so the map and mini_ht can be indexed without absolute addresses */
+#define MMAP_BASE_REG 15
+
 #define EAX 0
 #define ECX 1
 #define EDX 2
@@ -148,7 +148,7 @@ int isclean(pointer addr)
   return 0;
 }
 
-void get_bounds(pointer addr,u32 *start,u32 *end)
+void get_bounds(pointer addr,pointer *start,pointer *end)
 {
   u8 *ptr=(u8 *)addr;
   assert(ptr[5]==0xB8);
@@ -1150,6 +1150,13 @@ void emit_cmovne_reg(int rs,int rt)
   output_byte(0x45);
   output_modrm(3,rs,rt);
 }
+void emit_cmovno_reg(int rs,int rt)
+{
+  assem_debug("cmovno %%%s,%%%s\n",regname[rs],regname[rt]);
+  output_byte(0x0F);
+  output_byte(0x41);
+  output_modrm(3,rs,rt);
+}
 void emit_cmovl_reg(int rs,int rt)
 {
   assem_debug("cmovl %%%s,%%%s\n",regname[rs],regname[rt]);
@@ -1483,6 +1490,22 @@ void emit_subc(int s, int t, int sr)
   emit_sbb(s,t);
   emit_adc(sr,sr);
 }
+void emit_addv(int s, int t, int sr, int temp)
+{
+  assert(temp>=0);
+  emit_orimm(sr,1,sr);
+  emit_addimm(sr,-1,temp);
+  emit_add(t,s,t);
+  emit_cmovno_reg(temp,sr);
+}
+void emit_subv(int s, int t, int sr, int temp)
+{
+  assert(temp>=0);
+  emit_orimm(sr,1,sr);
+  emit_addimm(sr,-1,temp);
+  emit_sub(t,s,t);
+  emit_cmovno_reg(temp,sr);
+}
 void emit_shrsr(int t, int sr)
 {
   emit_shrimm(sr,1,sr);
@@ -3173,7 +3196,7 @@ void printregs(int edi,int esi,int ebp,int esp,int b,int d,int c,int a)
   printf("regs: %x %x %x %x %x %x %x (%x)\n",a,b,c,d,ebp,esi,edi,(&edi)[-1]);
 }
 
-int do_dirty_stub(int i)
+pointer do_dirty_stub(int i)
 {
   assem_debug("do_dirty_stub %x\n",start+i*2);
   u32 alignedlen=((((u32)source)+slen*2+2)&~2)-(u32)alignedsource;
@@ -3212,7 +3235,7 @@ int do_map_r(int s,int ar,int map,int cache,int x,int a,int shift,int c,u32 addr
   }
   return map;
 }
-int do_map_r_branch(int map, int c, u32 addr, int *jaddr)
+int do_map_r_branch(int map, int c, u32 addr, pointer *jaddr)
 {
   if(!c) {
     emit_test(map,map);
@@ -3248,7 +3271,7 @@ int do_map_w(int s,int ar,int map,int cache,int x,int c,u32 addr)
   emit_shlimm(map,2,map);
   return map;
 }
-void do_map_w_branch(int map, int c, u32 addr, int *jaddr)
+void do_map_w_branch(int map, int c, u32 addr, pointer *jaddr)
 {
   if(!c||can_direct_write(addr)) {
     *jaddr=(int)out;
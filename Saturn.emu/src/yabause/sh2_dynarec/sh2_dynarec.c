@@ -107,9 +107,9 @@ struct ll_entry
   int ccadj[MAXBLOCK];
   int slen;
   pointer instr_addr[MAXBLOCK];
-  u32 link_addr[MAXBLOCK][3];
+  pointer link_addr[MAXBLOCK][3];
   int linkcount;
-  u32 stubs[MAXBLOCK*3][8];
+  pointer stubs[MAXBLOCK*3][8];
   int stubcount;
   pointer ccstub_return[MAXBLOCK];
   u32 literals[1024][2];
@@ -119,7 +119,7 @@ struct ll_entry
   struct ll_entry *jump_in[2048];
   struct ll_entry *jump_out[2048];
   struct ll_entry *jump_dirty[2048];
-  ALIGNED(16) u32 hash_table[65536][4];
+  ALIGNED(16) pointer hash_table[65536][4];
   ALIGNED(16) char shadow[2097152];
   char *copy;
   int expirep;
@@ -221,7 +221,7 @@ struct ll_entry
 // asm linkage
 int sh2_recompile_block(int addr);
 void *get_addr_ht(u32 vaddr);
-void get_bounds(pointer addr,u32 *start,u32 *end);
+void get_bounds(pointer addr,pointer *start,pointer *end);
 void invalidate_addr(u32 addr);
 void remove_hash(int vaddr);
 void dyna_linker();
@@ -270,10 +270,10 @@ void *get_addr(u32 vaddr)
     if(head->vaddr==vaddr) {
   //printf("TRACE: count=%d next=%d (get_addr match %x: %x)\n",Count,next_interupt,vaddr,(int)head->addr);
   //printf("TRACE: (get_addr match %x: %x)\n",vaddr,(int)head->addr);
-      int *ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
+      pointer *ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
       ht_bin[3]=ht_bin[1];
       ht_bin[2]=ht_bin[0];
-      ht_bin[1]=(int)head->addr;
+      ht_bin[1]=(pointer)head->addr;
       ht_bin[0]=vaddr;
       //printf("TRACE: get_addr clean (%x,%x)\n",vaddr,(int)head->addr);
       return head->addr;
@@ -287,8 +287,8 @@ void *get_addr(u32 vaddr)
       // Don't restore blocks which are about to expire from the cache
       if((((u32)head->addr-(u32)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2)))
       if(verify_dirty(head->addr)) {
-        u32 start,end;
-        int *ht_bin;
+        pointer start,end;
+        pointer *ht_bin;
         //printf("restore candidate: %x (%d) d=%d\n",vaddr,page,(cached_code[vaddr>>15]>>((vaddr>>12)&7))&1);
         //invalid_code[vaddr>>12]=0;
         cached_code[vaddr>>15]|=1<<((vaddr>>12)&7);
@@ -302,18 +302,18 @@ void *get_addr(u32 vaddr)
         #endif
         restore_candidate[page>>3]|=1<<(page&7);
         get_bounds((pointer)head->addr,&start,&end);
-        if(start-(u32)HighWram<0x100000) {
-          u32 vstart=start-(u32)HighWram+0x6000000;
-          u32 vend=end-(u32)HighWram+0x6000000;
+        if(start-(pointer)HighWram<0x100000) {
+          u32 vstart=start-(pointer)HighWram+0x6000000;
+          u32 vend=end-(pointer)HighWram+0x6000000;
           int i;
           //printf("write protect: start=%x, end=%x\n",vstart,vend);
           for(i=0;i<vend-vstart;i+=4) {
             cached_code_words[((vstart<4194304?vstart:((vstart|0x400000)&0x7fffff))+i)>>5]|=1<<(((vstart+i)>>2)&7);
           }
         }
-        if(start-(u32)LowWram<0x100000) {
-          u32 vstart=start-(u32)LowWram+0x200000;
-          u32 vend=end-(u32)LowWram+0x200000;
+        if(start-(pointer)LowWram<0x100000) {
+          u32 vstart=start-(pointer)LowWram+0x200000;
+          u32 vend=end-(pointer)LowWram+0x200000;
           int i;
           //printf("write protect: start=%x, end=%x\n",vstart,vend);
           for(i=0;i<vend-vstart;i+=4) {
@@ -322,13 +322,13 @@ void *get_addr(u32 vaddr)
         }
         ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
         if(ht_bin[0]==vaddr) {
-          ht_bin[1]=(int)head->addr; // Replace existing entry
+          ht_bin[1]=(pointer)head->addr; // Replace existing entry
         }
         else
         {
           ht_bin[3]=ht_bin[1];
           ht_bin[2]=ht_bin[0];
-          ht_bin[1]=(int)head->addr;
+          ht_bin[1]=(pointer)head->addr;
           ht_bin[0]=vaddr;
         }
         //printf("TRACE: get_addr dirty (%x,%x)\n",vaddr,(int)head->addr);
@@ -345,7 +345,7 @@ void *get_addr_ht(u32 vaddr)
 {
   //printf("TRACE: count=%d next=%d (get_addr_ht %x)\n",Count,next_interupt,vaddr);
   //if(vaddr>>12==0x60a0) printf("TRACE: (get_addr_ht %x)\n",vaddr);
-  int *ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
+  pointer *ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
   //if(vaddr>>12==0x60a0) printf("%x %x %x %x\n",ht_bin[0],ht_bin[1],ht_bin[2],ht_bin[3]);
   if(ht_bin[0]==vaddr) return (void *)ht_bin[1];
   if(ht_bin[2]==vaddr) return (void *)ht_bin[3];
@@ -752,13 +752,13 @@ void *check_addr(u32 vaddr)
 {
   struct ll_entry *head;
   u32 page;
-  u32 *ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
+  pointer *ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
   if(ht_bin[0]==vaddr) {
-    if(((ht_bin[1]-MAX_OUTPUT_BLOCK_SIZE-(u32)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2)))
+    if((((u32)ht_bin[1]-MAX_OUTPUT_BLOCK_SIZE-(u32)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2)))
       if(isclean(ht_bin[1])) return (void *)ht_bin[1];
   }
   if(ht_bin[2]==vaddr) {
-    if(((ht_bin[3]-MAX_OUTPUT_BLOCK_SIZE-(u32)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2)))
+    if((((u32)ht_bin[3]-MAX_OUTPUT_BLOCK_SIZE-(u32)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2)))
       if(isclean(ht_bin[3])) return (void *)ht_bin[3];
   }
   page=(vaddr&0xDFFFFFFF)>>12;
@@ -769,21 +769,21 @@ void *check_addr(u32 vaddr)
       if((((u32)head->addr-(u32)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2))) {
         // Update existing entry with current address
         if(ht_bin[0]==vaddr) {
-          ht_bin[1]=(int)head->addr;
+          ht_bin[1]=(pointer)head->addr;
           return head->addr;
         }
         if(ht_bin[2]==vaddr) {
-          ht_bin[3]=(int)head->addr;
+          ht_bin[3]=(pointer)head->addr;
           return head->addr;
         }
         // Insert into hash table with low priority.
         // Don't evict existing entries, as they are probably
         // addresses that are being accessed frequently.
         if(ht_bin[0]==-1) {
-          ht_bin[1]=(int)head->addr;
+          ht_bin[1]=(pointer)head->addr;
           ht_bin[0]=vaddr;
         }else if(ht_bin[2]==-1) {
-          ht_bin[3]=(int)head->addr;
+          ht_bin[3]=(pointer)head->addr;
           ht_bin[2]=vaddr;
         }
         return head->addr;
@@ -797,7 +797,7 @@ void *check_addr(u32 vaddr)
 void remove_hash(int vaddr)
 {
   //printf("remove hash: %x\n",vaddr);
-  int *ht_bin=hash_table[(((vaddr)>>16)^vaddr)&0xFFFF];
+  pointer *ht_bin=hash_table[(((vaddr)>>16)^vaddr)&0xFFFF];
   if(ht_bin[2]==vaddr) {
     ht_bin[2]=ht_bin[3]=-1;
   }
@@ -808,12 +808,12 @@ void remove_hash(int vaddr)
   }
 }
 
-void ll_remove_matching_addrs(struct ll_entry **head,int addr,int shift)
+void ll_remove_matching_addrs(struct ll_entry **head,pointer addr,int shift)
 {
   struct ll_entry *next;
   while(*head) {
-    if(((u32)((*head)->addr)>>shift)==(addr>>shift) || 
-       ((u32)(((char *)(*head)->addr)-MAX_OUTPUT_BLOCK_SIZE)>>shift)==(addr>>shift))
+    if((((pointer)(*head)->addr-BASE_ADDR)>>shift)==((addr-BASE_ADDR)>>shift) || 
+       (((pointer)(*head)->addr-MAX_OUTPUT_BLOCK_SIZE-BASE_ADDR)>>shift)==((addr-BASE_ADDR)>>shift))
     {
       inv_debug("EXP: Remove pointer to %x (%x)\n",(int)(*head)->addr,(*head)->vaddr);
       remove_hash((*head)->vaddr);
@@ -844,19 +844,19 @@ void ll_clear(struct ll_entry **head)
 }
 
 // Dereference the pointers and remove if it matches
-void ll_kill_pointers(struct ll_entry *head,int addr,int shift)
+void ll_kill_pointers(struct ll_entry *head,pointer addr,int shift)
 {
   while(head) {
-    int ptr=get_pointer(head->addr);
+    pointer ptr=get_pointer(head->addr);
     inv_debug("EXP: Lookup pointer to %x at %x (%x)\n",(int)ptr,(int)head->addr,head->vaddr);
-    if(((ptr>>shift)==(addr>>shift)) ||
-       (((ptr-MAX_OUTPUT_BLOCK_SIZE)>>shift)==(addr>>shift)))
+    if((((ptr-BASE_ADDR)>>shift)==((addr-BASE_ADDR)>>shift)) ||
+       (((ptr-MAX_OUTPUT_BLOCK_SIZE-BASE_ADDR)>>shift)==((addr-BASE_ADDR)>>shift)))
     {
-      u32 host_addr;
+      pointer host_addr;
       inv_debug("EXP: Kill pointer at %x (%x)\n",(int)head->addr,head->vaddr);
-      host_addr=(u32)kill_pointer(head->addr);
+      host_addr=(pointer)kill_pointer(head->addr);
       #ifdef __arm__
-        needs_clear_cache[(host_addr-(u32)BASE_ADDR)>>17]|=1<<(((host_addr-(u32)BASE_ADDR)>>12)&31);
+        needs_clear_cache[(host_addr-BASE_ADDR)>>17]|=1<<(((host_addr-BASE_ADDR)>>12)&31);
       #endif
     }
     head=head->next;
@@ -880,11 +880,11 @@ void invalidate_page(u32 page)
   head=jump_out[page];
   jump_out[page]=0;
   while(head!=NULL) {
-    u32 host_addr;
+    pointer host_addr;
     inv_debug("INVALIDATE: kill pointer to %x (%x)\n",head->vaddr,(int)head->addr);
-    host_addr=(u32)kill_pointer(head->addr);
+    host_addr=(pointer)kill_pointer(head->addr);
     #ifdef __arm__
-      needs_clear_cache[(host_addr-(u32)BASE_ADDR)>>17]|=1<<(((host_addr-(u32)BASE_ADDR)>>12)&31);
+      needs_clear_cache[(host_addr-BASE_ADDR)>>17]|=1<<(((host_addr-BASE_ADDR)>>12)&31);
     #endif
     next=head->next;
     free(head);
@@ -909,21 +909,21 @@ void invalidate_blocks(u32 firstblock,u32 lastblock)
     head=jump_dirty[page];
     //printf("page=%d vpage=%d\n",page,vpage);
     while(head!=NULL) {
-      u32 start,end;
+      pointer start,end;
       if((head->vaddr>>12)==block) { // Ignore vaddr hash collision
         get_bounds((pointer)head->addr,&start,&end);
         //printf("start: %x end: %x\n",start,end);
-        if(start>=(u32)LowWram&&end<(u32)LowWram+1048576) {
-          if(((start-(u32)LowWram)>>12)<=page&&((end-1-(u32)LowWram)>>12)>=page) {
-            if((((start-(u32)LowWram)>>12)+512)<first) first=((start-(u32)LowWram)>>12)&1023;
-            if((((end-1-(u32)LowWram)>>12)+512)>last) last=((end-1-(u32)LowWram)>>12)&1023;
+        if(start>=(pointer)LowWram&&end<(pointer)LowWram+1048576) {
+          if(((start-(pointer)LowWram)>>12)<=page&&((end-1-(pointer)LowWram)>>12)>=page) {
+            if((((start-(pointer)LowWram)>>12)+512)<first) first=((start-(pointer)LowWram)>>12)&1023;
+            if((((end-1-(pointer)LowWram)>>12)+512)>last) last=((end-1-(pointer)LowWram)>>12)&1023;
           }
         }
         // FIXME: Aliasing/mirroring is wrong here
-        if(start>=(u32)HighWram&&end<(u32)HighWram+1048576) {
-          if(((start-(u32)HighWram)>>12)<=page-1024&&((end-1-(u32)HighWram)>>12)>=page-1024) {
-            if((((start-(u32)HighWram)>>12)&255)<first-1024) first=(((start-(u32)HighWram)>>12)&255)+1024;
-            if((((end-1-(u32)HighWram)>>12)&255)>last-1024) last=(((end-1-(u32)HighWram)>>12)&255)+1024;
+        if(start>=(pointer)HighWram&&end<(pointer)HighWram+1048576) {
+          if(((start-(pointer)HighWram)>>12)<=page-1024&&((end-1-(pointer)HighWram)>>12)>=page-1024) {
+            if((((start-(pointer)HighWram)>>12)&255)<first-1024) first=(((start-(pointer)HighWram)>>12)&255)+1024;
+            if((((end-1-(pointer)HighWram)>>12)&255)>last-1024) last=(((end-1-(pointer)HighWram)>>12)&255)+1024;
           }
         }
       }
@@ -1047,24 +1047,25 @@ void clean_blocks(u32 page)
     if((cached_code[head->vaddr>>15]>>((head->vaddr>>12)&7))&1) {;
       // Don't restore blocks which are about to expire from the cache
       if((((u32)head->addr-(u32)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2))) {
-        u32 start,end,vstart=0,vend;
-        if(verify_dirty((int)head->addr)) {
+        pointer start,end;
+        u32 vstart=0,vend;
+        if(verify_dirty((pointer)head->addr)) {
           //printf("Possibly Restore %x (%x)\n",head->vaddr, (int)head->addr);
           u32 i;
           u32 inv=0;
           get_bounds((pointer)head->addr,&start,&end);
-          if(start-(u32)HighWram<0x100000) {
-            vstart=start-(u32)HighWram+0x6000000;
-            vend=end-(u32)HighWram+0x6000000;
-            for(i=(start-(u32)HighWram+0x6000000)>>12;i<=(end-1-(u32)HighWram+0x6000000)>>12;i++) {
+          if(start-(pointer)HighWram<0x100000) {
+            vstart=start-(pointer)HighWram+0x6000000;
+            vend=end-(pointer)HighWram+0x6000000;
+            for(i=vstart>>12;i<=(vend-1)>>12;i++) {
               // Check that all the pages are write-protected
               if(!((cached_code[i>>3]>>(i&7))&1)) inv=1;
             }
           }
-          if(start-(u32)LowWram<0x100000) {
-            vstart=start-(u32)LowWram+0x200000;
-            vend=end-(u32)LowWram+0x200000;
-            for(i=(start-(u32)LowWram+0x200000)>>12;i<=(end-1-(u32)LowWram+0x200000)>>12;i++) {
+          if(start-(pointer)LowWram<0x100000) {
+            vstart=start-(pointer)LowWram+0x200000;
+            vend=end-(pointer)LowWram+0x200000;
+            for(i=vstart>>12;i<=(vend-1)>>12;i++) {
               // Check that all the pages are write-protected
               if(!((cached_code[i>>3]>>(i&7))&1)) inv=1;
             }
@@ -1077,19 +1078,19 @@ void clean_blocks(u32 page)
             }
           }
           if(!inv) {
-            void * clean_addr=(void *)get_clean_addr((int)head->addr);
+            void * clean_addr=(void *)get_clean_addr((pointer)head->addr);
             if((((u32)clean_addr-(u32)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2))) {
-              int *ht_bin;
+              pointer *ht_bin;
               inv_debug("INV: Restored %x (%x/%x)\n",head->vaddr, (int)head->addr, (int)clean_addr);
               //printf("page=%x, addr=%x\n",page,head->vaddr);
               //assert(head->vaddr>>12==(page|0x80000));
               ll_add_nodup(jump_in+page,head->vaddr,clean_addr);
               ht_bin=hash_table[((head->vaddr>>16)^head->vaddr)&0xFFFF];
               if(ht_bin[0]==head->vaddr) {
-                ht_bin[1]=(int)clean_addr; // Replace existing entry
+                ht_bin[1]=(pointer)clean_addr; // Replace existing entry
               }
               if(ht_bin[2]==head->vaddr) {
-                ht_bin[3]=(int)clean_addr; // Replace existing entry
+                ht_bin[3]=(pointer)clean_addr; // Replace existing entry
               }
             }
             if(vstart) {
@@ -1329,7 +1330,8 @@ void alu_alloc(struct regstat *current,int i)
     }
   }
   if(opcode[i]==6) { // NOT/NEG/NEGC
-    if(needed_again(rs1[i],i)) alloc_reg(current,i,rs1[i]);
+    // NEGC needs the source for the carry even when the result is unused
+    if(needed_again(rs1[i],i)||opcode2[i]==10) alloc_reg(current,i,rs1[i]);
     alloc_reg(current,i,rt1[i]);
     if(opcode2[i]==8||opcode2[i]==9) { // SWAP needs temp (?)
       alloc_reg_temp(current,i,-1);
@@ -1360,6 +1362,7 @@ void imm8_alloc(struct regstat *current,int i)
     else clear_const(current,rt1[i]);
   }
   else if(opcode[i]==0x8) { // CMP/EQ
+    clear_const(current,rs1[i]); // Compares the register, not the constant
     alloc_reg(current,i,SR); // Liveness analysis on TBIT?
     dirty_reg(current,SR);
     alloc_reg_temp(current,i,-1);
@@ -1367,6 +1370,7 @@ void imm8_alloc(struct regstat *current,int i)
   }
   else if(opcode[i]==12) {
     if(opcode2[i]==8) { // TST
+      clear_const(current,rs1[i]);
       alloc_reg(current,i,SR); // Liveness analysis on TBIT?
       dirty_reg(current,SR);
       alloc_reg_temp(current,i,-1);
@@ -1445,8 +1449,9 @@ void load_alloc(struct regstat *current,int i)
 
   // Need a register to load from memory_map
   alloc_reg(current,i,MOREG);
-  if(rt1[i]==TBIT||get_reg(current->regmap,rt1[i])<0) {
+  if(rt1[i]==TBIT||get_reg(current->regmap,rt1[i])<0||((current->u>>rt1[i])&1)) {
     // dummy load, but we still need a register to calculate the address
+    // (an unneeded target may still be mapped here, but is culled later)
     alloc_reg_temp(current,i,-1);
     minimum_free_regs[i]=1;
   }
@@ -1619,7 +1624,8 @@ void multdiv_alloc(struct regstat *current,int i)
       alloc_x86_reg(current,i,MACH,EDX); // Don't need to alloc MACH if it's unneeded
       current->u&=~(1LL<<MACL); // But if it is, then assume MACL is needed since it will be overwritten
     }
-    alloc_x86_reg(current,i,MACL,EAX);
+    // Don't evict a dirty register from EAX if the result is discarded
+    if(!(current->u&(1LL<<MACL))) alloc_x86_reg(current,i,MACL,EAX);
     #else
     if(!(current->u&(1LL<<MACH))) {
       alloc_reg(current,i,MACH);
@@ -1789,7 +1795,7 @@ void delayslot_alloc(struct regstat *current,int i)
   }
 }
 
-void add_stub(int type,int addr,int retaddr,int a,int b,int c,int d,int e)
+void add_stub(int type,pointer addr,pointer retaddr,int a,int b,pointer c,int d,int e)
 {
   stubs[stubcount][0]=type;
   stubs[stubcount][1]=addr;
@@ -1954,12 +1960,10 @@ void alu_assemble(int i,struct regstat *i_regs)
         //assert(s2==t);
         if(opcode2[i]==8) emit_sub(t,s,t);
         if(opcode2[i]==10) emit_subc(s,t,sr);
-        //if(opcode2[i]==11) emit_subv(s,sr,temp);
-        assert(opcode2[i]!=11);
+        if(opcode2[i]==11) emit_subv(s,t,sr,temp);
         if(opcode2[i]==12) emit_add(s,t,t);
         if(opcode2[i]==14) emit_addc(s,t,sr);
-        //if(opcode2[i]==15) emit_addv(s,sr,temp);
-        assert(opcode2[i]!=15);
+        if(opcode2[i]==15) emit_addv(s,t,sr,temp);
       }
     }
   }
@@ -1985,7 +1989,7 @@ void alu_assemble(int i,struct regstat *i_regs)
   if(opcode[i]==6) { // NOT/SWAP/NEG
     int s=get_reg(i_regs->regmap,rs1[i]);
     int t=get_reg(i_regs->regmap,rt1[i]);
-    if(s<0) {
+    if(s<0&&t>=0) {
       // FIXME: Preload?
       emit_loadreg(rs1[i],t);
       s=t;
@@ -2189,7 +2193,7 @@ void load_assemble(int i,struct regstat *i_regs)
   int dummy;
   int s,o,t,addr,map=-1,cache=-1;
   int offset;
-  int jaddr=0;
+  pointer jaddr=0;
   int memtarget=0,c=0;
   int dualindex=(addrmode[i]==DUALIND||addrmode[i]==GBRIND);
   int size=(opcode[i]==4)?2:(opcode2[i]&3);
@@ -2290,7 +2294,7 @@ void load_assemble(int i,struct regstat *i_regs)
         }
       }
       if(jaddr)
-        add_stub(LOADB_STUB,jaddr,(int)out,i,addr,(int)i_regs,ccadj[i],reglist);
+        add_stub(LOADB_STUB,jaddr,(pointer)out,i,addr,(pointer)i_regs,ccadj[i],reglist);
     }
     else
       inline_readstub(LOADB_STUB,i,constaddr,i_regs->regmap,rt1[i],ccadj[i],reglist);
@@ -2315,7 +2319,7 @@ void load_assemble(int i,struct regstat *i_regs)
         }
       }
       if(jaddr)
-        add_stub(LOADW_STUB,jaddr,(int)out,i,addr,(int)i_regs,ccadj[i],reglist);
+        add_stub(LOADW_STUB,jaddr,(pointer)out,i,addr,(pointer)i_regs,ccadj[i],reglist);
     }
     else
       inline_readstub(LOADW_STUB,i,constaddr,i_regs->regmap,rt1[i],ccadj[i],reglist);
@@ -2332,7 +2336,7 @@ void load_assemble(int i,struct regstat *i_regs)
         emit_rorimm(t,16,t);
       }
       if(jaddr)
-        add_stub(LOADL_STUB,jaddr,(int)out,i,addr,(int)i_regs,ccadj[i],reglist);
+        add_stub(LOADL_STUB,jaddr,(pointer)out,i,addr,(pointer)i_regs,ccadj[i],reglist);
     }
     else
       inline_readstub(LOADL_STUB,i,constaddr,i_regs->regmap,rt1[i],ccadj[i],reglist);
@@ -2379,7 +2383,8 @@ void store_assemble(int i,struct regstat *i_regs)
   int s,t,o,map=-1,cache=-1;
   int addr,temp;
   int offset;
-  int jaddr=0,jaddr2,type;
+  pointer jaddr=0,jaddr2;
+  int type;
   int memtarget=0,c=0,constaddr=0;
   int dualindex=(addrmode[i]==DUALIND);
   int size=(opcode[i]==4)?2:(opcode2[i]&3);
@@ -2482,7 +2487,7 @@ void store_assemble(int i,struct regstat *i_regs)
     type=STOREL_STUB;
   }
   if(jaddr) {
-    add_stub(type,jaddr,(int)out,i,addr,(int)i_regs,ccadj[i],reglist);
+    add_stub(type,jaddr,(pointer)out,i,addr,(pointer)i_regs,ccadj[i],reglist);
   } else if(c&&!memtarget) {
     inline_writestub(type,i,constaddr,i_regs->regmap,rs1[i],ccadj[i],reglist);
   }
@@ -2524,7 +2529,7 @@ void store_assemble(int i,struct regstat *i_regs)
 void rmw_assemble(int i,struct regstat *i_regs)
 {
   int s,o,t,addr,map=-1,cache=-1;
-  int jaddr=0;
+  pointer jaddr=0;
   int type;
   int memtarget,c=0,constaddr=0;
   int dualindex=(addrmode[i]==GBRIND);
@@ -2583,14 +2588,14 @@ void rmw_assemble(int i,struct regstat *i_regs)
     if(opcode2[i]==15) emit_rmw_orimm(addr,map,imm[i]); // OR.B
   }
   if(jaddr)
-    add_stub(type,jaddr,(int)out,i,addr,(int)i_regs,ccadj[i],reglist);
+    add_stub(type,jaddr,(pointer)out,i,addr,(pointer)i_regs,ccadj[i],reglist);
 }
 
 void pcrel_assemble(int i,struct regstat *i_regs)
 {
   int t,addr,map=-1,cache=-1;
   int offset;
-  int jaddr=0;
+  pointer jaddr=0;
   int memtarget,c=0,constaddr;
   unsigned int hr;
   u32 reglist=0;
@@ -2602,7 +2607,7 @@ void pcrel_assemble(int i,struct regstat *i_regs)
   if(i_regs->regmap[HOST_CCREG]==CCREG) reglist&=~(1<<HOST_CCREG);
   if(t>=0) {
     if(!((i_regs->isdoingcp>>t)&1)) {
-      int jaddr=0;
+      pointer jaddr=0;
       // This is to handle the exceptional case where we can not do constant propagation
       assert(opcode[i]!=12); // MOVA should always be able to do constant propagation
       constaddr=((start+i*2+4)&~3)+imm[i];
@@ -2805,6 +2810,14 @@ void flags_assemble(int i,struct regstat *i_regs)
 void complex_assemble(int i,struct regstat *i_regs)
 {
   if(opcode[i]==3&&opcode2[i]==4) { // DIV1
+    // If both registers are the same, only the dividend was allocated.
+    #if defined(__i386__) || defined(__x86_64__)
+    if(rs1[i]==rs2[i]) emit_mov(EAX,ECX);
+    #else
+    #if defined(__arm__)
+    if(rs1[i]==rs2[i]) emit_mov(0,1);
+    #endif
+    #endif
     emit_call((pointer)div1);
   }
   if(opcode[i]==0&&opcode2[i]==15) { // MAC.L
@@ -2986,6 +2999,8 @@ void load_regs(signed char entry[],signed char regmap[],int rs1,int rs2,int rs3)
       if(entry[hr]!=regmap[hr]) {
         if(regmap[hr]==rs1||regmap[hr]==rs2||regmap[hr]==rs3)
         {
+          // Already moved here by wb_invalidate, and possibly dirty
+          if(regmap[hr]<TEMPREG&&get_reg(entry,regmap[hr])>=0) continue;
           emit_loadreg(regmap[hr],hr);
         }
       }
@@ -3555,15 +3570,15 @@ void ds_assemble_entry(int i)
   else
     assem_debug("branch: external\n");
   assert(internal_branch(ba[i]+2));
-  add_to_linker((int)out,ba[i]+2,internal_branch(ba[i]+2));
+  add_to_linker((pointer)out,ba[i]+2,internal_branch(ba[i]+2));
   emit_jmp(0);
 }
 
 void do_cc(int i,signed char i_regmap[],int *adj,int addr,int taken,int invert)
 {
   int count;
-  int jaddr;
-  int idle=0;
+  pointer jaddr;
+  pointer idle=0;
   if(itype[i]==RJUMP)
   {
     *adj=0;
@@ -3586,24 +3601,24 @@ void do_cc(int i,signed char i_regmap[],int *adj,int addr,int taken,int invert)
     // Idle loop
     // FIXME
     //if(count&1) emit_addimm_and_set_flags(2*(count+2),HOST_CCREG);
-    idle=(int)out;
+    idle=(pointer)out;
     //emit_subfrommem(&idlecount,HOST_CCREG); // Count idle cycles
     emit_andimm(HOST_CCREG,3,HOST_CCREG);
-    jaddr=(int)out;
+    jaddr=(pointer)out;
     emit_jmp(0);
   }
   else if(*adj==0||invert) {
     emit_addimm_and_set_flags(CLOCK_DIVIDER*count,HOST_CCREG);
-    jaddr=(int)out;
+    jaddr=(pointer)out;
     emit_jns(0);
   }
   else
   {
     emit_cmpimm(HOST_CCREG,-CLOCK_DIVIDER*count);
-    jaddr=(int)out;
+    jaddr=(pointer)out;
     emit_jns(0);
   }
-  add_stub(CC_STUB,jaddr,idle?idle:(int)out,(*adj==0||invert||idle)?0:count,i,addr,taken,0);
+  add_stub(CC_STUB,jaddr,idle?idle:(pointer)out,(*adj==0||invert||idle)?0:count,i,addr,taken,0);
 }
 
 void do_ccstub(int n)
@@ -3634,7 +3649,7 @@ void do_ccstub(int n)
   {
     // Save PC as return address
     emit_movimm(stubs[n][5],0);
-    emit_writeword(0,slave?(int)&slave_pc:(int)&master_pc);
+    emit_writeword(0,slave?(pointer)&slave_pc:(pointer)&master_pc);
   }
   else
   {
@@ -3651,7 +3666,7 @@ void do_ccstub(int n)
       else if(opcode[i]==0&&opcode2[i]==11&&opcode3[i]==2) {  // RTE
         r=get_reg(branch_regs[i].regmap,RTEMP);
       }
-      emit_writeword(r,slave?(int)&slave_pc:(int)&master_pc);
+      emit_writeword(r,slave?(pointer)&slave_pc:(pointer)&master_pc);
     }
     else {printf("Unknown branch type in do_ccstub\n");exit(1);}
   }
@@ -3672,7 +3687,7 @@ void do_ccstub(int n)
       load_needed_regs(branch_regs[i].regmap,regs[(ba[i]-start)>>1].regmap_entry);
     else if(itype[i]==RJUMP) {
       if(get_reg(branch_regs[i].regmap,RTEMP)>=0)
-        emit_readword(slave?(int)&slave_pc:(int)&master_pc,get_reg(branch_regs[i].regmap,RTEMP));
+        emit_readword(slave?(pointer)&slave_pc:(pointer)&master_pc,get_reg(branch_regs[i].regmap,RTEMP));
       else
         emit_loadreg(rs1[i],get_reg(branch_regs[i].regmap,rs1[i]));
     }
@@ -3709,7 +3724,7 @@ void do_ccstub(int n)
   emit_jmp(stubs[n][2]); // return address
 }
 
-void add_to_linker(int addr,int target,int ext)
+void add_to_linker(pointer addr,int target,int ext)
 {
   link_addr[linkcount][0]=addr;
   link_addr[linkcount][1]=target|slave;
@@ -3816,7 +3831,7 @@ void ujump_assemble(int i,struct regstat *i_regs)
     ds_assemble_entry(i);
   }
   else {
-    add_to_linker((int)out,ba[i],internal_branch(ba[i]));
+    add_to_linker((pointer)out,ba[i],internal_branch(ba[i]));
     emit_jmp(0);
   }
 }
@@ -3929,7 +3944,7 @@ void rjump_assemble(int i,struct regstat *i_regs)
     int cache=get_reg(branch_regs[i].regmap,MMREG);
     int sp=get_reg(branch_regs[i].regmap,15);
     int sr=get_reg(branch_regs[i].regmap,SR);
-    int jaddr=0;
+    pointer jaddr=0;
     unsigned int hr;
     u32 reglist=0;
     temp=get_reg(branch_regs[i].regmap,RTEMP);
@@ -3953,10 +3968,10 @@ void rjump_assemble(int i,struct regstat *i_regs)
     emit_addimm(sp,4,sp);
     emit_rorimm(sr,16,sr);
     assert(jaddr);
-    add_stub(LOADS_STUB,jaddr,(int)out,i,sp,(int)(&branch_regs[i]),ccadj[i],reglist);
+    add_stub(LOADS_STUB,jaddr,(pointer)out,i,sp,(pointer)(&branch_regs[i]),ccadj[i],reglist);
     store_regs_bt(branch_regs[i].regmap,branch_regs[i].dirty,-1);
     emit_addimm_and_set_flags(CLOCK_DIVIDER*(ccadj[i]+cycles[i]+cycles[i+1]),HOST_CCREG);
-    add_stub(CC_STUB,(int)out,jump_vaddr_reg[slave][temp],0,i,-1,TAKEN,0);
+    add_stub(CC_STUB,(pointer)out,jump_vaddr_reg[slave][temp],0,i,-1,TAKEN,0);
     emit_jns(0);
     emit_jmp(jump_vaddr_reg[slave][temp]);
   }
@@ -3989,14 +4004,14 @@ void rjump_assemble(int i,struct regstat *i_regs)
           ds_assemble_entry(i);
         }
         else {
-          add_to_linker((int)out,constaddr,1/*internal_branch*/);
+          add_to_linker((pointer)out,constaddr,1/*internal_branch*/);
           emit_jmp(0);
         }
       }
       else
       {
         assem_debug("branch: external (constant address)\n");
-        add_to_linker((int)out,constaddr,0/*internal_branch*/);
+        add_to_linker((pointer)out,constaddr,0/*internal_branch*/);
         emit_jmp(0);
       }
     }
@@ -4028,7 +4043,7 @@ void rjump_assemble(int i,struct regstat *i_regs)
       //if(adj) emit_addimm(cc,2*(ccadj[i]+2-adj),cc); // ??? - Shouldn't happen
       //assert(adj==0);
       emit_addimm_and_set_flags(CLOCK_DIVIDER*(ccadj[i]+cycles[i]+cycles[i+1]),HOST_CCREG);
-      add_stub(CC_STUB,(int)out,jump_vaddr_reg[slave][rs],0,i,-1,TAKEN,0);
+      add_stub(CC_STUB,(pointer)out,jump_vaddr_reg[slave][rs],0,i,-1,TAKEN,0);
       emit_jns(0);
       //load_regs_bt(branch_regs[i].regmap,branch_regs[i].dirty,-1);
       #ifdef USE_MINI_HT
@@ -4085,7 +4100,7 @@ void cjump_assemble(int i,struct regstat *i_regs)
         ds_assemble_entry(i);
       }
       else {
-        add_to_linker((int)out,ba[i],internal);
+        add_to_linker((pointer)out,ba[i],internal);
         emit_jmp(0);
       }
       #ifdef CORTEX_A8_BRANCH_PREDICTION_HACK
@@ -4094,11 +4109,11 @@ void cjump_assemble(int i,struct regstat *i_regs)
     }
   }
   else if(nop) {
-    int jaddr;
+    pointer jaddr;
     emit_addimm_and_set_flags(CLOCK_DIVIDER*(ccadj[i]+2),cc);
-    jaddr=(int)out;
+    jaddr=(pointer)out;
     emit_jns(0);
-    add_stub(CC_STUB,jaddr,(int)out,0,i,start+i*2+4,NOTTAKEN,0);
+    add_stub(CC_STUB,jaddr,(pointer)out,0,i,start+i*2+4,NOTTAKEN,0);
   }
   else {
     pointer taken=0,nottaken=0,nottaken1=0;
@@ -4113,7 +4128,7 @@ void cjump_assemble(int i,struct regstat *i_regs)
         nottaken=(pointer)out;
         emit_jeq(1);
       }else{
-        add_to_linker((int)out,ba[i],internal);
+        add_to_linker((pointer)out,ba[i],internal);
         emit_jne(0);
       }
     }
@@ -4123,7 +4138,7 @@ void cjump_assemble(int i,struct regstat *i_regs)
         nottaken=(pointer)out;
         emit_jne(1);
       }else{
-        add_to_linker((int)out,ba[i],internal);
+        add_to_linker((pointer)out,ba[i],internal);
         emit_jeq(0);
       }
     }
@@ -4133,10 +4148,10 @@ void cjump_assemble(int i,struct regstat *i_regs)
       if(match&&(!internal||!is_ds[(ba[i]-start)>>1])) {
         if(adj) {
           emit_addimm(cc,-CLOCK_DIVIDER*adj,cc);
-          add_to_linker((int)out,ba[i],internal);
+          add_to_linker((pointer)out,ba[i],internal);
         }else{
           emit_addnop(13);
-          add_to_linker((int)out,ba[i],internal*2);
+          add_to_linker((pointer)out,ba[i],internal*2);
         }
         emit_jmp(0);
       }else
@@ -4153,7 +4168,7 @@ void cjump_assemble(int i,struct regstat *i_regs)
           ds_assemble_entry(i);
         }
         else {
-          add_to_linker((int)out,ba[i],internal);
+          add_to_linker((pointer)out,ba[i],internal);
           emit_jmp(0);
         }
       }
@@ -4223,7 +4238,7 @@ void sjump_assemble(int i,struct regstat *i_regs)
           ds_assemble_entry(i);
         }
         else {
-          add_to_linker((int)out,ba[i],internal);
+          add_to_linker((pointer)out,ba[i],internal);
           emit_jmp(0);
         }
         #ifdef CORTEX_A8_BRANCH_PREDICTION_HACK
@@ -4232,11 +4247,11 @@ void sjump_assemble(int i,struct regstat *i_regs)
       }
     }
     else if(nop) {
-      int jaddr;
+      pointer jaddr;
       emit_addimm_and_set_flags(CLOCK_DIVIDER*(ccadj[i]+2),cc);
-      jaddr=(int)out;
+      jaddr=(pointer)out;
       emit_jns(0);
-      add_stub(CC_STUB,jaddr,(int)out,0,i,start+i*2+4,NOTTAKEN,0);
+      add_stub(CC_STUB,jaddr,(pointer)out,0,i,start+i*2+4,NOTTAKEN,0);
     }
     else {
       pointer taken=0,nottaken=0,nottaken1=0;
@@ -4252,7 +4267,7 @@ void sjump_assemble(int i,struct regstat *i_regs)
           nottaken=(pointer)out;
           emit_jeq(1);
         }else{
-          add_to_linker((int)out,ba[i],internal);
+          add_to_linker((pointer)out,ba[i],internal);
           emit_jne(0);
         }
       }
@@ -4262,7 +4277,7 @@ void sjump_assemble(int i,struct regstat *i_regs)
           nottaken=(pointer)out;
           emit_jne(1);
         }else{
-          add_to_linker((int)out,ba[i],internal);
+          add_to_linker((pointer)out,ba[i],internal);
           emit_jeq(0);
         }
       }
@@ -4272,10 +4287,10 @@ void sjump_assemble(int i,struct regstat *i_regs)
         if(match&&(!internal||!is_ds[(ba[i]-start)>>1])) {
           if(adj) {
             emit_addimm(cc,-CLOCK_DIVIDER*adj,cc);
-            add_to_linker((int)out,ba[i],internal);
+            add_to_linker((pointer)out,ba[i],internal);
           }else{
             emit_addnop(13);
-            add_to_linker((int)out,ba[i],internal*2);
+            add_to_linker((pointer)out,ba[i],internal*2);
           }
           emit_jmp(0);
         }else
@@ -4292,7 +4307,7 @@ void sjump_assemble(int i,struct regstat *i_regs)
             ds_assemble_entry(i);
           }
           else {
-            add_to_linker((int)out,ba[i],internal);
+            add_to_linker((pointer)out,ba[i],internal);
             emit_jmp(0);
           }
         }
@@ -4329,7 +4344,7 @@ void sjump_assemble(int i,struct regstat *i_regs)
     ds_unneeded&=~((1LL<<rs1[i+1])|(1LL<<rs2[i+1])|(1LL<<rs3[i+1]));
     // branch taken
     if(!nop) {
-      if(taken) set_jump_target(taken,(int)out);
+      if(taken) set_jump_target(taken,(pointer)out);
       assem_debug("1:\n");
       wb_invalidate(regs[i].regmap,branch_regs[i].regmap,regs[i].dirty,
                     ds_unneeded);
@@ -4363,14 +4378,14 @@ void sjump_assemble(int i,struct regstat *i_regs)
         ds_assemble_entry(i);
       }
       else {
-        add_to_linker((int)out,ba[i],internal);
+        add_to_linker((pointer)out,ba[i],internal);
         emit_jmp(0);
       }
     }
     // branch not taken
     if(!unconditional) {
-      if(nottaken1) set_jump_target(nottaken1,(int)out);
-      set_jump_target(nottaken,(int)out);
+      if(nottaken1) set_jump_target(nottaken1,(pointer)out);
+      set_jump_target(nottaken,(pointer)out);
       assem_debug("2:\n");
       wb_invalidate(regs[i].regmap,branch_regs[i].regmap,regs[i].dirty,
                     ds_unneeded);
@@ -4400,7 +4415,7 @@ void system_assemble(int i,struct regstat *i_regs)
     return_address=(pointer)out;
     emit_zeroreg(HOST_CCREG);
     set_jump_target(jaddr,(pointer)out);
-    add_stub(CC_STUB,(int)out,return_address,0,i,start+i*2,TAKEN,0);
+    add_stub(CC_STUB,(pointer)out,return_address,0,i,start+i*2,TAKEN,0);
     emit_jmp(0);
     // DEBUG: Count in multiples of three to match interpreter
     //emit_addimm_and_set_flags(CLOCK_DIVIDER*3,HOST_CCREG);
@@ -4410,7 +4425,7 @@ void system_assemble(int i,struct regstat *i_regs)
   }
   else {
     int b,t,sr,st,map=-1,cache=-1;
-    int jaddr=0;
+    pointer jaddr=0;
     unsigned int hr;
     u32 reglist=0;
     assert(opcode[i]==12); // TRAPA
@@ -4437,7 +4452,7 @@ void system_assemble(int i,struct regstat *i_regs)
     emit_writeword_indexed_map(sr,0,st,map,map);
     emit_rorimm(sr,16,sr);
     if(jaddr) {
-      add_stub(STOREL_STUB,jaddr,(int)out,i,st,(int)i_regs,ccadj[i],reglist);
+      add_stub(STOREL_STUB,jaddr,(pointer)out,i,st,(pointer)i_regs,ccadj[i],reglist);
     }
     emit_addimm(st,-4,st);
     store_regs_bt(i_regs->regmap,i_regs->dirty,-1);
@@ -4449,7 +4464,7 @@ void system_assemble(int i,struct regstat *i_regs)
     emit_rorimm(sr,16,sr);
     emit_writeword_indexed_map(sr,0,st,map,map);
     if(jaddr) {
-      add_stub(STOREL_STUB,jaddr,(int)out,i,st,(int)i_regs,ccadj[i],reglist);
+      add_stub(STOREL_STUB,jaddr,(pointer)out,i,st,(pointer)i_regs,ccadj[i],reglist);
     }
     // Load PC
     map=do_map_r(b,b,map,cache,0,-1,-1,0,0);
@@ -4457,7 +4472,7 @@ void system_assemble(int i,struct regstat *i_regs)
     emit_readword_indexed_map(0,b,map,t);
     emit_rorimm(t,16,t);
     if(jaddr)
-      add_stub(LOADL_STUB,jaddr,(int)out,i,t,(int)i_regs,ccadj[i],reglist);
+      add_stub(LOADL_STUB,jaddr,(pointer)out,i,t,(pointer)i_regs,ccadj[i],reglist);
     if(i_regs->regmap[HOST_CCREG]!=CCREG) {
       emit_loadreg(CCREG,HOST_CCREG);
     }
@@ -4512,6 +4527,8 @@ void unneeded_registers(int istart,int iend,int r)
           if(rs1[i+1]>=0) u&=~(1LL<<rs1[i+1]);
           if(rs2[i+1]>=0) u&=~(1LL<<rs2[i+1]);
           if(rs3[i+1]>=0) u&=~(1LL<<rs3[i+1]);
+          if(itype[i+1]==COMPLEX&&opcode2[i+1]==15) u&=~((1LL<<MACH)|(1LL<<MACL));
+          if((rs1[i+1]==SR||rs2[i+1]==SR||rs3[i+1]==SR)&&rt1[i+1]!=TBIT&&rt2[i+1]!=TBIT) u&=~(1LL<<TBIT);
         }
       }
       else
@@ -4536,12 +4553,15 @@ void unneeded_registers(int istart,int iend,int r)
             if(rs1[i+1]>=0) temp_u&=~(1LL<<rs1[i+1]);
             if(rs2[i+1]>=0) temp_u&=~(1LL<<rs2[i+1]);
             if(rs3[i+1]>=0) temp_u&=~(1LL<<rs3[i+1]);
+            if(itype[i+1]==COMPLEX&&opcode2[i+1]==15) temp_u&=~((1LL<<MACH)|(1LL<<MACL));
+            if((rs1[i+1]==SR||rs2[i+1]==SR||rs3[i+1]==SR)&&rt1[i+1]!=TBIT&&rt2[i+1]!=TBIT) temp_u&=~(1LL<<TBIT);
           }
           if(rt1[i]>=0) temp_u|=1LL<<rt1[i];
           if(rt2[i]>=0) temp_u|=1LL<<rt2[i];
           if(rs1[i]>=0) temp_u&=~(1LL<<rs1[i]);
           if(rs2[i]>=0) temp_u&=~(1LL<<rs2[i]);
           if(rs3[i]>=0) temp_u&=~(1LL<<rs3[i]);
+          if(itype[i]==COMPLEX&&opcode2[i]==15) temp_u&=~((1LL<<MACH)|(1LL<<MACL));
           unneeded_reg[i]=temp_u;
           // Only go three levels deep.  This recursion can take an
           // excessive amount of time if there are a lot of nested loops.
@@ -4566,6 +4586,8 @@ void unneeded_registers(int istart,int iend,int r)
             if(rs1[i+1]>=0) u&=~(1LL<<rs1[i+1]);
             if(rs2[i+1]>=0) u&=~(1LL<<rs2[i+1]);
             if(rs3[i+1]>=0) u&=~(1LL<<rs3[i+1]);
+            if(itype[i+1]==COMPLEX&&opcode2[i+1]==15) u&=~((1LL<<MACH)|(1LL<<MACL));
+            if((rs1[i+1]==SR||rs2[i+1]==SR||rs3[i+1]==SR)&&rt1[i+1]!=TBIT&&rt2[i+1]!=TBIT) u&=~(1LL<<TBIT);
           } else {
             // Conditional branch
             b=unneeded_reg[(ba[i]-start)>>1];
@@ -4579,6 +4601,8 @@ void unneeded_registers(int istart,int iend,int r)
               if(rs1[i+1]>=0) b&=~(1LL<<rs1[i+1]);
               if(rs2[i+1]>=0) b&=~(1LL<<rs2[i+1]);
               if(rs3[i+1]>=0) b&=~(1LL<<rs3[i+1]);
+              if(itype[i+1]==COMPLEX&&opcode2[i+1]==15) b&=~((1LL<<MACH)|(1LL<<MACL));
+              if((rs1[i+1]==SR||rs2[i+1]==SR||rs3[i+1]==SR)&&rt1[i+1]!=TBIT&&rt2[i+1]!=TBIT) b&=~(1LL<<TBIT);
             }
             u&=b;
             // Always need stack and status in case of interrupt
@@ -4621,6 +4645,10 @@ void unneeded_registers(int istart,int iend,int r)
     if(rs1[i]>=0) u&=~(1LL<<rs1[i]);
     if(rs2[i]>=0) u&=~(1LL<<rs2[i]);
     if(rs3[i]>=0) u&=~(1LL<<rs3[i]);
+    // MAC.L/MAC.W accumulate into MACH:MACL
+    if(itype[i]==COMPLEX&&opcode2[i]==15) u&=~((1LL<<MACH)|(1LL<<MACL));
+    // Reading all of SR (DIV1, STC) also reads the T bit
+    if((rs1[i]==SR||rs2[i]==SR||rs3[i]==SR)&&rt1[i]!=TBIT&&rt2[i]!=TBIT) u&=~(1LL<<TBIT);
     // Source-target dependencies
     //uu&=~(tdep<<dep1[i]);
     //uu&=~(tdep<<dep2[i]);
@@ -5039,6 +5067,18 @@ void clean_registers(int istart,int iend,int wr)
       regs[i].dirty&=wont_dirty_i;
       if(itype[i]==RJUMP||itype[i]==UJUMP||itype[i]==SJUMP)
       {
+        // wb_invalidate moves a dirty register that the delay slot wants
+        // in a different host register instead of writing it back, so it
+        // has to stay dirty in the new one
+        for(r=0;r<HOST_REGS;r++) {
+          if(r!=EXCLUDE_REG&&((regs[i].dirty>>r)&1)) {
+            int nr;
+            if(regs[i].regmap[r]>=0&&(regs[i].regmap[r]&63)<TEMPREG&&
+               branch_regs[i].regmap[r]!=regs[i].regmap[r]&&
+               (nr=get_reg(branch_regs[i].regmap,regs[i].regmap[r]))>=0)
+              branch_regs[i].dirty|=1<<nr;
+          }
+        }
         if(i<iend-1&&itype[i]!=RJUMP&&itype[i]!=UJUMP) {
           for(r=0;r<HOST_REGS;r++) {
             if(r!=EXCLUDE_REG) {
@@ -5236,7 +5276,7 @@ void sh2_dynarec_init()
   int n;
   //printf("Init new dynarec\n");
   out=(u8 *)BASE_ADDR;
-  #ifdef __arm__
+  #if defined(__arm__) || defined(__x86_64__)
   mprotect(out, 1<<TARGET_SIZE_2, PROT_READ | PROT_WRITE | PROT_EXEC);
   #else
   if (mmap (out, 1<<TARGET_SIZE_2,
@@ -5259,10 +5299,6 @@ void sh2_dynarec_init()
   expirep=16384; // Expiry pointer, +2 blocks
   literalcount=0;
   stop_after_jal=0;
-  if (mmap ((void *)0x80000000, 4194304,
-            PROT_READ | PROT_WRITE,
-            MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS,
-            -1, 0) == MAP_FAILED) {printf("mmap() failed\n");}
 
   // This has to be done after BiosRom etc are allocated
   for(n=0;n<1048576;n++) {
@@ -5320,10 +5356,9 @@ void SH2DynarecReset(SH2_struct *context) {
 void sh2_dynarec_cleanup()
 {
   int n;
-  #ifndef __arm__
+  #if !defined(__arm__) && !defined(__x86_64__)
   if (munmap ((void *)BASE_ADDR, 1<<TARGET_SIZE_2) < 0) {printf("munmap() failed\n");}
   #endif
-  munmap ((void *)0x80000000, 4194304);
   for(n=0;n<2048;n++) ll_clear(jump_in+n);
   for(n=0;n<2048;n++) ll_clear(jump_out+n);
   for(n=0;n<2048;n++) ll_clear(jump_dirty+n);
@@ -6231,6 +6266,7 @@ int sh2_recompile_block(int addr)
         if(rs1[i]>=0) current.u&=~(1LL<<rs1[i]);
         if(rs2[i]>=0) current.u&=~(1LL<<rs2[i]);
         if(rs3[i]>=0) current.u&=~(1LL<<rs3[i]);
+        if(itype[i]==COMPLEX&&opcode2[i]==15) current.u&=~((1LL<<MACH)|(1LL<<MACL));
         if(rs1[i]==TBIT||rs2[i]==TBIT) current.u&=~(1LL<<SR);
         if(rt1[i]==TBIT||rt2[i]==TBIT) current.u&=~(1LL<<SR);
       } else {
@@ -6248,6 +6284,7 @@ int sh2_recompile_block(int addr)
         current.u=branch_unneeded_reg[i-1];
       }
       current.u&=~((1LL<<rs1[i])|(1LL<<rs2[i]));
+      if(itype[i]==COMPLEX&&opcode2[i]==15) current.u&=~((1LL<<MACH)|(1LL<<MACL));
       memcpy(&temp,&current,sizeof(current));
       temp.wasdirty=temp.dirty;
       // TODO: Take into account unconditional branches, as below
@@ -6557,7 +6594,7 @@ int sh2_recompile_block(int addr)
           }
           else
           {
-            current.u=branch_unneeded_reg[i-1]&~(1LL<<rs1[i-1]);
+            current.u=branch_unneeded_reg[i-1]&~((1LL<<rs1[i-1])|(1LL<<SR));
             // Alloc the branch condition register
             alloc_reg(&current,i-1,SR);
           }
@@ -6839,7 +6876,7 @@ int sh2_recompile_block(int addr)
              itype[i+1]==RMW || itype[i+1]==PCREL ||
              itype[i+1]==SYSTEM || source[i]==0x002B /* RTE */ )
             temp1=MOREG;
-          if(itype[i+1]==COMPLEX) {
+          if(itype[i+1]==COMPLEX&&opcode2[i+1]==15) { // MAC.L/MAC.W
             temp1=MACH;
             temp2=MACL;
           }
@@ -6861,7 +6898,8 @@ int sh2_recompile_block(int addr)
                branch_regs[i].regmap[hr]!=RHASH && branch_regs[i].regmap[hr]!=RHTBL &&
                branch_regs[i].regmap[hr]!=RTEMP && branch_regs[i].regmap[hr]!=PTEMP &&
                branch_regs[i].regmap[hr]!=CCREG &&
-               branch_regs[i].regmap[hr]!=temp1 && branch_regs[i].regmap[hr]!=temp2)
+               branch_regs[i].regmap[hr]!=temp1 && branch_regs[i].regmap[hr]!=temp2 &&
+               (itype[i]!=SJUMP||branch_regs[i].regmap[hr]!=SR)) // BT/S BF/S test SR after the delay slot
             {
               branch_regs[i].regmap[hr]=-1;
               branch_regs[i].regmap_entry[hr]=-1;
@@ -6889,7 +6927,7 @@ int sh2_recompile_block(int addr)
             if(itype[i]==LOAD || itype[i]==STORE || itype[i]==RMW ||
                itype[i]==PCREL || itype[i]==SYSTEM )
               temp1=MOREG;
-            if(itype[i]==COMPLEX) {
+            if(itype[i]==COMPLEX&&opcode2[i]==15) { // MAC.L/MAC.W
               temp1=MACH;
               temp2=MACL;
             }
@@ -7965,7 +8003,7 @@ int sh2_recompile_block(int addr)
         store_regs_bt(regs[i-2].regmap,regs[i-2].dirty,start+i*2);
         assert(regs[i-2].regmap[HOST_CCREG]==CCREG);
       }
-      add_to_linker((int)out,start+i*2,0);
+      add_to_linker((pointer)out,start+i*2,0);
       emit_jmp(0);
     }
   }
@@ -7976,7 +8014,7 @@ int sh2_recompile_block(int addr)
     if(regs[i-1].regmap[HOST_CCREG]!=CCREG)
       emit_loadreg(CCREG,HOST_CCREG);
     emit_addimm(HOST_CCREG,CLOCK_DIVIDER*(ccadj[i-1]+1),HOST_CCREG);
-    add_to_linker((int)out,start+i*2,0);
+    add_to_linker((pointer)out,start+i*2,0);
     emit_jmp(0);
   }
 
@@ -8007,8 +8045,8 @@ int sh2_recompile_block(int addr)
 
   /* Pass 9 - Linker */
   {
-  int *ht_bin;
-  int entry_point;
+  pointer *ht_bin;
+  pointer entry_point;
   u32 alignedlen;
   u32 alignedstart;
   u32 index;
@@ -8022,10 +8060,10 @@ int sh2_recompile_block(int addr)
       void *addr=check_addr(link_addr[i][1]);
       emit_extjump(link_addr[i][0],link_addr[i][1]);
       if(addr) {
-        set_jump_target(link_addr[i][0],(int)addr);
+        set_jump_target(link_addr[i][0],(pointer)addr);
         add_link(link_addr[i][1],stub);
       }
-      else set_jump_target(link_addr[i][0],(int)stub);
+      else set_jump_target(link_addr[i][0],(pointer)stub);
     }
     else
     {
@@ -8092,7 +8130,7 @@ int sh2_recompile_block(int addr)
   
   // If we're within 256K of the end of the buffer,
   // start over from the beginning. (Is 256K enough?)
-  if((int)out>BASE_ADDR+(1<<TARGET_SIZE_2)-MAX_OUTPUT_BLOCK_SIZE-JUMP_TABLE_SIZE) out=(u8 *)BASE_ADDR;
+  if((pointer)out>BASE_ADDR+(1<<TARGET_SIZE_2)-MAX_OUTPUT_BLOCK_SIZE-JUMP_TABLE_SIZE) out=(u8 *)BASE_ADDR;
   
   // Trap writes to any of the pages we compiled
   for(i=start>>12;i<=(start+slen*2)>>12;i++) {
@@ -8118,11 +8156,11 @@ int sh2_recompile_block(int addr)
   /* Pass 10 - Free memory by expiring oldest blocks */
   
   {
-  int end=((((int)out-BASE_ADDR)>>(TARGET_SIZE_2-16))+16384)&65535;
+  int end=((((pointer)out-BASE_ADDR)>>(TARGET_SIZE_2-16))+16384)&65535;
   while(expirep!=end)
   {
     int shift=TARGET_SIZE_2-3; // Divide into 8 blocks
-    int base=BASE_ADDR+((expirep>>13)<<shift); // Base address of this block
+    pointer base=BASE_ADDR+((expirep>>13)<<shift); // Base address of this block
     inv_debug("EXP: Phase %d\n",expirep);
     switch((expirep>>11)&3)
     {
@@ -8138,14 +8176,14 @@ int sh2_recompile_block(int addr)
       case 2:
         // Clear hash table
         for(i=0;i<32;i++) {
-          int *ht_bin=hash_table[((expirep&2047)<<5)+i];
-          if((ht_bin[3]>>shift)==(base>>shift) ||
-             ((ht_bin[3]-MAX_OUTPUT_BLOCK_SIZE)>>shift)==(base>>shift)) {
+          pointer *ht_bin=hash_table[((expirep&2047)<<5)+i];
+          if(((ht_bin[3]-BASE_ADDR)>>shift)==((base-BASE_ADDR)>>shift) ||
+             ((ht_bin[3]-MAX_OUTPUT_BLOCK_SIZE-BASE_ADDR)>>shift)==((base-BASE_ADDR)>>shift)) {
             inv_debug("EXP: Remove hash %x -> %x\n",ht_bin[2],ht_bin[3]);
             ht_bin[2]=ht_bin[3]=-1;
           }
-          if((ht_bin[1]>>shift)==(base>>shift) ||
-             ((ht_bin[1]-MAX_OUTPUT_BLOCK_SIZE)>>shift)==(base>>shift)) {
+          if(((ht_bin[1]-BASE_ADDR)>>shift)==((base-BASE_ADDR)>>shift) ||
+             ((ht_bin[1]-MAX_OUTPUT_BLOCK_SIZE-BASE_ADDR)>>shift)==((base-BASE_ADDR)>>shift)) {
             inv_debug("EXP: Remove hash %x -> %x\n",ht_bin[0],ht_bin[1]);
             ht_bin[0]=ht_bin[2];
             ht_bin[1]=ht_bin[3];
@@ -0,0 +1,535 @@
+/*  This file is part of Yabause.
+
+    Yabause is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Yabause is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Yabause; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*
+ * Interpreter/dynarec lockstep checker
+ *
+ * Runs the same stream of generated SH2 test programs on the interpreter
+ * and on the dynamic recompiler, each core in its own process since both
+ * keep their state in globals. After every program the master SH2
+ * registers and the scratch RAM it touched are compared and the first
+ * mismatch is reported with a disassembly of the program.
+ *
+ * Not part of the emulator build, link it against the Yabause core sources
+ * built with -DSH2_DYNAREC=1 -DUSE_DYNAREC=1 and the CPU_* define of the
+ * host, e.g.:
+ *
+ *   cc -O2 -DCPU_X64=1 -DUSE_DYNAREC=1 -DSH2_DYNAREC=1 -DHAVE_STDINT_H=1
+ *      -I.. sh2_lockstep.c <core sources> linkage_x64.s -lm -o sh2_lockstep
+ *   ./sh2_lockstep [programs] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../memory.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../sh2d.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../smpc.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../scsp.h"
+#include "../vdp1.h"
+
+#define CODE_ADDR    0x06004000
+#define DATA_ADDR    0x06010000
+#define RESULT_ADDR  0x06020000
+#define DATA_SIZE    0x100
+#define MAX_OPS      512
+#define RESULT_WORDS 19
+#define SENTINEL     0x5A
+#define SH2CORE_DYNAREC 2
+
+extern SH2Interface_struct SH2Dynarec;
+
+SH2Interface_struct *SH2CoreList[] = { &SH2Interpreter, &SH2Dynarec, NULL };
+PerInterface_struct *PERCoreList[] = { &PERDummy, NULL };
+CDInterface *CDCoreList[] = { &DummyCD, NULL };
+SoundInterface_struct *SNDCoreList[] = { &SNDDummy, NULL };
+VideoInterface_struct *VIDCoreList[] = { &VIDDummy, NULL };
+M68K_struct *M68KCoreList[] = { &M68KDummy, NULL };
+
+void YuiSwapBuffers(void) {}
+void YuiErrorMsg(const char *string) { fprintf(stderr, "%s\n", string); }
+void YuiParallelFor(int begin, int end, int grainsize,
+                    void (*func)(void *data, int begin, int end), void *data)
+{
+   func(data, begin, end);
+}
+int OSDUseBuffer(void) { return 0; }
+int OSDChangeCore(int coreid) { return 0; }
+void OSDPushMessage(int msgtype, int ttl, const char *message, ...) {}
+void OSDDisplayMessages(void) {}
+void DisplayMessage(const char *str) {}
+
+typedef struct
+{
+   u16 op[MAX_OPS];
+   int len;
+   u32 regs[16];
+   u32 mach, macl, sr;
+} program_struct;
+
+typedef struct
+{
+   u32 status;
+   u32 result[RESULT_WORDS];
+   u8 data[DATA_SIZE];
+} report_struct;
+
+static u32 rngstate;
+
+static u32 Rand(void)
+{
+   rngstate ^= rngstate << 13;
+   rngstate ^= rngstate >> 17;
+   rngstate ^= rngstate << 5;
+   return rngstate;
+}
+
+// R14 holds the data pointer and R15 the result pointer, neither is written
+// by generated code
+static int RandReg(void)
+{
+   return Rand() % 14;
+}
+
+static u16 GenAluOp(void)
+{
+   static const u16 rr[] =
+   {
+      0x6003, 0x300C, 0x300E, 0x300F, 0x3008, 0x300A, 0x300B, 0x2009,
+      0x200B, 0x200A, 0x2008, 0x3000, 0x3002, 0x3003, 0x3006, 0x3007,
+      0x200C, 0x2007, 0x3004, 0x300D, 0x3005, 0x600E, 0x600F, 0x600C,
+      0x600D, 0x0007, 0x200F, 0x200E, 0x600B, 0x600A, 0x6007, 0x6008,
+      0x6009, 0x200D,
+   };
+   static const u16 rn[] =
+   {
+      0x4011, 0x4015, 0x4010, 0x4004, 0x4005, 0x4024, 0x4025, 0x4020,
+      0x4021, 0x4000, 0x4001, 0x4008, 0x4009, 0x4018, 0x4019, 0x4028,
+      0x4029, 0x0029, 0x000A, 0x001A, 0x400A, 0x401A, 0x0002,
+   };
+   static const u16 r0imm[] = { 0xC900, 0xCB00, 0xCA00, 0xC800, 0x8800 };
+   static const u16 noarg[] = { 0x0019, 0x0008, 0x0018, 0x0028, 0x0009 };
+
+   switch (Rand() % 8)
+   {
+      case 0:
+         return 0xE000 | (RandReg() << 8) | (Rand() & 0xFF);
+      case 1:
+         return 0x7000 | (RandReg() << 8) | (Rand() & 0xFF);
+      case 2:
+         return r0imm[Rand() % (sizeof(r0imm) / sizeof(r0imm[0]))] | (Rand() & 0xFF);
+      case 3:
+         return noarg[Rand() % (sizeof(noarg) / sizeof(noarg[0]))];
+      case 4:
+      case 5:
+         return rn[Rand() % (sizeof(rn) / sizeof(rn[0]))] | (RandReg() << 8);
+      default:
+      {
+         u16 op = rr[Rand() % (sizeof(rr) / sizeof(rr[0]))];
+         int n = RandReg(), m = RandReg();
+         // DIV1 Rn,Rn is left out, the interpreter divides by the shifted
+         // dividend while the dynarec uses the original register value
+         if (op == 0x3004 && n == m)
+            n = (m + 1) % 14;
+         return op | (n << 8) | (m << 4);
+      }
+   }
+}
+
+static u16 GenMemOp(void)
+{
+   switch (Rand() % 8)
+   {
+      case 0:
+         return 0x1E00 | (RandReg() << 4) | (Rand() & 0xF);        // mov.l Rm,@(disp,R14)
+      case 1:
+         return 0x50E0 | (RandReg() << 8) | (Rand() & 0xF);        // mov.l @(disp,R14),Rn
+      case 2:
+         return 0x80E0 | (Rand() & 0x100) | (Rand() & 0xF);        // mov.b/w R0,@(disp,R14)
+      case 3:
+         return 0x84E0 | (Rand() & 0x100) | (Rand() & 0xF);        // mov.b/w @(disp,R14),R0
+      case 4:
+         return 0xC000 | (Rand() % 3 << 8) | (Rand() & 0x3F);      // mov.x R0,@(disp,GBR)
+      case 5:
+         return 0xC400 | (Rand() % 3 << 8) | (Rand() & 0x3F);      // mov.x @(disp,GBR),R0
+      case 6:
+         return 0x9000 | (RandReg() << 8) | (Rand() & 0x1F);       // mov.w @(disp,PC),Rn
+      default:
+         return 0xD000 | (RandReg() << 8) | (Rand() & 0x1F);       // mov.l @(disp,PC),Rn
+   }
+}
+
+static void Emit(program_struct *prog, u16 op)
+{
+   prog->op[prog->len++] = op;
+}
+
+static void GenProgram(program_struct *prog, int count)
+{
+   int i, n;
+
+   memset(prog, 0, sizeof(*prog));
+   for (i = 0; i < 14; i++)
+      prog->regs[i] = Rand();
+   prog->regs[14] = DATA_ADDR + DATA_SIZE / 2;
+   prog->regs[15] = RESULT_ADDR;
+   prog->mach = Rand();
+   prog->macl = Rand();
+   // the saturating MAC modes aren't covered, the interpreter and dynarec
+   // only agree on them while MACH holds a sign extended 16-bit value
+   prog->sr = 0xF0 | (Rand() & 0x301);
+
+   for (n = 0; n < count && prog->len < MAX_OPS - 48; n++)
+   {
+      int kind = Rand() % 16;
+      int rn = RandReg();
+
+      if (kind < 8)
+         Emit(prog, GenAluOp());
+      else if (kind < 12)
+         Emit(prog, GenMemOp());
+      else if (kind == 12)
+      {
+         // forward conditional or unconditional branch over a few ops
+         int skip = 1 + Rand() % 4;
+         int delayed = Rand() & 1;
+         int type = Rand() % 3;
+
+         // the branch always lands on the op following the skipped ones
+         if (type == 2)
+            Emit(prog, 0xA000 | skip);
+         else
+            Emit(prog, (type ? 0x8B00 : 0x8900) | (delayed << 10) | (skip - !delayed));
+         if (type == 2 || delayed)
+            Emit(prog, GenAluOp());
+         for (i = 0; i < skip; i++)
+            Emit(prog, GenAluOp());
+      }
+      else if (kind == 13)
+      {
+         // counted loop
+         int body = 1 + Rand() % 3;
+         Emit(prog, 0xE000 | (rn << 8) | (1 + Rand() % 6));
+         for (i = 0; i < body; i++)
+         {
+            u16 op;
+            do
+            {
+               op = GenAluOp();
+            } while (((op >> 8) & 0xF) == rn || (op & 0xF000) == 0xC000 || (op & 0xFF00) == 0x8800);
+            Emit(prog, op);
+         }
+         Emit(prog, 0x4010 | (rn << 8));
+         Emit(prog, 0x8B00 | ((-(body + 3)) & 0xFF));
+      }
+      else if (kind == 14)
+      {
+         // post-increment/pre-decrement through copies of the data pointer
+         int rm = (rn + 1 + Rand() % 13) % 14;
+         Emit(prog, 0x60E3 | (rn << 8));
+         Emit(prog, 0x7000 | (rn << 8) | (((Rand() % 8) * 4 - 16) & 0xFF));
+         switch (Rand() % 4)
+         {
+            case 0: Emit(prog, 0x6006 | (rm << 8) | (rn << 4)); break; // mov.l @Rm+,Rn
+            case 1: Emit(prog, 0x2006 | (rn << 8) | (rm << 4)); break; // mov.l Rm,@-Rn
+            default:
+               Emit(prog, 0x60E3 | (rm << 8));
+               Emit(prog, 0x7000 | (rm << 8) | (((Rand() % 8) * 4 - 16) & 0xFF));
+               if (Rand() & 1)
+                  Emit(prog, 0x000F | (rn << 8) | (rm << 4));          // mac.l @Rm+,@Rn+
+               else
+                  Emit(prog, 0x400F | (rn << 8) | (rm << 4));          // mac.w @Rm+,@Rn+
+               break;
+         }
+      }
+      else
+      {
+         // indexed access with R0 as the offset
+         Emit(prog, 0xE000 | ((Rand() % 16) * 4 - 32) & 0xFF);
+         if (Rand() & 1)
+            Emit(prog, 0x0E04 | (RandReg() << 4) | (Rand() % 3));
+         else
+            Emit(prog, 0x00EC | (RandReg() << 8) | (Rand() % 3));
+      }
+   }
+
+   // store the registers through R15
+   for (i = 0; i < 15; i++)
+      Emit(prog, 0x2F06 | (i << 4));
+   Emit(prog, 0x0002);   // stc sr,r0
+   Emit(prog, 0x2F06);
+   Emit(prog, 0x000A);   // sts mach,r0
+   Emit(prog, 0x2F06);
+   Emit(prog, 0x001A);   // sts macl,r0
+   Emit(prog, 0x2F06);
+   Emit(prog, 0xE000 | SENTINEL);
+   Emit(prog, 0x2F06);
+   Emit(prog, 0xAFFE);   // bra $
+   Emit(prog, 0x0009);
+}
+
+static void LoadProgram(const program_struct *prog)
+{
+   sh2regs_struct regs;
+   int i;
+
+   for (i = 0; i < prog->len; i++)
+      MappedMemoryWriteWord(CODE_ADDR + i * 2, prog->op[i]);
+   // literal pool for the PC relative loads past the end of the program
+   for (i = prog->len; i < MAX_OPS + 0x40; i++)
+      MappedMemoryWriteWord(CODE_ADDR + i * 2, (u16)(i * 0x9E37));
+   SH2WriteNotify(CODE_ADDR, (MAX_OPS + 0x40) * 2);
+   for (i = 0; i < DATA_SIZE; i++)
+      MappedMemoryWriteByte(DATA_ADDR + i, (u8)(i * 0x3B));
+   for (i = 0; i < RESULT_WORDS; i++)
+      MappedMemoryWriteLong(RESULT_ADDR - (i + 1) * 4, 0);
+
+   SH2GetRegisters(MSH2, &regs);
+   memcpy(regs.R, prog->regs, sizeof(regs.R));
+   regs.SR.all = prog->sr;
+   regs.GBR = DATA_ADDR;
+   regs.MACH = prog->mach;
+   regs.MACL = prog->macl;
+   regs.PC = CODE_ADDR;
+   SH2SetRegisters(MSH2, &regs);
+}
+
+static void RunProgram(const program_struct *prog, report_struct *report)
+{
+   int frame, i;
+
+   LoadProgram(prog);
+   memset(report, 0, sizeof(*report));
+   for (frame = 0; frame < 8; frame++)
+   {
+      YabauseExec();
+      if (MappedMemoryReadLong(RESULT_ADDR - RESULT_WORDS * 4) == SENTINEL)
+      {
+         report->status = 1;
+         break;
+      }
+   }
+   for (i = 0; i < RESULT_WORDS; i++)
+      report->result[i] = MappedMemoryReadLong(RESULT_ADDR - (i + 1) * 4);
+   for (i = 0; i < DATA_SIZE; i++)
+      report->data[i] = MappedMemoryReadByte(DATA_ADDR + i);
+}
+
+static int WriteAll(int fd, const void *buf, size_t size)
+{
+   const u8 *p = buf;
+   while (size)
+   {
+      ssize_t ret = write(fd, p, size);
+      if (ret <= 0)
+         return -1;
+      p += ret;
+      size -= ret;
+   }
+   return 0;
+}
+
+static int ReadAll(int fd, void *buf, size_t size)
+{
+   u8 *p = buf;
+   while (size)
+   {
+      ssize_t ret = read(fd, p, size);
+      if (ret <= 0)
+         return -1;
+      p += ret;
+      size -= ret;
+   }
+   return 0;
+}
+
+// Every program gets its own generator state so a restarted core can resume
+// at any index
+static void GenIndexedProgram(program_struct *prog, u32 seed, int index)
+{
+   rngstate = (seed + index * 0x9E3779B9) | 1;
+   GenProgram(prog, 8 + Rand() % 120);
+}
+
+static void RunCore(int coretype, int fd, int first, int programs, u32 seed)
+{
+   yabauseinit_struct yinit;
+   program_struct prog;
+   report_struct report;
+   int i;
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = coretype;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.clocksync = 1;
+   // fails at loading the game since there's no disc, the rest is set up
+   if (YabauseInit(&yinit) == -1)
+   {
+      fprintf(stderr, "error initializing core %d\n", coretype);
+      exit(1);
+   }
+   YabauseSetDecilineMode(1);
+
+   for (i = first; i < programs; i++)
+   {
+      GenIndexedProgram(&prog, seed, i);
+      RunProgram(&prog, &report);
+      if (WriteAll(fd, &report, sizeof(report)) != 0)
+         break;
+   }
+   YabauseDeInit();
+   exit(0);
+}
+
+static void StartCores(pid_t pid[2], int fd[2], int first, int programs, u32 seed)
+{
+   int i, p[2];
+
+   fflush(stdout);
+   for (i = 0; i < 2; i++)
+   {
+      if (pipe(p) != 0)
+      {
+         perror("pipe");
+         exit(1);
+      }
+      pid[i] = fork();
+      if (pid[i] == 0)
+      {
+         close(p[0]);
+         RunCore(i ? SH2CORE_DYNAREC : SH2CORE_INTERPRETER, p[1], first, programs, seed);
+      }
+      close(p[1]);
+      fd[i] = p[0];
+   }
+}
+
+static void StopCores(pid_t pid[2], int fd[2])
+{
+   int i;
+
+   for (i = 0; i < 2; i++)
+   {
+      close(fd[i]);
+      kill(pid[i], SIGKILL);
+      waitpid(pid[i], NULL, 0);
+   }
+}
+
+static const char *ResultName(int i)
+{
+   static const char *names[RESULT_WORDS] =
+   {
+      "R0", "R1", "R2", "R3", "R4", "R5", "R6", "R7", "R8", "R9", "R10",
+      "R11", "R12", "R13", "R14", "SR", "MACH", "MACL", "done",
+   };
+   return names[i];
+}
+
+static void PrintProgram(const program_struct *prog)
+{
+   char buf[256];
+   int i;
+
+   for (i = 0; i < 14; i++)
+      printf("  initial R%d=%08X\n", i, prog->regs[i]);
+   printf("  initial SR=%08X MACH=%08X MACL=%08X\n", prog->sr, prog->mach, prog->macl);
+   for (i = 0; i < prog->len; i++)
+   {
+      SH2Disasm(CODE_ADDR + i * 2, prog->op[i], 0, buf);
+      printf("  %04X  %s\n", prog->op[i], buf);
+   }
+}
+
+static void PrintMismatch(int index, const program_struct *prog,
+                          const report_struct *ref, const report_struct *test)
+{
+   int i;
+
+   printf("mismatch in program %d\n", index);
+   PrintProgram(prog);
+   if (ref->status != test->status)
+      printf("  interpreter %s, dynarec %s\n", ref->status ? "finished" : "timed out",
+             test->status ? "finished" : "timed out");
+   for (i = 0; i < RESULT_WORDS; i++)
+   {
+      if (ref->result[i] != test->result[i])
+         printf("  %s interpreter=%08X dynarec=%08X\n", ResultName(i),
+                ref->result[i], test->result[i]);
+   }
+   for (i = 0; i < DATA_SIZE; i++)
+   {
+      if (ref->data[i] != test->data[i])
+         printf("  data[%08X] interpreter=%02X dynarec=%02X\n", DATA_ADDR + i,
+                ref->data[i], test->data[i]);
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   int programs = argc > 1 ? atoi(argv[1]) : 10000;
+   u32 seed = argc > 2 ? strtoul(argv[2], NULL, 0) : 1;
+   int fd[2], ran, failures = 0;
+   pid_t pid[2];
+
+   StartCores(pid, fd, 0, programs, seed);
+   for (ran = 0; ran < programs && failures < 10; ran++)
+   {
+      program_struct prog;
+      report_struct ref, test;
+      int refok, testok;
+
+      GenIndexedProgram(&prog, seed, ran);
+      refok = ReadAll(fd[0], &ref, sizeof(ref)) == 0;
+      testok = ReadAll(fd[1], &test, sizeof(test)) == 0;
+      if (!refok || !testok)
+      {
+         // report the crash and carry on with the next program
+         printf("%s crashed in program %d\n", refok ? "dynarec" : "interpreter", ran);
+         PrintProgram(&prog);
+         failures++;
+         StopCores(pid, fd);
+         StartCores(pid, fd, ran + 1, programs, seed);
+         continue;
+      }
+      if (!ref.status || memcmp(&ref, &test, sizeof(ref)) != 0)
+      {
+         PrintMismatch(ran, &prog, &ref, &test);
+         failures++;
+      }
+   }
+   StopCores(pid, fd);
+   printf("%d programs, %d failures\n", ran, failures);
+   return failures != 0;
+}
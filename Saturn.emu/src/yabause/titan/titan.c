@@ -18,6 +18,7 @@
 */
 
 #include "titan.h"
+#include "../yui.h"
 
 #include <stdlib.h>
 
@@ -293,12 +294,13 @@ void TitanPutShadow(int priority, s32 x, s32 y)
    }
 }
 
-void TitanRender(pixel_t * dispbuffer)
+static void TitanRenderLines(void * data, int ystart, int yend)
 {
+   pixel_t * dispbuffer = (pixel_t *)data;
    u32 dot;
    int i;
 
-   for (i = 0; i < (tt_context.vdp2width * tt_context.vdp2height); i++)
+   for (i = ystart * tt_context.vdp2width; i < (yend * tt_context.vdp2width); i++)
    {
       dot = TitanDigPixel(7, i);
       if (dot)
@@ -308,6 +310,12 @@ void TitanRender(pixel_t * dispbuffer)
    }
 }
 
+void TitanRender(pixel_t * dispbuffer)
+{
+   /* each pixel only touches its own position in the priority buffers */
+   YuiParallelFor(0, tt_context.vdp2height, 32, TitanRenderLines, dispbuffer);
+}
+
 #ifdef WORDS_BIGENDIAN
 void TitanWriteColor(pixel_t * dispbuffer, s32 bufwidth, s32 x, s32 y, u32 color)
 {
@@ -179,6 +179,23 @@ typedef struct
 
 //////////////////////////////////////////////////////////////////////////////
 
+// filled in VIDSoftInit since layers are drawn from multiple threads
+static int mosaic_table[16][1024];
+
+static void InitMosaicTable(void)
+{
+   int i, j;
+
+   for (i = 0; i < 16; i++)
+   {
+      int m = i + 1;
+      for (j = 0; j < 1024; j++)
+         mosaic_table[i][j] = j / m * m;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 static INLINE u32 FASTCALL Vdp2ColorRamGetColor(u32 addr)
 {
    switch(Vdp2Internal.ColorMode)
@@ -667,22 +684,8 @@ static void FASTCALL Vdp2DrawScroll(vdp2draw_struct *info)
    ReadLineWindowData(&info->islinewindow, info->wctl, &linewnd0addr, &linewnd1addr);
    /* color calculation window: in => no color calc, out => color calc */
    ReadWindowData(Vdp2Regs->WCTLD >> 8, colorcalcwindow);
-   {
-	   static int tables_initialized = 0;
-	   static int mosaic_table[16][1024];
-	   if(!tables_initialized)
-	   {
-		   tables_initialized = 1;
-			for(i=0;i<16;i++)
-			{
-				int m = i+1;
-				for(j=0;j<1024;j++)
-					mosaic_table[i][j] = j/m*m;
-			}
-	   }
-	   mosaic_x = mosaic_table[info->mosaicxmask-1];
-	   mosaic_y = mosaic_table[info->mosaicymask-1];
-   }
+   mosaic_x = mosaic_table[info->mosaicxmask-1];
+   mosaic_y = mosaic_table[info->mosaicymask-1];
 
    for (j = 0; j < vdp2height; j++)
    {
@@ -1697,6 +1700,8 @@ int VIDSoftInit(void)
    if (TitanInit() == -1)
       return -1;
 
+   InitMosaicTable();
+
    if ((dispbuffer = (pixel_t *)memalign(8, sizeof(pixel_t) * 704 * 512)) == NULL)
       return -1;
 
@@ -3101,8 +3106,94 @@ void VIDSoftVdp2DrawEnd(void)
 
 //////////////////////////////////////////////////////////////////////////////
 
+// Layers only interact through the Titan priority buffers they blend into
+// and the rotation line color screens, so layers that can't touch the same
+// buffers are drawn in parallel. Layers that can are kept in one group and
+// drawn in the original order.
+
+#define VDP2_LAYER_ROTATION_MASK 0x100
+
+typedef struct
+{
+   int count;
+   int buffers;
+   void (*draw[5])(void);
+} vdp2layergroup_struct;
+
+static int Vdp2LayerSwapsPriorityBit(int sfprmdshift)
+{
+   Vdp2 * regs;
+   int i;
+
+   // special priority mode 1 replaces bit 0 of the priority per character
+   if (((Vdp2Regs->SFPRMD >> sfprmdshift) & 0x3) == 1)
+      return 1;
+   for (i = 0; i < vdp2height; i++)
+   {
+      regs = Vdp2RestoreRegs(i);
+      if (regs && ((regs->SFPRMD >> sfprmdshift) & 0x3) == 1)
+         return 1;
+   }
+   return 0;
+}
+
+static int Vdp2LayerBuffers(int priority, int sfprmdshift, int isrotation)
+{
+   int buffers = 1 << priority;
+
+   if (Vdp2LayerSwapsPriorityBit(sfprmdshift))
+      buffers = 3 << (priority & 0x6);
+   if (isrotation)
+      buffers |= VDP2_LAYER_ROTATION_MASK;
+   return buffers;
+}
+
+static void Vdp2AddLayer(vdp2layergroup_struct *groups, int *groupcount, int buffers, void (*draw)(void))
+{
+   vdp2layergroup_struct *target = NULL;
+   int i, j;
+
+   for (i = 0; i < *groupcount; i++)
+   {
+      if (!(groups[i].buffers & buffers))
+         continue;
+      if (!target)
+      {
+         target = &groups[i];
+         continue;
+      }
+      // layer links two groups, they don't share buffers so appending keeps each one's order
+      for (j = 0; j < groups[i].count; j++)
+         target->draw[target->count++] = groups[i].draw[j];
+      target->buffers |= groups[i].buffers;
+      groups[i--] = groups[--*groupcount];
+   }
+   if (!target)
+   {
+      target = &groups[(*groupcount)++];
+      target->count = 0;
+      target->buffers = 0;
+   }
+   target->draw[target->count++] = draw;
+   target->buffers |= buffers;
+}
+
+static void Vdp2DrawLayerGroups(void *data, int start, int end)
+{
+   vdp2layergroup_struct *groups = (vdp2layergroup_struct *)data;
+   int i, j;
+
+   for (i = start; i < end; i++)
+   {
+      for (j = 0; j < groups[i].count; j++)
+         groups[i].draw[j]();
+   }
+}
+
 void VIDSoftVdp2DrawScreens(void)
 {
+   vdp2layergroup_struct groups[5];
+   int groupcount = 0;
    int i;
 
    VIDSoftVdp2SetResolution(Vdp2Regs->TVMD);
@@ -3115,16 +3206,18 @@ void VIDSoftVdp2DrawScreens(void)
    for (i = 7; i > 0; i--)
    {   
       if (nbg3priority == i)
-         Vdp2DrawNBG3();
+         Vdp2AddLayer(groups, &groupcount, Vdp2LayerBuffers(i, 6, 0), Vdp2DrawNBG3);
       if (nbg2priority == i)
-         Vdp2DrawNBG2();
+         Vdp2AddLayer(groups, &groupcount, Vdp2LayerBuffers(i, 4, 0), Vdp2DrawNBG2);
       if (nbg1priority == i)
-         Vdp2DrawNBG1();
-      if (nbg0priority == i)
-         Vdp2DrawNBG0();
+         Vdp2AddLayer(groups, &groupcount, Vdp2LayerBuffers(i, 2, 0), Vdp2DrawNBG1);
+      if (nbg0priority == i) // NBG0 is drawn as RBG1 when enabled
+         Vdp2AddLayer(groups, &groupcount, Vdp2LayerBuffers(i, 0, Vdp2Regs->BGON & 0x20), Vdp2DrawNBG0);
       if (rbg0priority == i)
-         Vdp2DrawRBG0();
+         Vdp2AddLayer(groups, &groupcount, Vdp2LayerBuffers(i, 8, 1), Vdp2DrawRBG0);
    }
+
+   YuiParallelFor(0, groupcount, 1, Vdp2DrawLayerGroups, groups);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -36,6 +36,11 @@ void YuiErrorMsg(const char *string);
    up being moved to the Video Core. */
 void YuiSwapBuffers(void);
 
+/* Calls func(data, rowBegin, rowEnd) over [begin, end) in chunks of at least
+   grainsize rows, possibly in parallel on the frontend's worker threads.
+   Returns once every chunk is done. */
+void YuiParallelFor(int begin, int end, int grainsize, void (*func)(void *data, int begin, int end), void *data);
+
 //////////////////////////////////////////////////////////////////////////////
 // Helper functions(you can use these in your own port)
 //////////////////////////////////////////////////////////////////////////////
@@ -5,7 +5,7 @@
 #include <imagine/fs/ArchiveFS.hh>
 #include <imagine/util/format.hh>
 #include <imagine/util/string.h>
-#include <imagine/util/zlib.hh>
+#include <imagine/util/compression.hh>
 
 #include <memmap.h>
 #include <display.h>
@@ -36,6 +36,7 @@ bool EmuSystem::hasResetModes = true;
 bool EmuSystem::canRenderRGBA8888 = false;
 bool EmuSystem::hasRectangularPixels = true;
 bool EmuApp::needsGlobalInstance = true;
+bool EmuSystem::canRunAhead = true;
 
 EmuSystem::NameFilterFunc EmuSystem::defaultFsFilter =
 	[](std::string_view name)
@@ -135,10 +136,10 @@ static int unfreezeStateFrom(std::span<uint8_t> buff)
 
 void Snes9xSystem::readState(EmuApp &, std::span<uint8_t> buff)
 {
-	DynArray<uint8_t> uncompArr;
-	if(hasGzipHeader(buff))
+	ScratchBuffer uncompArr;
+	if(isCompressed(buff))
 	{
-		uncompArr = uncompressGzipState(buff);
+		uncompArr = uncompressState(buff);
 		buff = uncompArr;
 	}
 	if(!unfreezeStateFrom(buff))
@@ -146,6 +147,32 @@ void Snes9xSystem::readState(EmuApp &, std::span<uint8_t> buff)
 	IPPU.RenderThisFrame = TRUE;
 }
 
+#ifndef SNES9X_VERSION_1_4
+// Passes S9xFreezeToStream() output straight to a compressor
+class CompressorStream final : public Stream
+{
+public:
+	CompressorStream(StreamCompressor &compressor): compressor{compressor} {}
+	int get_char() final { return 0; }
+	char *gets(char *buf, size_t) final { *buf = '\0'; return {}; }
+	size_t read(void *, size_t) final { return 0; }
+	size_t write(void *buf, size_t len) final
+	{
+		compressor.write({static_cast<const uint8_t*>(buf), len});
+		bytesWritten += len;
+		return len;
+	}
+	size_t pos() final { return bytesWritten; }
+	size_t size() final { return bytesWritten; }
+	int revert(uint8, int32) final { return -1; }
+	void closeStream() final {}
+
+private:
+	StreamCompressor &compressor;
+	size_t bytesWritten{};
+};
+#endif
+
 static void freezeStateTo(std::span<uint8_t> buff)
 {
 	#ifndef SNES9X_VERSION_1_4
@@ -164,12 +191,30 @@ size_t Snes9xSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags)
 	}
 	else
 	{
-		auto uncompArr = DynArray<uint8_t>(saveStateSize);
+		#ifndef SNES9X_VERSION_1_4
+		// LZ4 works on the whole block so the state still gets written to memory first
+		auto inputBuff = stateCompressionCodec == CompressionCodec::LZ4 ? stateScratchBuffer(saveStateSize) : ScratchBuffer{};
+		auto compressor = stateCompressor(buff, inputBuff);
+		CompressorStream stream{compressor};
+		S9xFreezeToStream(&stream);
+		if(auto size = compressor.finish(); size)
+			return size;
+		// data didn't compress into the buffer, store it as-is
+		freezeStateTo(buff);
+		return saveStateSize;
+		#else
+		auto uncompArr = stateScratchBuffer(saveStateSize);
 		freezeStateTo(uncompArr);
-		return compressGzip(buff, uncompArr, Z_DEFAULT_COMPRESSION);
+		return compressState(buff, uncompArr);
+		#endif
 	}
 }
 
+size_t Snes9xSystem::compressState(std::span<uint8_t> dest, std::span<const uint8_t> state) const
+{
+	return compressStateData(dest, state);
+}
+
 void Snes9xSystem::loadBackupMemory(EmuApp &app)
 {
 	if(!Memory.SRAMSize)
@@ -43,6 +43,7 @@ using namespace MDFN_IEN_WSWAN;
 
 const char *EmuSystem::creditsViewStr = CREDITS_INFO_STRING "(c) 2011-2024\nRobert Broglia\nwww.explusalpha.com\n\nPortions (c) the\nMednafen Team\nmednafen.github.io";
 bool EmuApp::needsGlobalInstance = true;
+bool EmuSystem::canRunAhead = true;
 
 EmuSystem::NameFilterFunc EmuSystem::defaultFsFilter =
 	[](std::string_view name)
@@ -69,7 +70,8 @@ FS::FileString WsSystem::stateFilename(int slot, std::string_view name) const
 
 size_t WsSystem::stateSize() { return stateSizeMDFN(); }
 void WsSystem::readState(EmuApp &app, std::span<uint8_t> buff) { readStateMDFN(app, buff); }
-size_t WsSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags) { return writeStateMDFN(buff, flags); }
+size_t WsSystem::writeState(std::span<uint8_t> buff, SaveStateFlags flags) { return writeStateMDFN(*this, buff, flags); }
+size_t WsSystem::compressState(std::span<uint8_t> dest, std::span<const uint8_t> state) const { return compressStateData(dest, state); }
 
 void WsSystem::loadBackupMemory(EmuApp &app)
 {
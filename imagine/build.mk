@@ -31,6 +31,7 @@ include $(imagineSrcDir)/data-type/image/system.mk
 include $(imagineSrcDir)/thread/system.mk
 include $(imagineSrcDir)/vmem/system.mk
 include $(imagineSrcDir)/logger/system.mk
+include $(imagineSrcDir)/util/compression.mk
 include $(buildSysPath)/package/stdc++.mk
 
 libName := imagine$(libNameExt)
@@ -0,0 +1,59 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include "Format.hh"
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace IG::Audio
+{
+
+// Streaming polyphase windowed-sinc resampler for interleaved 16-bit or float frames.
+// The ratio is output frames per input frame and may change on every call, which allows
+// small rate adjustments to keep an output buffer at a target fill level.
+class Resampler
+{
+public:
+	static constexpr int taps = 16;
+	static constexpr int phaseBits = 7;
+	static constexpr int phases = 1 << phaseBits;
+	static constexpr int maxChannels = 2;
+
+	Resampler() = default;
+	void reset(SampleFormat, int8_t channels);
+	size_t outputFrames(size_t srcFrames, double ratio) const;
+	// returns the number of frames written to dest, output past destFrames is dropped
+	size_t process(void *dest, size_t destFrames, const void *src, size_t srcFrames, double ratio);
+
+protected:
+	std::vector<float> kernel;
+	std::array<std::vector<float>, maxChannels> history;
+	uint64_t pos{};
+	float cutoff{};
+	SampleFormat sample;
+	int8_t channels{};
+
+	void makeKernel(float cutoff);
+	void updateCutoff(double ratio);
+	static uint64_t stepForRatio(double ratio);
+	template<class T>
+	size_t processFrames(T *dest, size_t destFrames, const T *src, size_t srcFrames, uint64_t step);
+};
+
+}
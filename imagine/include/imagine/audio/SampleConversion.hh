@@ -0,0 +1,39 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <cstdint>
+#include <cstddef>
+
+namespace IG::Audio
+{
+
+// Vectorized sample conversion and gain kernels. On x86 an AVX2 path is selected at runtime
+// when the CPU supports it with SSE2 as the baseline, ARM uses NEON when enabled at compile time.
+// Conversions to int16 saturate. All functions return the end of the written samples in dest.
+
+float *convertSamples(float *dest, const int16_t *src, size_t samples, float volume = 1.f);
+int16_t *convertSamples(int16_t *dest, const float *src, size_t samples, float volume = 1.f);
+float *scaleSamples(float *dest, const float *src, size_t samples, float volume);
+int16_t *scaleSamples(int16_t *dest, const int16_t *src, size_t samples, float volume);
+
+// Interleaves separate 32-bit left & right channel buffers into 16-bit stereo frames
+int16_t *mergeStereoSamples(int16_t *dest, const int32_t *left, const int32_t *right, size_t frames);
+
+// Name of the kernel set in use for logging & benchmarks
+const char *sampleConversionKernelName();
+
+}
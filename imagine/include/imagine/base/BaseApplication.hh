@@ -128,7 +128,7 @@ protected:
 	DelegateFuncSet<ExitDelegate> onExit_;
 	WindowContainer window_{};
 	ScreenContainer screen_{};
-	MessagePort<CommandMessage> commandPort{"Main thread messages"};
+	RingMessagePort<CommandMessage> commandPort{"Main thread messages"};
 	InputDeviceContainer inputDev{};
 	std::optional<Timer> keyRepeatTimer{};
 	Input::KeyEvent keyRepeatEvent{};
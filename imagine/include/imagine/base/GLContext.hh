@@ -127,6 +127,7 @@ public:
 	using GLManagerImpl::GLManagerImpl;
 	static constexpr bool hasSwapInterval = GLManagerImpl::hasSwapInterval;
 
+	GLManager() = default; // no display, for a headless renderer
 	GLManager(NativeDisplayConnection);
 	GLManager(NativeDisplayConnection, GL::API);
 	GLDisplay display() const;
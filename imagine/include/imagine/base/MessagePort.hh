@@ -17,9 +17,16 @@
 
 #include <imagine/config/defs.hh>
 #include <imagine/base/Pipe.hh>
+#include <imagine/base/CustomEvent.hh>
 #include <imagine/thread/Semaphore.hh>
 #include <imagine/util/concepts.hh>
 #include <imagine/util/utility.h>
+#include <imagine/util/DelegateFunc.hh>
+#include <imagine/util/bit.hh>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <thread>
 #include <cstring>
 #include <span>
 
@@ -217,6 +224,219 @@ protected:
 	Pipe pipe{Pipe::NullInit{}};
 };
 
+template<class MsgType>
+class RingMessagePort;
+
+template<class MsgType>
+class RingMessages
+{
+public:
+	struct Sentinel {};
+
+	class Iterator
+	{
+	public:
+		constexpr Iterator(RingMessagePort<MsgType> &port): port{&port}
+		{
+			this->operator++();
+		}
+
+		Iterator operator++()
+		{
+			if(!port) [[unlikely]]
+				return *this;
+			if(auto nextMsg = port->tryGetMessage(); nextMsg)
+			{
+				msg = *nextMsg;
+			}
+			else
+			{
+				// end of messages
+				port = nullptr;
+			}
+			return *this;
+		}
+
+		bool operator==(Sentinel) const
+		{
+			return !port;
+		}
+
+		const MsgType &operator*() const
+		{
+			return msg;
+		}
+
+	private:
+		RingMessagePort<MsgType> *port{};
+		MsgType msg;
+	};
+
+	constexpr RingMessages(RingMessagePort<MsgType> &port): port{port} {}
+	auto begin() const { return Iterator{port}; }
+	auto end() const { return Sentinel{}; }
+
+protected:
+	RingMessagePort<MsgType> &port;
+};
+
+// Bounded multi-producer/single-consumer queue in shared memory. Senders only signal the
+// consumer's event loop when the queue goes from empty to non-empty, so a burst of messages
+// costs a single wakeup and no syscalls on the send side while the consumer is still busy.
+// Messages are copied into the ring so MsgType should be cheap to copy and there's no support
+// for sending extra data.
+template<class MsgType>
+class RingMessagePort
+{
+public:
+	using Messages = RingMessages<MsgType>;
+	static constexpr int defaultCapacity = 512;
+
+	RingMessagePort(const char *debugLabel = nullptr, int capacity = 0):
+		slots{std::make_unique<Slot[]>(std::bit_ceil(unsigned(capacity ? capacity : defaultCapacity)))},
+		mask{std::bit_ceil(unsigned(capacity ? capacity : defaultCapacity)) - 1},
+		event{debugLabel}
+	{
+		for(size_t i = 0; i <= mask; i++)
+		{
+			slots[i].seq.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	void attach(auto &&f)
+	{
+		attach(EventLoop::forThread(), IG_forward(f));
+	}
+
+	void attach(EventLoop loop, Callable<void, Messages> auto &&f)
+	{
+		attach(loop, [=](Messages msgs){ f(msgs); return true; });
+	}
+
+	void attach(EventLoop loop, Callable<bool, Messages> auto &&f)
+	{
+		callback = f;
+		event.attach(loop, PollEventDelegate
+			{
+				[this](int fd, int) -> bool
+				{
+					if(!CustomEvent::shouldPerformCallback(fd))
+						return true;
+					return dispatchMessages();
+				}
+			});
+	}
+
+	void detach()
+	{
+		event.detach();
+	}
+
+	bool send(MsgType msg)
+	{
+		auto pos = enqueuePos.load(std::memory_order_relaxed);
+		Slot *slot;
+		while(true)
+		{
+			slot = &slots[pos & mask];
+			auto seq = slot->seq.load(std::memory_order_acquire);
+			auto diff = intptr_t(seq) - intptr_t(pos);
+			if(diff == 0)
+			{
+				if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else
+			{
+				if(diff < 0) // full, wait for the consumer like a blocking pipe write would
+					std::this_thread::yield();
+				pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+		slot->msg = msg;
+		slot->seq.store(pos + 1, std::memory_order_release);
+		if(pending.fetch_add(1, std::memory_order_acq_rel) == 0)
+			event.notify();
+		return true;
+	}
+
+	bool send(MsgType msg, MessageReplyMode mode)
+	{
+		if(mode == MessageReplyMode::wait)
+		{
+			std::binary_semaphore replySemaphore{0};
+			return send(msg, &replySemaphore);
+		}
+		else
+		{
+			return send(msg);
+		}
+	}
+
+	bool send(ReplySemaphoreSettableMessage auto msg, std::binary_semaphore *semPtr)
+	{
+		if(semPtr)
+		{
+			msg.setReplySemaphore(semPtr);
+			send(msg);
+			semPtr->acquire();
+			return true;
+		}
+		else
+		{
+			return send(msg);
+		}
+	}
+
+	// Only call from the consumer thread
+	std::optional<MsgType> tryGetMessage()
+	{
+		auto &slot = slots[dequeuePos & mask];
+		if(slot.seq.load(std::memory_order_acquire) != dequeuePos + 1)
+			return {};
+		MsgType msg = slot.msg;
+		slot.seq.store(dequeuePos + mask + 1, std::memory_order_release);
+		dequeuePos++;
+		pending.fetch_sub(1, std::memory_order_acq_rel);
+		return msg;
+	}
+
+	void clear()
+	{
+		while(tryGetMessage()) {}
+	}
+
+	bool dispatchMessages()
+	{
+		if(!callback) [[unlikely]]
+			return true;
+		bool keep = callback(messages());
+		// a sender may still be writing a slot that blocked the queue, check back once it's done
+		if(keep && pending.load(std::memory_order_acquire) > 0)
+			event.notify();
+		return keep;
+	}
+
+	Messages messages() { return Messages{*this}; }
+
+	explicit operator bool() const { return (bool)event; }
+
+protected:
+	struct Slot
+	{
+		std::atomic<size_t> seq;
+		MsgType msg;
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	size_t mask{};
+	alignas(64) std::atomic<size_t> enqueuePos{};
+	alignas(64) std::atomic<intptr_t> pending{};
+	alignas(64) size_t dequeuePos{};
+	DelegateFuncS<sizeof(void*)*4, bool(Messages)> callback;
+	CustomEvent event;
+};
+
 template<class MsgType>
 using MessagePort = PipeMessagePort<MsgType>;
 
@@ -52,6 +52,7 @@ class FrameTimer;
 struct ApplicationInitParams
 {
 	ANativeActivity *nActivity;
+	bool headless{};
 
 	constexpr CommandArgs commandArgs() const	{ return {}; }
 };
@@ -61,11 +61,12 @@ public:
 		fdSrc.setCallback(makeDelegate(IG_forward(f)));
 	}
 
+	// Consumes the pending notification, returns false on a spurious wakeup
+	static bool shouldPerformCallback(int fd);
+
 protected:
 	IG_UseMemberIf(Config::DEBUG_BUILD, const char *, debugLabel){};
 	FDEventSource fdSrc{};
-
-	static bool shouldPerformCallback(int fd);
 };
 
 using CustomEventImpl = FDCustomEvent;
@@ -28,6 +28,7 @@ struct ApplicationInitParams
 	void *uiAppPtr;
 	int argc;
 	char **argv;
+	bool headless{};
 
 	constexpr CommandArgs commandArgs() const
 	{
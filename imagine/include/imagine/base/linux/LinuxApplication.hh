@@ -39,6 +39,7 @@ struct ApplicationInitParams
 	ApplicationContext *ctxPtr;
 	int argc;
 	char **argv;
+	bool headless{}; // don't connect to the display server, no windows can be created
 
 	constexpr CommandArgs commandArgs() const
 	{
@@ -0,0 +1,96 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/fs/FSDefs.hh>
+#include <imagine/io/IO.hh>
+#include <imagine/io/ArchiveIO.hh>
+#include <imagine/util/DelegateFunc.hh>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace IG
+{
+class JobSystem;
+}
+
+namespace IG::FS
+{
+
+struct ArchiveIndexEntry
+{
+	std::string name;
+	size_t size{};
+	size_t compressedSize{};
+	size_t localHeaderOffset{};
+	uint32_t crc32{};
+	uint16_t method{};
+	file_type type{};
+	// stored or deflated zip entry that can be read directly from the mapped archive
+	bool randomAccess{};
+};
+
+// Lists an archive's entries once for lookup by name or CRC32. Zip entries are located from
+// the central directory and can be decompressed concurrently, other formats are read through
+// libarchive in a single pass per batch of requests.
+class ArchiveIndex
+{
+public:
+	using Entry = ArchiveIndexEntry;
+
+	struct ReadRequest
+	{
+		const Entry *entry{};
+		std::span<uint8_t> dest; // receives dest.size() bytes of the entry starting at offset
+		size_t offset{};
+		size_t bytesRead{};
+		bool ok{};
+	};
+
+	// Called once per request after it's read, calls don't overlap but can come from a job thread
+	using OnReadDelegate = DelegateFunc<void(const ReadRequest &)>;
+
+	ArchiveIndex() = default;
+	ArchiveIndex(IO);
+	const Entry *find(std::string_view name) const;
+	const Entry *findCRC32(uint32_t crc) const;
+	std::span<const Entry> entries() const { return entries_; }
+	bool read(const Entry &, std::span<uint8_t> dest, size_t offset = 0);
+	// Reads all requests, spreading random access entries over the job system's threads if
+	// given, and returns the number that completed. Requests with overlapping destinations
+	// are written in their original order.
+	size_t read(std::span<ReadRequest>, JobSystem * = {}, OnReadDelegate onRead = {});
+	explicit operator bool() const { return io || arch; }
+
+private:
+	IO io;
+	std::span<uint8_t> mapped;
+	ArchiveIO arch; // for entries that need libarchive
+	std::vector<Entry> entries_;
+	std::unordered_map<std::string_view, uint32_t> nameMap;
+	std::unordered_map<uint32_t, uint32_t> crcMap;
+
+	bool indexZip(std::span<const uint8_t> data);
+	void indexArchive();
+	void makeMaps();
+	static bool readRandomAccess(std::span<const uint8_t> data, ReadRequest &);
+	void readSequential(std::span<ReadRequest *>, bool keepOrder, OnReadDelegate onRead);
+};
+
+}
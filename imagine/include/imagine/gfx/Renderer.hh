@@ -76,7 +76,7 @@ class Renderer : public RendererImpl
 {
 public:
 	using RendererImpl::RendererImpl;
-	Renderer(ApplicationContext);
+	Renderer(ApplicationContext, bool headless = false);
 	~Renderer();
 	void configureRenderer();
 	bool isConfigured() const;
@@ -169,7 +169,7 @@ public:
 	Gfx::QuadIndexArray<uint8_t> quadIndices;
 	CustomEvent releaseShaderCompilerEvent{CustomEvent::NullInit{}};
 
-	GLRenderer(ApplicationContext);
+	GLRenderer(ApplicationContext, bool headless);
 	GLDisplay glDisplay() const;
 	bool makeWindowDrawable(RendererTask &task, Window &, GLBufferConfig, GLColorSpace);
 	int toSwapInterval(const Window &win, PresentMode mode) const;
@@ -0,0 +1,33 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <cstdint>
+
+namespace IG
+{
+
+// Converts a rectangle of indexed pixels to direct color through a palette that covers every
+// possible index (256 entries for 8-bit indices, 65536 for 16-bit). Pitches are in pixels.
+// 32-bit output uses AVX2 gathers when the CPU supports them and 8-bit indices use NEON
+// table lookups on ARM64, otherwise a scalar loop is used.
+
+void expandPalette(uint16_t *dest, int destPitch, const uint8_t *src, int srcPitch, int w, int h, const uint16_t *palette);
+void expandPalette(uint32_t *dest, int destPitch, const uint8_t *src, int srcPitch, int w, int h, const uint32_t *palette);
+void expandPalette(uint16_t *dest, int destPitch, const uint16_t *src, int srcPitch, int w, int h, const uint16_t *palette);
+void expandPalette(uint32_t *dest, int destPitch, const uint16_t *src, int srcPitch, int w, int h, const uint32_t *palette);
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/pixmap/PixelFormat.hh>
+
+namespace IG
+{
+
+// Converts a rectangle of pixels between the RGBA8888, BGRA8888, RGB565 & RGB888 formats with
+// the same results as the transform*() functions. Pitches are in bytes. On x86 an SSSE3 path is
+// selected at runtime and ARM uses NEON when enabled at compile time.
+// Returns false if the conversion isn't supported.
+bool convertPixels(PixelFormatID destFormat, void *dest, int destPitch,
+	PixelFormatID srcFormat, const void *src, int srcPitch, int w, int h);
+
+}
@@ -17,12 +17,15 @@
 
 #include <imagine/config/defs.hh>
 #include <imagine/pixmap/PixmapDesc.hh>
+#include <imagine/pixmap/PaletteExpand.hh>
+#include <imagine/pixmap/PixelConvert.hh>
 #include <imagine/util/rectangle2.h>
 #include <imagine/util/algorithm.h>
 #include <imagine/util/ranges.hh>
 #include <imagine/util/mdspan.hh>
 #include <imagine/util/concepts.hh>
 #include <cstring>
+#include <span>
 
 namespace IG
 {
@@ -189,43 +192,10 @@ public:
 			write(pixmap);
 			return;
 		}
-		auto srcFormatID = pixmap.format().id();
-		switch(format().id())
+		if(!convertPixels(format().id(), data_, pitchBytes(), pixmap.format().id(), pixmap.data(), pixmap.pitchBytes(),
+			pixmap.w(), pixmap.h()))
 		{
-			case PIXEL_RGBA8888:
-				switch(srcFormatID)
-				{
-					case PIXEL_BGRA8888: return convertRGBA8888ToBGRA8888(*this, pixmap);
-					case PIXEL_RGB565: return convertRGB565ToRGBX8888(*this, pixmap);
-					case PIXEL_RGB888: return convertRGB888ToRGBX8888(*this, pixmap);
-					default: return invalidFormatConversion(*this, pixmap);
-				}
-			case PIXEL_BGRA8888:
-				switch(srcFormatID)
-				{
-					case PIXEL_RGBA8888: return convertRGBA8888ToBGRA8888(*this, pixmap);
-					case PIXEL_RGB565: return convertRGB565ToBGRX8888(*this, pixmap);
-					case PIXEL_RGB888: return convertRGB888ToBGRX8888(*this, pixmap);
-					default: return invalidFormatConversion(*this, pixmap);
-				}
-			case PIXEL_RGB888:
-				switch(srcFormatID)
-				{
-					case PIXEL_BGRA8888: return convertBGRX8888ToRGB888(*this, pixmap);
-					case PIXEL_RGBA8888: return convertRGBX8888ToRGB888(*this, pixmap);
-					case PIXEL_RGB565: return convertRGB565ToRGB888(*this, pixmap);
-					default: return invalidFormatConversion(*this, pixmap);
-				}
-			case PIXEL_RGB565:
-				switch(srcFormatID)
-				{
-					case PIXEL_RGBA8888: return convertRGBX8888ToRGB565(*this, pixmap);
-					case PIXEL_BGRA8888: return convertBGRX8888ToRGB565(*this, pixmap);
-					case PIXEL_RGB888: return convertRGB888ToRGB565(*this, pixmap);
-					default: return invalidFormatConversion(*this, pixmap);
-				}
-			default:
-				return invalidFormatConversion(*this, pixmap);
+			invalidFormatConversion(*this, pixmap);
 		}
 	}
 
@@ -313,6 +283,26 @@ public:
 		subView(destPos, size() - destPos).writeTransformed(func, pixmap);
 	}
 
+	// Converts an indexed pixmap through a palette covering every possible index of its pixel size
+	template <class Dest>
+	void writePaletteExpanded(std::span<const Dest> palette, auto pixmap) requires(dataIsMutable)
+	{
+		assumeExpr(format().bytesPerPixel() == sizeof(Dest));
+		assumeExpr(w() >= pixmap.w() && h() >= pixmap.h());
+		switch(pixmap.format().bytesPerPixel())
+		{
+			case 1:
+				assumeExpr(palette.size() >= 0x100);
+				return expandPalette((Dest*)data_, pitchPx(), (const uint8_t*)pixmap.data(), pixmap.pitchPx(),
+					pixmap.w(), pixmap.h(), palette.data());
+			case 2:
+				assumeExpr(palette.size() >= 0x10000);
+				return expandPalette((Dest*)data_, pitchPx(), (const uint16_t*)pixmap.data(), pixmap.pitchPx(),
+					pixmap.w(), pixmap.h(), palette.data());
+		}
+		bug_unreachable("invalid bytes per pixel:%d", pixmap.format().bytesPerPixel());
+	}
+
 	template <class Src, class Dest>
 	void writeTransformedDirect(PixmapTransformFunc auto &&func, auto pixmap) requires(dataIsMutable)
 	{
@@ -371,61 +361,6 @@ protected:
 	{
 		bug_unreachable("unimplemented conversion:%s -> %s", src.format().name(), dest.format().name());
 	}
-
-	static void convertRGB888ToRGBX8888(auto dest, auto src)
-	{
-		dest.template writeTransformedDirect<RGBTripleArray, uint32_t>(transformRGB888ToRGBX8888, src);
-	}
-
-	static void convertRGB888ToBGRX8888(auto dest, auto src)
-	{
-		dest.template writeTransformedDirect<RGBTripleArray, uint32_t>(transformRGB888ToBGRX8888, src);
-	}
-
-	static void convertRGB565ToRGBX8888(auto dest, auto src)
-	{
-		dest.writeTransformed(transformRGB565ToRGBX8888, src);
-	}
-
-	static void convertRGB565ToBGRX8888(auto dest, auto src)
-	{
-		dest.writeTransformed(transformRGB565ToBGRX8888, src);
-	}
-
-	static void convertRGBX8888ToRGB888(auto dest, auto src)
-	{
-		dest.template writeTransformedDirect<uint32_t, RGBTripleArray>(transformRGBX8888ToRGB888, src);
-	}
-
-	static void convertBGRX8888ToRGB888(auto dest, auto src)
-	{
-		dest.template writeTransformedDirect<uint32_t, RGBTripleArray>(transformBGRX8888ToRGB888, src);
-	}
-
-	static void convertRGB565ToRGB888(auto dest, auto src)
-	{
-		dest.template writeTransformedDirect<uint16_t, RGBTripleArray>(transformRGB565ToRGB888, src);
-	}
-
-	static void convertRGB888ToRGB565(auto dest, auto src)
-	{
-		dest.template writeTransformedDirect<RGBTripleArray, uint16_t>(transformRGB888ToRGB565, src);
-	}
-
-	static void convertRGBX8888ToRGB565(auto dest, auto src)
-	{
-		dest.writeTransformed(transformRGBX8888ToRGB565, src);
-	}
-
-	static void convertRGBA8888ToBGRA8888(auto dest, auto src)
-	{
-		dest.writeTransformed(transformRGBA8888ToBGRA8888, src);
-	}
-
-	static void convertBGRX8888ToRGB565(auto dest, auto src)
-	{
-		dest.template writeTransformed(transformBGRX8888ToRGB565, src);
-	}
 };
 
 using PixmapView = PixmapViewBase<const char>;
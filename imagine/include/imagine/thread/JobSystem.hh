@@ -0,0 +1,97 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <imagine/thread/Thread.hh>
+#include <imagine/util/DelegateFunc.hh>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace IG
+{
+
+enum class JobPriority : uint8_t
+{
+	high,   // work someone is waiting on this frame, like parallelFor() chunks
+	normal,
+	low,    // background work like state compression or ROM indexing
+};
+
+using JobDelegate = DelegateFuncS<sizeof(void*)*4, void()>;
+using JobRangeDelegate = DelegateFuncS<sizeof(void*)*4, void(int begin, int end)>;
+
+// Pool of worker threads that each own a queue per priority. Workers run their newest job first
+// and steal the oldest job from other workers when their own queues are empty.
+class JobSystem
+{
+public:
+	static constexpr int priorities = 3;
+
+	JobSystem() = default;
+	JobSystem(const JobSystem &) = delete;
+	JobSystem &operator=(const JobSystem &) = delete;
+	~JobSystem() { stop(); }
+
+	// With threadCount <= 0 all jobs run on the submitting thread
+	void start(int threadCount);
+	// Finishes any queued jobs and joins the worker threads
+	void stop();
+	int threads() const { return workers.size(); }
+	std::vector<ThreadId> threadIds() const;
+	void setCPUAffinityMask(CPUMask);
+	void submit(JobDelegate, JobPriority = JobPriority::normal);
+
+	// Calls func(rowBegin, rowEnd) over [begin, end) in chunks of at least grainSize rows.
+	// The calling thread also runs chunks and returns once every chunk is done.
+	void parallelFor(int begin, int end, int grainSize, std::invocable<int, int> auto &&func)
+	{
+		parallelFor(begin, end, grainSize, JobRangeDelegate{[&func](int b, int e){ func(b, e); }});
+	}
+
+	void parallelFor(int begin, int end, int grainSize, JobRangeDelegate);
+
+	// Worker count for the CPUs in mask (or all CPUs if 0), leaving one for the submitting thread
+	static int threadCountForMask(CPUMask, int cpuCount);
+
+protected:
+	struct Worker
+	{
+		std::mutex mutex;
+		std::array<std::deque<JobDelegate>, priorities> queues;
+		std::thread thread;
+		ThreadId id{};
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	// number of queued jobs, also the word idle workers wait on
+	std::atomic_int queuedJobs{};
+	std::atomic_bool quit{};
+	std::atomic_uint nextWorker{};
+
+	void runWorker(int idx);
+	std::optional<JobDelegate> takeJob(int selfIdx);
+	int currentWorkerIndex() const;
+};
+
+}
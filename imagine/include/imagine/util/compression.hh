@@ -0,0 +1,94 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <span>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace IG
+{
+
+// Buffer compression with a selectable codec. Gzip data is identified by its own header,
+// the other codecs write an 8 byte header: a 4 byte magic followed by the uncompressed size
+// as a little-endian uint32.
+enum class CompressionCodec : uint8_t
+{
+	None,
+	Gzip, // zlib deflate with a gzip header, compatible with compressGzip()
+	LZ4, // LZ4 block format, fastest with a moderate ratio, level is ignored
+	LZMA, // xz stream, slowest with the highest ratio
+};
+
+constexpr int defaultCompressionLevel = -1;
+
+constexpr bool isValidCompressionCodec(CompressionCodec c) { return c <= CompressionCodec::LZMA; }
+
+// Source of the codecs' working memory, lets callers recycle it between calls
+// instead of zlib/liblzma allocating from the heap every time
+struct CompressionAllocator
+{
+	void *(*alloc)(void *ctx, size_t size){};
+	void (*free)(void *ctx, void *ptr){};
+	void *ctx{};
+};
+
+// returns the number of bytes written to dest, or 0 if dest is too small or an error occurred
+size_t compress(std::span<uint8_t> dest, std::span<const uint8_t> src, CompressionCodec, int level = defaultCompressionLevel,
+	const CompressionAllocator * = {});
+
+// returns the codec used by the compressed data in buff or None if not recognized
+CompressionCodec compressionCodec(std::span<const uint8_t> buff);
+
+inline bool isCompressed(std::span<const uint8_t> buff) { return compressionCodec(buff) != CompressionCodec::None; }
+
+// returns the uncompressed size stored in the header, or 0 if buff isn't compressed data
+size_t uncompressedSize(std::span<const uint8_t> buff);
+
+// returns the number of bytes written to dest, or 0 if src is invalid or dest is too small
+size_t uncompress(std::span<uint8_t> dest, std::span<const uint8_t> src, const CompressionAllocator * = {});
+
+// Compresses data passed in pieces to write(), with the same output as compress().
+// Gzip & LZMA compress as the data arrives, LZ4 needs the whole input so it's
+// gathered in inputBuff first, which must be large enough to hold all of it.
+class StreamCompressor
+{
+public:
+	StreamCompressor(std::span<uint8_t> dest, CompressionCodec, int level = defaultCompressionLevel,
+		std::span<uint8_t> inputBuff = {}, const CompressionAllocator * = {});
+	StreamCompressor(const StreamCompressor &) = delete;
+	StreamCompressor &operator=(const StreamCompressor &) = delete;
+	~StreamCompressor();
+	// returns false if the output or input buffer is full, or on a codec error
+	bool write(std::span<const uint8_t>);
+	// returns the total number of bytes written to dest, or 0 if any write() failed
+	size_t finish();
+
+private:
+	std::span<uint8_t> dest;
+	std::span<uint8_t> inputBuff;
+	size_t inputSize{};
+	size_t outputSize{};
+	CompressionCodec codec;
+	int level;
+	bool failed{};
+	bool finished{};
+	// z_stream or lzma_stream, depending on the codec
+	alignas(std::max_align_t) std::array<std::byte, 192> codecState;
+};
+
+}
@@ -0,0 +1,6 @@
+ifndef inc_pkg_liblzma
+inc_pkg_liblzma := 1
+
+pkgConfigStaticDeps += liblzma
+
+endif
\ No newline at end of file
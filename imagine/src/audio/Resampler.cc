@@ -0,0 +1,239 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/audio/Resampler.hh>
+#include <imagine/util/utility.h>
+#include <imagine/util/ranges.hh>
+#include <imagine/util/math.hh>
+#include <algorithm>
+#include <numbers>
+#include <cmath>
+#if defined __SSE__
+#include <xmmintrin.h>
+#elif defined __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+namespace IG::Audio
+{
+
+static_assert(Resampler::taps % 4 == 0, "kernel must be a multiple of the SIMD width");
+
+constexpr int fracBits = 32;
+constexpr int phaseFracBits = fracBits - Resampler::phaseBits;
+// keep the pass band below Nyquist so the transition band of the short kernel doesn't alias
+constexpr float passBand = .92f;
+
+// coeffs = a + (b - a) * t
+static void lerpKernel(float * __restrict__ coeffs, const float *a, const float *b, float t)
+{
+	#if defined __SSE__
+	auto vt = _mm_set1_ps(t);
+	for(int i = 0; i < Resampler::taps; i += 4)
+	{
+		auto va = _mm_loadu_ps(a + i);
+		_mm_storeu_ps(coeffs + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b + i), va), vt)));
+	}
+	#elif defined __ARM_NEON
+	for(int i = 0; i < Resampler::taps; i += 4)
+	{
+		auto va = vld1q_f32(a + i);
+		vst1q_f32(coeffs + i, vmlaq_n_f32(va, vsubq_f32(vld1q_f32(b + i), va), t));
+	}
+	#else
+	for(int i = 0; i < Resampler::taps; i++)
+	{
+		coeffs[i] = a[i] + (b[i] - a[i]) * t;
+	}
+	#endif
+}
+
+static float dotProduct(const float *coeffs, const float *samples)
+{
+	#if defined __SSE__
+	auto sum = _mm_setzero_ps();
+	for(int i = 0; i < Resampler::taps; i += 4)
+	{
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(coeffs + i), _mm_loadu_ps(samples + i)));
+	}
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+	return _mm_cvtss_f32(sum);
+	#elif defined __ARM_NEON
+	auto sum = vdupq_n_f32(0);
+	for(int i = 0; i < Resampler::taps; i += 4)
+	{
+		sum = vmlaq_f32(sum, vld1q_f32(coeffs + i), vld1q_f32(samples + i));
+	}
+	#if defined __aarch64__
+	return vaddvq_f32(sum);
+	#else
+	auto pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+	return vget_lane_f32(vpadd_f32(pair, pair), 0);
+	#endif
+	#else
+	float sum{};
+	for(int i = 0; i < Resampler::taps; i++)
+	{
+		sum += coeffs[i] * samples[i];
+	}
+	return sum;
+	#endif
+}
+
+static float toFloat(float s) { return s; }
+static float toFloat(int16_t s) { return s * (1.f / 32768.f); }
+
+template<class T>
+static T fromFloat(float s)
+{
+	if constexpr(std::is_same_v<T, float>)
+		return s;
+	else
+		return std::clamp(std::lrint(s * 32768.f), -32768l, 32767l);
+}
+
+void Resampler::reset(SampleFormat sample_, int8_t channels_)
+{
+	assumeExpr(channels_ > 0 && channels_ <= maxChannels);
+	sample = sample_;
+	channels = channels_;
+	for(auto &h : history)
+	{
+		h.clear();
+	}
+	for(auto ch : iotaCount(channels))
+	{
+		history[ch].resize(taps);
+	}
+	// the first output frame lines up with the kernel center, adding taps / 2 frames of latency
+	pos = uint64_t(taps / 2) << fracBits;
+}
+
+void Resampler::makeKernel(float newCutoff)
+{
+	cutoff = newCutoff;
+	kernel.resize((phases + 1) * taps);
+	for(auto p : iotaCount(phases + 1))
+	{
+		auto row = &kernel[p * taps];
+		float frac = float(p) / phases;
+		float sum{};
+		for(auto k : iotaCount(taps))
+		{
+			// distance from the output position to this tap
+			double d = k - (taps / 2 - 1) - frac;
+			double x = d * cutoff;
+			double sinc = x == 0. ? 1. : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+			// Blackman window spanning the kernel
+			double w = (d + taps / 2.) / taps;
+			double window = .42 - .5 * std::cos(2. * std::numbers::pi * w) + .08 * std::cos(4. * std::numbers::pi * w);
+			row[k] = sinc * window;
+			sum += row[k];
+		}
+		// normalize each phase for unity DC gain
+		for(auto k : iotaCount(taps))
+		{
+			row[k] /= sum;
+		}
+	}
+}
+
+void Resampler::updateCutoff(double ratio)
+{
+	// lower the cutoff when decimating, but ignore the small ratio changes from rate control
+	float newCutoff = passBand * std::min(ratio, 1.);
+	if(std::abs(newCutoff - cutoff) > .01f)
+		makeKernel(newCutoff);
+}
+
+uint64_t Resampler::stepForRatio(double ratio)
+{
+	assumeExpr(ratio > 0.);
+	return std::max(std::llround(double(1ull << fracBits) / ratio), 1ll);
+}
+
+size_t Resampler::outputFrames(size_t srcFrames, double ratio) const
+{
+	const uint64_t end = uint64_t(srcFrames + taps / 2) << fracBits;
+	if(pos >= end)
+		return 0;
+	auto step = stepForRatio(ratio);
+	return (end - pos + step - 1) / step;
+}
+
+template<class T>
+size_t Resampler::processFrames(T *dest, size_t destFrames, const T *src, size_t srcFrames, uint64_t step)
+{
+	// each channel's history holds the last taps input frames followed by the new ones
+	for(auto ch : iotaCount(channels))
+	{
+		auto &h = history[ch];
+		if(h.size() < taps + srcFrames)
+			h.resize(taps + srcFrames);
+		auto hNew = h.data() + taps;
+		for(auto i : iotaCount(srcFrames))
+		{
+			hNew[i] = toFloat(src[i * channels + ch]);
+		}
+	}
+	const uint64_t end = uint64_t(srcFrames + taps / 2) << fracBits;
+	size_t written{};
+	alignas(16) float coeffs[taps];
+	while(pos < end)
+	{
+		if(written == destFrames) [[unlikely]]
+		{
+			// skip the remaining output to stay in sync with the input
+			pos += (end - pos + step - 1) / step * step;
+			break;
+		}
+		auto idx = pos >> fracBits;
+		auto frac = uint32_t(pos);
+		auto phase = frac >> phaseFracBits;
+		float t = (frac & ((1u << phaseFracBits) - 1)) * (1.f / (1u << phaseFracBits));
+		auto row = &kernel[phase * taps];
+		lerpKernel(coeffs, row, row + taps, t);
+		auto first = idx - (taps / 2 - 1);
+		for(auto ch : iotaCount(channels))
+		{
+			dest[ch] = fromFloat<T>(dotProduct(coeffs, history[ch].data() + first));
+		}
+		dest += channels;
+		written++;
+		pos += step;
+	}
+	pos -= uint64_t(srcFrames) << fracBits;
+	for(auto ch : iotaCount(channels))
+	{
+		auto h = history[ch].data();
+		std::copy_n(h + srcFrames, taps, h);
+	}
+	return written;
+}
+
+size_t Resampler::process(void *dest, size_t destFrames, const void *src, size_t srcFrames, double ratio)
+{
+	assumeExpr(channels);
+	updateCutoff(ratio);
+	auto step = stepForRatio(ratio);
+	if(sample.isFloat())
+		return processFrames(static_cast<float*>(dest), destFrames, static_cast<const float*>(src), srcFrames, step);
+	else if(sample.bytes() == 2)
+		return processFrames(static_cast<int16_t*>(dest), destFrames, static_cast<const int16_t*>(src), srcFrames, step);
+	bug_unreachable("unsupported sample format");
+}
+
+}
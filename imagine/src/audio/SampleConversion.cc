@@ -0,0 +1,392 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/audio/SampleConversion.hh>
+#include <algorithm>
+#include <cmath>
+#if defined __SSE2__
+#define IG_AUDIO_X86_SIMD
+#include <immintrin.h>
+#elif defined __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+namespace IG::Audio
+{
+
+constexpr float i16Scale = 32768.f;
+
+static int16_t saturateToInt16(float s)
+{
+	return std::clamp(std::lrint(s), -32768l, 32767l);
+}
+
+// Scalar versions, also used for the remainder of the vector loops
+
+static float *convertI16ToFloatScalar(float * __restrict__ dest, const int16_t * __restrict__ src, size_t samples, float scale)
+{
+	return std::transform(src, src + samples, dest, [=](int16_t s){ return s * scale; });
+}
+
+static int16_t *convertFloatToI16Scalar(int16_t * __restrict__ dest, const float * __restrict__ src, size_t samples, float scale)
+{
+	return std::transform(src, src + samples, dest, [=](float s){ return saturateToInt16(s * scale); });
+}
+
+static float *scaleFloatScalar(float * __restrict__ dest, const float * __restrict__ src, size_t samples, float volume)
+{
+	return std::transform(src, src + samples, dest, [=](float s){ return s * volume; });
+}
+
+static int16_t *scaleI16Scalar(int16_t * __restrict__ dest, const int16_t * __restrict__ src, size_t samples, float volume)
+{
+	return std::transform(src, src + samples, dest, [=](int16_t s){ return saturateToInt16(s * volume); });
+}
+
+static int16_t *mergeStereoScalar(int16_t * __restrict__ dest, const int32_t *left, const int32_t *right, size_t frames)
+{
+	for(size_t i = 0; i < frames; i++)
+	{
+		*dest++ = std::clamp(left[i], -32768, 32767);
+		*dest++ = std::clamp(right[i], -32768, 32767);
+	}
+	return dest;
+}
+
+struct SampleKernels
+{
+	float *(*convertI16ToFloat)(float *, const int16_t *, size_t, float);
+	int16_t *(*convertFloatToI16)(int16_t *, const float *, size_t, float);
+	float *(*scaleFloat)(float *, const float *, size_t, float);
+	int16_t *(*scaleI16)(int16_t *, const int16_t *, size_t, float);
+	int16_t *(*mergeStereo)(int16_t *, const int32_t *, const int32_t *, size_t);
+	const char *name;
+};
+
+[[maybe_unused]] constexpr SampleKernels scalarKernels
+{
+	convertI16ToFloatScalar,
+	convertFloatToI16Scalar,
+	scaleFloatScalar,
+	scaleI16Scalar,
+	mergeStereoScalar,
+	"scalar"
+};
+
+#ifdef IG_AUDIO_X86_SIMD
+
+static __m128i floatToI16SSE2(__m128 lo, __m128 hi)
+{
+	// clamp before converting since out of range values become INT_MIN
+	auto min = _mm_set1_ps(-32768.f);
+	auto max = _mm_set1_ps(32767.f);
+	auto iLo = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(lo, min), max));
+	auto iHi = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(hi, min), max));
+	return _mm_packs_epi32(iLo, iHi);
+}
+
+static float *convertI16ToFloatSSE2(float * __restrict__ dest, const int16_t * __restrict__ src, size_t samples, float scale)
+{
+	auto vScale = _mm_set1_ps(scale);
+	size_t i = 0;
+	for(; i + 8 <= samples; i += 8)
+	{
+		auto v = _mm_loadu_si128((const __m128i*)(src + i));
+		auto lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		auto hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), vScale));
+		_mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vScale));
+	}
+	return convertI16ToFloatScalar(dest + i, src + i, samples - i, scale);
+}
+
+static int16_t *convertFloatToI16SSE2(int16_t * __restrict__ dest, const float * __restrict__ src, size_t samples, float scale)
+{
+	auto vScale = _mm_set1_ps(scale);
+	size_t i = 0;
+	for(; i + 8 <= samples; i += 8)
+	{
+		auto lo = _mm_mul_ps(_mm_loadu_ps(src + i), vScale);
+		auto hi = _mm_mul_ps(_mm_loadu_ps(src + i + 4), vScale);
+		_mm_storeu_si128((__m128i*)(dest + i), floatToI16SSE2(lo, hi));
+	}
+	return convertFloatToI16Scalar(dest + i, src + i, samples - i, scale);
+}
+
+static float *scaleFloatSSE2(float * __restrict__ dest, const float * __restrict__ src, size_t samples, float volume)
+{
+	auto vVolume = _mm_set1_ps(volume);
+	size_t i = 0;
+	for(; i + 4 <= samples; i += 4)
+	{
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_loadu_ps(src + i), vVolume));
+	}
+	return scaleFloatScalar(dest + i, src + i, samples - i, volume);
+}
+
+static int16_t *scaleI16SSE2(int16_t * __restrict__ dest, const int16_t * __restrict__ src, size_t samples, float volume)
+{
+	auto vVolume = _mm_set1_ps(volume);
+	size_t i = 0;
+	for(; i + 8 <= samples; i += 8)
+	{
+		auto v = _mm_loadu_si128((const __m128i*)(src + i));
+		auto lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+		auto hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+		_mm_storeu_si128((__m128i*)(dest + i), floatToI16SSE2(_mm_mul_ps(lo, vVolume), _mm_mul_ps(hi, vVolume)));
+	}
+	return scaleI16Scalar(dest + i, src + i, samples - i, volume);
+}
+
+static int16_t *mergeStereoSSE2(int16_t * __restrict__ dest, const int32_t *left, const int32_t *right, size_t frames)
+{
+	size_t i = 0;
+	for(; i + 4 <= frames; i += 4)
+	{
+		auto l = _mm_loadu_si128((const __m128i*)(left + i));
+		auto r = _mm_loadu_si128((const __m128i*)(right + i));
+		auto out = _mm_packs_epi32(_mm_unpacklo_epi32(l, r), _mm_unpackhi_epi32(l, r));
+		_mm_storeu_si128((__m128i*)(dest + i * 2), out);
+	}
+	return mergeStereoScalar(dest + i * 2, left + i, right + i, frames - i);
+}
+
+constexpr SampleKernels sse2Kernels
+{
+	convertI16ToFloatSSE2,
+	convertFloatToI16SSE2,
+	scaleFloatSSE2,
+	scaleI16SSE2,
+	mergeStereoSSE2,
+	"SSE2"
+};
+
+#define AVX2_FUNC [[gnu::target("avx2")]]
+
+AVX2_FUNC static __m256i floatToI16AVX2(__m256 lo, __m256 hi)
+{
+	auto min = _mm256_set1_ps(-32768.f);
+	auto max = _mm256_set1_ps(32767.f);
+	auto iLo = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(lo, min), max));
+	auto iHi = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(hi, min), max));
+	// packs works within 128-bit lanes, restore the sample order
+	return _mm256_permute4x64_epi64(_mm256_packs_epi32(iLo, iHi), 0xD8);
+}
+
+AVX2_FUNC static float *convertI16ToFloatAVX2(float * __restrict__ dest, const int16_t * __restrict__ src, size_t samples, float scale)
+{
+	auto vScale = _mm256_set1_ps(scale);
+	size_t i = 0;
+	for(; i + 16 <= samples; i += 16)
+	{
+		auto lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+		auto hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i + 8)));
+		_mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), vScale));
+		_mm256_storeu_ps(dest + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), vScale));
+	}
+	return convertI16ToFloatSSE2(dest + i, src + i, samples - i, scale);
+}
+
+AVX2_FUNC static int16_t *convertFloatToI16AVX2(int16_t * __restrict__ dest, const float * __restrict__ src, size_t samples, float scale)
+{
+	auto vScale = _mm256_set1_ps(scale);
+	size_t i = 0;
+	for(; i + 16 <= samples; i += 16)
+	{
+		auto lo = _mm256_mul_ps(_mm256_loadu_ps(src + i), vScale);
+		auto hi = _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), vScale);
+		_mm256_storeu_si256((__m256i*)(dest + i), floatToI16AVX2(lo, hi));
+	}
+	return convertFloatToI16SSE2(dest + i, src + i, samples - i, scale);
+}
+
+AVX2_FUNC static float *scaleFloatAVX2(float * __restrict__ dest, const float * __restrict__ src, size_t samples, float volume)
+{
+	auto vVolume = _mm256_set1_ps(volume);
+	size_t i = 0;
+	for(; i + 8 <= samples; i += 8)
+	{
+		_mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), vVolume));
+	}
+	return scaleFloatSSE2(dest + i, src + i, samples - i, volume);
+}
+
+AVX2_FUNC static int16_t *scaleI16AVX2(int16_t * __restrict__ dest, const int16_t * __restrict__ src, size_t samples, float volume)
+{
+	auto vVolume = _mm256_set1_ps(volume);
+	size_t i = 0;
+	for(; i + 16 <= samples; i += 16)
+	{
+		auto lo = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i))));
+		auto hi = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i + 8))));
+		_mm256_storeu_si256((__m256i*)(dest + i), floatToI16AVX2(_mm256_mul_ps(lo, vVolume), _mm256_mul_ps(hi, vVolume)));
+	}
+	return scaleI16SSE2(dest + i, src + i, samples - i, volume);
+}
+
+AVX2_FUNC static int16_t *mergeStereoAVX2(int16_t * __restrict__ dest, const int32_t *left, const int32_t *right, size_t frames)
+{
+	size_t i = 0;
+	for(; i + 8 <= frames; i += 8)
+	{
+		auto l = _mm256_loadu_si256((const __m256i*)(left + i));
+		auto r = _mm256_loadu_si256((const __m256i*)(right + i));
+		// unpack & packs both work within 128-bit lanes so the frames end up in order
+		auto out = _mm256_packs_epi32(_mm256_unpacklo_epi32(l, r), _mm256_unpackhi_epi32(l, r));
+		_mm256_storeu_si256((__m256i*)(dest + i * 2), out);
+	}
+	return mergeStereoSSE2(dest + i * 2, left + i, right + i, frames - i);
+}
+
+constexpr SampleKernels avx2Kernels
+{
+	convertI16ToFloatAVX2,
+	convertFloatToI16AVX2,
+	scaleFloatAVX2,
+	scaleI16AVX2,
+	mergeStereoAVX2,
+	"AVX2"
+};
+
+#undef AVX2_FUNC
+
+static const SampleKernels &kernels()
+{
+	static const SampleKernels &k = __builtin_cpu_supports("avx2") ? avx2Kernels : sse2Kernels;
+	return k;
+}
+
+#elif defined __ARM_NEON
+
+static int16x8_t floatToI16NEON(float32x4_t lo, float32x4_t hi)
+{
+	#if defined __aarch64__
+	auto iLo = vcvtnq_s32_f32(lo);
+	auto iHi = vcvtnq_s32_f32(hi);
+	#else
+	auto iLo = vcvtq_s32_f32(lo); // truncates, no round to nearest before ARMv8
+	auto iHi = vcvtq_s32_f32(hi);
+	#endif
+	return vcombine_s16(vqmovn_s32(iLo), vqmovn_s32(iHi));
+}
+
+static float *convertI16ToFloatNEON(float * __restrict__ dest, const int16_t * __restrict__ src, size_t samples, float scale)
+{
+	size_t i = 0;
+	for(; i + 8 <= samples; i += 8)
+	{
+		auto v = vld1q_s16(src + i);
+		vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+		vst1q_f32(dest + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+	}
+	return convertI16ToFloatScalar(dest + i, src + i, samples - i, scale);
+}
+
+static int16_t *convertFloatToI16NEON(int16_t * __restrict__ dest, const float * __restrict__ src, size_t samples, float scale)
+{
+	size_t i = 0;
+	for(; i + 8 <= samples; i += 8)
+	{
+		auto lo = vmulq_n_f32(vld1q_f32(src + i), scale);
+		auto hi = vmulq_n_f32(vld1q_f32(src + i + 4), scale);
+		vst1q_s16(dest + i, floatToI16NEON(lo, hi));
+	}
+	return convertFloatToI16Scalar(dest + i, src + i, samples - i, scale);
+}
+
+static float *scaleFloatNEON(float * __restrict__ dest, const float * __restrict__ src, size_t samples, float volume)
+{
+	size_t i = 0;
+	for(; i + 4 <= samples; i += 4)
+	{
+		vst1q_f32(dest + i, vmulq_n_f32(vld1q_f32(src + i), volume));
+	}
+	return scaleFloatScalar(dest + i, src + i, samples - i, volume);
+}
+
+static int16_t *scaleI16NEON(int16_t * __restrict__ dest, const int16_t * __restrict__ src, size_t samples, float volume)
+{
+	size_t i = 0;
+	for(; i + 8 <= samples; i += 8)
+	{
+		auto v = vld1q_s16(src + i);
+		auto lo = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), volume);
+		auto hi = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), volume);
+		vst1q_s16(dest + i, floatToI16NEON(lo, hi));
+	}
+	return scaleI16Scalar(dest + i, src + i, samples - i, volume);
+}
+
+static int16_t *mergeStereoNEON(int16_t * __restrict__ dest, const int32_t *left, const int32_t *right, size_t frames)
+{
+	size_t i = 0;
+	for(; i + 8 <= frames; i += 8)
+	{
+		int16x8x2_t out
+		{
+			vcombine_s16(vqmovn_s32(vld1q_s32(left + i)), vqmovn_s32(vld1q_s32(left + i + 4))),
+			vcombine_s16(vqmovn_s32(vld1q_s32(right + i)), vqmovn_s32(vld1q_s32(right + i + 4)))
+		};
+		vst2q_s16(dest + i * 2, out);
+	}
+	return mergeStereoScalar(dest + i * 2, left + i, right + i, frames - i);
+}
+
+constexpr SampleKernels neonKernels
+{
+	convertI16ToFloatNEON,
+	convertFloatToI16NEON,
+	scaleFloatNEON,
+	scaleI16NEON,
+	mergeStereoNEON,
+	"NEON"
+};
+
+static const SampleKernels &kernels() { return neonKernels; }
+
+#else
+
+static const SampleKernels &kernels() { return scalarKernels; }
+
+#endif
+
+float *convertSamples(float *dest, const int16_t *src, size_t samples, float volume)
+{
+	return kernels().convertI16ToFloat(dest, src, samples, volume / i16Scale);
+}
+
+int16_t *convertSamples(int16_t *dest, const float *src, size_t samples, float volume)
+{
+	return kernels().convertFloatToI16(dest, src, samples, volume * i16Scale);
+}
+
+float *scaleSamples(float *dest, const float *src, size_t samples, float volume)
+{
+	return kernels().scaleFloat(dest, src, samples, volume);
+}
+
+int16_t *scaleSamples(int16_t *dest, const int16_t *src, size_t samples, float volume)
+{
+	return kernels().scaleI16(dest, src, samples, volume);
+}
+
+int16_t *mergeStereoSamples(int16_t *dest, const int32_t *left, const int32_t *right, size_t frames)
+{
+	return kernels().mergeStereo(dest, left, right, frames);
+}
+
+const char *sampleConversionKernelName() { return kernels().name; }
+
+}
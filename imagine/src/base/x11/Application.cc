@@ -73,11 +73,18 @@ XApplication::XApplication(ApplicationInitParams initParams):
 	LinuxApplication{initParams},
 	supportedFrameTimer{testFrameTimers()}
 {
+	if(initParams.headless)
+	{
+		log.info("running headless, not opening X display");
+		return;
+	}
 	xEventSrc = makeXDisplayConnection(initParams.eventLoop);
 }
 
 XApplication::~XApplication()
 {
+	if(!dpy)
+		return;
 	deinitWindows();
 	deinitInputSystem();
 	log.info("closing X display");
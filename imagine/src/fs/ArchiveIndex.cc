@@ -0,0 +1,407 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/fs/ArchiveIndex.hh>
+#include <imagine/thread/JobSystem.hh>
+#include <imagine/logger/logger.h>
+#include <zlib.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <mutex>
+#include <ranges>
+
+namespace IG::FS
+{
+
+constexpr SystemLogger log{"ArchIndex"};
+
+constexpr uint32_t eocdSig = 0x06054b50;
+constexpr uint32_t zip64EocdSig = 0x06064b50;
+constexpr uint32_t zip64LocatorSig = 0x07064b50;
+constexpr uint32_t centralHeaderSig = 0x02014b50;
+constexpr uint32_t localHeaderSig = 0x04034b50;
+constexpr size_t eocdSize = 22;
+constexpr size_t centralHeaderSize = 46;
+constexpr size_t localHeaderSize = 30;
+constexpr uint16_t methodStored = 0;
+constexpr uint16_t methodDeflate = 8;
+
+static uint16_t readLE16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+static uint32_t readLE32(const uint8_t *p) { return readLE16(p) | (uint32_t(readLE16(p + 2)) << 16); }
+static uint64_t readLE64(const uint8_t *p) { return readLE32(p) | (uint64_t(readLE32(p + 4)) << 32); }
+
+ArchiveIndex::ArchiveIndex(IO io_):
+	io{std::move(io_)},
+	mapped{io.map()}
+{
+	if(!mapped.data() || !indexZip(mapped))
+	{
+		if(mapped.data())
+			arch = ArchiveIO{IO{MapIO{mapped}}};
+		else
+			arch = ArchiveIO{IO{std::move(io)}};
+		indexArchive();
+	}
+	makeMaps();
+}
+
+bool ArchiveIndex::indexZip(std::span<const uint8_t> data)
+{
+	if(data.size() < eocdSize)
+		return false;
+	// end of central directory is followed by a comment of up to 64KB
+	auto searchEnd = data.size() - std::min(data.size(), eocdSize + 0xFFFF);
+	ssize_t eocdPos = data.size() - eocdSize;
+	for(; eocdPos >= ssize_t(searchEnd); eocdPos--)
+	{
+		if(readLE32(&data[eocdPos]) == eocdSig)
+			break;
+	}
+	if(eocdPos < ssize_t(searchEnd))
+		return false;
+	auto eocd = &data[eocdPos];
+	uint64_t entryCount = readLE16(eocd + 10);
+	uint64_t dirSize = readLE32(eocd + 12);
+	uint64_t dirOffset = readLE32(eocd + 16);
+	if(entryCount == 0xFFFF || dirSize == 0xFFFFFFFF || dirOffset == 0xFFFFFFFF)
+	{
+		if(eocdPos < 20 || readLE32(eocd - 20) != zip64LocatorSig)
+			return false;
+		auto zip64EocdPos = readLE64(eocd - 20 + 8);
+		if(zip64EocdPos + 56 > data.size() || readLE32(&data[zip64EocdPos]) != zip64EocdSig)
+			return false;
+		auto zip64Eocd = &data[zip64EocdPos];
+		entryCount = readLE64(zip64Eocd + 32);
+		dirSize = readLE64(zip64Eocd + 40);
+		dirOffset = readLE64(zip64Eocd + 48);
+	}
+	if(dirOffset + dirSize > data.size())
+		return false;
+	auto dir = data.subspan(dirOffset, dirSize);
+	std::vector<Entry> newEntries;
+	newEntries.reserve(std::min(entryCount, uint64_t(dirSize / centralHeaderSize)));
+	size_t pos{};
+	for(uint64_t i = 0; i < entryCount; i++)
+	{
+		if(pos + centralHeaderSize > dir.size() || readLE32(&dir[pos]) != centralHeaderSig)
+			return false;
+		auto h = &dir[pos];
+		auto nameLen = readLE16(h + 28);
+		auto extraLen = readLE16(h + 30);
+		auto commentLen = readLE16(h + 32);
+		if(pos + centralHeaderSize + nameLen + extraLen + commentLen > dir.size())
+			return false;
+		Entry e
+		{
+			.name{reinterpret_cast<const char*>(h + centralHeaderSize), nameLen},
+			.size = readLE32(h + 24),
+			.compressedSize = readLE32(h + 20),
+			.localHeaderOffset = readLE32(h + 42),
+			.crc32 = readLE32(h + 16),
+			.method = readLE16(h + 10),
+		};
+		// zip64 extended info only has the fields that overflowed
+		for(auto extra = h + centralHeaderSize + nameLen, extraEnd = extra + extraLen; extra + 4 <= extraEnd;)
+		{
+			auto id = readLE16(extra);
+			auto fieldSize = readLE16(extra + 2);
+			auto field = extra + 4;
+			auto fieldEnd = std::min(field + fieldSize, extraEnd);
+			if(id == 0x0001)
+			{
+				auto readField = [&](size_t &v)
+				{
+					if(v != 0xFFFFFFFF || field + 8 > fieldEnd)
+						return;
+					v = readLE64(field);
+					field += 8;
+				};
+				readField(e.size);
+				readField(e.compressedSize);
+				readField(e.localHeaderOffset);
+				break;
+			}
+			extra = field + fieldSize;
+		}
+		e.type = e.name.ends_with('/') ? file_type::directory : file_type::regular;
+		bool encrypted = readLE16(h + 8) & 1;
+		e.randomAccess = e.type == file_type::regular && !encrypted &&
+			(e.method == methodStored || e.method == methodDeflate);
+		newEntries.emplace_back(std::move(e));
+		pos += centralHeaderSize + nameLen + extraLen + commentLen;
+	}
+	entries_ = std::move(newEntries);
+	log.info("indexed {} zip entries", entries_.size());
+	return true;
+}
+
+void ArchiveIndex::indexArchive()
+{
+	for(; arch.hasEntry(); arch.readNextEntry())
+	{
+		entries_.emplace_back(Entry
+		{
+			.name = std::string{arch.name()},
+			.size = arch.size(),
+			.crc32 = arch.crc32(),
+			.type = arch.type(),
+		});
+	}
+	log.info("indexed {} archive entries", entries_.size());
+}
+
+void ArchiveIndex::makeMaps()
+{
+	nameMap.reserve(entries_.size());
+	for(uint32_t i = 0; auto &e : entries_)
+	{
+		nameMap.try_emplace(e.name, i);
+		if(e.type == file_type::regular)
+			crcMap.try_emplace(e.crc32, i);
+		i++;
+	}
+}
+
+const ArchiveIndexEntry *ArchiveIndex::find(std::string_view name) const
+{
+	auto it = nameMap.find(name);
+	return it != nameMap.end() ? &entries_[it->second] : nullptr;
+}
+
+const ArchiveIndexEntry *ArchiveIndex::findCRC32(uint32_t crc) const
+{
+	auto it = crcMap.find(crc);
+	return it != crcMap.end() ? &entries_[it->second] : nullptr;
+}
+
+bool ArchiveIndex::read(const Entry &e, std::span<uint8_t> dest, size_t offset)
+{
+	ReadRequest req{&e, dest, offset};
+	return read(std::span{&req, 1});
+}
+
+static bool destinationsOverlap(std::span<const ArchiveIndex::ReadRequest> reqs)
+{
+	std::vector<std::span<uint8_t>> dests;
+	for(auto &r : reqs) { dests.emplace_back(r.dest); }
+	std::ranges::sort(dests, [](auto a, auto b){ return a.data() < b.data(); });
+	return std::ranges::adjacent_find(dests, [](auto a, auto b){ return a.data() + a.size() > b.data(); }) != dests.end();
+}
+
+static bool overlaps(std::span<uint8_t> a, std::span<uint8_t> b)
+{
+	return a.data() < b.data() + b.size() && b.data() < a.data() + a.size();
+}
+
+size_t ArchiveIndex::read(std::span<ReadRequest> reqs, JobSystem *jobSystem, OnReadDelegate onRead)
+{
+	for(auto &r : reqs)
+	{
+		r.ok = false;
+		r.bytesRead = 0;
+	}
+	if(destinationsOverlap(reqs))
+	{
+		// later requests may patch earlier ones, read each run of random access or
+		// sequential entries in turn without reordering
+		for(auto runBegin = reqs.begin(); runBegin != reqs.end();)
+		{
+			bool randomAccess = runBegin->entry->randomAccess;
+			auto runEnd = std::find_if(runBegin, reqs.end(), [&](auto &r){ return r.entry->randomAccess != randomAccess; });
+			if(randomAccess)
+			{
+				for(auto &r : std::ranges::subrange(runBegin, runEnd))
+				{
+					readRandomAccess(mapped, r);
+					if(onRead)
+						onRead(r);
+				}
+			}
+			else
+			{
+				std::vector<ReadRequest*> runReqs;
+				for(auto &r : std::ranges::subrange(runBegin, runEnd)) { runReqs.emplace_back(&r); }
+				readSequential(runReqs, true, onRead);
+			}
+			runBegin = runEnd;
+		}
+		return std::ranges::count_if(reqs, [](auto &r){ return r.ok; });
+	}
+	std::vector<ReadRequest*> randomReqs, sequentialReqs;
+	for(auto &r : reqs)
+	{
+		if(r.entry->randomAccess)
+			randomReqs.emplace_back(&r);
+		else
+			sequentialReqs.emplace_back(&r);
+	}
+	if(randomReqs.size())
+	{
+		std::mutex onReadMutex;
+		auto readRange = [&](int begin, int end)
+		{
+			for(int i = begin; i < end; i++)
+			{
+				readRandomAccess(mapped, *randomReqs[i]);
+				if(onRead)
+				{
+					std::scoped_lock lock{onReadMutex};
+					onRead(*randomReqs[i]);
+				}
+			}
+		};
+		if(jobSystem && randomReqs.size() > 1)
+			jobSystem->parallelFor(0, randomReqs.size(), 1, readRange);
+		else
+			readRange(0, randomReqs.size());
+	}
+	if(sequentialReqs.size())
+		readSequential(sequentialReqs, false, onRead);
+	return std::ranges::count_if(reqs, [](auto &r){ return r.ok; });
+}
+
+static bool inflateRaw(std::span<const uint8_t> src, std::span<uint8_t> dest, size_t skip, size_t &bytesRead)
+{
+	z_stream s{};
+	if(inflateInit2(&s, -MAX_WBITS) != Z_OK)
+		return false;
+	s.next_in = const_cast<z_const Bytef*>(src.data());
+	s.avail_in = src.size();
+	std::array<uint8_t, 32 * 1024> discard;
+	int res = Z_OK;
+	while(skip && res == Z_OK)
+	{
+		auto chunk = std::min(skip, discard.size());
+		s.next_out = discard.data();
+		s.avail_out = chunk;
+		res = inflate(&s, Z_NO_FLUSH);
+		skip -= chunk - s.avail_out;
+	}
+	if(!skip && res == Z_OK)
+	{
+		s.next_out = dest.data();
+		s.avail_out = dest.size();
+		res = inflate(&s, Z_FINISH);
+		bytesRead = dest.size() - s.avail_out;
+	}
+	inflateEnd(&s);
+	return !skip && (res == Z_STREAM_END || (res == Z_BUF_ERROR && !s.avail_out));
+}
+
+bool ArchiveIndex::readRandomAccess(std::span<const uint8_t> data, ReadRequest &r)
+{
+	auto &e = *r.entry;
+	if(r.offset > e.size || r.dest.size() > e.size - r.offset)
+		return false;
+	if(e.localHeaderOffset + localHeaderSize > data.size() ||
+		readLE32(&data[e.localHeaderOffset]) != localHeaderSig)
+	{
+		log.error("bad local header for:{}", e.name);
+		return false;
+	}
+	auto h = &data[e.localHeaderOffset];
+	auto dataOffset = e.localHeaderOffset + localHeaderSize + readLE16(h + 26) + readLE16(h + 28);
+	if(dataOffset + e.compressedSize > data.size())
+		return false;
+	auto src = data.subspan(dataOffset, e.compressedSize);
+	if(e.method == methodStored)
+	{
+		if(e.compressedSize != e.size)
+			return false;
+		std::ranges::copy(src.subspan(r.offset, r.dest.size()), r.dest.begin());
+		r.bytesRead = r.dest.size();
+	}
+	else if(!inflateRaw(src, r.dest, r.offset, r.bytesRead) || r.bytesRead != r.dest.size())
+	{
+		log.error("error decompressing:{}", e.name);
+		return false;
+	}
+	if(!r.offset && r.dest.size() == e.size &&
+		crc32_z(0, r.dest.data(), r.dest.size()) != e.crc32)
+	{
+		log.error("CRC mismatch in:{}", e.name);
+		return false;
+	}
+	return r.ok = true;
+}
+
+void ArchiveIndex::readSequential(std::span<ReadRequest *> reqs, bool keepOrder, OnReadDelegate onRead)
+{
+	if(!arch)
+		arch = ArchiveIO{IO{MapIO{mapped}}};
+	// requests for the same entry are served in offset order in one pass, any that
+	// start before the current read position wait for the next pass
+	if(!keepOrder)
+		std::ranges::stable_sort(reqs, [](auto a, auto b){ return a->offset < b->offset; });
+	std::vector<bool> attempted(reqs.size());
+	// with keepOrder, a request also waits until every earlier one writing to the same memory is done
+	auto waitsForEarlier = [&](size_t i)
+	{
+		if(!keepOrder)
+			return false;
+		for(size_t j = 0; j < i; j++)
+		{
+			if(!attempted[j] && overlaps(reqs[j]->dest, reqs[i]->dest))
+				return true;
+		}
+		return false;
+	};
+	std::array<uint8_t, 32 * 1024> discard;
+	for(bool progressed = true; progressed;)
+	{
+		progressed = false;
+		arch.rewind();
+		for(; arch.hasEntry(); arch.readNextEntry())
+		{
+			size_t pos{};
+			for(size_t i = 0; i < reqs.size(); i++)
+			{
+				auto &r = *reqs[i];
+				if(attempted[i] || r.entry->name != arch.name() || r.offset < pos || waitsForEarlier(i))
+					continue;
+				attempted[i] = progressed = true;
+				while(pos < r.offset)
+				{
+					auto bytes = arch.read(discard.data(), std::min(r.offset - pos, discard.size()));
+					if(bytes <= 0)
+						break;
+					pos += bytes;
+				}
+				if(pos != r.offset)
+				{
+					if(onRead)
+						onRead(r);
+					break;
+				}
+				auto bytes = arch.read(r.dest.data(), r.dest.size());
+				if(bytes >= 0)
+				{
+					r.bytesRead = bytes;
+					r.ok = size_t(bytes) == r.dest.size();
+					pos += bytes;
+				}
+				if(onRead)
+					onRead(r);
+				if(bytes < 0)
+					break;
+			}
+		}
+		if(std::ranges::all_of(attempted, [](bool a){ return a; }))
+			break;
+	}
+}
+
+}
@@ -33,8 +33,8 @@ namespace IG::Gfx
 
 static_assert((uint8_t)TextureBufferMode::DEFAULT == 0, "TextureBufferMode::DEFAULT != 0");
 
-Renderer::Renderer(ApplicationContext ctx):
-	GLRenderer{ctx}
+Renderer::Renderer(ApplicationContext ctx, bool headless):
+	GLRenderer{ctx, headless}
 {}
 
 Renderer::~Renderer()
@@ -46,11 +46,23 @@ Renderer::~Renderer()
 	}
 }
 
-GLRenderer::GLRenderer(ApplicationContext ctx):
-	glManager{ctx.nativeDisplayConnection(), glAPI},
+static GLManager makeGLManager(ApplicationContext ctx, bool headless)
+{
+	if(headless)
+		return {};
+	return {ctx.nativeDisplayConnection(), glAPI};
+}
+
+GLRenderer::GLRenderer(ApplicationContext ctx, bool headless):
+	glManager{makeGLManager(ctx, headless)},
 	mainTask{ctx, "Main GL Context Messages", *static_cast<Renderer*>(this)},
 	releaseShaderCompilerEvent{"GLRenderer::releaseShaderCompilerEvent"}
 {
+	if(headless)
+	{
+		logMsg("headless, skipped getting GL display");
+		return;
+	}
 	if(!glManager)
 	{
 		throw std::runtime_error("Renderer error getting GL display");
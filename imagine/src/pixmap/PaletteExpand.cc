@@ -0,0 +1,215 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/pixmap/PaletteExpand.hh>
+#include <algorithm>
+#include <array>
+#if defined __x86_64__ || defined __i386__
+#define IG_PALETTE_AVX2
+#include <immintrin.h>
+#elif defined __aarch64__ && defined __ARM_NEON
+#define IG_PALETTE_NEON_TBL
+#include <arm_neon.h>
+#endif
+
+namespace IG
+{
+
+// Calls func once per row, or once for the whole image when neither side has row padding
+static void forEachRow(auto *dest, int destPitch, const auto *src, int srcPitch, int w, int h, auto &&func)
+{
+	if(w == destPitch && w == srcPitch)
+	{
+		func(dest, src, w * h);
+		return;
+	}
+	for(int y = 0; y < h; y++)
+	{
+		func(dest, src, w);
+		dest += destPitch;
+		src += srcPitch;
+	}
+}
+
+template<class Src, class Dest>
+static void expandRowScalar(Dest * __restrict__ dest, const Src * __restrict__ src, int pixels, const Dest * __restrict__ palette)
+{
+	std::transform(src, src + pixels, dest, [=](Src p){ return palette[p]; });
+}
+
+template<class Src, class Dest>
+static void expandScalar(Dest *dest, int destPitch, const Src *src, int srcPitch, int w, int h, const Dest *palette)
+{
+	forEachRow(dest, destPitch, src, srcPitch, w, h,
+		[&](Dest *dest, const Src *src, int pixels){ expandRowScalar(dest, src, pixels, palette); });
+}
+
+#ifdef IG_PALETTE_AVX2
+
+// Gathers are only a win for 32-bit entries, a 16-bit palette would need 32-bit loads that
+// can read past the end of the table
+template<class Src>
+[[gnu::target("avx2")]]
+static void expandRowAVX2(uint32_t * __restrict__ dest, const Src * __restrict__ src, int pixels, const uint32_t * __restrict__ palette)
+{
+	int i = 0;
+	for(; i + 8 <= pixels; i += 8)
+	{
+		__m256i idx;
+		if constexpr(sizeof(Src) == 1)
+		{
+			idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i)));
+		}
+		else
+		{
+			idx = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+		}
+		_mm256_storeu_si256((__m256i*)(dest + i), _mm256_i32gather_epi32((const int*)palette, idx, 4));
+	}
+	expandRowScalar(dest + i, src + i, pixels - i, palette);
+}
+
+template<class Src>
+static void expand32(uint32_t *dest, int destPitch, const Src *src, int srcPitch, int w, int h, const uint32_t *palette)
+{
+	static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+	if(!hasAVX2)
+		return expandScalar(dest, destPitch, src, srcPitch, w, h, palette);
+	forEachRow(dest, destPitch, src, srcPitch, w, h,
+		[&](uint32_t *dest, const Src *src, int pixels){ expandRowAVX2(dest, src, pixels, palette); });
+}
+
+#else
+
+template<class Src>
+static void expand32(uint32_t *dest, int destPitch, const Src *src, int srcPitch, int w, int h, const uint32_t *palette)
+{
+	expandScalar(dest, destPitch, src, srcPitch, w, h, palette);
+}
+
+#endif
+
+#ifdef IG_PALETTE_NEON_TBL
+
+// A 256 entry palette split into byte planes of four 64-byte tables each, so TBL/TBX can look up
+// 16 pixels at a time per plane
+template<int planes>
+struct PalettePlanes
+{
+	std::array<std::array<uint8x16x4_t, 4>, planes> tables;
+
+	PalettePlanes(const auto *palette)
+	{
+		alignas(16) uint8_t bytes[planes][256];
+		for(int i = 0; i < 256; i++)
+		{
+			auto entry = palette[i];
+			for(int p = 0; p < planes; p++)
+			{
+				bytes[p][i] = entry >> (p * 8);
+			}
+		}
+		for(int p = 0; p < planes; p++)
+		{
+			for(int t = 0; t < 4; t++)
+			{
+				tables[p][t] = vld1q_u8_x4(&bytes[p][t * 64]);
+			}
+		}
+	}
+
+	uint8x16_t lookup(int plane, uint8x16_t idx) const
+	{
+		// out of range indices leave the previous result in place with TBX
+		auto offset = vdupq_n_u8(64);
+		auto v = vqtbl4q_u8(tables[plane][0], idx);
+		idx = vsubq_u8(idx, offset);
+		v = vqtbx4q_u8(v, tables[plane][1], idx);
+		idx = vsubq_u8(idx, offset);
+		v = vqtbx4q_u8(v, tables[plane][2], idx);
+		idx = vsubq_u8(idx, offset);
+		return vqtbx4q_u8(v, tables[plane][3], idx);
+	}
+};
+
+static void expand8(uint16_t *dest, int destPitch, const uint8_t *src, int srcPitch, int w, int h, const uint16_t *palette)
+{
+	const PalettePlanes<2> planes{palette};
+	forEachRow(dest, destPitch, src, srcPitch, w, h,
+		[&](uint16_t *dest, const uint8_t *src, int pixels)
+		{
+			int i = 0;
+			for(; i + 16 <= pixels; i += 16)
+			{
+				auto idx = vld1q_u8(src + i);
+				uint8x16x2_t out{planes.lookup(0, idx), planes.lookup(1, idx)};
+				vst2q_u8((uint8_t*)(dest + i), out);
+			}
+			expandRowScalar(dest + i, src + i, pixels - i, palette);
+		});
+}
+
+static void expand8(uint32_t *dest, int destPitch, const uint8_t *src, int srcPitch, int w, int h, const uint32_t *palette)
+{
+	const PalettePlanes<4> planes{palette};
+	forEachRow(dest, destPitch, src, srcPitch, w, h,
+		[&](uint32_t *dest, const uint8_t *src, int pixels)
+		{
+			int i = 0;
+			for(; i + 16 <= pixels; i += 16)
+			{
+				auto idx = vld1q_u8(src + i);
+				uint8x16x4_t out{planes.lookup(0, idx), planes.lookup(1, idx), planes.lookup(2, idx), planes.lookup(3, idx)};
+				vst4q_u8((uint8_t*)(dest + i), out);
+			}
+			expandRowScalar(dest + i, src + i, pixels - i, palette);
+		});
+}
+
+#else
+
+static void expand8(uint16_t *dest, int destPitch, const uint8_t *src, int srcPitch, int w, int h, const uint16_t *palette)
+{
+	expandScalar(dest, destPitch, src, srcPitch, w, h, palette);
+}
+
+static void expand8(uint32_t *dest, int destPitch, const uint8_t *src, int srcPitch, int w, int h, const uint32_t *palette)
+{
+	expand32(dest, destPitch, src, srcPitch, w, h, palette);
+}
+
+#endif
+
+void expandPalette(uint16_t *dest, int destPitch, const uint8_t *src, int srcPitch, int w, int h, const uint16_t *palette)
+{
+	expand8(dest, destPitch, src, srcPitch, w, h, palette);
+}
+
+void expandPalette(uint32_t *dest, int destPitch, const uint8_t *src, int srcPitch, int w, int h, const uint32_t *palette)
+{
+	expand8(dest, destPitch, src, srcPitch, w, h, palette);
+}
+
+void expandPalette(uint16_t *dest, int destPitch, const uint16_t *src, int srcPitch, int w, int h, const uint16_t *palette)
+{
+	expandScalar(dest, destPitch, src, srcPitch, w, h, palette);
+}
+
+void expandPalette(uint32_t *dest, int destPitch, const uint16_t *src, int srcPitch, int w, int h, const uint32_t *palette)
+{
+	expand32(dest, destPitch, src, srcPitch, w, h, palette);
+}
+
+}
@@ -0,0 +1,364 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/pixmap/PixelConvert.hh>
+#include <imagine/pixmap/Pixmap.hh>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#if defined __x86_64__ || defined __i386__
+#define IG_PIXEL_CONVERT_SSSE3
+#include <immintrin.h>
+#elif defined __ARM_NEON
+#define IG_PIXEL_CONVERT_NEON
+#include <arm_neon.h>
+#endif
+
+namespace IG
+{
+
+// Memory layouts the SIMD paths read & write. Channels are handled in memory byte order for
+// RGB888 & X8888 and as red, green, blue for RGB565.
+enum class Layout : uint8_t { RGB565, RGB888, X8888 };
+
+template<Layout l>
+constexpr int layoutBytes = l == Layout::RGB565 ? 2 : l == Layout::RGB888 ? 3 : 4;
+
+// Division by multiplying with the high half of a 16-bit product and shifting, exact over the
+// range of inputs used by the transform*() functions
+constexpr uint16_t div31Mul = 8457, div31Shift = 2; // x <= 31 * 255 + 15
+constexpr uint16_t div63Mul = 16645, div63Shift = 4; // x <= 63 * 255 + 31
+constexpr uint16_t div255Mul = 16449, div255Shift = 6; // x <= 63 * 255 + 127
+constexpr uint16_t div510Mul = 16449, div510Shift = 7; // x <= 62 * 255 + 255
+
+using RowConvertFunc = void(*)(char *dest, const char *src, int pixels);
+
+template<class F> struct TransformTypes;
+template<class D, class S> struct TransformTypes<D(*)(S)> { using Src = S; using Dest = D; };
+
+template<auto transform>
+static void convertRowScalar(char *dest, const char *src, int pixels)
+{
+	using Src = typename TransformTypes<decltype(transform)>::Src;
+	using Dest = typename TransformTypes<decltype(transform)>::Dest;
+	for(int i = 0; i < pixels; i++)
+	{
+		Src s;
+		std::memcpy(&s, src + i * sizeof(Src), sizeof(Src));
+		Dest d = transform(s);
+		std::memcpy(dest + i * sizeof(Dest), &d, sizeof(Dest));
+	}
+}
+
+#ifdef IG_PIXEL_CONVERT_SSSE3
+
+#define SSSE3_FUNC [[gnu::target("ssse3")]]
+
+// 8 pixels with one channel per 16-bit lane
+struct Channels
+{
+	__m128i c0, c1, c2;
+};
+
+SSSE3_FUNC static __m128i divideU16(__m128i x, uint16_t mul, int shift)
+{
+	return _mm_srli_epi16(_mm_mulhi_epu16(x, _mm_set1_epi16(mul)), shift);
+}
+
+SSSE3_FUNC static __m128i mulAddU16(__m128i x, uint16_t mul, uint16_t add)
+{
+	return _mm_add_epi16(_mm_mullo_epi16(x, _mm_set1_epi16(mul)), _mm_set1_epi16(add));
+}
+
+SSSE3_FUNC static Channels channelsFromX8888(__m128i lo, __m128i hi)
+{
+	auto mask = _mm_set1_epi32(0xFF);
+	auto channel = [&](int shift)
+	{
+		return _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, shift), mask), _mm_and_si128(_mm_srli_epi32(hi, shift), mask));
+	};
+	return {channel(0), channel(8), channel(16)};
+}
+
+template<Layout l>
+SSSE3_FUNC static Channels readPixels(const char *src)
+{
+	if constexpr(l == Layout::RGB565)
+	{
+		auto v = _mm_loadu_si128((const __m128i*)src);
+		auto r = _mm_srli_epi16(v, 11);
+		auto g = _mm_and_si128(_mm_srli_epi16(v, 5), _mm_set1_epi16(0x3F));
+		auto b = _mm_and_si128(v, _mm_set1_epi16(0x1F));
+		return
+		{
+			divideU16(mulAddU16(r, 255, 15), div31Mul, div31Shift),
+			divideU16(mulAddU16(g, 255, 31), div63Mul, div63Shift),
+			divideU16(mulAddU16(b, 255, 15), div31Mul, div31Shift),
+		};
+	}
+	else if constexpr(l == Layout::RGB888)
+	{
+		// reads 4 bytes past the 8 pixels
+		auto expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		auto lo = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src), expand);
+		auto hi = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 12)), expand);
+		return channelsFromX8888(lo, hi);
+	}
+	else
+	{
+		return channelsFromX8888(_mm_loadu_si128((const __m128i*)src), _mm_loadu_si128((const __m128i*)(src + 16)));
+	}
+}
+
+template<Layout l>
+SSSE3_FUNC static void writePixels(char *dest, Channels c)
+{
+	if constexpr(l == Layout::RGB565)
+	{
+		auto r = divideU16(mulAddU16(c.c0, 62, 255), div510Mul, div510Shift);
+		auto g = divideU16(mulAddU16(c.c1, 63, 127), div255Mul, div255Shift);
+		auto b = divideU16(mulAddU16(c.c2, 31, 127), div255Mul, div255Shift);
+		_mm_storeu_si128((__m128i*)dest, _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11), _mm_slli_epi16(g, 5)), b));
+	}
+	else
+	{
+		auto c01 = _mm_or_si128(c.c0, _mm_slli_epi16(c.c1, 8));
+		auto lo = _mm_unpacklo_epi16(c01, c.c2);
+		auto hi = _mm_unpackhi_epi16(c01, c.c2);
+		if constexpr(l == Layout::RGB888)
+		{
+			auto pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+			lo = _mm_shuffle_epi8(lo, pack);
+			hi = _mm_shuffle_epi8(hi, pack);
+			_mm_storeu_si128((__m128i*)dest, _mm_or_si128(lo, _mm_slli_si128(hi, 12)));
+			_mm_storel_epi64((__m128i*)(dest + 16), _mm_srli_si128(hi, 4));
+		}
+		else
+		{
+			_mm_storeu_si128((__m128i*)dest, lo);
+			_mm_storeu_si128((__m128i*)(dest + 16), hi);
+		}
+	}
+}
+
+template<Layout srcLayout, Layout destLayout, bool swapRB, auto transform>
+SSSE3_FUNC static void convertRowSIMD(char *dest, const char *src, int pixels)
+{
+	constexpr int srcBytes = layoutBytes<srcLayout>;
+	constexpr int destBytes = layoutBytes<destLayout>;
+	// keep the over-read of RGB888 sources inside the row
+	constexpr int srcSlack = srcLayout == Layout::RGB888 ? 2 : 0;
+	int i = 0;
+	for(; i + 8 + srcSlack <= pixels; i += 8)
+	{
+		auto c = readPixels<srcLayout>(src + i * srcBytes);
+		if constexpr(swapRB)
+			std::swap(c.c0, c.c2);
+		writePixels<destLayout>(dest + i * destBytes, c);
+	}
+	convertRowScalar<transform>(dest + i * destBytes, src + i * srcBytes, pixels - i);
+}
+
+SSSE3_FUNC static void swapRBRowSIMD(char *dest, const char *src, int pixels)
+{
+	auto swap = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	int i = 0;
+	for(; i + 4 <= pixels; i += 4)
+	{
+		_mm_storeu_si128((__m128i*)(dest + i * 4), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + i * 4)), swap));
+	}
+	convertRowScalar<transformRGBA8888ToBGRA8888>(dest + i * 4, src + i * 4, pixels - i);
+}
+
+#undef SSSE3_FUNC
+
+static bool hasSIMD()
+{
+	static const bool hasSSSE3 = __builtin_cpu_supports("ssse3");
+	return hasSSSE3;
+}
+
+#elif defined IG_PIXEL_CONVERT_NEON
+
+// 8 pixels with one channel per 8-bit lane
+struct Channels
+{
+	uint8x8_t c0, c1, c2;
+};
+
+static uint16x8_t divideU16(uint16x8_t x, uint16_t mul, int shift)
+{
+	auto lo = vshrn_n_u32(vmull_n_u16(vget_low_u16(x), mul), 16);
+	auto hi = vshrn_n_u32(vmull_n_u16(vget_high_u16(x), mul), 16);
+	return vshlq_u16(vcombine_u16(lo, hi), vdupq_n_s16(-shift));
+}
+
+static uint16x8_t mulAddU16(uint16x8_t x, uint16_t mul, uint16_t add)
+{
+	return vmlaq_n_u16(vdupq_n_u16(add), x, mul);
+}
+
+template<Layout l>
+static Channels readPixels(const char *src)
+{
+	if constexpr(l == Layout::RGB565)
+	{
+		auto v = vld1q_u16((const uint16_t*)src);
+		auto r = vshrq_n_u16(v, 11);
+		auto g = vandq_u16(vshrq_n_u16(v, 5), vdupq_n_u16(0x3F));
+		auto b = vandq_u16(v, vdupq_n_u16(0x1F));
+		return
+		{
+			vmovn_u16(divideU16(mulAddU16(r, 255, 15), div31Mul, div31Shift)),
+			vmovn_u16(divideU16(mulAddU16(g, 255, 31), div63Mul, div63Shift)),
+			vmovn_u16(divideU16(mulAddU16(b, 255, 15), div31Mul, div31Shift)),
+		};
+	}
+	else if constexpr(l == Layout::RGB888)
+	{
+		auto v = vld3_u8((const uint8_t*)src);
+		return {v.val[0], v.val[1], v.val[2]};
+	}
+	else
+	{
+		auto v = vld4_u8((const uint8_t*)src);
+		return {v.val[0], v.val[1], v.val[2]};
+	}
+}
+
+template<Layout l>
+static void writePixels(char *dest, Channels c)
+{
+	if constexpr(l == Layout::RGB565)
+	{
+		auto r = divideU16(mulAddU16(vmovl_u8(c.c0), 62, 255), div510Mul, div510Shift);
+		auto g = divideU16(mulAddU16(vmovl_u8(c.c1), 63, 127), div255Mul, div255Shift);
+		auto b = divideU16(mulAddU16(vmovl_u8(c.c2), 31, 127), div255Mul, div255Shift);
+		vst1q_u16((uint16_t*)dest, vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), b));
+	}
+	else if constexpr(l == Layout::RGB888)
+	{
+		vst3_u8((uint8_t*)dest, uint8x8x3_t{c.c0, c.c1, c.c2});
+	}
+	else
+	{
+		vst4_u8((uint8_t*)dest, uint8x8x4_t{c.c0, c.c1, c.c2, vdup_n_u8(0)});
+	}
+}
+
+template<Layout srcLayout, Layout destLayout, bool swapRB, auto transform>
+static void convertRowSIMD(char *dest, const char *src, int pixels)
+{
+	constexpr int srcBytes = layoutBytes<srcLayout>;
+	constexpr int destBytes = layoutBytes<destLayout>;
+	int i = 0;
+	for(; i + 8 <= pixels; i += 8)
+	{
+		auto c = readPixels<srcLayout>(src + i * srcBytes);
+		if constexpr(swapRB)
+			std::swap(c.c0, c.c2);
+		writePixels<destLayout>(dest + i * destBytes, c);
+	}
+	convertRowScalar<transform>(dest + i * destBytes, src + i * srcBytes, pixels - i);
+}
+
+static void swapRBRowSIMD(char *dest, const char *src, int pixels)
+{
+	int i = 0;
+	for(; i + 16 <= pixels; i += 16)
+	{
+		auto v = vld4q_u8((const uint8_t*)(src + i * 4));
+		std::swap(v.val[0], v.val[2]);
+		vst4q_u8((uint8_t*)(dest + i * 4), v);
+	}
+	convertRowScalar<transformRGBA8888ToBGRA8888>(dest + i * 4, src + i * 4, pixels - i);
+}
+
+static bool hasSIMD() { return true; }
+
+#else
+
+template<Layout srcLayout, Layout destLayout, bool swapRB, auto transform>
+static void convertRowSIMD(char *dest, const char *src, int pixels)
+{
+	convertRowScalar<transform>(dest, src, pixels);
+}
+
+static void swapRBRowSIMD(char *dest, const char *src, int pixels)
+{
+	convertRowScalar<transformRGBA8888ToBGRA8888>(dest, src, pixels);
+}
+
+static bool hasSIMD() { return false; }
+
+#endif
+
+struct RowConversion
+{
+	PixelFormatID dest, src;
+	RowConvertFunc scalar, simd;
+};
+
+template<Layout srcLayout, Layout destLayout, bool swapRB, auto transform>
+constexpr RowConversion rowConversion(PixelFormatID dest, PixelFormatID src)
+{
+	return {dest, src, convertRowScalar<transform>, convertRowSIMD<srcLayout, destLayout, swapRB, transform>};
+}
+
+using enum Layout;
+
+// mirrors the cases handled by PixmapViewBase::writeConverted() before it used this function
+constexpr RowConversion rowConversions[]
+{
+	{PIXEL_RGBA8888, PIXEL_BGRA8888, convertRowScalar<transformRGBA8888ToBGRA8888>, swapRBRowSIMD},
+	{PIXEL_BGRA8888, PIXEL_RGBA8888, convertRowScalar<transformRGBA8888ToBGRA8888>, swapRBRowSIMD},
+	rowConversion<RGB565, X8888, false, transformRGB565ToRGBX8888>(PIXEL_RGBA8888, PIXEL_RGB565),
+	rowConversion<RGB565, X8888, true, transformRGB565ToBGRX8888>(PIXEL_BGRA8888, PIXEL_RGB565),
+	rowConversion<RGB888, X8888, true, transformRGB888ToRGBX8888>(PIXEL_RGBA8888, PIXEL_RGB888),
+	rowConversion<RGB888, X8888, false, transformRGB888ToBGRX8888>(PIXEL_BGRA8888, PIXEL_RGB888),
+	rowConversion<X8888, RGB888, false, transformRGBX8888ToRGB888>(PIXEL_RGB888, PIXEL_RGBA8888),
+	rowConversion<X8888, RGB888, true, transformBGRX8888ToRGB888>(PIXEL_RGB888, PIXEL_BGRA8888),
+	rowConversion<RGB565, RGB888, false, transformRGB565ToRGB888>(PIXEL_RGB888, PIXEL_RGB565),
+	rowConversion<X8888, RGB565, false, transformRGBX8888ToRGB565>(PIXEL_RGB565, PIXEL_RGBA8888),
+	rowConversion<X8888, RGB565, true, transformBGRX8888ToRGB565>(PIXEL_RGB565, PIXEL_BGRA8888),
+	rowConversion<RGB888, RGB565, false, transformRGB888ToRGB565>(PIXEL_RGB565, PIXEL_RGB888),
+};
+
+bool convertPixels(PixelFormatID destFormat, void *dest, int destPitch,
+	PixelFormatID srcFormat, const void *src, int srcPitch, int w, int h)
+{
+	auto it = std::ranges::find_if(rowConversions, [&](auto &c){ return c.dest == destFormat && c.src == srcFormat; });
+	if(it == std::end(rowConversions))
+		return false;
+	auto convertRow = hasSIMD() ? it->simd : it->scalar;
+	auto destData = static_cast<char*>(dest);
+	auto srcData = static_cast<const char*>(src);
+	int destRowBytes = w * PixelFormat{destFormat}.bytesPerPixel();
+	int srcRowBytes = w * PixelFormat{srcFormat}.bytesPerPixel();
+	if(destPitch == destRowBytes && srcPitch == srcRowBytes)
+	{
+		convertRow(destData, srcData, w * h);
+		return true;
+	}
+	for(int y = 0; y < h; y++)
+	{
+		convertRow(destData, srcData, w);
+		destData += destPitch;
+		srcData += srcPitch;
+	}
+	return true;
+}
+
+}
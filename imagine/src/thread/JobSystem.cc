@@ -0,0 +1,245 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/thread/JobSystem.hh>
+#include <imagine/logger/logger.h>
+#include <algorithm>
+#include <bit>
+
+namespace IG
+{
+
+constexpr SystemLogger log{"JobSystem"};
+
+struct WorkerSlot
+{
+	const JobSystem *system{};
+	int idx{-1};
+};
+
+static thread_local WorkerSlot thisWorker;
+
+void JobSystem::start(int threadCount)
+{
+	stop();
+	if(threadCount <= 0)
+	{
+		log.info("no worker threads, running jobs inline");
+		return;
+	}
+	quit.store(false, std::memory_order_relaxed);
+	queuedJobs.store(0, std::memory_order_relaxed);
+	workers.reserve(threadCount);
+	for(int i = 0; i < threadCount; i++)
+	{
+		workers.emplace_back(std::make_unique<Worker>());
+	}
+	for(int i = 0; i < threadCount; i++)
+	{
+		workers[i]->thread = makeThreadSync(
+			[this, i](auto &sem)
+			{
+				workers[i]->id = thisThreadId();
+				thisWorker = {this, i};
+				sem.release();
+				runWorker(i);
+			});
+	}
+	log.info("started {} worker threads", threadCount);
+}
+
+void JobSystem::stop()
+{
+	if(workers.empty())
+		return;
+	quit.store(true, std::memory_order_relaxed);
+	// bump the counter so idle workers see a change and re-check the quit flag
+	queuedJobs.fetch_add(1, std::memory_order_release);
+	queuedJobs.notify_all();
+	for(auto &w : workers)
+	{
+		w->thread.join();
+	}
+	workers.clear();
+}
+
+std::vector<ThreadId> JobSystem::threadIds() const
+{
+	std::vector<ThreadId> ids;
+	ids.reserve(workers.size());
+	for(const auto &w : workers)
+	{
+		ids.emplace_back(w->id);
+	}
+	return ids;
+}
+
+void JobSystem::setCPUAffinityMask(CPUMask mask)
+{
+	if(workers.empty())
+		return;
+	setThreadCPUAffinityMask(threadIds(), mask);
+}
+
+int JobSystem::currentWorkerIndex() const
+{
+	return thisWorker.system == this ? thisWorker.idx : -1;
+}
+
+void JobSystem::submit(JobDelegate job, JobPriority priority)
+{
+	if(workers.empty())
+	{
+		job();
+		return;
+	}
+	// keep jobs from a worker local to it, otherwise spread them out
+	auto idx = currentWorkerIndex();
+	if(idx == -1)
+		idx = nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+	{
+		auto &w = *workers[idx];
+		std::scoped_lock lock{w.mutex};
+		w.queues[std::to_underlying(priority)].emplace_back(job);
+	}
+	queuedJobs.fetch_add(1, std::memory_order_release);
+	queuedJobs.notify_one();
+}
+
+std::optional<JobDelegate> JobSystem::takeJob(int selfIdx)
+{
+	if(queuedJobs.load(std::memory_order_acquire) <= 0)
+		return {};
+	const int count = workers.size();
+	for(int prio = 0; prio < priorities; prio++)
+	{
+		if(selfIdx != -1)
+		{
+			auto &w = *workers[selfIdx];
+			std::scoped_lock lock{w.mutex};
+			if(auto &q = w.queues[prio]; !q.empty())
+			{
+				auto job = q.back();
+				q.pop_back();
+				queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+				return job;
+			}
+		}
+		for(int i = 0; i < count; i++)
+		{
+			auto victimIdx = (selfIdx + 1 + i) % count;
+			if(victimIdx == selfIdx)
+				continue;
+			auto &w = *workers[victimIdx];
+			std::scoped_lock lock{w.mutex};
+			if(auto &q = w.queues[prio]; !q.empty())
+			{
+				auto job = q.front();
+				q.pop_front();
+				queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+				return job;
+			}
+		}
+	}
+	return {};
+}
+
+void JobSystem::runWorker(int idx)
+{
+	while(true)
+	{
+		if(auto job = takeJob(idx); job)
+		{
+			(*job)();
+			continue;
+		}
+		if(quit.load(std::memory_order_relaxed))
+			break;
+		queuedJobs.wait(0, std::memory_order_acquire);
+	}
+}
+
+struct ParallelForState
+{
+	std::atomic_int nextChunk{};
+	std::atomic_int doneChunks{};
+	std::atomic_int refs{};
+	int begin{}, end{}, grainSize{}, chunks{};
+	JobRangeDelegate func;
+
+	void runChunks()
+	{
+		while(true)
+		{
+			auto chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+			if(chunk >= chunks)
+				return;
+			auto chunkBegin = begin + chunk * grainSize;
+			func(chunkBegin, std::min(chunkBegin + grainSize, end));
+			if(doneChunks.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks)
+				doneChunks.notify_all();
+		}
+	}
+
+	static void unref(ParallelForState *state)
+	{
+		if(state->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			delete state;
+	}
+};
+
+void JobSystem::parallelFor(int begin, int end, int grainSize, JobRangeDelegate func)
+{
+	if(end <= begin)
+		return;
+	grainSize = std::max(grainSize, 1);
+	const int chunks = (end - begin + grainSize - 1) / grainSize;
+	if(chunks == 1 || workers.empty())
+	{
+		func(begin, end);
+		return;
+	}
+	// The state is ref-counted since helper jobs may start after all chunks are taken and the
+	// caller has returned. Those helpers never touch func.
+	const int helpers = std::min(threads(), chunks - 1);
+	auto state = new ParallelForState{.refs{helpers + 1}, .begin = begin, .end = end,
+		.grainSize = grainSize, .chunks = chunks, .func = func};
+	for(int i = 0; i < helpers; i++)
+	{
+		submit([state]()
+		{
+			state->runChunks();
+			ParallelForState::unref(state);
+		}, JobPriority::high);
+	}
+	state->runChunks();
+	// remaining chunks are already running on workers
+	while(true)
+	{
+		auto done = state->doneChunks.load(std::memory_order_acquire);
+		if(done == chunks)
+			break;
+		state->doneChunks.wait(done, std::memory_order_acquire);
+	}
+	ParallelForState::unref(state);
+}
+
+int JobSystem::threadCountForMask(CPUMask mask, int cpuCount)
+{
+	auto cpus = mask ? std::popcount(mask) : cpuCount;
+	return std::max(cpus - 1, 0);
+}
+
+}
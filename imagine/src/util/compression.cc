@@ -0,0 +1,578 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/util/compression.hh>
+#include <imagine/util/zlib.hh>
+#include <imagine/logger/logger.h>
+#include <lzma.h>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <algorithm>
+#include <optional>
+#include <new>
+
+namespace IG
+{
+
+constexpr SystemLogger log{"Compression"};
+
+constexpr size_t headerSize = 8;
+constexpr std::array<uint8_t, 4> lz4Magic{0x89, 'L', 'Z', '4'};
+constexpr std::array<uint8_t, 4> lzmaMagic{0x89, 'X', 'Z', 0};
+constexpr uint32_t maxLZMADictSize = 8 * 1024 * 1024;
+
+static uint32_t readLE32(const uint8_t *p)
+{
+	uint32_t v;
+	std::memcpy(&v, p, 4);
+	if constexpr(std::endian::native == std::endian::big)
+		return std::byteswap(v);
+	return v;
+}
+
+static void writeLE32(uint8_t *p, uint32_t v)
+{
+	if constexpr(std::endian::native == std::endian::big)
+		v = std::byteswap(v);
+	std::memcpy(p, &v, 4);
+}
+
+static bool hasMagic(std::span<const uint8_t> buff, std::span<const uint8_t, 4> magic)
+{
+	return buff.size() >= headerSize && std::equal(magic.begin(), magic.end(), buff.begin());
+}
+
+static size_t writeHeader(std::span<uint8_t> dest, std::span<const uint8_t, 4> magic, size_t srcSize)
+{
+	if(dest.size() < headerSize || srcSize > UINT32_MAX)
+		return 0;
+	std::ranges::copy(magic, dest.begin());
+	writeLE32(dest.data() + 4, srcSize);
+	return headerSize;
+}
+
+static voidpf zAlloc(voidpf opaque, uInt items, uInt size)
+{
+	auto &a = *static_cast<const CompressionAllocator*>(opaque);
+	return a.alloc(a.ctx, size_t(items) * size);
+}
+
+static void zFree(voidpf opaque, voidpf ptr)
+{
+	auto &a = *static_cast<const CompressionAllocator*>(opaque);
+	a.free(a.ctx, ptr);
+}
+
+static void setAllocator(z_stream &s, const CompressionAllocator *a)
+{
+	if(!a)
+		return;
+	s.zalloc = zAlloc;
+	s.zfree = zFree;
+	s.opaque = const_cast<CompressionAllocator*>(a);
+}
+
+static void *lzmaAlloc(void *opaque, size_t nmemb, size_t size)
+{
+	auto &a = *static_cast<const CompressionAllocator*>(opaque);
+	return a.alloc(a.ctx, nmemb * size);
+}
+
+static void lzmaFree(void *opaque, void *ptr)
+{
+	auto &a = *static_cast<const CompressionAllocator*>(opaque);
+	a.free(a.ctx, ptr);
+}
+
+static lzma_allocator lzmaAllocator(const CompressionAllocator *a)
+{
+	return {lzmaAlloc, lzmaFree, const_cast<CompressionAllocator*>(a)};
+}
+
+// LZ4 block format, see https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+
+namespace LZ4
+{
+
+constexpr size_t minMatch = 4;
+constexpr size_t lastLiterals = 5; // last 5 bytes of a block are always literals
+constexpr size_t matchFindLimit = 12; // last match must start at least 12 bytes before the end
+constexpr int hashLog = 14;
+constexpr size_t maxDistance = 0xFFFF;
+
+static uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+	std::memcpy(&v, p, 4);
+	return v;
+}
+
+static uint32_t hash(uint32_t v)
+{
+	return (v * 2654435761u) >> (32 - hashLog);
+}
+
+static size_t matchLength(const uint8_t *ip, const uint8_t *ref, const uint8_t *limit)
+{
+	auto start = ip;
+	if constexpr(std::endian::native == std::endian::little)
+	{
+		while(ip + 8 <= limit)
+		{
+			uint64_t a, b;
+			std::memcpy(&a, ip, 8);
+			std::memcpy(&b, ref, 8);
+			if(auto diff = a ^ b; diff)
+				return (ip - start) + (std::countr_zero(diff) >> 3);
+			ip += 8;
+			ref += 8;
+		}
+	}
+	while(ip < limit && *ip == *ref)
+	{
+		ip++;
+		ref++;
+	}
+	return ip - start;
+}
+
+static uint8_t *writeLength(uint8_t *op, const uint8_t *opEnd, size_t len)
+{
+	while(len >= 255)
+	{
+		if(op == opEnd)
+			return nullptr;
+		*op++ = 255;
+		len -= 255;
+	}
+	if(op == opEnd)
+		return nullptr;
+	*op++ = len;
+	return op;
+}
+
+static uint8_t *writeSequence(uint8_t *op, const uint8_t *opEnd, const uint8_t *literals, size_t litLen,
+	size_t offset, size_t matchLen)
+{
+	if(op == opEnd)
+		return nullptr;
+	auto token = op++;
+	*token = std::min(litLen, size_t(15)) << 4;
+	if(litLen >= 15 && !(op = writeLength(op, opEnd, litLen - 15)))
+		return nullptr;
+	if(size_t(opEnd - op) < litLen)
+		return nullptr;
+	if(litLen)
+		std::memcpy(op, literals, litLen);
+	op += litLen;
+	if(!matchLen) // final literal run
+		return op;
+	if(opEnd - op < 2)
+		return nullptr;
+	*op++ = offset & 0xFF;
+	*op++ = offset >> 8;
+	matchLen -= minMatch;
+	*token |= std::min(matchLen, size_t(15));
+	if(matchLen >= 15 && !(op = writeLength(op, opEnd, matchLen - 15)))
+		return nullptr;
+	return op;
+}
+
+static size_t compress(std::span<uint8_t> dest, std::span<const uint8_t> src)
+{
+	const auto srcBegin = src.data();
+	const auto srcEnd = srcBegin + src.size();
+	auto op = dest.data();
+	const auto opEnd = op + dest.size();
+	auto anchor = srcBegin;
+	if(src.size() > matchFindLimit)
+	{
+		std::array<uint32_t, 1 << hashLog> table{};
+		const auto matchSearchEnd = srcEnd - matchFindLimit;
+		const auto matchEnd = srcEnd - lastLiterals;
+		auto ip = srcBegin + 1;
+		unsigned misses = 0;
+		while(ip < matchSearchEnd)
+		{
+			auto seq = read32(ip);
+			auto &entry = table[hash(seq)];
+			auto ref = srcBegin + entry;
+			entry = ip - srcBegin;
+			if(ref >= ip || size_t(ip - ref) > maxDistance || read32(ref) != seq)
+			{
+				// skip ahead faster through data that doesn't compress
+				ip += 1 + (misses++ >> 6);
+				continue;
+			}
+			misses = 0;
+			while(ip > anchor && ref > srcBegin && ip[-1] == ref[-1])
+			{
+				ip--;
+				ref--;
+			}
+			auto len = minMatch + matchLength(ip + minMatch, ref + minMatch, matchEnd);
+			op = writeSequence(op, opEnd, anchor, ip - anchor, ip - ref, len);
+			if(!op)
+				return 0;
+			ip += len;
+			anchor = ip;
+			if(ip < matchSearchEnd)
+				table[hash(read32(ip - 2))] = ip - 2 - srcBegin;
+		}
+	}
+	op = writeSequence(op, opEnd, anchor, srcEnd - anchor, 0, 0);
+	if(!op)
+		return 0;
+	return op - dest.data();
+}
+
+static size_t uncompress(std::span<uint8_t> dest, std::span<const uint8_t> src)
+{
+	auto ip = src.data();
+	const auto ipEnd = ip + src.size();
+	const auto opBegin = dest.data();
+	auto op = opBegin;
+	const auto opEnd = op + dest.size();
+	auto readLength = [&](size_t len) -> std::optional<size_t>
+	{
+		if(len != 15)
+			return len;
+		while(true)
+		{
+			if(ip == ipEnd)
+				return {};
+			auto b = *ip++;
+			len += b;
+			if(b != 255)
+				return len;
+		}
+	};
+	while(ip < ipEnd)
+	{
+		auto token = *ip++;
+		auto litLen = readLength(token >> 4);
+		if(!litLen || size_t(ipEnd - ip) < *litLen || size_t(opEnd - op) < *litLen)
+			return 0;
+		std::memcpy(op, ip, *litLen);
+		ip += *litLen;
+		op += *litLen;
+		if(ip == ipEnd)
+			break;
+		if(ipEnd - ip < 2)
+			return 0;
+		size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		auto matchLen = readLength(token & 0xF);
+		if(!matchLen || !offset || offset > size_t(op - opBegin))
+			return 0;
+		auto len = *matchLen + minMatch;
+		if(size_t(opEnd - op) < len)
+			return 0;
+		auto ref = op - offset;
+		if(offset >= len)
+		{
+			std::memcpy(op, ref, len);
+			op += len;
+		}
+		else
+		{
+			// overlapping copy repeats the last offset bytes
+			while(len--)
+				*op++ = *ref++;
+		}
+	}
+	return op - opBegin;
+}
+
+}
+
+static size_t uncompressLZMA(std::span<uint8_t> dest, std::span<const uint8_t> src, const CompressionAllocator *a)
+{
+	uint64_t memLimit = UINT64_MAX;
+	size_t inPos{}, outPos{};
+	auto allocator = lzmaAllocator(a);
+	auto ret = lzma_stream_buffer_decode(&memLimit, 0, a ? &allocator : nullptr,
+		src.data(), &inPos, src.size(), dest.data(), &outPos, dest.size());
+	if(ret != LZMA_OK)
+	{
+		log.error("LZMA decode error:{}", int(ret));
+		return 0;
+	}
+	return outPos;
+}
+
+static size_t inflateGzip(std::span<uint8_t> dest, std::span<const uint8_t> src, const CompressionAllocator *a)
+{
+	if(!a)
+		return uncompressGzip(dest, src);
+	z_stream s{};
+	setAllocator(s, a);
+	s.avail_in = src.size();
+	s.next_in = const_cast<z_const Bytef*>(src.data());
+	s.avail_out = dest.size();
+	s.next_out = dest.data();
+	if(inflateInit2(&s, MAX_WBITS + 16) != Z_OK)
+		return 0;
+	auto res = inflate(&s, Z_FINISH);
+	inflateEnd(&s);
+	if(res != Z_STREAM_END)
+		return 0;
+	return s.total_out;
+}
+
+size_t compress(std::span<uint8_t> dest, std::span<const uint8_t> src, CompressionCodec codec, int level,
+	const CompressionAllocator *a)
+{
+	switch(codec)
+	{
+		case CompressionCodec::None:
+		{
+			if(dest.size() < src.size())
+				return 0;
+			std::ranges::copy(src, dest.begin());
+			return src.size();
+		}
+		case CompressionCodec::Gzip:
+		case CompressionCodec::LZMA:
+		{
+			StreamCompressor compressor{dest, codec, level, {}, a};
+			compressor.write(src);
+			return compressor.finish();
+		}
+		case CompressionCodec::LZ4:
+		{
+			if(!writeHeader(dest, lz4Magic, src.size()))
+				return 0;
+			auto size = LZ4::compress(dest.subspan(headerSize), src);
+			return size ? headerSize + size : 0;
+		}
+	}
+	return 0;
+}
+
+CompressionCodec compressionCodec(std::span<const uint8_t> buff)
+{
+	if(hasGzipHeader(buff))
+		return CompressionCodec::Gzip;
+	if(hasMagic(buff, lz4Magic))
+		return CompressionCodec::LZ4;
+	if(hasMagic(buff, lzmaMagic))
+		return CompressionCodec::LZMA;
+	return CompressionCodec::None;
+}
+
+size_t uncompressedSize(std::span<const uint8_t> buff)
+{
+	switch(compressionCodec(buff))
+	{
+		case CompressionCodec::None: return 0;
+		case CompressionCodec::Gzip: return gzipUncompressedSize(buff);
+		case CompressionCodec::LZ4:
+		case CompressionCodec::LZMA: return readLE32(buff.data() + 4);
+	}
+	return 0;
+}
+
+size_t uncompress(std::span<uint8_t> dest, std::span<const uint8_t> src, const CompressionAllocator *a)
+{
+	switch(compressionCodec(src))
+	{
+		case CompressionCodec::None: return 0;
+		case CompressionCodec::Gzip: return inflateGzip(dest, src, a);
+		case CompressionCodec::LZ4: return LZ4::uncompress(dest, src.subspan(headerSize));
+		case CompressionCodec::LZMA: return uncompressLZMA(dest, src.subspan(headerSize), a);
+	}
+	return 0;
+}
+
+struct LZMAState
+{
+	lzma_stream stream = LZMA_STREAM_INIT;
+	lzma_allocator allocator{};
+};
+
+template<class T>
+static T &codecStateAs(auto &storage)
+{
+	static_assert(sizeof(T) <= sizeof(storage));
+	return *std::launder(reinterpret_cast<T*>(storage.data()));
+}
+
+StreamCompressor::StreamCompressor(std::span<uint8_t> dest, CompressionCodec codec, int level,
+	std::span<uint8_t> inputBuff, const CompressionAllocator *a):
+	dest{dest}, inputBuff{inputBuff}, codec{codec}, level{level}
+{
+	switch(codec)
+	{
+		case CompressionCodec::None:
+		case CompressionCodec::LZ4: return;
+		case CompressionCodec::Gzip:
+		{
+			auto &s = *new(codecState.data()) z_stream{};
+			setAllocator(s, a);
+			s.avail_out = dest.size();
+			s.next_out = dest.data();
+			if(deflateInit2(&s, level < 0 ? Z_DEFAULT_COMPRESSION : std::min(level, 9),
+				Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			{
+				failed = finished = true;
+			}
+			return;
+		}
+		case CompressionCodec::LZMA:
+		{
+			auto &state = *new(codecState.data()) LZMAState{};
+			if(dest.size() <= headerSize)
+			{
+				failed = finished = true;
+				return;
+			}
+			if(a)
+			{
+				state.allocator = lzmaAllocator(a);
+				state.stream.allocator = &state.allocator;
+			}
+			// header is written by finish() once the uncompressed size is known
+			state.stream.next_out = dest.data() + headerSize;
+			state.stream.avail_out = dest.size() - headerSize;
+			uint32_t preset = level < 0 ? LZMA_PRESET_DEFAULT : std::min(level, 9);
+			lzma_options_lzma opts;
+			lzma_lzma_preset(&opts, preset);
+			// presets above 6 only grow the dictionary past any state size, which takes
+			// the encoder from ~94MB to ~674MB at level 9, so keep level 6's dictionary
+			opts.dict_size = std::min(opts.dict_size, maxLZMADictSize);
+			lzma_filter filters[]{{LZMA_FILTER_LZMA2, &opts}, {LZMA_VLI_UNKNOWN, nullptr}};
+			if(auto ret = lzma_stream_encoder(&state.stream, filters, LZMA_CHECK_NONE);
+				ret != LZMA_OK)
+			{
+				log.error("LZMA encoder init error:{}", int(ret));
+				failed = finished = true;
+			}
+			return;
+		}
+	}
+}
+
+StreamCompressor::~StreamCompressor()
+{
+	if(finished)
+		return;
+	if(codec == CompressionCodec::Gzip)
+		deflateEnd(&codecStateAs<z_stream>(codecState));
+	else if(codec == CompressionCodec::LZMA)
+		lzma_end(&codecStateAs<LZMAState>(codecState).stream);
+}
+
+bool StreamCompressor::write(std::span<const uint8_t> src)
+{
+	if(failed)
+		return false;
+	inputSize += src.size();
+	switch(codec)
+	{
+		case CompressionCodec::None:
+		{
+			if(dest.size() - outputSize < src.size())
+				return failed = true, false;
+			std::ranges::copy(src, dest.begin() + outputSize);
+			outputSize += src.size();
+			return true;
+		}
+		case CompressionCodec::LZ4:
+		{
+			if(inputBuff.size() < inputSize)
+				return failed = true, false;
+			std::ranges::copy(src, inputBuff.begin() + (inputSize - src.size()));
+			return true;
+		}
+		case CompressionCodec::Gzip:
+		{
+			auto &s = codecStateAs<z_stream>(codecState);
+			s.avail_in = src.size();
+			s.next_in = const_cast<z_const Bytef*>(src.data());
+			while(s.avail_in)
+			{
+				// output is full if input remains after deflate() returns
+				if(deflate(&s, Z_NO_FLUSH) == Z_STREAM_ERROR || (s.avail_in && !s.avail_out))
+					return failed = true, false;
+			}
+			return true;
+		}
+		case CompressionCodec::LZMA:
+		{
+			auto &s = codecStateAs<LZMAState>(codecState).stream;
+			s.next_in = src.data();
+			s.avail_in = src.size();
+			while(s.avail_in)
+			{
+				if(lzma_code(&s, LZMA_RUN) != LZMA_OK || (s.avail_in && !s.avail_out))
+					return failed = true, false;
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t StreamCompressor::finish()
+{
+	if(finished)
+		return failed ? 0 : outputSize;
+	finished = true;
+	switch(codec)
+	{
+		case CompressionCodec::None: break;
+		case CompressionCodec::LZ4:
+		{
+			if(!failed)
+				outputSize = compress(dest, inputBuff.first(inputSize), CompressionCodec::LZ4);
+			break;
+		}
+		case CompressionCodec::Gzip:
+		{
+			auto &s = codecStateAs<z_stream>(codecState);
+			if(!failed && deflate(&s, Z_FINISH) == Z_STREAM_END)
+				outputSize = s.total_out;
+			else
+				failed = true;
+			deflateEnd(&s);
+			break;
+		}
+		case CompressionCodec::LZMA:
+		{
+			auto &s = codecStateAs<LZMAState>(codecState).stream;
+			if(!failed)
+			{
+				lzma_ret ret;
+				while((ret = lzma_code(&s, LZMA_FINISH)) == LZMA_OK && s.avail_out) {}
+				if(ret == LZMA_STREAM_END && writeHeader(dest, lzmaMagic, inputSize))
+					outputSize = headerSize + s.total_out;
+				else
+					failed = true;
+			}
+			lzma_end(&s);
+			break;
+		}
+	}
+	if(failed || !outputSize)
+	{
+		failed = true;
+		return 0;
+	}
+	return outputSize;
+}
+
+}
@@ -0,0 +1,9 @@
+ifndef inc_util_compression
+inc_util_compression := 1
+
+include $(IMAGINE_PATH)/make/package/zlib.mk
+include $(IMAGINE_PATH)/make/package/liblzma.mk
+
+SRC += util/compression.cc
+
+endif
\ No newline at end of file
@@ -0,0 +1 @@
+include $(IMAGINE_PATH)/make/shortcut/meta-builds/android-release.mk
@@ -0,0 +1,282 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/audio/SampleConversion.hh>
+#include <imagine/audio/Resampler.hh>
+#include <imagine/util/algorithm.h>
+#include "benchmark.hh"
+#include <vector>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+
+namespace ConversionBenchmark
+{
+
+// ~21ms of 48KHz stereo audio, a typical callback size
+constexpr size_t frames = 1024;
+constexpr size_t samples = frames * 2;
+constexpr float volume = .75f;
+
+// reference versions matching the previous per-sample loops
+
+static void convertI16ToFloatRef(float *dest, const int16_t *src)
+{
+	transformN(src, samples, dest, [=](int16_t s){ return (float(s) / 32768.f) * volume; });
+}
+
+static void convertFloatToI16Ref(int16_t *dest, const float *src)
+{
+	transformN(src, samples, dest, [=](float s){ return remapClamp(s * volume, -1.f, 1.f, std::numeric_limits<int16_t>{}); });
+}
+
+static void scaleI16Ref(int16_t *dest, const int16_t *src)
+{
+	transformN(src, samples, dest, [=](int16_t s){ return remapClamp((float(s) / 32768.f) * volume, -1.f, 1.f, std::numeric_limits<int16_t>{}); });
+}
+
+static void scaleFloatRef(float *dest, const float *src)
+{
+	transformN(src, samples, dest, [=](float s){ return s * volume; });
+}
+
+static void mergeStereoRef(int16_t *dest, const int32_t *left, const int32_t *right)
+{
+	for(size_t i = 0; i < frames; i++)
+	{
+		*dest++ = std::clamp(left[i], -32768, 32767);
+		*dest++ = std::clamp(right[i], -32768, 32767);
+	}
+}
+
+// Checks a kernel's output for count items against the expected value of each one, and that
+// it returned the end of its output without writing past it. Int16 results may be off by one
+// since 32-bit ARM NEON truncates instead of rounding to nearest.
+template<class T>
+static bool checkOutput(std::string_view name, float volume, size_t count, const std::vector<T> &dest,
+	const T *end, auto &&expected)
+{
+	constexpr float tolerance = std::is_integral_v<T> ? 1.f : 0.f;
+	if(end != dest.data() + count)
+	{
+		log.error("{} (volume:{} count:{}): returned end is off by {}", name, volume, count, end - (dest.data() + count));
+		return false;
+	}
+	for(size_t i = 0; i < count; i++)
+	{
+		auto e = expected(i);
+		if(std::abs(float(dest[i]) - float(e)) > tolerance)
+		{
+			log.error("{} (volume:{} count:{}): differs at {}, got:{} expected:{}", name, volume, count, i, dest[i], e);
+			return false;
+		}
+	}
+	if(dest[count] != T(1))
+	{
+		log.error("{} (volume:{} count:{}): wrote past the end", name, volume, count);
+		return false;
+	}
+	return true;
+}
+
+static int16_t saturateToInt16(float s)
+{
+	return std::clamp(std::lrint(s), -32768l, 32767l);
+}
+
+// Compares each kernel with the per-sample math of the scalar versions in SampleConversion.cc.
+// The counts leave tails after the SSE2, AVX2 & NEON blocks and the volumes cover saturation.
+static bool checkSampleKernels(const std::vector<int16_t> &i16Src, const std::vector<float> &floatSrc,
+	const std::vector<int32_t> &left, const std::vector<int32_t> &right)
+{
+	constexpr size_t counts[]{1, 3, 7, 9, 15, 17, 31, 33, 1023};
+	constexpr float volumes[]{.75f, 1.5f};
+	bool ok = true;
+	for(auto volume : volumes)
+	{
+		for(auto count : counts)
+		{
+			std::vector<float> floatDest(count + 1, 1.f);
+			ok &= checkOutput("int16 -> float", volume, count, floatDest,
+				Audio::convertSamples(floatDest.data(), i16Src.data(), count, volume),
+				[&](size_t i){ return i16Src[i] * (volume / 32768.f); });
+			std::vector<int16_t> i16Dest(count + 1, 1);
+			ok &= checkOutput("float -> int16", volume, count, i16Dest,
+				Audio::convertSamples(i16Dest.data(), floatSrc.data(), count, volume),
+				[&](size_t i){ return saturateToInt16(floatSrc[i] * (volume * 32768.f)); });
+			std::ranges::fill(floatDest, 1.f);
+			ok &= checkOutput("float volume", volume, count, floatDest,
+				Audio::scaleSamples(floatDest.data(), floatSrc.data(), count, volume),
+				[&](size_t i){ return floatSrc[i] * volume; });
+			std::ranges::fill(i16Dest, 1);
+			ok &= checkOutput("int16 volume", volume, count, i16Dest,
+				Audio::scaleSamples(i16Dest.data(), i16Src.data(), count, volume),
+				[&](size_t i){ return saturateToInt16(i16Src[i] * volume); });
+		}
+	}
+	for(auto frames : counts)
+	{
+		std::vector<int16_t> i16Dest(frames * 2 + 1, 1);
+		ok &= checkOutput("int32 L/R -> int16 stereo", 1.f, frames * 2, i16Dest,
+			Audio::mergeStereoSamples(i16Dest.data(), left.data(), right.data(), frames),
+			[&](size_t i){ return int16_t(std::clamp((i % 2 ? right : left)[i / 2], -32768, 32767)); });
+	}
+	return ok;
+}
+
+// Resampler with its SSE/NEON kernel blend & dot product done by plain loops in source order
+class ScalarResampler : public Audio::Resampler
+{
+public:
+	size_t process(float *dest, size_t destFrames, const float *src, size_t srcFrames, double ratio)
+	{
+		// same fixed point layout as Resampler.cc
+		constexpr int fracBits = 32;
+		constexpr int phaseFracBits = fracBits - phaseBits;
+		updateCutoff(ratio);
+		auto step = stepForRatio(ratio);
+		for(int ch = 0; ch < channels; ch++)
+		{
+			auto &h = history[ch];
+			if(h.size() < taps + srcFrames)
+				h.resize(taps + srcFrames);
+			for(size_t i = 0; i < srcFrames; i++)
+			{
+				h[taps + i] = src[i * channels + ch];
+			}
+		}
+		const uint64_t end = uint64_t(srcFrames + taps / 2) << fracBits;
+		size_t written{};
+		while(pos < end)
+		{
+			if(written == destFrames)
+			{
+				pos += (end - pos + step - 1) / step * step;
+				break;
+			}
+			auto idx = pos >> fracBits;
+			auto frac = uint32_t(pos);
+			auto phase = frac >> phaseFracBits;
+			float t = (frac & ((1u << phaseFracBits) - 1)) * (1.f / (1u << phaseFracBits));
+			auto row = &kernel[phase * taps];
+			auto first = idx - (taps / 2 - 1);
+			for(int ch = 0; ch < channels; ch++)
+			{
+				float sum{};
+				for(int k = 0; k < taps; k++)
+				{
+					sum += (row[k] + (row[taps + k] - row[k]) * t) * history[ch][first + k];
+				}
+				*dest++ = sum;
+			}
+			written++;
+			pos += step;
+		}
+		pos -= uint64_t(srcFrames) << fracBits;
+		for(int ch = 0; ch < channels; ch++)
+		{
+			auto h = history[ch].data();
+			std::copy_n(h + srcFrames, taps, h);
+		}
+		return written;
+	}
+};
+
+// Feeds the same stereo float blocks through both resamplers while changing the ratio between
+// blocks, including decimation that rebuilds the kernel. Only the summation order differs so
+// the output is allowed a small error.
+static bool checkResampler(const std::vector<float> &floatSrc)
+{
+	constexpr float tolerance = 1e-5f;
+	constexpr std::pair<size_t, double> blocks[]
+	{
+		{1, 48000. / 44100.}, {37, 48000. / 44100.}, {300, 1.003}, {2, .997}, {256, .5}, {99, 2.}, {300, 48000. / 32000.},
+	};
+	Audio::Resampler resampler;
+	ScalarResampler scalarResampler;
+	resampler.reset(Audio::SampleFormats::f32, 2);
+	scalarResampler.reset(Audio::SampleFormats::f32, 2);
+	size_t srcPos{};
+	for(auto [srcFrames, ratio] : blocks)
+	{
+		auto src = floatSrc.data() + srcPos * 2;
+		srcPos += srcFrames;
+		auto destFrames = resampler.outputFrames(srcFrames, ratio);
+		std::vector<float> dest(destFrames * 2), scalarDest(destFrames * 2);
+		auto written = resampler.process(dest.data(), destFrames, src, srcFrames, ratio);
+		auto scalarWritten = scalarResampler.process(scalarDest.data(), destFrames, src, srcFrames, ratio);
+		if(written != scalarWritten)
+		{
+			log.error("resampler (ratio:{} frames:{}): wrote {} frames, expected {}", ratio, srcFrames, written, scalarWritten);
+			return false;
+		}
+		for(size_t i = 0; i < written * 2; i++)
+		{
+			if(std::abs(dest[i] - scalarDest[i]) > tolerance)
+			{
+				log.error("resampler (ratio:{} frames:{}): differs at {}, got:{} expected:{}", ratio, srcFrames, i, dest[i], scalarDest[i]);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool runAudioBenchmarks()
+{
+	std::vector<int16_t> i16Src(samples), i16Dest(samples);
+	std::vector<float> floatSrc(samples), floatDest(samples);
+	std::vector<int32_t> left(frames), right(frames);
+	for(size_t i = 0; i < samples; i++)
+	{
+		auto s = std::sin(i * .01);
+		i16Src[i] = s * 32767.;
+		// past full scale so the int16 conversion saturates
+		floatSrc[i] = s * 1.25;
+	}
+	// reach both int16 limits
+	i16Src[5] = -32768;
+	i16Src[12] = 32767;
+	for(size_t i = 0; i < frames; i++)
+	{
+		left[i] = i16Src[i * 2] * 2;
+		right[i] = i16Src[i * 2 + 1] * 2;
+	}
+	log.info("audio kernels:{}", Audio::sampleConversionKernelName());
+	bool ok = checkSampleKernels(i16Src, floatSrc, left, right);
+	ok &= checkResampler(floatSrc);
+	log.info("audio kernels {} the scalar path", ok ? "match" : "DON'T match");
+	log.info("times are per sample");
+	logResult("int16 -> float",
+		nsPerItem(samples, [&]{ convertI16ToFloatRef(floatDest.data(), i16Src.data()); }),
+		nsPerItem(samples, [&]{ Audio::convertSamples(floatDest.data(), i16Src.data(), samples, volume); }));
+	logResult("float -> int16",
+		nsPerItem(samples, [&]{ convertFloatToI16Ref(i16Dest.data(), floatSrc.data()); }),
+		nsPerItem(samples, [&]{ Audio::convertSamples(i16Dest.data(), floatSrc.data(), samples, volume); }));
+	logResult("int16 volume",
+		nsPerItem(samples, [&]{ scaleI16Ref(i16Dest.data(), i16Src.data()); }),
+		nsPerItem(samples, [&]{ Audio::scaleSamples(i16Dest.data(), i16Src.data(), samples, volume); }));
+	logResult("float volume",
+		nsPerItem(samples, [&]{ scaleFloatRef(floatDest.data(), floatSrc.data()); }),
+		nsPerItem(samples, [&]{ Audio::scaleSamples(floatDest.data(), floatSrc.data(), samples, volume); }));
+	logResult("int32 L/R -> int16 stereo",
+		nsPerItem(samples, [&]{ mergeStereoRef(i16Dest.data(), left.data(), right.data()); }),
+		nsPerItem(samples, [&]{ Audio::mergeStereoSamples(i16Dest.data(), left.data(), right.data(), frames); }));
+	return ok;
+}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/time/Time.hh>
+#include <imagine/logger/logger.h>
+#include <string_view>
+#include <algorithm>
+
+namespace ConversionBenchmark
+{
+
+using namespace IG;
+
+constexpr SystemLogger log{"ConvBench"};
+constexpr int benchmarkRuns = 50;
+
+// Returns the fastest time of several runs in nanoseconds per item
+double nsPerItem(size_t items, auto &&func)
+{
+	auto best = Nanoseconds::max();
+	for(int i = 0; i < benchmarkRuns; i++)
+	{
+		auto start = SteadyClock::now();
+		func();
+		best = std::min(best, duration_cast<Nanoseconds>(SteadyClock::now() - start));
+	}
+	return double(best.count()) / items;
+}
+
+inline void logResult(std::string_view name, double baselineNs, double ns)
+{
+	log.info("{}: {:.3f} ns (scalar {:.3f} ns, {:.2f}x)", name, ns, baselineNs, baselineNs / ns);
+}
+
+// Both return false if a kernel's output differs from its scalar version
+bool runAudioBenchmarks();
+bool runPixelBenchmarks();
+
+}
@@ -0,0 +1,147 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/pixmap/Pixmap.hh>
+#include "benchmark.hh"
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <format>
+
+namespace ConversionBenchmark
+{
+
+// largest Saturn hi-res frame
+constexpr WSize frameSize{704, 512};
+
+struct PixelConversion
+{
+	PixelFormatID destFormat, srcFormat;
+	// the per-pixel transform writeConverted() used before convertPixels()
+	void (*scalarConvert)(MutablePixmapView, PixmapView);
+};
+
+// every conversion convertPixels() handles
+constexpr PixelConversion conversions[]
+{
+	{PIXEL_RGBA8888, PIXEL_RGB565,
+		[](MutablePixmapView dest, PixmapView src){ dest.writeTransformed(transformRGB565ToRGBX8888, src); }},
+	{PIXEL_BGRA8888, PIXEL_RGB565,
+		[](MutablePixmapView dest, PixmapView src){ dest.writeTransformed(transformRGB565ToBGRX8888, src); }},
+	{PIXEL_RGB565, PIXEL_RGBA8888,
+		[](MutablePixmapView dest, PixmapView src){ dest.writeTransformed(transformRGBX8888ToRGB565, src); }},
+	{PIXEL_RGB565, PIXEL_BGRA8888,
+		[](MutablePixmapView dest, PixmapView src){ dest.writeTransformed(transformBGRX8888ToRGB565, src); }},
+	{PIXEL_BGRA8888, PIXEL_RGBA8888,
+		[](MutablePixmapView dest, PixmapView src){ dest.writeTransformed(transformRGBA8888ToBGRA8888, src); }},
+	{PIXEL_RGBA8888, PIXEL_BGRA8888,
+		[](MutablePixmapView dest, PixmapView src){ dest.writeTransformed(transformRGBA8888ToBGRA8888, src); }},
+	{PIXEL_RGBA8888, PIXEL_RGB888,
+		[](MutablePixmapView dest, PixmapView src){ dest.writeTransformedDirect<RGBTripleArray, uint32_t>(transformRGB888ToRGBX8888, src); }},
+	{PIXEL_BGRA8888, PIXEL_RGB888,
+		[](MutablePixmapView dest, PixmapView src){ dest.writeTransformedDirect<RGBTripleArray, uint32_t>(transformRGB888ToBGRX8888, src); }},
+	{PIXEL_RGB888, PIXEL_RGBA8888,
+		[](MutablePixmapView dest, PixmapView src){ dest.writeTransformedDirect<uint32_t, RGBTripleArray>(transformRGBX8888ToRGB888, src); }},
+	{PIXEL_RGB888, PIXEL_BGRA8888,
+		[](MutablePixmapView dest, PixmapView src){ dest.writeTransformedDirect<uint32_t, RGBTripleArray>(transformBGRX8888ToRGB888, src); }},
+	{PIXEL_RGB888, PIXEL_RGB565,
+		[](MutablePixmapView dest, PixmapView src){ dest.writeTransformedDirect<uint16_t, RGBTripleArray>(transformRGB565ToRGB888, src); }},
+	{PIXEL_RGB565, PIXEL_RGB888,
+		[](MutablePixmapView dest, PixmapView src){ dest.writeTransformedDirect<RGBTripleArray, uint16_t>(transformRGB888ToRGB565, src); }},
+};
+
+static std::string conversionName(const PixelConversion &conv)
+{
+	return std::format("{} -> {}", PixelFormat{conv.srcFormat}.name(), PixelFormat{conv.destFormat}.name());
+}
+
+static void fillSource(std::vector<char> &data)
+{
+	for(size_t i = 0; i < data.size(); i++)
+	{
+		data[i] = i * 7;
+	}
+}
+
+// Compares writeConverted() with the scalar path byte for byte, including the row padding
+// that neither should touch. Padding is in pixels since pitches are stored that way.
+static bool checkPixelConversion(const PixelConversion &conv, WSize size, int destPadding, int srcPadding)
+{
+	PixelFormat srcFormat{conv.srcFormat}, destFormat{conv.destFormat};
+	int srcPitch = srcFormat.pixelBytes(size.x + srcPadding);
+	int destPitch = destFormat.pixelBytes(size.x + destPadding);
+	std::vector<char> srcData(srcPitch * size.y);
+	fillSource(srcData);
+	std::vector<char> refData(destPitch * size.y, 0x5A), destData(refData);
+	PixmapView src{{size, conv.srcFormat}, srcData.data(), {srcPitch, PixmapUnits::BYTE}};
+	conv.scalarConvert({{size, conv.destFormat}, refData.data(), {destPitch, PixmapUnits::BYTE}}, src);
+	MutablePixmapView{{size, conv.destFormat}, destData.data(), {destPitch, PixmapUnits::BYTE}}.writeConverted(src);
+	auto [destIt, refIt] = std::ranges::mismatch(destData, refData);
+	if(destIt == destData.end())
+		return true;
+	auto offset = destIt - destData.begin();
+	log.error("{}: {}x{} (dest padding:{} src padding:{}) differs at row:{} byte:{}, got:{:#04x} expected:{:#04x}",
+		conversionName(conv), size.x, size.y, destPadding, srcPadding,
+		offset / destPitch, offset % destPitch, uint8_t(*destIt), uint8_t(*refIt));
+	return false;
+}
+
+static bool checkPixelConversion(const PixelConversion &conv)
+{
+	// odd widths leave tail pixels after the last full SIMD block
+	constexpr WSize sizes[]{{1, 1}, {3, 2}, {7, 3}, {17, 5}, {31, 2}, {705, 4}};
+	constexpr std::pair<int, int> paddings[]{{0, 0}, {3, 0}, {0, 5}, {1, 2}};
+	bool ok = true;
+	for(auto size : sizes)
+	{
+		for(auto [destPadding, srcPadding] : paddings)
+		{
+			ok &= checkPixelConversion(conv, size, destPadding, srcPadding);
+		}
+	}
+	return ok;
+}
+
+static void runPixelBenchmark(const PixelConversion &conv)
+{
+	std::vector<char> srcData(PixelFormat{conv.srcFormat}.pixelBytes(frameSize.x * frameSize.y));
+	std::vector<char> destData(PixelFormat{conv.destFormat}.pixelBytes(frameSize.x * frameSize.y));
+	fillSource(srcData);
+	PixmapView src{{frameSize, conv.srcFormat}, srcData.data()};
+	MutablePixmapView dest{{frameSize, conv.destFormat}, destData.data()};
+	auto pixels = frameSize.x * frameSize.y;
+	logResult(conversionName(conv),
+		nsPerItem(pixels, [&]{ conv.scalarConvert(dest, src); }),
+		nsPerItem(pixels, [&]{ dest.writeConverted(src); }));
+}
+
+bool runPixelBenchmarks()
+{
+	bool ok = true;
+	for(const auto &conv : conversions)
+	{
+		ok &= checkPixelConversion(conv);
+	}
+	log.info("pixel conversions {} the scalar path", ok ? "match" : "DON'T match");
+	log.info("{}x{} frames, times are per pixel", frameSize.x, frameSize.y);
+	for(const auto &conv : conversions)
+	{
+		runPixelBenchmark(conv);
+	}
+	return ok;
+}
+
+}